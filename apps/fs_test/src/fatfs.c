@@ -0,0 +1,66 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+
+#if MYNEWT_VAL(FS_TEST_FATFS)
+
+#include <disk/disk.h>
+#include <fs/fs.h>
+#include <mmc/mmc.h>
+
+/*
+ * Low level SPI configuration handed to hal_spi_init(). Most MCUs require
+ * one, so boards running this test should override it.
+ */
+__attribute__((weak)) void *
+fs_test_mmc_spi_cfg(void)
+{
+    return NULL;
+}
+
+int
+fs_lowlevel_init(void)
+{
+    int rc;
+
+    rc = mmc_init(MYNEWT_VAL(FS_TEST_MMC_SPI_NUM), fs_test_mmc_spi_cfg(),
+                  MYNEWT_VAL(FS_TEST_MMC_SS_PIN));
+    if (rc) {
+        return rc;
+    }
+
+    rc = disk_register("mmc0", "fatfs", &mmc_ops);
+    if (rc) {
+        return rc;
+    }
+
+    rc = fs_mount("mmc0");
+    if (rc) {
+        return rc;
+    }
+
+#if MYNEWT_VAL(FS_TEST_FORCE_REFORMAT)
+    rc = fs_mkfs("mmc0:", 0);
+#endif
+
+    return rc;
+}
+
+#endif
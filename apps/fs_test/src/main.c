@@ -43,7 +43,8 @@ static struct os_task blinky_task;
 #define FS_TEST_STACK_SIZE   OS_STACK_ALIGN(2048)
 static struct os_task fs_test_task;
 
-#if !MYNEWT_VAL(FS_TEST_LITTLEFS) && !MYNEWT_VAL(FS_TEST_NFFS)
+#if !MYNEWT_VAL(FS_TEST_LITTLEFS) && !MYNEWT_VAL(FS_TEST_NFFS) && \
+    !MYNEWT_VAL(FS_TEST_FATFS)
 #error "No filesystem selected, or unsupported FS!"
 #endif
 
@@ -56,10 +57,16 @@ static char *random_strings[] = {
 };
 
 /* Root directory where files will be created */
+#if MYNEWT_VAL(FS_TEST_FATFS)
+static const char *dirformat = "mmc0:/fs_test_%d";
+#else
 static const char *dirformat = "fs_test_%d";
+#endif
 
 #define STARTUP_DELAY MYNEWT_VAL(FS_TEST_STARTUP_DELAY)
 #define MAX_TEST_FILES MYNEWT_VAL(FS_TEST_MAX_FILES)
+#define THROUGHPUT_SIZE MYNEWT_VAL(FS_TEST_THROUGHPUT_SIZE)
+#define THROUGHPUT_CHUNK MYNEWT_VAL(FS_TEST_THROUGHPUT_CHUNK)
 
 #define BLINK_NORMAL (OS_TICKS_PER_SEC)
 #define BLINK_SLOW (OS_TICKS_PER_SEC * 2)
@@ -245,6 +252,90 @@ fs_test_read_files(char *root)
     return 0;
 }
 
+#if THROUGHPUT_SIZE > 0
+static uint8_t throughput_buf[THROUGHPUT_CHUNK];
+
+static void
+fs_test_print_rate(const char *what, uint32_t bytes, int64_t usecs)
+{
+    if (usecs <= 0) {
+        usecs = 1;
+    }
+    printf("%s %lu bytes in %lu us (%lu KB/s)\n", what, (unsigned long)bytes,
+           (unsigned long)usecs,
+           (unsigned long)((uint64_t)bytes * 1000000 / 1024 / usecs));
+}
+
+static int
+fs_test_throughput(char *root)
+{
+    struct fs_file *file;
+    char name[30];
+    uint32_t off;
+    uint32_t chunk;
+    uint32_t outlen;
+    uint32_t i;
+    int64_t start;
+    int rc;
+
+    sprintf(name, "%s/throughput", root);
+
+    for (i = 0; i < sizeof(throughput_buf); i++) {
+        throughput_buf[i] = i;
+    }
+
+    rc = fs_open(name, FS_ACCESS_WRITE | FS_ACCESS_TRUNCATE, &file);
+    if (rc != 0) {
+        printf("Failed opening (%s) for writing: %d\n", name, rc);
+        return rc;
+    }
+
+    start = os_get_uptime_usec();
+    for (off = 0; off < THROUGHPUT_SIZE; off += chunk) {
+        chunk = min(THROUGHPUT_CHUNK, THROUGHPUT_SIZE - off);
+        rc = fs_write(file, throughput_buf, chunk);
+        if (rc != 0) {
+            printf("Write failed at offset %lu: %d\n", (unsigned long)off, rc);
+            fs_close(file);
+            return rc;
+        }
+    }
+    rc = fs_close(file);
+    fs_test_print_rate("Wrote", THROUGHPUT_SIZE, os_get_uptime_usec() - start);
+    if (rc != 0) {
+        return rc;
+    }
+
+    rc = fs_open(name, FS_ACCESS_READ, &file);
+    if (rc != 0) {
+        printf("Failed opening (%s) for reading: %d\n", name, rc);
+        return rc;
+    }
+
+    start = os_get_uptime_usec();
+    for (off = 0; off < THROUGHPUT_SIZE; off += chunk) {
+        chunk = min(THROUGHPUT_CHUNK, THROUGHPUT_SIZE - off);
+        rc = fs_read(file, chunk, throughput_buf, &outlen);
+        if (rc != 0 || outlen != chunk) {
+            printf("Read failed at offset %lu: %d\n", (unsigned long)off, rc);
+            fs_close(file);
+            return -1;
+        }
+    }
+    fs_test_print_rate("Read", THROUGHPUT_SIZE, os_get_uptime_usec() - start);
+    fs_close(file);
+
+    for (i = 0; i < chunk; i++) {
+        if (throughput_buf[i] != (uint8_t)i) {
+            printf("Throughput file contents mismatch\n");
+            return -1;
+        }
+    }
+
+    return fs_unlink(name);
+}
+#endif
+
 static int
 fs_test_rename_files(char *root)
 {
@@ -377,6 +468,11 @@ fs_test_handler(void *arg)
     if (rc == 0) {
         rc = fs_test_read_files(root);
     }
+#if THROUGHPUT_SIZE > 0
+    if (rc == 0) {
+        rc = fs_test_throughput(root);
+    }
+#endif
     if (rc == 0) {
         rc = fs_test_rename_files(root);
     }
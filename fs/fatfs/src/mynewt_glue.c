@@ -55,6 +55,9 @@ static int fatfs_mkfs(const char *path, uint8_t format);
 static int fatfs_mount(const char *disk_name);
 static int fatfs_unmount(const char *disk_name);
 static bool fatfs_is_mounted(const char *disk_name);
+#if MYNEWT_VAL(FATFS_SECTOR_CACHE_SIZE) > 0
+static void fatfs_sector_cache_flush(int pdrv);
+#endif
 
 #define DRIVE_LEN 4
 
@@ -236,6 +239,10 @@ fatfs_unmount(const char *disk_name)
     sprintf(path, "%d:", (uint8_t)sc->disk_number);
     rc = f_mount(NULL, path, 0); // set FAT context to NULL unmount the disk
     sc->mounted = false;
+#if MYNEWT_VAL(FATFS_SECTOR_CACHE_SIZE) > 0
+    /* The medium may be swapped before the next mount */
+    fatfs_sector_cache_flush(sc->disk_number);
+#endif
 
     return rc;
 }
@@ -774,30 +781,219 @@ disk_status(BYTE pdrv)
     return RES_OK;
 }
 
-static struct disk_ops *dops_from_handle(BYTE pdrv)
+static struct mounted_disk *disk_from_handle(BYTE pdrv)
 {
     struct mounted_disk *sc;
 
     SLIST_FOREACH(sc, &mounted_disks, sc_next) {
         if (sc->disk_number == pdrv) {
-            return sc->dops;
+            return sc;
+        }
+    }
+
+    return NULL;
+}
+
+static struct disk_ops *dops_from_handle(BYTE pdrv)
+{
+    struct mounted_disk *sc;
+
+    sc = disk_from_handle(pdrv);
+    if (sc == NULL) {
+        return NULL;
+    }
+
+    return sc->dops;
+}
+
+#if MYNEWT_VAL(FATFS_SECTOR_CACHE_SIZE) > 0
+/*
+ * Write-through cache of FAT and directory sectors.
+ *
+ * FatFs keeps a single sector window per volume for FAT and directory
+ * access, so walking a directory while allocating clusters keeps evicting
+ * and re-reading the same few sectors.  Only transfers into or out of that
+ * window are cached; file data, which FatFs hands down as multi-sector
+ * requests whenever it can, always goes straight to the disk.
+ */
+struct fatfs_cached_sector {
+    DWORD sector;
+    uint32_t last_used;
+    int8_t pdrv;
+    BYTE data[_MAX_SS];
+};
+
+static struct fatfs_cached_sector
+    fatfs_sector_cache[MYNEWT_VAL(FATFS_SECTOR_CACHE_SIZE)];
+static uint32_t fatfs_sector_cache_clock;
+static struct os_mutex fatfs_sector_cache_mutex;
+
+static bool
+fatfs_sector_cacheable(BYTE pdrv, const BYTE *buff, UINT count)
+{
+    struct mounted_disk *sc;
+
+    if (count != 1) {
+        return false;
+    }
+
+    sc = disk_from_handle(pdrv);
+    return sc != NULL && sc->fs_instance != NULL &&
+           buff == sc->fs_instance->win;
+}
+
+static struct fatfs_cached_sector *
+fatfs_sector_cache_find(BYTE pdrv, DWORD sector)
+{
+    int i;
+
+    for (i = 0; i < ARRAY_SIZE(fatfs_sector_cache); i++) {
+        if (fatfs_sector_cache[i].pdrv == pdrv &&
+            fatfs_sector_cache[i].sector == sector) {
+            return &fatfs_sector_cache[i];
         }
     }
 
     return NULL;
 }
 
+static void
+fatfs_sector_cache_insert(BYTE pdrv, DWORD sector, const BYTE *buff)
+{
+    struct fatfs_cached_sector *entry;
+    int i;
+
+    entry = fatfs_sector_cache_find(pdrv, sector);
+    if (entry == NULL) {
+        /* Replace a free or the least recently used entry */
+        entry = &fatfs_sector_cache[0];
+        for (i = 0; i < ARRAY_SIZE(fatfs_sector_cache); i++) {
+            if (fatfs_sector_cache[i].pdrv < 0) {
+                entry = &fatfs_sector_cache[i];
+                break;
+            }
+            if ((int32_t)(fatfs_sector_cache[i].last_used -
+                          entry->last_used) < 0) {
+                entry = &fatfs_sector_cache[i];
+            }
+        }
+    }
+
+    entry->pdrv = pdrv;
+    entry->sector = sector;
+    entry->last_used = ++fatfs_sector_cache_clock;
+    memcpy(entry->data, buff, _MAX_SS);
+}
+
+/**
+ * Looks up a window read in the cache.
+ *
+ * @return true if buff was filled from the cache
+ */
+static bool
+fatfs_sector_cache_read(BYTE pdrv, BYTE *buff, DWORD sector, UINT count)
+{
+    struct fatfs_cached_sector *entry;
+
+    if (!fatfs_sector_cacheable(pdrv, buff, count)) {
+        return false;
+    }
+
+    os_mutex_pend(&fatfs_sector_cache_mutex, OS_TIMEOUT_NEVER);
+    entry = fatfs_sector_cache_find(pdrv, sector);
+    if (entry != NULL) {
+        entry->last_used = ++fatfs_sector_cache_clock;
+        memcpy(buff, entry->data, _MAX_SS);
+    }
+    os_mutex_release(&fatfs_sector_cache_mutex);
+
+    return entry != NULL;
+}
+
+/**
+ * Records a completed transfer.  Window sectors are (re)inserted, any other
+ * cached sector the transfer overlaps is updated (or dropped on error) so
+ * the cache never holds stale data.
+ */
+static void
+fatfs_sector_cache_update(BYTE pdrv, const BYTE *buff, DWORD sector,
+                          UINT count, bool ok)
+{
+    struct fatfs_cached_sector *entry;
+    int i;
+
+    os_mutex_pend(&fatfs_sector_cache_mutex, OS_TIMEOUT_NEVER);
+    if (ok && fatfs_sector_cacheable(pdrv, buff, count)) {
+        fatfs_sector_cache_insert(pdrv, sector, buff);
+    } else {
+        for (i = 0; i < ARRAY_SIZE(fatfs_sector_cache); i++) {
+            entry = &fatfs_sector_cache[i];
+            if (entry->pdrv != pdrv || entry->sector < sector ||
+                entry->sector - sector >= count) {
+                continue;
+            }
+            if (ok) {
+                memcpy(entry->data, buff + (entry->sector - sector) * _MAX_SS,
+                       _MAX_SS);
+            } else {
+                entry->pdrv = -1;
+            }
+        }
+    }
+    os_mutex_release(&fatfs_sector_cache_mutex);
+}
+
+static void
+fatfs_sector_cache_flush(int pdrv)
+{
+    int i;
+
+    os_mutex_pend(&fatfs_sector_cache_mutex, OS_TIMEOUT_NEVER);
+    for (i = 0; i < ARRAY_SIZE(fatfs_sector_cache); i++) {
+        if (fatfs_sector_cache[i].pdrv == pdrv) {
+            fatfs_sector_cache[i].pdrv = -1;
+        }
+    }
+    os_mutex_release(&fatfs_sector_cache_mutex);
+}
+
+static void
+fatfs_sector_cache_init(void)
+{
+    int i;
+
+    for (i = 0; i < ARRAY_SIZE(fatfs_sector_cache); i++) {
+        fatfs_sector_cache[i].pdrv = -1;
+    }
+    os_mutex_init(&fatfs_sector_cache_mutex);
+}
+#endif
+
+/*
+ * Contiguous multi-sector requests are passed to the disk as a single
+ * transfer, which lets block devices such as mmc use their multiple block
+ * commands.
+ */
 DRESULT
 disk_read(BYTE pdrv, BYTE* buff, DWORD sector, UINT count)
 {
     int rc;
     uint32_t num_bytes;
+    uint32_t addr;
     struct disk_ops *dops;
 
+#if MYNEWT_VAL(FATFS_SECTOR_CACHE_SIZE) > 0
+    if (fatfs_sector_cache_read(pdrv, buff, sector, count)) {
+        return RES_OK;
+    }
+#endif
+
     num_bytes = (uint32_t) count * 512;
 #if !MYNEWT_VAL(FATFS_HANDLE_BLOCK)
     /* NOTE: safe to assume sector size as 512 for now, see ffconf.h */
-    sector = (uint32_t) sector * 512;
+    addr = (uint32_t) sector * 512;
+#else
+    addr = sector;
 #endif
 
     dops = dops_from_handle(pdrv);
@@ -805,7 +1001,12 @@ disk_read(BYTE pdrv, BYTE* buff, DWORD sector, UINT count)
         return STA_NOINIT;
     }
 
-    rc = dops->read(pdrv, sector, (void *) buff, num_bytes);
+    rc = dops->read(pdrv, addr, (void *) buff, num_bytes);
+#if MYNEWT_VAL(FATFS_SECTOR_CACHE_SIZE) > 0
+    if (rc >= 0) {
+        fatfs_sector_cache_update(pdrv, buff, sector, count, true);
+    }
+#endif
     if (rc < 0) {
         return STA_NOINIT;
     }
@@ -818,11 +1019,14 @@ disk_write(BYTE pdrv, const BYTE* buff, DWORD sector, UINT count)
 {
     int rc;
     uint32_t num_bytes;
+    uint32_t addr;
     struct disk_ops *dops;
 
 #if !MYNEWT_VAL(FATFS_HANDLE_BLOCK)
     /* NOTE: safe to assume sector size as 512 for now, see ffconf.h */
-    sector = (uint32_t) sector * 512;
+    addr = (uint32_t) sector * 512;
+#else
+    addr = sector;
 #endif
 
     num_bytes = (uint32_t) count * 512;
@@ -832,7 +1036,10 @@ disk_write(BYTE pdrv, const BYTE* buff, DWORD sector, UINT count)
         return STA_NOINIT;
     }
 
-    rc = dops->write(pdrv, sector, (const void *) buff, num_bytes);
+    rc = dops->write(pdrv, addr, (const void *) buff, num_bytes);
+#if MYNEWT_VAL(FATFS_SECTOR_CACHE_SIZE) > 0
+    fatfs_sector_cache_update(pdrv, buff, sector, count, rc >= 0);
+#endif
     if (rc < 0) {
         return STA_NOINIT;
     }
@@ -866,5 +1073,9 @@ fatfs_pkg_init(void)
     /* Ensure this function only gets called by sysinit. */
     SYSINIT_ASSERT_ACTIVE();
 
+#if MYNEWT_VAL(FATFS_SECTOR_CACHE_SIZE) > 0
+    fatfs_sector_cache_init();
+#endif
+
     fs_register(&fatfs_ops);
 }
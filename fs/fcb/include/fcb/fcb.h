@@ -49,6 +49,26 @@ struct fcb_entry {
     uint16_t fe_data_len;	/* size of data area */
 };
 
+#if MYNEWT_VAL(FCB_SECTOR_INDEX)
+/**
+ * Location of one element, as kept in the RAM sector index.
+ */
+struct fcb_idx_entry {
+    uint32_t fie_elem_off;	/* start of entry */
+    uint16_t fie_data_len;	/* size of data area */
+    uint8_t fie_flags;		/* FCB_IDX_F_xxx */
+};
+
+/**
+ * State of the RAM index of one sector.
+ */
+struct fcb_sector_idx {
+    uint16_t fsi_cnt;		/* Number of entries in the index */
+    uint16_t fsi_last;		/* Entry returned by the last lookup */
+    uint8_t fsi_state;		/* FCB_IDX_xxx */
+};
+#endif
+
 struct fcb {
     /* Caller of fcb_init fills this in */
     uint32_t f_magic;		/* As placed on the disk */
@@ -56,6 +76,16 @@ struct fcb {
     uint8_t f_sector_cnt;	/* Number of elements in sector array */
     uint8_t f_scratch_cnt;	/* How many sectors should be kept empty */
     struct flash_area *f_sectors; /* Array of sectors, must be contiguous */
+#if MYNEWT_VAL(FCB_SECTOR_INDEX)
+    /*
+     * Optional RAM index of element locations.  Leave f_sidx NULL to not
+     * use one.  Otherwise f_sidx has f_sector_cnt elements, and
+     * f_idx_ents has f_idx_per_sector elements for every sector.
+     */
+    struct fcb_sector_idx *f_sidx;
+    struct fcb_idx_entry *f_idx_ents;
+    uint16_t f_idx_per_sector;
+#endif
 
     /* Flash circular buffer internal state */
     struct os_mutex f_mtx;	/* Locking for accessing the FCB data */
@@ -26,7 +26,7 @@
 #include "testutil/testutil.h"
 
 #include "fcb/fcb.h"
-#include "fcb_priv.h"
+#include "fcb/../../src/fcb_priv.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -47,6 +47,8 @@ uint8_t fcb_test_append_data(int msg_len, int off);
 int fcb_test_data_walk_cb(struct fcb_entry *loc, void *arg);
 int fcb_test_cnt_elems_cb(struct fcb_entry *loc, void *arg);
 
+TEST_SUITE_DECL(fcb_test_all);
+
 #ifdef __cplusplus
 }
 #endif
@@ -26,7 +26,7 @@
 #include "fcb/fcb.h"
 #include "fcb/../../src/fcb_priv.h"
 
-#include "fcb_test.h"
+#include "fcb_test/fcb_test.h"
 
 #include "flash_map/flash_map.h"
 
@@ -147,6 +147,7 @@ TEST_CASE_DECL(fcb_test_rotate)
 TEST_CASE_DECL(fcb_test_multiple_scratch)
 TEST_CASE_DECL(fcb_test_last_of_n)
 TEST_CASE_DECL(fcb_test_area_info)
+TEST_CASE_DECL(fcb_test_sector_idx)
 
 TEST_SUITE(fcb_test_all)
 {
@@ -161,11 +162,7 @@ TEST_SUITE(fcb_test_all)
     fcb_test_multiple_scratch();
     fcb_test_last_of_n();
     fcb_test_area_info();
-}
-
-int
-main(int argc, char **argv)
-{
-    fcb_test_all();
-    return tu_any_failed;
+#if MYNEWT_VAL(FCB_SECTOR_INDEX)
+    fcb_test_sector_idx();
+#endif
 }
@@ -0,0 +1,208 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "fcb_test/fcb_test.h"
+
+#if MYNEWT_VAL(FCB_SECTOR_INDEX)
+
+#define FCB_TEST_IDX_PER_SECTOR 256
+#define FCB_TEST_IDX_MAX        512
+
+static struct fcb_sector_idx fcb_test_sidx[4];
+static struct fcb_idx_entry fcb_test_idx_ents[4 * FCB_TEST_IDX_PER_SECTOR];
+
+static int
+fcb_test_idx_collect(struct fcb *fcb, struct fcb_entry *locs)
+{
+    struct fcb_entry loc;
+    int cnt;
+
+    memset(&loc, 0, sizeof(loc));
+    for (cnt = 0; fcb_getnext(fcb, &loc) == 0; cnt++) {
+        TEST_ASSERT_FATAL(cnt < FCB_TEST_IDX_MAX);
+        locs[cnt] = loc;
+    }
+    return cnt;
+}
+
+/*
+ * Walks the FCB with and without the index; both must give the same entries.
+ */
+static void
+fcb_test_idx_compare(struct fcb *fcb)
+{
+    static struct fcb_entry with[FCB_TEST_IDX_MAX];
+    static struct fcb_entry without[FCB_TEST_IDX_MAX];
+    struct fcb_sector_idx *sidx;
+    int cnt;
+    int i;
+
+    cnt = fcb_test_idx_collect(fcb, with);
+
+    sidx = fcb->f_sidx;
+    fcb->f_sidx = NULL;
+    TEST_ASSERT(fcb_test_idx_collect(fcb, without) == cnt);
+    fcb->f_sidx = sidx;
+
+    for (i = 0; i < cnt; i++) {
+        TEST_ASSERT(with[i].fe_area == without[i].fe_area);
+        TEST_ASSERT(with[i].fe_elem_off == without[i].fe_elem_off);
+        TEST_ASSERT(with[i].fe_data_off == without[i].fe_data_off);
+        TEST_ASSERT(with[i].fe_data_len == without[i].fe_data_len);
+    }
+}
+
+static void
+fcb_test_idx_append(struct fcb *fcb, int len, int finish,
+                    struct fcb_entry *out)
+{
+    struct fcb_entry loc;
+    uint8_t test_data[128];
+    int rc;
+    int i;
+
+    for (i = 0; i < len; i++) {
+        test_data[i] = fcb_test_append_data(len, i);
+    }
+    rc = fcb_append(fcb, len, &loc);
+    if (rc == FCB_ERR_NOSPACE) {
+        rc = fcb_rotate(fcb);
+        TEST_ASSERT_FATAL(rc == 0);
+        rc = fcb_append(fcb, len, &loc);
+    }
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = flash_area_write(loc.fe_area, loc.fe_data_off, test_data, len);
+    TEST_ASSERT(rc == 0);
+    if (finish) {
+        rc = fcb_append_finish(fcb, &loc);
+        TEST_ASSERT(rc == 0);
+    }
+    if (out) {
+        *out = loc;
+    }
+}
+
+/*
+ * Returns the index entry of the element at loc.
+ */
+static struct fcb_idx_entry *
+fcb_test_idx_find(struct fcb *fcb, const struct fcb_entry *loc)
+{
+    struct fcb_sector_idx *sidx;
+    struct fcb_idx_entry *ents;
+    int sector;
+    int i;
+
+    sector = loc->fe_area - fcb->f_sectors;
+    sidx = &fcb->f_sidx[sector];
+    ents = &fcb->f_idx_ents[sector * fcb->f_idx_per_sector];
+    for (i = 0; i < sidx->fsi_cnt; i++) {
+        if (ents[i].fie_elem_off == loc->fe_elem_off) {
+            return &ents[i];
+        }
+    }
+    TEST_ASSERT_FATAL(0);
+    return NULL;
+}
+
+TEST_CASE_SELF(fcb_test_sector_idx)
+{
+    struct fcb_idx_entry *ent;
+    struct flash_area *oldest;
+    struct fcb_entry loc;
+    struct fcb *fcb;
+    int var_cnt;
+    int rc;
+    int i;
+
+    fcb_tc_pretest(2);
+
+    fcb = &test_fcb;
+    fcb->f_sidx = fcb_test_sidx;
+    fcb->f_idx_ents = fcb_test_idx_ents;
+    fcb->f_idx_per_sector = FCB_TEST_IDX_PER_SECTOR;
+    rc = fcb_init(fcb);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /* Index is built by the first walk and maintained by appends. */
+    for (i = 1; i < 64; i++) {
+        fcb_test_idx_append(fcb, i, 1, NULL);
+    }
+    var_cnt = 1;
+    rc = fcb_walk(fcb, NULL, fcb_test_data_walk_cb, &var_cnt);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(var_cnt == 64);
+    TEST_ASSERT(fcb->f_sidx[0].fsi_state == FCB_IDX_VALID);
+    TEST_ASSERT(fcb->f_sidx[0].fsi_cnt == 63);
+
+    /* fcb_append_finish() checks the element in the index right away. */
+    fcb_test_idx_append(fcb, 64, 1, &loc);
+    ent = fcb_test_idx_find(fcb, &loc);
+    TEST_ASSERT(!(ent->fie_flags & FCB_IDX_F_PENDING));
+    for (i = 65; i < 128; i++) {
+        fcb_test_idx_append(fcb, i, 1, NULL);
+    }
+    var_cnt = 1;
+    rc = fcb_walk(fcb, NULL, fcb_test_data_walk_cb, &var_cnt);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(var_cnt == 128);
+
+    /* An unfinished entry is skipped until it is finished. */
+    fcb_test_idx_append(fcb, 100, 0, &loc);
+    fcb_test_idx_append(fcb, 10, 1, NULL);
+    fcb_test_idx_compare(fcb);
+    ent = fcb_test_idx_find(fcb, &loc);
+    TEST_ASSERT(ent->fie_flags & FCB_IDX_F_PENDING);
+    rc = fcb_append_finish(fcb, &loc);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(!(ent->fie_flags & FCB_IDX_F_PENDING));
+    fcb_test_idx_compare(fcb);
+
+    /* Rebuilt from flash after a restart. */
+    rc = fcb_init(fcb);
+    TEST_ASSERT_FATAL(rc == 0);
+    fcb_test_idx_compare(fcb);
+
+    /* Wrap around a few times. */
+    for (i = 0; i < 1000; i++) {
+        fcb_test_idx_append(fcb, 64 + i % 64, 1, NULL);
+        if (i % 97 == 0) {
+            fcb_test_idx_compare(fcb);
+        }
+    }
+    fcb_test_idx_compare(fcb);
+
+    /* Sectors with more entries than fit in the index are read from flash. */
+    fcb->f_idx_per_sector = 4;
+    rc = fcb_init(fcb);
+    TEST_ASSERT_FATAL(rc == 0);
+    fcb_test_idx_compare(fcb);
+    TEST_ASSERT(fcb->f_sidx[0].fsi_state == FCB_IDX_OVERFLOW);
+
+    /* fcb_rotate() empties the index of the erased sector. */
+    oldest = fcb->f_oldest;
+    TEST_ASSERT_FATAL(oldest != fcb->f_active.fe_area);
+    rc = fcb_rotate(fcb);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(fcb->f_sidx[oldest - fcb->f_sectors].fsi_state ==
+                FCB_IDX_VALID);
+    TEST_ASSERT(fcb->f_sidx[oldest - fcb->f_sectors].fsi_cnt == 0);
+    fcb_test_idx_compare(fcb);
+}
+
+#endif
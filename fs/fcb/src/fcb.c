@@ -82,6 +82,9 @@ fcb_init(struct fcb *fcb)
     fcb->f_active.fe_area = newest_fap;
     fcb->f_active.fe_elem_off = sizeof(struct fcb_disk_area);
     fcb->f_active_id = newest;
+#if MYNEWT_VAL(FCB_SECTOR_INDEX)
+    fcb_idx_init(fcb);
+#endif
 
     /* Require alignment to be a power of two.  Some code depends on this
      * assumption.
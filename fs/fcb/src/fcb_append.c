@@ -60,6 +60,9 @@ fcb_append_to_scratch(struct fcb *fcb)
     if (rc) {
         return rc;
     }
+#if MYNEWT_VAL(FCB_SECTOR_INDEX)
+    fcb_idx_reset(fcb, fa);
+#endif
     fcb->f_active.fe_area = fa;
     fcb->f_active.fe_elem_off = sizeof(struct fcb_disk_area);
     fcb->f_active_id++;
@@ -72,9 +75,15 @@ fcb_append(struct fcb *fcb, uint16_t len, struct fcb_entry *append_loc)
     struct fcb_entry *active;
     struct flash_area *fa;
     uint8_t tmp_str[2];
+#if MYNEWT_VAL(FCB_SECTOR_INDEX)
+    uint16_t data_len;
+#endif
     int cnt;
     int rc;
 
+#if MYNEWT_VAL(FCB_SECTOR_INDEX)
+    data_len = len;
+#endif
     cnt = fcb_put_len(tmp_str, len);
     if (cnt < 0) {
         return cnt;
@@ -98,6 +107,9 @@ fcb_append(struct fcb *fcb, uint16_t len, struct fcb_entry *append_loc)
         if (rc) {
             goto err;
         }
+#if MYNEWT_VAL(FCB_SECTOR_INDEX)
+        fcb_idx_reset(fcb, fa);
+#endif
         fcb->f_active.fe_area = fa;
         fcb->f_active.fe_elem_off = sizeof(struct fcb_disk_area);
         fcb->f_active_id++;
@@ -116,6 +128,10 @@ fcb_append(struct fcb *fcb, uint16_t len, struct fcb_entry *append_loc)
     active->fe_data_off = append_loc->fe_data_off;
     active->fe_data_len = len;
 
+#if MYNEWT_VAL(FCB_SECTOR_INDEX)
+    fcb_idx_append(fcb, append_loc, data_len);
+#endif
+
     os_mutex_release(&fcb->f_mtx);
 
     return FCB_OK;
@@ -141,5 +157,8 @@ fcb_append_finish(struct fcb *fcb, struct fcb_entry *loc)
     if (rc) {
         return FCB_ERR_FLASH;
     }
+#if MYNEWT_VAL(FCB_SECTOR_INDEX)
+    fcb_idx_append_finish(fcb, loc);
+#endif
     return 0;
 }
@@ -62,6 +62,14 @@ fcb_getnext_nolock(struct fcb *fcb, struct fcb_entry *loc)
          */
         loc->fe_area = fcb->f_oldest;
     }
+#if MYNEWT_VAL(FCB_SECTOR_INDEX)
+    if (fcb->f_sidx) {
+        rc = fcb_idx_getnext(fcb, loc);
+        if (rc != FCB_IDX_MISS) {
+            return rc;
+        }
+    }
+#endif
     if (loc->fe_elem_off == 0) {
         /*
          * If offset is zero, we serve the first entry from the area.
@@ -58,6 +58,25 @@ int fcb_sector_hdr_init(struct fcb *, struct flash_area *fap, uint16_t id);
 int fcb_sector_hdr_read(struct fcb *, struct flash_area *fap,
   struct fcb_disk_area *fdap);
 
+#if MYNEWT_VAL(FCB_SECTOR_INDEX)
+/* fsi_state */
+#define FCB_IDX_NONE		0 /* Not built; scan the sector on first use */
+#define FCB_IDX_VALID		1 /* Lists every element in the sector */
+#define FCB_IDX_OVERFLOW	2 /* Sector has too many elements to index */
+
+/* fie_flags */
+#define FCB_IDX_F_PENDING	0x01 /* CRC of the element not checked yet */
+
+/* fcb_idx_getnext() return value when the index cannot answer. */
+#define FCB_IDX_MISS		1
+
+void fcb_idx_init(struct fcb *fcb);
+void fcb_idx_reset(struct fcb *fcb, struct flash_area *fap);
+void fcb_idx_append(struct fcb *fcb, struct fcb_entry *loc, uint16_t data_len);
+void fcb_idx_append_finish(struct fcb *fcb, struct fcb_entry *loc);
+int fcb_idx_getnext(struct fcb *fcb, struct fcb_entry *loc);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
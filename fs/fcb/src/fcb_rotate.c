@@ -36,6 +36,9 @@ fcb_rotate(struct fcb *fcb)
         rc = FCB_ERR_FLASH;
         goto out;
     }
+#if MYNEWT_VAL(FCB_SECTOR_INDEX)
+    fcb_idx_reset(fcb, fcb->f_oldest);
+#endif
     if (fcb->f_oldest == fcb->f_active.fe_area) {
         /*
          * Need to create a new active area, as we're wiping the current.
@@ -45,6 +48,9 @@ fcb_rotate(struct fcb *fcb)
         if (rc) {
             goto out;
         }
+#if MYNEWT_VAL(FCB_SECTOR_INDEX)
+        fcb_idx_reset(fcb, fap);
+#endif
         fcb->f_active.fe_area = fap;
         fcb->f_active.fe_elem_off = sizeof(struct fcb_disk_area);
         fcb->f_active_id++;
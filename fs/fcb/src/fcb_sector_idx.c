@@ -0,0 +1,295 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "fcb/fcb.h"
+#include "fcb_priv.h"
+
+#if MYNEWT_VAL(FCB_SECTOR_INDEX)
+
+static struct fcb_sector_idx *
+fcb_idx_sector(struct fcb *fcb, struct flash_area *fap)
+{
+    return &fcb->f_sidx[fap - fcb->f_sectors];
+}
+
+static struct fcb_idx_entry *
+fcb_idx_entries(struct fcb *fcb, struct flash_area *fap)
+{
+    return &fcb->f_idx_ents[(fap - fcb->f_sectors) * fcb->f_idx_per_sector];
+}
+
+/*
+ * Adds an element to the end of the index of a sector.  Returns 0 on
+ * success, FCB_ERR_NOMEM if the sector has too many elements.
+ */
+static int
+fcb_idx_push(struct fcb *fcb, struct flash_area *fap, uint32_t elem_off,
+  uint16_t data_len, uint8_t flags)
+{
+    struct fcb_sector_idx *sidx;
+    struct fcb_idx_entry *ent;
+
+    sidx = fcb_idx_sector(fcb, fap);
+    if (sidx->fsi_cnt >= fcb->f_idx_per_sector) {
+        sidx->fsi_state = FCB_IDX_OVERFLOW;
+        return FCB_ERR_NOMEM;
+    }
+    ent = &fcb_idx_entries(fcb, fap)[sidx->fsi_cnt++];
+    ent->fie_elem_off = elem_off;
+    ent->fie_data_len = data_len;
+    ent->fie_flags = flags;
+    return 0;
+}
+
+/*
+ * Scans a sector in flash and records every element in it.  Elements with a
+ * bad CRC are left out, except in the active sector, where they may still
+ * be in the middle of being written.
+ */
+static void
+fcb_idx_build(struct fcb *fcb, struct flash_area *fap)
+{
+    struct fcb_sector_idx *sidx;
+    struct fcb_entry loc;
+    uint8_t flags;
+    int rc;
+
+    sidx = fcb_idx_sector(fcb, fap);
+    sidx->fsi_cnt = 0;
+    sidx->fsi_last = 0;
+
+    loc.fe_area = fap;
+    loc.fe_elem_off = sizeof(struct fcb_disk_area);
+    while (1) {
+        rc = fcb_elem_info(fcb, &loc);
+        if (rc == 0 || rc == FCB_ERR_CRC) {
+            if (rc == 0 || fap == fcb->f_active.fe_area) {
+                flags = rc ? FCB_IDX_F_PENDING : 0;
+                if (fcb_idx_push(fcb, fap, loc.fe_elem_off, loc.fe_data_len,
+                                 flags)) {
+                    return;
+                }
+            }
+            loc.fe_elem_off = loc.fe_data_off +
+              fcb_len_in_flash(fcb, loc.fe_data_len) +
+              fcb_len_in_flash(fcb, FCB_CRC_SZ);
+        } else if (rc == FCB_ERR_NOVAR) {
+            break;
+        } else {
+            /* Flash error; try again next time. */
+            sidx->fsi_state = FCB_IDX_NONE;
+            return;
+        }
+    }
+    sidx->fsi_state = FCB_IDX_VALID;
+}
+
+/*
+ * Returns the position of the first element in the index of a sector which
+ * starts after elem_off.
+ */
+static int
+fcb_idx_find_next(struct fcb_sector_idx *sidx, struct fcb_idx_entry *ents,
+  uint32_t elem_off)
+{
+    int lo;
+    int hi;
+    int mid;
+
+    if (elem_off == 0) {
+        return 0;
+    }
+
+    /* Sequential walks continue from the previous lookup. */
+    if (sidx->fsi_last < sidx->fsi_cnt &&
+      ents[sidx->fsi_last].fie_elem_off == elem_off) {
+        return sidx->fsi_last + 1;
+    }
+
+    lo = 0;
+    hi = sidx->fsi_cnt;
+    while (lo < hi) {
+        mid = (lo + hi) / 2;
+        if (ents[mid].fie_elem_off <= elem_off) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+void
+fcb_idx_init(struct fcb *fcb)
+{
+    int i;
+
+    if (!fcb->f_sidx) {
+        return;
+    }
+    for (i = 0; i < fcb->f_sector_cnt; i++) {
+        fcb->f_sidx[i].fsi_state = FCB_IDX_NONE;
+        fcb->f_sidx[i].fsi_cnt = 0;
+        fcb->f_sidx[i].fsi_last = 0;
+    }
+}
+
+/*
+ * Sector was erased, or is about to be taken into use.
+ */
+void
+fcb_idx_reset(struct fcb *fcb, struct flash_area *fap)
+{
+    struct fcb_sector_idx *sidx;
+
+    if (!fcb->f_sidx) {
+        return;
+    }
+    sidx = fcb_idx_sector(fcb, fap);
+    sidx->fsi_state = FCB_IDX_VALID;
+    sidx->fsi_cnt = 0;
+    sidx->fsi_last = 0;
+}
+
+/*
+ * Space for an element was reserved by fcb_append().  Called with the FCB
+ * locked.
+ */
+void
+fcb_idx_append(struct fcb *fcb, struct fcb_entry *loc, uint16_t data_len)
+{
+    struct fcb_sector_idx *sidx;
+    struct fcb_idx_entry *ents;
+
+    if (!fcb->f_sidx) {
+        return;
+    }
+    sidx = fcb_idx_sector(fcb, loc->fe_area);
+    if (sidx->fsi_state != FCB_IDX_VALID) {
+        /* Element is picked up when the sector gets scanned. */
+        return;
+    }
+    ents = fcb_idx_entries(fcb, loc->fe_area);
+    if (sidx->fsi_cnt > 0 &&
+      ents[sidx->fsi_cnt - 1].fie_elem_off >= loc->fe_elem_off) {
+        /* Out of order; should not happen.  Rescan. */
+        sidx->fsi_state = FCB_IDX_NONE;
+        return;
+    }
+    fcb_idx_push(fcb, loc->fe_area, loc->fe_elem_off, data_len,
+                 FCB_IDX_F_PENDING);
+}
+
+/*
+ * Element was completed with fcb_append_finish().
+ */
+void
+fcb_idx_append_finish(struct fcb *fcb, struct fcb_entry *loc)
+{
+    struct fcb_sector_idx *sidx;
+    struct fcb_idx_entry *ents;
+    int pos;
+    int rc;
+
+    if (!fcb->f_sidx) {
+        return;
+    }
+    rc = os_mutex_pend(&fcb->f_mtx, OS_WAIT_FOREVER);
+    if (rc && rc != OS_NOT_STARTED) {
+        return;
+    }
+    sidx = fcb_idx_sector(fcb, loc->fe_area);
+    if (sidx->fsi_state == FCB_IDX_VALID) {
+        ents = fcb_idx_entries(fcb, loc->fe_area);
+
+        /* Usually the element appended last. */
+        pos = sidx->fsi_cnt - 1;
+        if (pos < 0 || ents[pos].fie_elem_off != loc->fe_elem_off) {
+            pos = fcb_idx_find_next(sidx, ents, loc->fe_elem_off - 1);
+        }
+        if (pos < sidx->fsi_cnt && ents[pos].fie_elem_off == loc->fe_elem_off) {
+            ents[pos].fie_flags &= ~FCB_IDX_F_PENDING;
+        }
+    }
+    os_mutex_release(&fcb->f_mtx);
+}
+
+/*
+ * Finds the element following loc using the index.  Called with the FCB
+ * locked.  Returns FCB_IDX_MISS if the sector holding the next element is
+ * not indexed; loc is then updated so that the caller can continue from
+ * flash.
+ */
+int
+fcb_idx_getnext(struct fcb *fcb, struct fcb_entry *loc)
+{
+    struct fcb_sector_idx *sidx;
+    struct fcb_idx_entry *ents;
+    struct fcb_idx_entry *ent;
+    struct flash_area *fap;
+    struct fcb_entry tmp;
+    uint32_t elem_off;
+    int pos;
+
+    fap = loc->fe_area;
+    elem_off = loc->fe_elem_off;
+    while (1) {
+        sidx = fcb_idx_sector(fcb, fap);
+        if (sidx->fsi_state == FCB_IDX_NONE) {
+            fcb_idx_build(fcb, fap);
+        }
+        if (sidx->fsi_state != FCB_IDX_VALID) {
+            if (fap != loc->fe_area) {
+                loc->fe_area = fap;
+                loc->fe_elem_off = 0;
+            }
+            return FCB_IDX_MISS;
+        }
+
+        ents = fcb_idx_entries(fcb, fap);
+        for (pos = fcb_idx_find_next(sidx, ents, elem_off);
+             pos < sidx->fsi_cnt; pos++) {
+            ent = &ents[pos];
+            if (ent->fie_flags & FCB_IDX_F_PENDING) {
+                tmp.fe_area = fap;
+                tmp.fe_elem_off = ent->fie_elem_off;
+                if (fcb_elem_info(fcb, &tmp)) {
+                    /* Not finished (yet). */
+                    continue;
+                }
+                ent->fie_flags &= ~FCB_IDX_F_PENDING;
+            }
+            sidx->fsi_last = pos;
+            loc->fe_area = fap;
+            loc->fe_elem_off = ent->fie_elem_off;
+            loc->fe_data_off = ent->fie_elem_off +
+              fcb_len_in_flash(fcb, ent->fie_data_len < 0x80 ? 1 : 2);
+            loc->fe_data_len = ent->fie_data_len;
+            return 0;
+        }
+
+        if (fap == fcb->f_active.fe_area) {
+            return FCB_ERR_NOVAR;
+        }
+        fap = fcb_getnext_area(fcb, fap);
+        elem_off = 0;
+    }
+}
+
+#endif
@@ -53,6 +53,27 @@ struct fcb2_entry {
     uint16_t fe_entry_num;  /* entry number in sector */
 };
 
+#if MYNEWT_VAL(FCB2_SECTOR_INDEX)
+/**
+ * Location of one entry, as kept in the RAM sector index.
+ */
+struct fcb2_idx_entry {
+    uint32_t fie_data_off;  /* start of data in sector */
+    uint16_t fie_data_len;  /* size of data area */
+    uint16_t fie_entry_num; /* entry number in sector */
+    uint8_t fie_flags;      /* FCB2_IDX_F_xxx */
+};
+
+/**
+ * State of the RAM index of one sector.
+ */
+struct fcb2_sector_idx {
+    uint16_t fsi_cnt;       /* Number of entries in the index */
+    uint16_t fsi_last;      /* Entry returned by the last lookup */
+    uint8_t fsi_state;      /* FCB2_IDX_xxx */
+};
+#endif
+
 /* Number of bytes needed for fcb_sector_entry on flash */
 #define FCB2_ENTRY_SIZE          6
 #define FCB2_CRC_LEN             2
@@ -69,6 +90,16 @@ struct fcb2 {
     uint16_t f_sector_cnt;  /* Number of sectors used by fcb */
     uint16_t f_oldest_sec;  /* Index of oldest sector */
     struct flash_sector_range *f_ranges;
+#if MYNEWT_VAL(FCB2_SECTOR_INDEX)
+    /*
+     * Optional RAM index of entry locations.  Leave f_sidx NULL to not
+     * use one.  Otherwise f_sidx has f_sector_cnt elements, and
+     * f_idx_ents has f_idx_per_sector elements for every sector.
+     */
+    struct fcb2_sector_idx *f_sidx;
+    struct fcb2_idx_entry *f_idx_ents;
+    uint16_t f_idx_per_sector;
+#endif
 
     /* Flash circular buffer internal state */
     struct os_mutex f_mtx;	/* Locking for accessing the FCB data */
@@ -26,7 +26,7 @@
 #include "testutil/testutil.h"
 
 #include "fcb/fcb2.h"
-#include "fcb_priv.h"
+#include "fcb/../../src/fcb_priv.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -47,6 +47,8 @@ int fcb_test_data_walk_cb(struct fcb2_entry *loc, void *arg);
 int fcb_test_cnt_elems_cb(struct fcb2_entry *loc, void *arg);
 void fcb_tc_pretest(uint8_t sector_count);
 
+TEST_SUITE_DECL(fcb_test_all);
+
 #ifdef __cplusplus
 }
 #endif
@@ -24,9 +24,9 @@
 #include "testutil/testutil.h"
 
 #include "fcb/fcb2.h"
-#include "fcb_priv.h"
+#include "fcb/../../src/fcb_priv.h"
 
-#include "fcb_test.h"
+#include "fcb2_test/fcb_test.h"
 
 #include "flash_map/flash_map.h"
 
@@ -142,6 +142,7 @@ TEST_CASE_DECL(fcb_test_multiple_scratch)
 TEST_CASE_DECL(fcb_test_last_of_n)
 TEST_CASE_DECL(fcb_test_area_info)
 TEST_CASE_DECL(fcb_test_getprev)
+TEST_CASE_DECL(fcb_test_sector_idx)
 
 TEST_SUITE(fcb_test_all)
 {
@@ -156,11 +157,7 @@ TEST_SUITE(fcb_test_all)
     fcb_test_last_of_n();
     fcb_test_area_info();
     fcb_test_getprev();
-}
-
-int
-main(int argc, char **argv)
-{
-    fcb_test_all();
-    return tu_any_failed;
+#if MYNEWT_VAL(FCB2_SECTOR_INDEX)
+    fcb_test_sector_idx();
+#endif
 }
@@ -0,0 +1,207 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "fcb2_test/fcb_test.h"
+
+#if MYNEWT_VAL(FCB2_SECTOR_INDEX)
+
+#define FCB_TEST_IDX_PER_SECTOR 64
+#define FCB_TEST_IDX_MAX        512
+
+static struct fcb2_sector_idx fcb_test_sidx[4];
+static struct fcb2_idx_entry fcb_test_idx_ents[4 * FCB_TEST_IDX_PER_SECTOR];
+
+static int
+fcb_test_idx_collect(struct fcb2 *fcb, struct fcb2_entry *locs)
+{
+    struct fcb2_entry loc;
+    int cnt;
+
+    memset(&loc, 0, sizeof(loc));
+    for (cnt = 0; fcb2_getnext(fcb, &loc) == 0; cnt++) {
+        TEST_ASSERT_FATAL(cnt < FCB_TEST_IDX_MAX);
+        locs[cnt] = loc;
+    }
+    return cnt;
+}
+
+/*
+ * Walks the FCB with and without the index; both must give the same entries.
+ */
+static void
+fcb_test_idx_compare(struct fcb2 *fcb)
+{
+    static struct fcb2_entry with[FCB_TEST_IDX_MAX];
+    static struct fcb2_entry without[FCB_TEST_IDX_MAX];
+    struct fcb2_sector_idx *sidx;
+    int cnt;
+    int i;
+
+    cnt = fcb_test_idx_collect(fcb, with);
+
+    sidx = fcb->f_sidx;
+    fcb->f_sidx = NULL;
+    TEST_ASSERT(fcb_test_idx_collect(fcb, without) == cnt);
+    fcb->f_sidx = sidx;
+
+    for (i = 0; i < cnt; i++) {
+        TEST_ASSERT(with[i].fe_sector == without[i].fe_sector);
+        TEST_ASSERT(with[i].fe_entry_num == without[i].fe_entry_num);
+        TEST_ASSERT(with[i].fe_data_off == without[i].fe_data_off);
+        TEST_ASSERT(with[i].fe_data_len == without[i].fe_data_len);
+    }
+}
+
+static void
+fcb_test_idx_append(struct fcb2 *fcb, int len, int finish)
+{
+    struct fcb2_entry loc;
+    uint8_t test_data[128];
+    int rc;
+    int i;
+
+    for (i = 0; i < len; i++) {
+        test_data[i] = fcb_test_append_data(len, i);
+    }
+    rc = fcb2_append(fcb, len, &loc);
+    if (rc == FCB2_ERR_NOSPACE) {
+        rc = fcb2_rotate(fcb);
+        TEST_ASSERT_FATAL(rc == 0);
+        rc = fcb2_append(fcb, len, &loc);
+    }
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = fcb2_write(&loc, 0, test_data, len);
+    TEST_ASSERT(rc == 0);
+    if (finish) {
+        rc = fcb2_append_finish(&loc);
+        TEST_ASSERT(rc == 0);
+    }
+}
+
+/*
+ * Returns the index entry of the entry appended last.
+ */
+static struct fcb2_idx_entry *
+fcb_test_idx_last(struct fcb2 *fcb)
+{
+    int sector;
+
+    sector = fcb->f_active.fe_sector;
+    TEST_ASSERT_FATAL(fcb->f_sidx[sector].fsi_cnt > 0);
+    return &fcb->f_idx_ents[sector * fcb->f_idx_per_sector +
+                            fcb->f_sidx[sector].fsi_cnt - 1];
+}
+
+TEST_CASE_SELF(fcb_test_sector_idx)
+{
+    struct fcb2 *fcb;
+    int var_cnt;
+    int sector;
+    int rc;
+    int i;
+
+    fcb_tc_pretest(2);
+
+    fcb = &test_fcb;
+    fcb->f_sidx = fcb_test_sidx;
+    fcb->f_idx_ents = fcb_test_idx_ents;
+    fcb->f_idx_per_sector = FCB_TEST_IDX_PER_SECTOR;
+    rc = fcb2_init(fcb);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /* Index is built by the first walk and maintained by appends. */
+    for (i = 1; i < 64; i++) {
+        fcb_test_idx_append(fcb, i, 1);
+    }
+    var_cnt = 1;
+    rc = fcb2_walk(fcb, 0, fcb_test_data_walk_cb, &var_cnt);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(var_cnt == 64);
+    TEST_ASSERT(fcb->f_sidx[0].fsi_state == FCB2_IDX_VALID);
+    TEST_ASSERT(fcb->f_sidx[0].fsi_cnt == 63);
+
+    /*
+     * fcb2_append_finish() has no handle to the FCB; entries stay pending
+     * until a walk checks their CRC.
+     */
+    fcb_test_idx_append(fcb, 64, 1);
+    TEST_ASSERT(fcb_test_idx_last(fcb)->fie_flags & FCB2_IDX_F_PENDING);
+    var_cnt = 1;
+    rc = fcb2_walk(fcb, 0, fcb_test_data_walk_cb, &var_cnt);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(var_cnt == 65);
+    TEST_ASSERT(!(fcb_test_idx_last(fcb)->fie_flags & FCB2_IDX_F_PENDING));
+
+    for (i = 65; i < 128; i++) {
+        fcb_test_idx_append(fcb, i, 1);
+    }
+    var_cnt = 1;
+    rc = fcb2_walk(fcb, FCB2_SECTOR_OLDEST, fcb_test_data_walk_cb, &var_cnt);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(var_cnt == 128);
+
+    /* An unfinished entry is skipped until it is finished. */
+    fcb_test_idx_append(fcb, 100, 0);
+    fcb_test_idx_append(fcb, 10, 1);
+    fcb_test_idx_compare(fcb);
+
+    /* Rebuilt from flash after a restart. */
+    rc = fcb2_init(fcb);
+    TEST_ASSERT_FATAL(rc == 0);
+    fcb_test_idx_compare(fcb);
+
+    /* Wrap around a few times. */
+    for (i = 0; i < 1000; i++) {
+        fcb_test_idx_append(fcb, 64 + i % 64, 1);
+        if (i % 97 == 0) {
+            fcb_test_idx_compare(fcb);
+        }
+    }
+    fcb_test_idx_compare(fcb);
+
+    /* Sectors with more entries than fit in the index are read from flash. */
+    fcb->f_idx_per_sector = 4;
+    rc = fcb2_init(fcb);
+    TEST_ASSERT_FATAL(rc == 0);
+    fcb_test_idx_compare(fcb);
+    TEST_ASSERT(fcb->f_sidx[0].fsi_state == FCB2_IDX_OVERFLOW);
+
+    /* fcb2_sector_erase() empties the index of the sector. */
+    fcb_tc_pretest(2);
+    fcb->f_sidx = fcb_test_sidx;
+    fcb->f_idx_ents = fcb_test_idx_ents;
+    fcb->f_idx_per_sector = 2 * FCB_TEST_IDX_PER_SECTOR;
+    rc = fcb2_init(fcb);
+    TEST_ASSERT_FATAL(rc == 0);
+    while (fcb->f_active.fe_sector == 0) {
+        fcb_test_idx_append(fcb, 127, 1);
+    }
+    fcb_test_idx_compare(fcb);
+    sector = fcb->f_oldest_sec;
+    TEST_ASSERT_FATAL(sector != fcb->f_active.fe_sector);
+    TEST_ASSERT(fcb->f_sidx[sector].fsi_state == FCB2_IDX_VALID);
+    TEST_ASSERT(fcb->f_sidx[sector].fsi_cnt > 0);
+
+    rc = fcb2_sector_erase(fcb, sector);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(fcb->f_sidx[sector].fsi_state == FCB2_IDX_VALID);
+    TEST_ASSERT(fcb->f_sidx[sector].fsi_cnt == 0);
+    fcb_test_idx_compare(fcb);
+}
+
+#endif
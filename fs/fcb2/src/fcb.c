@@ -86,6 +86,9 @@ fcb2_init(struct fcb2 *fcb)
         fcb2_len_in_flash(newest_srp, sizeof(struct fcb2_disk_area));
     fcb->f_active.fe_entry_num = 0;
     fcb->f_active_id = newest;
+#if MYNEWT_VAL(FCB2_SECTOR_INDEX)
+    fcb2_idx_init(fcb);
+#endif
 
     while (1) {
         rc = fcb2_getnext_in_area(fcb, &fcb->f_active);
@@ -363,6 +366,11 @@ fcb2_sector_erase(const struct fcb2 *fcb, int sector)
     rc = flash_area_erase(&info.si_range->fsr_flash_area,
         info.si_sector_in_range * info.si_range->fsr_sector_size,
         info.si_range->fsr_sector_size);
+#if MYNEWT_VAL(FCB2_SECTOR_INDEX)
+    if (rc == 0) {
+        fcb2_idx_reset(fcb, sector);
+    }
+#endif
 end:
     return rc;
 }
@@ -61,6 +61,9 @@ fcb2_append_to_scratch(struct fcb2 *fcb)
     if (rc) {
         return rc;
     }
+#if MYNEWT_VAL(FCB2_SECTOR_INDEX)
+    fcb2_idx_reset(fcb, sector);
+#endif
     range = fcb2_get_sector_range(fcb, sector);
     fcb->f_active.fe_range = range;
     fcb->f_active.fe_sector = sector;
@@ -71,13 +74,6 @@ fcb2_append_to_scratch(struct fcb2 *fcb)
     return FCB2_OK;
 }
 
-static inline int
-fcb2_sector_flash_offset(const struct fcb2_entry *loc)
-{
-    return (loc->fe_sector - loc->fe_range->fsr_first_sector) *
-        loc->fe_range->fsr_sector_size;
-}
-
 int
 fcb2_write_to_sector(struct fcb2_entry *loc, int off, const void *buf, int len)
 {
@@ -194,6 +190,9 @@ fcb2_append(struct fcb2 *fcb, uint16_t len, struct fcb2_entry *append_loc)
         if (rc) {
             goto err;
         }
+#if MYNEWT_VAL(FCB2_SECTOR_INDEX)
+        fcb2_idx_reset(fcb, sector);
+#endif
         fcb->f_active.fe_range = range;
         fcb->f_active.fe_sector = sector;
         /* Start with offset just after sector header */
@@ -225,6 +224,9 @@ fcb2_append(struct fcb2 *fcb, uint16_t len, struct fcb2_entry *append_loc)
     *append_loc = *active;
     /* Active element had everything ready except lenght */
     append_loc->fe_data_len = len;
+#if MYNEWT_VAL(FCB2_SECTOR_INDEX)
+    fcb2_idx_append(fcb, append_loc);
+#endif
 
     /* Prepare active element num and offset for new append */
     active->fe_data_off += fcb2_element_length_in_flash(active, len);
@@ -69,6 +69,12 @@ fcb2_read_entry(struct fcb2_entry *loc)
 
     assert(loc != NULL);
     entry_offset = fcb2_entry_location_in_range(loc);
+    /* Entry descriptors cannot extend into the sector header; past that
+     * point the descriptors of the preceding sector would be read. */
+    if ((int)entry_offset < fcb2_sector_flash_offset(loc) +
+        fcb2_len_in_flash(loc->fe_range, sizeof(struct fcb2_disk_area))) {
+        return FCB2_ERR_NOVAR;
+    }
     rc = flash_area_read_is_empty(&loc->fe_range->fsr_flash_area,
         entry_offset, buf, sizeof(buf));
     if (rc < 0) {
@@ -54,6 +54,14 @@ fcb2_getnext_nolock(struct fcb2 *fcb, struct fcb2_entry *loc)
         loc->fe_sector = fcb->f_oldest_sec;
         loc->fe_range = fcb2_get_sector_range(fcb, loc->fe_sector);
     }
+#if MYNEWT_VAL(FCB2_SECTOR_INDEX)
+    if (fcb->f_sidx) {
+        rc = fcb2_idx_getnext(fcb, loc);
+        if (rc != FCB2_IDX_MISS) {
+            return rc;
+        }
+    }
+#endif
     if (loc->fe_entry_num == 0) {
         /*
          * If offset is zero, we serve the first entry from the area.
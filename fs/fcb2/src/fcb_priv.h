@@ -49,6 +49,14 @@ fcb2_len_in_flash(const struct flash_sector_range *range, uint16_t len)
     return (len + (range->fsr_align - 1)) & ~(range->fsr_align - 1);
 }
 
+/* Offset of the sector of loc within its range. */
+static inline int
+fcb2_sector_flash_offset(const struct fcb2_entry *loc)
+{
+    return (loc->fe_sector - loc->fe_range->fsr_first_sector) *
+        loc->fe_range->fsr_sector_size;
+}
+
 int fcb2_getnext_in_area(struct fcb2 *fcb, struct fcb2_entry *loc);
 
 static inline int
@@ -73,6 +81,24 @@ struct flash_sector_range *fcb2_get_sector_range(const struct fcb2 *fcb,
 int fcb2_sector_hdr_read(struct fcb2 *, struct flash_sector_range *srp,
                          uint16_t sec, struct fcb2_disk_area *fdap);
 
+#if MYNEWT_VAL(FCB2_SECTOR_INDEX)
+/* fsi_state */
+#define FCB2_IDX_NONE       0 /* Not built; scan the sector on first use */
+#define FCB2_IDX_VALID      1 /* Lists every entry in the sector */
+#define FCB2_IDX_OVERFLOW   2 /* Sector has too many entries to index */
+
+/* fie_flags */
+#define FCB2_IDX_F_PENDING  0x01 /* CRC of the entry not checked yet */
+
+/* fcb2_idx_getnext() return value when the index cannot answer. */
+#define FCB2_IDX_MISS       1
+
+void fcb2_idx_init(struct fcb2 *fcb);
+void fcb2_idx_reset(const struct fcb2 *fcb, int sector);
+void fcb2_idx_append(struct fcb2 *fcb, const struct fcb2_entry *loc);
+int fcb2_idx_getnext(struct fcb2 *fcb, struct fcb2_entry *loc);
+#endif
+
 /**
  * Finds sector range for given fcb sector.
  */
@@ -47,6 +47,9 @@ fcb2_rotate(struct fcb2 *fcb)
         if (rc) {
             goto out;
         }
+#if MYNEWT_VAL(FCB2_SECTOR_INDEX)
+        fcb2_idx_reset(fcb, sector);
+#endif
         range = fcb2_get_sector_range(fcb, sector);
         fcb->f_active.fe_sector = sector;
         fcb->f_active.fe_range = range;
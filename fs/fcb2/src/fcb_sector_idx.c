@@ -0,0 +1,251 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "fcb/fcb2.h"
+#include "fcb_priv.h"
+
+#if MYNEWT_VAL(FCB2_SECTOR_INDEX)
+
+static struct fcb2_idx_entry *
+fcb2_idx_entries(struct fcb2 *fcb, int sector)
+{
+    return &fcb->f_idx_ents[sector * fcb->f_idx_per_sector];
+}
+
+/*
+ * Adds an entry to the end of the index of a sector.  Returns 0 on success,
+ * FCB2_ERR_NOMEM if the sector has too many entries.
+ */
+static int
+fcb2_idx_push(struct fcb2 *fcb, const struct fcb2_entry *loc, uint8_t flags)
+{
+    struct fcb2_sector_idx *sidx;
+    struct fcb2_idx_entry *ent;
+
+    sidx = &fcb->f_sidx[loc->fe_sector];
+    if (sidx->fsi_cnt >= fcb->f_idx_per_sector) {
+        sidx->fsi_state = FCB2_IDX_OVERFLOW;
+        return FCB2_ERR_NOMEM;
+    }
+    ent = &fcb2_idx_entries(fcb, loc->fe_sector)[sidx->fsi_cnt++];
+    ent->fie_data_off = loc->fe_data_off;
+    ent->fie_data_len = loc->fe_data_len;
+    ent->fie_entry_num = loc->fe_entry_num;
+    ent->fie_flags = flags;
+    return 0;
+}
+
+/*
+ * Scans a sector in flash and records every entry in it.  Entries with a
+ * bad CRC are left out, except in the active sector, where they may still
+ * be in the middle of being written.
+ */
+static void
+fcb2_idx_build(struct fcb2 *fcb, int sector)
+{
+    struct fcb2_sector_idx *sidx;
+    struct fcb2_entry loc;
+    int rc;
+
+    sidx = &fcb->f_sidx[sector];
+    sidx->fsi_cnt = 0;
+    sidx->fsi_last = 0;
+
+    loc.fe_sector = sector;
+    loc.fe_range = fcb2_get_sector_range(fcb, sector);
+    for (loc.fe_entry_num = 1; ; loc.fe_entry_num++) {
+        rc = fcb2_elem_info(&loc);
+        if (rc == 0) {
+            if (fcb2_idx_push(fcb, &loc, 0)) {
+                return;
+            }
+        } else if (rc == FCB2_ERR_CRC) {
+            if (sector == fcb->f_active.fe_sector &&
+                fcb2_idx_push(fcb, &loc, FCB2_IDX_F_PENDING)) {
+                return;
+            }
+        } else {
+            /* Out of entries; like fcb2_getnext(), a read error also ends
+             * the sector. */
+            break;
+        }
+    }
+    sidx->fsi_state = FCB2_IDX_VALID;
+}
+
+/*
+ * Returns the position of the first entry in the index of a sector whose
+ * entry number is greater than entry_num.
+ */
+static int
+fcb2_idx_find_next(struct fcb2_sector_idx *sidx,
+                   const struct fcb2_idx_entry *ents, uint16_t entry_num)
+{
+    int lo;
+    int hi;
+    int mid;
+
+    if (entry_num == 0) {
+        return 0;
+    }
+
+    /* Sequential walks continue from the previous lookup. */
+    if (sidx->fsi_last < sidx->fsi_cnt &&
+        ents[sidx->fsi_last].fie_entry_num == entry_num) {
+        return sidx->fsi_last + 1;
+    }
+
+    lo = 0;
+    hi = sidx->fsi_cnt;
+    while (lo < hi) {
+        mid = (lo + hi) / 2;
+        if (ents[mid].fie_entry_num <= entry_num) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+void
+fcb2_idx_init(struct fcb2 *fcb)
+{
+    int i;
+
+    if (!fcb->f_sidx) {
+        return;
+    }
+    for (i = 0; i < fcb->f_sector_cnt; i++) {
+        fcb->f_sidx[i].fsi_state = FCB2_IDX_NONE;
+        fcb->f_sidx[i].fsi_cnt = 0;
+        fcb->f_sidx[i].fsi_last = 0;
+    }
+}
+
+/*
+ * Sector was erased, or is about to be taken into use.
+ */
+void
+fcb2_idx_reset(const struct fcb2 *fcb, int sector)
+{
+    if (!fcb->f_sidx) {
+        return;
+    }
+    fcb->f_sidx[sector].fsi_state = FCB2_IDX_VALID;
+    fcb->f_sidx[sector].fsi_cnt = 0;
+    fcb->f_sidx[sector].fsi_last = 0;
+}
+
+/*
+ * Space for an entry was reserved by fcb2_append().  Called with the FCB
+ * locked.  fcb2_append_finish() has no handle to the FCB, so the entry is
+ * marked pending and its CRC is checked the first time it is walked over.
+ */
+void
+fcb2_idx_append(struct fcb2 *fcb, const struct fcb2_entry *loc)
+{
+    struct fcb2_sector_idx *sidx;
+    struct fcb2_idx_entry *ents;
+
+    if (!fcb->f_sidx) {
+        return;
+    }
+    sidx = &fcb->f_sidx[loc->fe_sector];
+    if (sidx->fsi_state != FCB2_IDX_VALID) {
+        /* Entry is picked up when the sector gets scanned. */
+        return;
+    }
+    ents = fcb2_idx_entries(fcb, loc->fe_sector);
+    if (sidx->fsi_cnt > 0 &&
+        ents[sidx->fsi_cnt - 1].fie_entry_num >= loc->fe_entry_num) {
+        /* Out of order; should not happen.  Rescan. */
+        sidx->fsi_state = FCB2_IDX_NONE;
+        return;
+    }
+    fcb2_idx_push(fcb, loc, FCB2_IDX_F_PENDING);
+}
+
+/*
+ * Finds the entry following loc using the index.  Called with the FCB
+ * locked.  Returns FCB2_IDX_MISS if the sector holding the next entry is
+ * not indexed; loc is then updated so that the caller can continue from
+ * flash.
+ */
+int
+fcb2_idx_getnext(struct fcb2 *fcb, struct fcb2_entry *loc)
+{
+    struct fcb2_sector_idx *sidx;
+    struct fcb2_idx_entry *ents;
+    struct fcb2_idx_entry *ent;
+    struct fcb2_entry tmp;
+    uint16_t entry_num;
+    int sector;
+    int pos;
+
+    sector = loc->fe_sector;
+    entry_num = loc->fe_entry_num;
+    while (1) {
+        sidx = &fcb->f_sidx[sector];
+        if (sidx->fsi_state == FCB2_IDX_NONE) {
+            fcb2_idx_build(fcb, sector);
+        }
+        if (sidx->fsi_state != FCB2_IDX_VALID) {
+            if (sector != loc->fe_sector) {
+                loc->fe_sector = sector;
+                loc->fe_range = fcb2_get_sector_range(fcb, sector);
+                loc->fe_entry_num = 0;
+            }
+            return FCB2_IDX_MISS;
+        }
+
+        ents = fcb2_idx_entries(fcb, sector);
+        for (pos = fcb2_idx_find_next(sidx, ents, entry_num);
+             pos < sidx->fsi_cnt; pos++) {
+            ent = &ents[pos];
+            if (ent->fie_flags & FCB2_IDX_F_PENDING) {
+                tmp.fe_sector = sector;
+                tmp.fe_range = fcb2_get_sector_range(fcb, sector);
+                tmp.fe_entry_num = ent->fie_entry_num;
+                if (fcb2_elem_info(&tmp)) {
+                    /* Not finished (yet). */
+                    continue;
+                }
+                ent->fie_data_off = tmp.fe_data_off;
+                ent->fie_data_len = tmp.fe_data_len;
+                ent->fie_flags &= ~FCB2_IDX_F_PENDING;
+            }
+            sidx->fsi_last = pos;
+            loc->fe_sector = sector;
+            loc->fe_range = fcb2_get_sector_range(fcb, sector);
+            loc->fe_entry_num = ent->fie_entry_num;
+            loc->fe_data_off = ent->fie_data_off;
+            loc->fe_data_len = ent->fie_data_len;
+            return 0;
+        }
+
+        if (sector == fcb->f_active.fe_sector) {
+            return FCB2_ERR_NOVAR;
+        }
+        sector = fcb2_getnext_sector(fcb, sector);
+        entry_num = 0;
+    }
+}
+
+#endif
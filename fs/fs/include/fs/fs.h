@@ -34,12 +34,19 @@ extern "C" {
 struct fs_file;
 struct fs_dir;
 struct fs_dirent;
+struct os_mbuf;
 
 int fs_mkfs(const char *disk, uint8_t format);
 int fs_open(const char *filename, uint8_t access_flags, struct fs_file **);
 int fs_close(struct fs_file *);
 int fs_read(struct fs_file *, uint32_t len, void *out_data, uint32_t *out_len);
 int fs_write(struct fs_file *, const void *data, int len);
+int fs_read_mbuf(struct fs_file *, uint32_t len, struct os_mbuf *om,
+  uint32_t *out_len);
+int fs_write_mbuf(struct fs_file *, const struct os_mbuf *om, int off,
+  uint32_t len);
+int fs_mmap(struct fs_file *, uint32_t offset, uint32_t len,
+  const void **out_ptr, uint32_t *out_len);
 int fs_seek(struct fs_file *, uint32_t offset);
 uint32_t fs_getpos(const struct fs_file *);
 int fs_filelen(const struct fs_file *, uint32_t *out_len);
@@ -85,6 +92,7 @@ int fs_flush(struct fs_file *);
 #define FS_EEXIST       11  /* File or directory already exists */
 #define FS_EACCESS      12  /* Operation prohibited by file open mode */
 #define FS_EUNINIT      13  /* File system not initialized */
+#define FS_ENOTSUP      14  /* Operation not supported */
 
 #define FS_MGMT_ID_FILE     0
 
@@ -38,6 +38,19 @@ struct fs_ops {
     int (*f_write)(struct fs_file *file, const void *data, int len);
     int (*f_flush)(struct fs_file *file);
 
+    /*
+     * Optional; when NULL, fs_read_mbuf() / fs_write_mbuf() fall back to
+     * f_read / f_write, one call per mbuf segment.
+     */
+    int (*f_read_mbuf)(struct fs_file *file, uint32_t len, struct os_mbuf *om,
+      uint32_t *out_len);
+    int (*f_write_mbuf)(struct fs_file *file, const struct os_mbuf *om,
+      int off, uint32_t len);
+
+    /* Optional; fs_mmap() fails with FS_ENOTSUP when NULL. */
+    int (*f_mmap)(struct fs_file *file, uint32_t offset, uint32_t len,
+      const void **out_ptr, uint32_t *out_len);
+
     int (*f_seek)(struct fs_file *file, uint32_t offset);
     uint32_t (*f_getpos)(const struct fs_file *file);
     int (*f_filelen)(const struct fs_file *file, uint32_t *out_len);
@@ -95,6 +108,44 @@ struct fs_ops *fs_ops_for(const char *name);
 
 struct fs_ops *fs_ops_from_container(struct fops_container *container);
 
+typedef int fs_read_fn(struct fs_file *file, uint32_t len, void *out_data,
+                       uint32_t *out_len);
+typedef int fs_write_fn(struct fs_file *file, const void *data, int len);
+
+/**
+ * Reads from a file straight into the free space of an mbuf chain, one
+ * read_fn call per segment.  Filesystems use this to implement f_read_mbuf
+ * on top of their (unlocked) flat read routine.
+ *
+ * @param file          The file to read from.
+ * @param read_fn       Reads into a flat buffer.
+ * @param len           The maximum number of bytes to read.
+ * @param om            The chain the data is appended to.
+ * @param out_len       On success, the number of bytes appended.
+ *
+ * @return 0 on success, FS_ENOMEM if the chain could not be extended, other
+ *         non-zero values as returned by read_fn.
+ */
+int fs_mbuf_read_segments(struct fs_file *file, fs_read_fn *read_fn,
+                          uint32_t len, struct os_mbuf *om,
+                          uint32_t *out_len);
+
+/**
+ * Writes a region of an mbuf chain to a file, one write_fn call per
+ * segment.
+ *
+ * @param file          The file to write to.
+ * @param write_fn      Writes a flat buffer.
+ * @param om            The chain holding the data.
+ * @param off           Offset within the chain of the first byte to write.
+ * @param len           The number of bytes to write.
+ *
+ * @return 0 on success, FS_EINVAL if the chain is shorter than off + len,
+ *         other non-zero values as returned by write_fn.
+ */
+int fs_mbuf_write_segments(struct fs_file *file, fs_write_fn *write_fn,
+                           const struct os_mbuf *om, int off, uint32_t len);
+
 #ifdef __cplusplus
 }
 #endif
@@ -242,6 +242,156 @@ fs_write(struct fs_file *file, const void *data, int len)
     return fops->f_write(file, data, len);
 }
 
+int
+fs_mbuf_read_segments(struct fs_file *file, fs_read_fn *read_fn,
+                      uint32_t len, struct os_mbuf *om, uint32_t *out_len)
+{
+    struct os_mbuf *last;
+    struct os_mbuf *next;
+    uint32_t total;
+    uint32_t chunk;
+    uint32_t got;
+    int rc;
+
+    last = om;
+    while (SLIST_NEXT(last, om_next) != NULL) {
+        last = SLIST_NEXT(last, om_next);
+    }
+
+    total = 0;
+    rc = 0;
+    while (total < len) {
+        got = 0;
+        next = NULL;
+        if (OS_MBUF_TRAILINGSPACE(last) == 0) {
+            next = os_mbuf_get(om->om_omp, 0);
+            if (next == NULL) {
+                rc = FS_ENOMEM;
+                break;
+            }
+        }
+
+        if (next != NULL) {
+            chunk = OS_MBUF_TRAILINGSPACE(next);
+            chunk = min(chunk, len - total);
+            rc = read_fn(file, chunk, next->om_data, &got);
+            if (got == 0) {
+                os_mbuf_free(next);
+                break;
+            }
+            SLIST_NEXT(last, om_next) = next;
+            last = next;
+        } else {
+            chunk = OS_MBUF_TRAILINGSPACE(last);
+            chunk = min(chunk, len - total);
+            rc = read_fn(file, chunk, last->om_data + last->om_len, &got);
+        }
+
+        last->om_len += got;
+        if (OS_MBUF_IS_PKTHDR(om)) {
+            OS_MBUF_PKTLEN(om) += got;
+        }
+        total += got;
+
+        if (rc != 0 || got < chunk) {
+            break;
+        }
+    }
+
+    *out_len = total;
+    return rc;
+}
+
+int
+fs_mbuf_write_segments(struct fs_file *file, fs_write_fn *write_fn,
+                       const struct os_mbuf *om, int off, uint32_t len)
+{
+    const struct os_mbuf *cur;
+    uint16_t seg_off;
+    uint32_t avail;
+    uint32_t chunk;
+    int rc;
+
+    om = os_mbuf_off(om, off, &seg_off);
+    if (om == NULL) {
+        return FS_EINVAL;
+    }
+
+    /* Don't write anything unless the chain holds the whole region. */
+    avail = om->om_len - seg_off;
+    for (cur = SLIST_NEXT(om, om_next); cur != NULL && avail < len;
+         cur = SLIST_NEXT(cur, om_next)) {
+        avail += cur->om_len;
+    }
+    if (avail < len) {
+        return FS_EINVAL;
+    }
+
+    while (len > 0) {
+        chunk = min(om->om_len - seg_off, len);
+        if (chunk > 0) {
+            rc = write_fn(file, om->om_data + seg_off, chunk);
+            if (rc != 0) {
+                return rc;
+            }
+        }
+
+        len -= chunk;
+        seg_off = 0;
+        om = SLIST_NEXT(om, om_next);
+    }
+
+    return 0;
+}
+
+int
+fs_read_mbuf(struct fs_file *file, uint32_t len, struct os_mbuf *om,
+             uint32_t *out_len)
+{
+    struct fs_ops *fops = fops_from_file(file);
+
+    if (fops->f_read_mbuf != NULL) {
+        return fops->f_read_mbuf(file, len, om, out_len);
+    }
+    return fs_mbuf_read_segments(file, fops->f_read, len, om, out_len);
+}
+
+int
+fs_write_mbuf(struct fs_file *file, const struct os_mbuf *om, int off,
+              uint32_t len)
+{
+    struct fs_ops *fops = fops_from_file(file);
+
+    if (fops->f_write_mbuf != NULL) {
+        return fops->f_write_mbuf(file, om, off, len);
+    }
+    return fs_mbuf_write_segments(file, fops->f_write, om, off, len);
+}
+
+/**
+ * Maps part of a file for reading in place, without copying it to RAM.
+ *
+ * On success, out_ptr points at the byte at offset and out_len holds the
+ * number of bytes, at most len, that are contiguous from there.  Files
+ * stored in several pieces are mapped one extent at a time.  The pointer
+ * stays valid until the file system is next modified.
+ *
+ * @return 0 on success, FS_ENOTSUP if the file system or its storage can't
+ *         be read in place, FS_EOFFSET if offset is at or past the end of
+ *         the file.
+ */
+int
+fs_mmap(struct fs_file *file, uint32_t offset, uint32_t len,
+        const void **out_ptr, uint32_t *out_len)
+{
+    struct fs_ops *fops = fops_from_file(file);
+
+    if (fops->f_mmap == NULL) {
+        return FS_ENOTSUP;
+    }
+    return fops->f_mmap(file, offset, len, out_ptr, out_len);
+}
+
 int
 fs_seek(struct fs_file *file, uint32_t offset)
 {
@@ -42,6 +42,11 @@ static int littlefs_close(struct fs_file *fs_file);
 static int littlefs_read(struct fs_file *fs_file, uint32_t len, void *out_data,
                          uint32_t *out_len);
 static int littlefs_write(struct fs_file *fs_file, const void *data, int len);
+static int littlefs_read_mbuf(struct fs_file *fs_file, uint32_t len,
+                              struct os_mbuf *om, uint32_t *out_len);
+static int littlefs_write_mbuf(struct fs_file *fs_file,
+                               const struct os_mbuf *om, int off,
+                               uint32_t len);
 static int littlefs_flush(struct fs_file *fs_file);
 static int littlefs_seek(struct fs_file *fs_file, uint32_t offset);
 static uint32_t littlefs_getpos(const struct fs_file *fs_file);
@@ -61,6 +66,19 @@ struct littlefs_file {
     struct fs_ops *fops;
     lfs_file_t *file;
     lfs_t *lfs;
+
+    /* Cache buffer handed to littlefs; from littlefs_file_cache_pool, or
+     * NULL if littlefs allocated it.
+     */
+    struct lfs_file_config cfg;
+
+    /* Serializes calls on this file. */
+    struct os_mutex mutex;
+
+    /* Set when reads that hit the file cache can be served without the
+     * global lock.
+     */
+    bool cache_reads;
 };
 
 struct littlefs_dirent {
@@ -81,6 +99,8 @@ static struct fs_ops littlefs_ops = {
     .f_read = littlefs_read,
     .f_write = littlefs_write,
     .f_flush = littlefs_flush,
+    .f_read_mbuf = littlefs_read_mbuf,
+    .f_write_mbuf = littlefs_write_mbuf,
 
     .f_seek = littlefs_seek,
     .f_getpos = littlefs_getpos,
@@ -225,11 +245,29 @@ static lfs_t *g_lfs = NULL;
 static bool g_lfs_alloc_done = false;
 
 #define READ_SIZE (MYNEWT_VAL(LITTLEFS_READ_SIZE))
-static uint8_t read_buffer[READ_SIZE];
 #define WRITE_SIZE (MYNEWT_VAL(LITTLEFS_WRITE_SIZE))
-static uint8_t prog_buffer[WRITE_SIZE];
 #define CACHE_SIZE (MYNEWT_VAL(LITTLEFS_CACHE_SIZE))
-static uint8_t __attribute__((aligned(4))) lookahead_buffer[CACHE_SIZE];
+#if MYNEWT_VAL(LITTLEFS_LOOKAHEAD_SIZE) > 0
+#define LOOKAHEAD_SIZE (MYNEWT_VAL(LITTLEFS_LOOKAHEAD_SIZE))
+#else
+#define LOOKAHEAD_SIZE CACHE_SIZE
+#endif
+
+#if LOOKAHEAD_SIZE % 8 != 0
+#error "littlefs lookahead size must be a multiple of 8"
+#endif
+
+/* littlefs requires both buffers to be cache_size bytes. */
+static uint8_t read_buffer[CACHE_SIZE];
+static uint8_t prog_buffer[CACHE_SIZE];
+static uint8_t __attribute__((aligned(4))) lookahead_buffer[LOOKAHEAD_SIZE];
+
+#if MYNEWT_VAL(LITTLEFS_FILE_CACHES) > 0
+static os_membuf_t littlefs_file_cache_mem[
+    OS_MEMPOOL_SIZE(MYNEWT_VAL(LITTLEFS_FILE_CACHES), CACHE_SIZE)];
+static struct os_mempool littlefs_file_cache_pool;
+#endif
+
 static struct lfs_config g_lfs_cfg = {
     .context = NULL,
 
@@ -243,9 +281,9 @@ static struct lfs_config g_lfs_cfg = {
     .prog_size = WRITE_SIZE,
     .block_size = MYNEWT_VAL(LITTLEFS_BLOCK_SIZE),
     .block_count = MYNEWT_VAL(LITTLEFS_BLOCK_COUNT),
-    .block_cycles = 500,
+    .block_cycles = MYNEWT_VAL(LITTLEFS_BLOCK_CYCLES),
     .cache_size = CACHE_SIZE,
-    .lookahead_size = CACHE_SIZE,
+    .lookahead_size = LOOKAHEAD_SIZE,
     .read_buffer = read_buffer,
     .prog_buffer = prog_buffer,
     .lookahead_buffer = lookahead_buffer,
@@ -275,6 +313,101 @@ littlefs_unlock(void)
     assert(rc == 0 || rc == OS_NOT_STARTED);
 }
 
+/*
+ * Lock order is the file first, then the global lock.
+ */
+static void
+littlefs_file_lock(struct littlefs_file *lfile)
+{
+    int rc;
+
+    rc = os_mutex_pend(&lfile->mutex, OS_TIMEOUT_NEVER);
+    assert(rc == 0 || rc == OS_NOT_STARTED);
+}
+
+static void
+littlefs_file_unlock(struct littlefs_file *lfile)
+{
+    int rc;
+
+    rc = os_mutex_release(&lfile->mutex);
+    assert(rc == 0 || rc == OS_NOT_STARTED);
+}
+
+/*
+ * Reads from the file cache, getpos and filelen skip the global lock on
+ * handles in a stable read state.  They read lfs_file_t internals (pos,
+ * off, block, ctz and cache) directly, which relies on how littlefs 2.4
+ * handles open files:
+ *  - Those fields only change in lfs_file_*() calls on that same file; all
+ *    of them hold the file lock here.
+ *  - lfs_dir_commit() on behalf of other files only rewrites the metadata
+ *    pair and id (m, id) of open files, and outlines inline files, which
+ *    are never read this way.
+ *  - lfs_file_read() serves bytes in the cache with a plain copy from
+ *    cache.buffer at off - cache.off.
+ * Other littlefs versions take the global lock for everything until these
+ * have been checked again.
+ */
+#if LFS_VERSION == 0x00020004
+#define LITTLEFS_UNLOCKED_READS     1
+#else
+#define LITTLEFS_UNLOCKED_READS     0
+#endif
+
+/*
+ * Whether reads from the file cache can skip the global lock: the file has
+ * no pending writes and its data is in blocks, not inlined in its
+ * directory.  Must be called with the global lock held.
+ */
+static bool
+littlefs_file_cache_private(const lfs_file_t *file)
+{
+    return LITTLEFS_UNLOCKED_READS &&
+           (file->flags & LFS_F_READING) &&
+           !(file->flags & (LFS_F_INLINE | LFS_F_WRITING | LFS_F_DIRTY));
+}
+
+/*
+ * Copies data littlefs already holds in the file cache, the same way
+ * lfs_file_read() would.  Returns the number of bytes read, 0 if the next
+ * byte is not in the cache.
+ */
+static uint32_t
+littlefs_read_cached(lfs_file_t *file, uint8_t *out_data, uint32_t len)
+{
+    const lfs_cache_t *cache;
+    uint32_t size;
+
+    cache = &file->cache;
+    if (file->pos >= file->ctz.size ||
+        file->block != cache->block ||
+        file->off < cache->off ||
+        file->off >= cache->off + cache->size) {
+
+        return 0;
+    }
+
+    size = min(len, cache->off + cache->size - file->off);
+    size = min(size, file->ctz.size - file->pos);
+    memcpy(out_data, &cache->buffer[file->off - cache->off], size);
+    file->pos += size;
+    file->off += size;
+
+    return size;
+}
+
+static void
+littlefs_file_cache_free(struct littlefs_file *lfile)
+{
+#if MYNEWT_VAL(LITTLEFS_FILE_CACHES) > 0
+    if (lfile->cfg.buffer) {
+        os_memblock_put(&littlefs_file_cache_pool, lfile->cfg.buffer);
+        lfile->cfg.buffer = NULL;
+    }
+#endif
+}
+
 static int
 littlefs_open(const char *path, uint8_t access_flags, struct fs_file **out_fs_file)
 {
@@ -298,6 +431,12 @@ littlefs_open(const char *path, uint8_t access_flags, struct fs_file **out_fs_fi
         goto out;
     }
 
+    memset(&file->cfg, 0, sizeof(file->cfg));
+#if MYNEWT_VAL(LITTLEFS_FILE_CACHES) > 0
+    /* Once the pool runs out littlefs allocates the cache itself. */
+    file->cfg.buffer = os_memblock_get(&littlefs_file_cache_pool);
+#endif
+
     out_file = malloc(sizeof(lfs_file_t));
     if (!out_file) {
         rc = FS_ENOMEM;
@@ -328,21 +467,34 @@ littlefs_open(const char *path, uint8_t access_flags, struct fs_file **out_fs_fi
     }
 
     littlefs_lock();
-    rc = lfs_file_open(g_lfs, out_file, filepath, flags);
+    rc = lfs_file_opencfg(g_lfs, out_file, filepath, flags, &file->cfg);
     littlefs_unlock();
     if (rc != LFS_ERR_OK) {
         rc = littlefs_to_vfs_error(rc);
         goto out;
     }
 
+    rc = os_mutex_init(&file->mutex);
+    if (rc != 0) {
+        littlefs_lock();
+        lfs_file_close(g_lfs, out_file);
+        littlefs_unlock();
+        rc = FS_EOS;
+        goto out;
+    }
+
     file->file = out_file;
     file->fops = &littlefs_ops;
     file->lfs = g_lfs;
+    file->cache_reads = false;
     *out_fs_file = (struct fs_file *) file;
     rc = FS_EOK;
 
 out:
     if (rc != FS_EOK) {
+        if (file) {
+            littlefs_file_cache_free(file);
+        }
         free(file);
         free(out_file);
     }
@@ -353,6 +505,7 @@ static int
 littlefs_close(struct fs_file *fs_file)
 {
     int rc;
+    struct littlefs_file *lfile;
     lfs_file_t *file;
     lfs_t *lfs;
 
@@ -360,17 +513,22 @@ littlefs_close(struct fs_file *fs_file)
         return FS_EINVAL;
     }
 
-    file = ((struct littlefs_file *) fs_file)->file;
+    lfile = (struct littlefs_file *) fs_file;
+    file = lfile->file;
     if (!file) {
         return FS_EOK;
     }
 
-    lfs = ((struct littlefs_file *) fs_file)->lfs;
+    lfs = lfile->lfs;
 
+    littlefs_file_lock(lfile);
     littlefs_lock();
     rc = lfs_file_close(lfs, file);
     littlefs_unlock();
+    littlefs_file_unlock(lfile);
     free(file);
+    littlefs_file_cache_free(lfile);
+    free(lfile);
 
     return littlefs_to_vfs_error(rc);
 }
@@ -378,6 +536,7 @@ littlefs_close(struct fs_file *fs_file)
 static int
 littlefs_seek(struct fs_file *fs_file, uint32_t offset)
 {
+    struct littlefs_file *lfile;
     lfs_file_t *file;
     lfs_t *lfs;
     int rc;
@@ -386,13 +545,17 @@ littlefs_seek(struct fs_file *fs_file, uint32_t offset)
         return FS_EINVAL;
     }
 
-    file = ((struct littlefs_file *) fs_file)->file;
-    lfs = ((struct littlefs_file *) fs_file)->lfs;
+    lfile = (struct littlefs_file *) fs_file;
+    file = lfile->file;
+    lfs = lfile->lfs;
 
     /* Returns the new position if succesful */
+    littlefs_file_lock(lfile);
     littlefs_lock();
     rc = lfs_file_seek(lfs, file, offset, LFS_SEEK_SET);
+    lfile->cache_reads = littlefs_file_cache_private(file);
     littlefs_unlock();
+    littlefs_file_unlock(lfile);
     if (rc < 0) {
         return littlefs_to_vfs_error(rc);
     }
@@ -403,6 +566,7 @@ littlefs_seek(struct fs_file *fs_file, uint32_t offset)
 static uint32_t
 littlefs_getpos(const struct fs_file *fs_file)
 {
+    struct littlefs_file *lfile;
     lfs_file_t *file;
     lfs_t *lfs;
     int rc;
@@ -411,17 +575,24 @@ littlefs_getpos(const struct fs_file *fs_file)
         return FS_EINVAL;
     }
 
-    file = ((struct littlefs_file *) fs_file)->file;
-    lfs = ((struct littlefs_file *) fs_file)->lfs;
+    lfile = (struct littlefs_file *) fs_file;
+    file = lfile->file;
+    lfs = lfile->lfs;
 
     /*
      * LttleFS can return < 0 on errors, but fs_getpos does not allow
      * failing, so just return 0 and hope for the best. This should
      * eventually be fixed in the FS abstraction.
      */
-    littlefs_lock();
-    rc = lfs_file_tell(lfs, file);
-    littlefs_unlock();
+    littlefs_file_lock(lfile);
+    if (lfile->cache_reads) {
+        rc = file->pos;
+    } else {
+        littlefs_lock();
+        rc = lfs_file_tell(lfs, file);
+        littlefs_unlock();
+    }
+    littlefs_file_unlock(lfile);
     if (rc < 0) {
         return 0;
     }
@@ -432,6 +603,7 @@ littlefs_getpos(const struct fs_file *fs_file)
 static int
 littlefs_file_len(const struct fs_file *fs_file, uint32_t *out_len)
 {
+    struct littlefs_file *lfile;
     lfs_file_t *file;
     lfs_t *lfs;
     int32_t len;
@@ -440,12 +612,19 @@ littlefs_file_len(const struct fs_file *fs_file, uint32_t *out_len)
         return FS_EINVAL;
     }
 
-    file = ((struct littlefs_file *) fs_file)->file;
-    lfs = ((struct littlefs_file *) fs_file)->lfs;
-
-    littlefs_lock();
-    len = (int32_t)lfs_file_size(lfs, file);
-    littlefs_unlock();
+    lfile = (struct littlefs_file *) fs_file;
+    file = lfile->file;
+    lfs = lfile->lfs;
+
+    littlefs_file_lock(lfile);
+    if (lfile->cache_reads) {
+        len = (int32_t)file->ctz.size;
+    } else {
+        littlefs_lock();
+        len = (int32_t)lfs_file_size(lfs, file);
+        littlefs_unlock();
+    }
+    littlefs_file_unlock(lfile);
     if (len < 0) {
         return littlefs_to_vfs_error((int)len);
     }
@@ -454,14 +633,49 @@ littlefs_file_len(const struct fs_file *fs_file, uint32_t *out_len)
     return FS_EOK;
 }
 
+/* Called with the file lock held. */
 static int
-littlefs_read(struct fs_file *fs_file, uint32_t len, void *out_data,
-              uint32_t *out_len)
+littlefs_read_segment(struct fs_file *fs_file, uint32_t len, void *out_data,
+                      uint32_t *out_len)
 {
+    struct littlefs_file *lfile;
     lfs_file_t *file;
-    lfs_t *lfs;
+    uint32_t cached;
     int32_t size;
 
+    lfile = (struct littlefs_file *) fs_file;
+    file = lfile->file;
+
+    /* Reads that hit the file cache let other files go ahead meanwhile. */
+    cached = 0;
+    if (lfile->cache_reads) {
+        cached = littlefs_read_cached(file, out_data, len);
+    }
+
+    size = 0;
+    if (cached < len) {
+        littlefs_lock();
+        size = lfs_file_read(lfile->lfs, file, (uint8_t *)out_data + cached,
+                             len - cached);
+        lfile->cache_reads = littlefs_file_cache_private(file);
+        littlefs_unlock();
+    }
+
+    if (size < 0) {
+        return littlefs_to_vfs_error((int)size);
+    }
+
+    *out_len = cached + (uint32_t)size;
+    return FS_EOK;
+}
+
+static int
+littlefs_read(struct fs_file *fs_file, uint32_t len, void *out_data,
+              uint32_t *out_len)
+{
+    struct littlefs_file *lfile;
+    int rc;
+
     if (!fs_file || !out_data || !out_len) {
         return FS_EINVAL;
     }
@@ -471,28 +685,63 @@ littlefs_read(struct fs_file *fs_file, uint32_t len, void *out_data,
         return FS_EOK;
     }
 
-    *out_len = len;
+    lfile = (struct littlefs_file *) fs_file;
 
-    file = ((struct littlefs_file *) fs_file)->file;
-    lfs = ((struct littlefs_file *) fs_file)->lfs;
+    littlefs_file_lock(lfile);
+    rc = littlefs_read_segment(fs_file, len, out_data, out_len);
+    littlefs_file_unlock(lfile);
 
-    littlefs_lock();
-    size = lfs_file_read(lfs, file, out_data, *out_len);
-    littlefs_unlock();
+    return rc;
+}
+
+static int
+littlefs_read_mbuf(struct fs_file *fs_file, uint32_t len, struct os_mbuf *om,
+                   uint32_t *out_len)
+{
+    struct littlefs_file *lfile;
+    int rc;
+
+    if (!fs_file || !om || !out_len) {
+        return FS_EINVAL;
+    }
+
+    lfile = (struct littlefs_file *) fs_file;
+
+    littlefs_file_lock(lfile);
+    rc = fs_mbuf_read_segments(fs_file, littlefs_read_segment, len, om,
+                               out_len);
+    littlefs_file_unlock(lfile);
+
+    return rc;
+}
+
+/* Called with both the file lock and the global lock held. */
+static int
+littlefs_write_segment(struct fs_file *fs_file, const void *data, int len)
+{
+    struct littlefs_file *lfile;
+    int32_t size;
+
+    lfile = (struct littlefs_file *) fs_file;
+
+    size = lfs_file_write(lfile->lfs, lfile->file, data, len);
+    lfile->cache_reads = false;
     if (size < 0) {
         return littlefs_to_vfs_error((int)size);
     }
 
-    *out_len = (uint32_t)size;
+    if (size != len) {
+        return FS_EFULL;
+    }
+
     return FS_EOK;
 }
 
 static int
 littlefs_write(struct fs_file *fs_file, const void *data, int len)
 {
-    lfs_file_t *file;
-    lfs_t *lfs;
-    int32_t size;
+    struct littlefs_file *lfile;
+    int rc;
 
     if (!fs_file || !data) {
         return FS_EINVAL;
@@ -502,21 +751,37 @@ littlefs_write(struct fs_file *fs_file, const void *data, int len)
         return FS_EOK;
     }
 
-    file = ((struct littlefs_file *) fs_file)->file;
-    lfs = ((struct littlefs_file *) fs_file)->lfs;
+    lfile = (struct littlefs_file *) fs_file;
 
+    littlefs_file_lock(lfile);
     littlefs_lock();
-    size = lfs_file_write(lfs, file, data, len);
+    rc = littlefs_write_segment(fs_file, data, len);
     littlefs_unlock();
-    if (size < 0) {
-        return littlefs_to_vfs_error((int)size);
-    }
+    littlefs_file_unlock(lfile);
 
-    if (size != len) {
-        return FS_EFULL;
+    return rc;
+}
+
+static int
+littlefs_write_mbuf(struct fs_file *fs_file, const struct os_mbuf *om,
+                    int off, uint32_t len)
+{
+    struct littlefs_file *lfile;
+    int rc;
+
+    if (!fs_file || !om) {
+        return FS_EINVAL;
     }
 
-    return FS_EOK;
+    lfile = (struct littlefs_file *) fs_file;
+
+    littlefs_file_lock(lfile);
+    littlefs_lock();
+    rc = fs_mbuf_write_segments(fs_file, littlefs_write_segment, om, off, len);
+    littlefs_unlock();
+    littlefs_file_unlock(lfile);
+
+    return rc;
 }
 
 static int
@@ -765,6 +1030,15 @@ littlefs_alloc(void)
         return FS_EOS;
     }
 
+#if MYNEWT_VAL(LITTLEFS_FILE_CACHES) > 0
+    rc = os_mempool_init(&littlefs_file_cache_pool,
+                         MYNEWT_VAL(LITTLEFS_FILE_CACHES), CACHE_SIZE,
+                         littlefs_file_cache_mem, "littlefs_cache");
+    if (rc != 0) {
+        return FS_EOS;
+    }
+#endif
+
     g_lfs = malloc(sizeof(lfs_t));
     if (!g_lfs) {
         return FS_ENOMEM;
@@ -792,6 +1066,25 @@ littlefs_alloc(void)
     return FS_EOK;
 }
 
+static int
+littlefs_format(void)
+{
+#if MYNEWT_VAL(LITTLEFS_FORMAT_ERASE)
+    const struct flash_area *fa;
+
+    /*
+     * One call for the whole area lets the flash driver use its largest
+     * block erase instead of littlefs erasing one block at a time.
+     */
+    fa = g_lfs_cfg.context;
+    if (flash_area_erase(fa, 0, fa->fa_size) != 0) {
+        return LFS_ERR_IO;
+    }
+#endif
+
+    return lfs_format(g_lfs, &g_lfs_cfg);
+}
+
 int
 littlefs_reformat(void)
 {
@@ -804,7 +1097,7 @@ littlefs_reformat(void)
         }
     }
 
-    return lfs_format(g_lfs, &g_lfs_cfg);
+    return littlefs_format();
 }
 
 static int
@@ -836,7 +1129,7 @@ littlefs_init(void)
          * detection failure policy.
          */
 #if MYNEWT_VAL(LITTLEFS_DETECT_FAIL_FORMAT)
-        rc = lfs_format(g_lfs, &g_lfs_cfg);
+        rc = littlefs_format();
         if (!rc) {
             rc = lfs_mount(g_lfs, &g_lfs_cfg);
         }
@@ -99,7 +99,12 @@ TEST_CASE_DECL(nffs_test_lost_found)
 TEST_CASE_DECL(nffs_test_readdir)
 TEST_CASE_DECL(nffs_test_split_file)
 TEST_CASE_DECL(nffs_test_gc_on_oom)
+TEST_CASE_DECL(nffs_test_checkpoint)
+TEST_CASE_DECL(nffs_test_mbuf)
+TEST_CASE_DECL(nffs_test_mmap)
 TEST_CASE_DECL(nffs_test_cache_large_file)
+TEST_CASE_DECL(nffs_test_cache_seq_read)
+TEST_CASE_DECL(nffs_test_hash_bench)
 
 static void
 nffs_test_basic_cases(void)
@@ -129,6 +134,9 @@ nffs_test_basic_cases(void)
     nffs_test_readdir();
     nffs_test_split_file();
     nffs_test_gc_on_oom();
+    nffs_test_checkpoint();
+    nffs_test_mbuf();
+    nffs_test_mmap();
 }
 
 TEST_SUITE(nffs_test_suite_1_1)
@@ -165,10 +173,18 @@ TEST_SUITE(nffs_suite_cache)
     tu_suite_set_pre_test_cb(nffs_testcase_pre, NULL);
 
     nffs_test_cache_large_file();
+    nffs_test_cache_seq_read();
+}
+
+TEST_SUITE(nffs_suite_hash)
+{
+    tu_suite_set_pre_test_cb(nffs_testcase_pre, NULL);
+
+    nffs_test_hash_bench();
 }
 
 int
-main(void)
+nffs_test_all(void)
 {
     nffs_config.nc_num_inodes = 1024 * 8;
     nffs_config.nc_num_blocks = 1024 * 20;
@@ -178,6 +194,7 @@ main(void)
     nffs_test_suite_32_1024();
 
     nffs_suite_cache();
+    nffs_suite_hash();
 
     return tu_any_failed;
 }
@@ -199,6 +199,7 @@ print_nffs_flash_areas(int verbose)
     }
 }
 
+#if !MYNEWT_VAL(NFFS_HASH_OPEN_ADDR)
 static int
 nffs_hash_fn(uint32_t id)
 {
@@ -221,6 +222,7 @@ print_hashlist(struct nffs_hash_entry *he)
                    he->nhe_next.sle_next);
    }
 }
+#endif
 
 void
 print_hash(void)
@@ -524,21 +526,16 @@ print_hash_entries(int verbose)
     struct nffs_hash_entry *next;
 
     printf("\nnffs_hash_entries:\n");
-    for (i = 0; i < NFFS_HASH_SIZE; i++) {
-        he = SLIST_FIRST(nffs_hash + i);
-        while (he != NULL) {
-            next = SLIST_NEXT(he, nhe_next);
-            if (nffs_hash_id_is_inode(he->nhe_id)) {
-                print_nffs_hash_inode(he, verbose);
-            } else if (nffs_hash_id_is_block(he->nhe_id)) {
-                print_nffs_hash_block(he, verbose);
-            } else {
-                printf("UNKNOWN type hash entry %d: id 0x%jx loc 0x%jx\n",
-                       i,
-                       (uintmax_t)he->nhe_id,
-                       (uintmax_t)he->nhe_flash_loc);
-            }
-            he = next;
+    NFFS_HASH_FOREACH(he, i, next) {
+        if (nffs_hash_id_is_inode(he->nhe_id)) {
+            print_nffs_hash_inode(he, verbose);
+        } else if (nffs_hash_id_is_block(he->nhe_id)) {
+            print_nffs_hash_block(he, verbose);
+        } else {
+            printf("UNKNOWN type hash entry %d: id 0x%jx loc 0x%jx\n",
+                   i,
+                   (uintmax_t)he->nhe_id,
+                   (uintmax_t)he->nhe_flash_loc);
         }
     }
 }
@@ -0,0 +1,147 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "nffs_test_utils.h"
+
+#define NFFS_TEST_SEQ_FILE_SZ   (NFFS_BLOCK_MAX_DATA_SZ_MAX * 20)
+#define NFFS_TEST_SEQ_EXTRA_SZ  (NFFS_BLOCK_MAX_DATA_SZ_MAX * 2)
+
+static char nffs_test_seq_data[NFFS_TEST_SEQ_FILE_SZ + NFFS_TEST_SEQ_EXTRA_SZ];
+
+static void
+nffs_test_seq_read_at(struct fs_file *file, uint32_t off, uint32_t len)
+{
+    static char buf[NFFS_BLOCK_MAX_DATA_SZ_MAX];
+    uint32_t bytes_read;
+    int rc;
+
+    rc = fs_seek(file, off);
+    TEST_ASSERT(rc == 0);
+    rc = fs_read(file, len, buf, &bytes_read);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(bytes_read == len);
+    TEST_ASSERT(memcmp(buf, nffs_test_seq_data + off, len) == 0);
+}
+
+static void
+nffs_test_seq_read_random(const char *filename, uint32_t file_len)
+{
+    struct fs_file *file;
+    uint32_t off;
+    int rc;
+    int i;
+
+    nffs_cache_clear();
+
+    rc = fs_open(filename, FS_ACCESS_READ, &file);
+    TEST_ASSERT(rc == 0);
+
+    off = 12345;
+    for (i = 0; i < 200; i++) {
+        off = (off * 1103515245 + 12345) % file_len;
+        if (off + 50 > file_len) {
+            off = file_len - 50;
+        }
+        nffs_test_seq_read_at(file, off, 50);
+    }
+
+    /* Head and tail of the file. */
+    nffs_test_seq_read_at(file, 0, 50);
+    nffs_test_seq_read_at(file, file_len - 50, 50);
+
+    rc = fs_close(file);
+    TEST_ASSERT(rc == 0);
+
+    nffs_test_util_assert_contents(filename, nffs_test_seq_data, file_len);
+}
+
+TEST_CASE_SELF(nffs_test_cache_seq_read)
+{
+    struct fs_file *file;
+    uint32_t file_len;
+    uint32_t off;
+    int rc;
+    int i;
+
+    /*** Setup. */
+    rc = nffs_format(nffs_current_area_descs);
+    TEST_ASSERT(rc == 0);
+
+    for (i = 0; i < sizeof nffs_test_seq_data; i++) {
+        nffs_test_seq_data[i] = i + i / 251;
+    }
+    file_len = NFFS_TEST_SEQ_FILE_SZ;
+    nffs_test_util_create_file("/seq.txt", nffs_test_seq_data, file_len);
+    nffs_cache_clear();
+
+    rc = fs_open("/seq.txt", FS_ACCESS_READ, &file);
+    TEST_ASSERT(rc == 0);
+
+    /* Touch the first blocks one after the other. */
+    nffs_test_seq_read_at(file, nffs_block_max_data_sz * 0, 1);
+    nffs_test_seq_read_at(file, nffs_block_max_data_sz * 1, 1);
+    nffs_test_util_assert_cache_range("/seq.txt", 0,
+                                      nffs_block_max_data_sz * 2);
+
+#if MYNEWT_VAL(NFFS_CACHE_READAHEAD_MAX) > 0
+    /* Sequential access detected; the next block is read ahead. */
+    nffs_test_seq_read_at(file, nffs_block_max_data_sz * 2, 1);
+    nffs_test_util_assert_cache_range("/seq.txt", 0,
+                                      nffs_block_max_data_sz * 4);
+
+    /* Read-ahead window doubles. */
+    nffs_test_seq_read_at(file, nffs_block_max_data_sz * 3, 1);
+    nffs_test_seq_read_at(file, nffs_block_max_data_sz * 4, 1);
+    nffs_test_util_assert_cache_range("/seq.txt", 0,
+                                      nffs_block_max_data_sz * 7);
+
+    /* Random access resets the window. */
+    nffs_test_seq_read_at(file, nffs_block_max_data_sz * 12, 1);
+    nffs_test_util_assert_cache_range("/seq.txt",
+                                      nffs_block_max_data_sz * 12,
+                                      nffs_block_max_data_sz * 13);
+#endif
+
+    /* Stream the whole file in chunks smaller than a block. */
+    for (off = 0; off + 100 <= file_len; off += 100) {
+        nffs_test_seq_read_at(file, off, 100);
+    }
+
+    rc = fs_close(file);
+    TEST_ASSERT(rc == 0);
+
+    nffs_test_seq_read_random("/seq.txt", file_len);
+
+    /* Append to the file; the old last block is no longer last. */
+    nffs_test_util_append_file("/seq.txt", nffs_test_seq_data + file_len,
+                               nffs_block_max_data_sz / 2);
+    file_len += nffs_block_max_data_sz / 2;
+    nffs_test_seq_read_random("/seq.txt", file_len);
+
+    /* Overwrite past the end of the file, growing the last block. */
+    rc = fs_open("/seq.txt", FS_ACCESS_WRITE, &file);
+    TEST_ASSERT(rc == 0);
+    rc = fs_seek(file, file_len - 10);
+    TEST_ASSERT(rc == 0);
+    rc = fs_write(file, nffs_test_seq_data + file_len - 10, 110);
+    TEST_ASSERT(rc == 0);
+    rc = fs_close(file);
+    TEST_ASSERT(rc == 0);
+    file_len += 100;
+    nffs_test_seq_read_random("/seq.txt", file_len);
+}
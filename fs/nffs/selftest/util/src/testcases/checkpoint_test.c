@@ -0,0 +1,157 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "nffs_test_utils.h"
+
+#if MYNEWT_VAL(NFFS_CHECKPOINT)
+static const struct nffs_area_desc nffs_test_checkpoint_area_descs[] = {
+        { 0x00000000, 16 * 1024 },
+        { 0x00004000, 16 * 1024 },
+        { 0x00008000, 16 * 1024 },
+        { 0x0000c000, 16 * 1024 },
+        { 0x00010000, 64 * 1024 },
+        { 0x00020000, 128 * 1024 },
+        { 0x00040000, 128 * 1024 },
+        { 0x00060000, 128 * 1024 },
+        { 0, 0 },
+};
+
+static const struct nffs_area_desc nffs_test_checkpoint_desc =
+        { 0x00080000, 128 * 1024 };
+#endif
+
+TEST_CASE_SELF(nffs_test_checkpoint)
+{
+#if MYNEWT_VAL(NFFS_CHECKPOINT)
+    const struct nffs_area_desc *descs;
+    struct nffs_disk_checkpoint hdr;
+    int rc;
+
+    descs = nffs_test_checkpoint_area_descs;
+
+    /*** Setup. */
+    rc = nffs_checkpoint_init(&nffs_test_checkpoint_desc);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = nffs_format(descs);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /* Nothing to restore from yet. */
+    rc = nffs_misc_reset();
+    TEST_ASSERT(rc == 0);
+    rc = nffs_restore_checkpoint(descs);
+    TEST_ASSERT(rc == FS_ENOENT);
+    rc = nffs_detect(descs);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    rc = fs_mkdir("/mydir");
+    TEST_ASSERT(rc == 0);
+    rc = fs_mkdir("/mydir/sub");
+    TEST_ASSERT(rc == 0);
+    nffs_test_util_create_file("/mydir/b", "bbbb", 4);
+    nffs_test_util_create_file("/mydir/a", "aaaa", 4);
+    nffs_test_util_create_file("/mydir/sub/c", "cccc", 4);
+    nffs_test_util_create_file("/gone", "gone", 4);
+
+    rc = nffs_checkpoint();
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /* Objects written after the checkpoint get picked up by the tail scan. */
+    nffs_test_util_append_file("/mydir/a", "AAAA", 4);
+    nffs_test_util_create_file("/mydir/d", "dddd", 4);
+    rc = fs_unlink("/gone");
+    TEST_ASSERT(rc == 0);
+
+    struct nffs_test_file_desc *expected_system =
+        (struct nffs_test_file_desc[]) { {
+            .filename = "",
+            .is_dir = 1,
+            .children = (struct nffs_test_file_desc[]) { {
+                .filename = "mydir",
+                .is_dir = 1,
+                .children = (struct nffs_test_file_desc[]) { {
+                    .filename = "a",
+                    .contents = "aaaaAAAA",
+                    .contents_len = 8,
+                }, {
+                    .filename = "b",
+                    .contents = "bbbb",
+                    .contents_len = 4,
+                }, {
+                    .filename = "d",
+                    .contents = "dddd",
+                    .contents_len = 4,
+                }, {
+                    .filename = "sub",
+                    .is_dir = 1,
+                    .children = (struct nffs_test_file_desc[]) { {
+                        .filename = "c",
+                        .contents = "cccc",
+                        .contents_len = 4,
+                    }, {
+                        .filename = NULL,
+                    } },
+                }, {
+                    .filename = NULL,
+                } },
+            }, {
+                .filename = NULL,
+            } },
+    } };
+
+    rc = nffs_misc_reset();
+    TEST_ASSERT(rc == 0);
+    rc = nffs_restore_checkpoint(descs);
+    TEST_ASSERT_FATAL(rc == 0);
+    nffs_test_assert_system_once(expected_system);
+
+    /* A checkpoint that fails its CRC check is rejected; detection falls
+     * back to a full restore and drops the bad checkpoint.
+     */
+    rc = flash_native_memset(nffs_test_checkpoint_desc.nad_offset +
+                             sizeof hdr + 8, 0x5a, 1);
+    TEST_ASSERT(rc == 0);
+    rc = nffs_misc_reset();
+    TEST_ASSERT(rc == 0);
+    rc = nffs_restore_checkpoint(descs);
+    TEST_ASSERT(rc == FS_ECORRUPT);
+    rc = nffs_detect(descs);
+    TEST_ASSERT_FATAL(rc == 0);
+    nffs_test_assert_system_once(expected_system);
+    rc = nffs_restore_checkpoint(descs);
+    TEST_ASSERT(rc == FS_ENOENT);
+
+    /* Garbage collection invalidates the checkpoint. */
+    rc = nffs_detect(descs);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = nffs_checkpoint();
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = nffs_gc(NULL);
+    TEST_ASSERT(rc == 0);
+    rc = nffs_restore_checkpoint(descs);
+    TEST_ASSERT(rc == FS_ENOENT);
+
+    rc = nffs_detect(descs);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = nffs_checkpoint();
+    TEST_ASSERT_FATAL(rc == 0);
+    nffs_test_assert_system(expected_system, descs);
+
+    rc = nffs_checkpoint_init(NULL);
+    TEST_ASSERT(rc == 0);
+#endif
+}
@@ -0,0 +1,132 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <time.h>
+#include "nffs_test_utils.h"
+
+/* Well above any ID the file system hands out during the test. */
+#define NFFS_TEST_HASH_ID_BASE      (NFFS_ID_BLOCK_MIN + 0x10000000)
+
+static uint64_t
+nffs_test_hash_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int
+nffs_test_hash_count(void)
+{
+    struct nffs_hash_entry *entry;
+    struct nffs_hash_entry *next;
+    int count;
+    int i;
+
+    count = 0;
+    NFFS_HASH_FOREACH(entry, i, next) {
+        count++;
+    }
+
+    return count;
+}
+
+/**
+ * Times inserting, finding and removing 'num_entries' block entries with
+ * sequential IDs, as the file system assigns them.  The results are the
+ * average number of nanoseconds per operation.
+ */
+static void
+nffs_test_hash_measure(int num_entries, uint64_t *out_insert_ns,
+                       uint64_t *out_find_ns, uint64_t *out_remove_ns)
+{
+    struct nffs_hash_entry *entries;
+    uint64_t start;
+    int base_count;
+    int i;
+
+    entries = calloc(num_entries, sizeof *entries);
+    TEST_ASSERT_FATAL(entries != NULL);
+
+    for (i = 0; i < num_entries; i++) {
+        entries[i].nhe_id = NFFS_TEST_HASH_ID_BASE + i;
+        entries[i].nhe_flash_loc = nffs_flash_loc(0, i);
+    }
+
+    base_count = nffs_test_hash_count();
+
+    start = nffs_test_hash_now_ns();
+    for (i = 0; i < num_entries; i++) {
+        nffs_hash_insert(entries + i);
+    }
+    *out_insert_ns = (nffs_test_hash_now_ns() - start) / num_entries;
+
+    TEST_ASSERT(nffs_test_hash_count() == base_count + num_entries);
+
+    start = nffs_test_hash_now_ns();
+    for (i = 0; i < num_entries; i++) {
+        TEST_ASSERT(nffs_hash_find_block(NFFS_TEST_HASH_ID_BASE + i) ==
+                    entries + i);
+    }
+    *out_find_ns = (nffs_test_hash_now_ns() - start) / num_entries;
+
+    start = nffs_test_hash_now_ns();
+    for (i = 0; i < num_entries; i++) {
+        nffs_hash_remove(entries + i);
+    }
+    *out_remove_ns = (nffs_test_hash_now_ns() - start) / num_entries;
+
+    TEST_ASSERT(nffs_test_hash_count() == base_count);
+    TEST_ASSERT(nffs_hash_find(NFFS_TEST_HASH_ID_BASE) == NULL);
+
+    free(entries);
+}
+
+TEST_CASE_SELF(nffs_test_hash_bench)
+{
+    static const int num_entries[] = { 256, 2048, 16384 };
+    uint64_t insert_ns;
+    uint64_t remove_ns;
+    uint64_t find_ns;
+    int rc;
+    int i;
+
+    rc = nffs_format(nffs_current_area_descs);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    for (i = 0; i < sizeof num_entries / sizeof num_entries[0]; i++) {
+        nffs_test_hash_measure(num_entries[i], &insert_ns, &find_ns,
+                               &remove_ns);
+        printf("nffs hash: %5d entries, %llu ns per insert, %llu ns per find, "
+               "%llu ns per remove (open addr=%d)\n", num_entries[i],
+               (unsigned long long)insert_ns, (unsigned long long)find_ns,
+               (unsigned long long)remove_ns,
+               MYNEWT_VAL(NFFS_HASH_OPEN_ADDR));
+    }
+
+    /* The file system is unaffected. */
+    struct nffs_test_file_desc *expected_system =
+        (struct nffs_test_file_desc[]) { {
+            .filename = "",
+            .is_dir = 1,
+    } };
+
+    nffs_test_assert_system(expected_system, nffs_current_area_descs);
+}
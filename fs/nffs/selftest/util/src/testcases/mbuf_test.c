@@ -0,0 +1,112 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "nffs_test_utils.h"
+
+#define NFFS_TEST_MBUF_DATA_SZ      48
+#define NFFS_TEST_MBUF_BLOCK_SZ     \
+    (NFFS_TEST_MBUF_DATA_SZ + sizeof(struct os_mbuf) + \
+     sizeof(struct os_mbuf_pkthdr))
+#define NFFS_TEST_MBUF_COUNT        64
+
+static os_membuf_t nffs_test_mbuf_mem[
+    OS_MEMPOOL_SIZE(NFFS_TEST_MBUF_COUNT, NFFS_TEST_MBUF_BLOCK_SZ)];
+static struct os_mempool nffs_test_mbuf_mempool;
+static struct os_mbuf_pool nffs_test_mbuf_pool;
+
+TEST_CASE_SELF(nffs_test_mbuf)
+{
+    struct fs_file *file;
+    struct os_mbuf *om;
+    uint8_t data[1000];
+    uint32_t len;
+    int rc;
+    int i;
+
+    rc = os_mempool_init(&nffs_test_mbuf_mempool, NFFS_TEST_MBUF_COUNT,
+                         NFFS_TEST_MBUF_BLOCK_SZ, nffs_test_mbuf_mem,
+                         "nffs_test_mbuf");
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = os_mbuf_pool_init(&nffs_test_mbuf_pool, &nffs_test_mbuf_mempool,
+                           NFFS_TEST_MBUF_BLOCK_SZ, NFFS_TEST_MBUF_COUNT);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    for (i = 0; i < sizeof data; i++) {
+        data[i] = i * 7;
+    }
+
+    rc = nffs_format(nffs_current_area_descs);
+    TEST_ASSERT(rc == 0);
+
+    /*** Write a multi-segment chain, skipping a leading header. */
+    om = os_mbuf_get_pkthdr(&nffs_test_mbuf_pool, 0);
+    TEST_ASSERT_FATAL(om != NULL);
+    rc = os_mbuf_append(om, "hdr", 3);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = os_mbuf_append(om, data, sizeof data);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT_FATAL(SLIST_NEXT(om, om_next) != NULL);
+
+    rc = fs_open("/myfile.txt", FS_ACCESS_WRITE, &file);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /* A region past the end of the chain is rejected without writing. */
+    rc = fs_write_mbuf(file, om, 3, sizeof data + 1);
+    TEST_ASSERT(rc == FS_EINVAL);
+    nffs_test_util_assert_file_len(file, 0);
+
+    rc = fs_write_mbuf(file, om, 3, sizeof data);
+    TEST_ASSERT(rc == 0);
+    nffs_test_util_assert_file_len(file, sizeof data);
+    rc = fs_close(file);
+    TEST_ASSERT(rc == 0);
+    os_mbuf_free_chain(om);
+
+    nffs_test_util_assert_contents("/myfile.txt", (char *)data, sizeof data);
+
+    /*** Read it back into a chain that already holds data. */
+    rc = fs_open("/myfile.txt", FS_ACCESS_READ, &file);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    om = os_mbuf_get_pkthdr(&nffs_test_mbuf_pool, 0);
+    TEST_ASSERT_FATAL(om != NULL);
+    rc = os_mbuf_append(om, "hdr", 3);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    rc = fs_read_mbuf(file, 100, om, &len);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(len == 100);
+    TEST_ASSERT(fs_getpos(file) == 100);
+
+    rc = fs_read_mbuf(file, 0xffff, om, &len);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(len == sizeof data - 100);
+
+    rc = fs_read_mbuf(file, 1, om, &len);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(len == 0);
+
+    TEST_ASSERT(OS_MBUF_PKTLEN(om) == sizeof data + 3);
+    TEST_ASSERT(os_mbuf_cmpf(om, 0, "hdr", 3) == 0);
+    TEST_ASSERT(os_mbuf_cmpf(om, 3, data, sizeof data) == 0);
+
+    rc = fs_close(file);
+    TEST_ASSERT(rc == 0);
+    os_mbuf_free_chain(om);
+}
@@ -0,0 +1,83 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "nffs_test_utils.h"
+
+TEST_CASE_SELF(nffs_test_mmap)
+{
+    struct fs_file *file;
+    const uint8_t *ptr;
+    uint8_t data[3000];
+    uint32_t extents;
+    uint32_t off;
+    uint32_t len;
+    int rc;
+    int i;
+
+    for (i = 0; i < sizeof data; i++) {
+        data[i] = i * 13;
+    }
+
+    rc = nffs_format(nffs_current_area_descs);
+    TEST_ASSERT(rc == 0);
+
+    /*** Write the file in pieces so that it spans several blocks. */
+    rc = fs_open("/myfile.txt", FS_ACCESS_WRITE, &file);
+    TEST_ASSERT_FATAL(rc == 0);
+    for (off = 0; off < sizeof data; off += 500) {
+        rc = fs_write(file, data + off, 500);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+
+    /* Mapping needs read access. */
+    rc = fs_mmap(file, 0, sizeof data, (const void **)&ptr, &len);
+    TEST_ASSERT(rc == FS_EACCESS);
+
+    rc = fs_close(file);
+    TEST_ASSERT(rc == 0);
+
+    /*** Walk the file one extent at a time. */
+    rc = fs_open("/myfile.txt", FS_ACCESS_READ, &file);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    extents = 0;
+    for (off = 0; off < sizeof data; off += len) {
+        rc = fs_mmap(file, off, sizeof data, (const void **)&ptr, &len);
+        TEST_ASSERT_FATAL(rc == 0);
+        TEST_ASSERT_FATAL(len > 0 && off + len <= sizeof data);
+        TEST_ASSERT(memcmp(ptr, data + off, len) == 0);
+        extents++;
+    }
+    TEST_ASSERT(extents > 1);
+
+    /* The handle's position is untouched. */
+    TEST_ASSERT(fs_getpos(file) == 0);
+
+    /* A mapping never extends past len. */
+    rc = fs_mmap(file, 10, 20, (const void **)&ptr, &len);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(len == 20);
+    TEST_ASSERT(memcmp(ptr, data + 10, 20) == 0);
+
+    rc = fs_mmap(file, sizeof data, 1, (const void **)&ptr, &len);
+    TEST_ASSERT(rc == FS_EOFFSET);
+
+    rc = fs_close(file);
+    TEST_ASSERT(rc == 0);
+}
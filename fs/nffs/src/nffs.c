@@ -63,7 +63,13 @@ static int nffs_close(struct fs_file *fs_file);
 static int nffs_read(struct fs_file *fs_file, uint32_t len, void *out_data,
   uint32_t *out_len);
 static int nffs_write(struct fs_file *fs_file, const void *data, int len);
+static int nffs_read_mbuf(struct fs_file *fs_file, uint32_t len,
+  struct os_mbuf *om, uint32_t *out_len);
+static int nffs_write_mbuf(struct fs_file *fs_file, const struct os_mbuf *om,
+  int off, uint32_t len);
 static int nffs_flush(struct fs_file *fs_file);
+static int nffs_mmap(struct fs_file *fs_file, uint32_t offset, uint32_t len,
+  const void **out_ptr, uint32_t *out_len);
 static int nffs_seek(struct fs_file *fs_file, uint32_t offset);
 static uint32_t nffs_getpos(const struct fs_file *fs_file);
 static int nffs_file_len(const struct fs_file *fs_file, uint32_t *out_len);
@@ -83,6 +89,9 @@ struct fs_ops nffs_ops = {
     .f_read = nffs_read,
     .f_write = nffs_write,
     .f_flush = nffs_flush,
+    .f_read_mbuf = nffs_read_mbuf,
+    .f_write_mbuf = nffs_write_mbuf,
+    .f_mmap = nffs_mmap,
 
     .f_seek = nffs_seek,
     .f_getpos = nffs_getpos,
@@ -123,6 +132,12 @@ STATS_NAME_START(nffs_stats)
     STATS_NAME(nffs_stats, nffs_readcnt_filename)
     STATS_NAME(nffs_stats, nffs_readcnt_object)
     STATS_NAME(nffs_stats, nffs_readcnt_detect)
+    STATS_NAME(nffs_stats, nffs_cache_inode_hit)
+    STATS_NAME(nffs_stats, nffs_cache_inode_miss)
+    STATS_NAME(nffs_stats, nffs_cache_block_hit)
+    STATS_NAME(nffs_stats, nffs_cache_block_miss)
+    STATS_NAME(nffs_stats, nffs_cache_index_hit)
+    STATS_NAME(nffs_stats, nffs_cache_readahead)
 STATS_NAME_END(nffs_stats)
 
 static void
@@ -385,6 +400,118 @@ done:
     return rc;
 }
 
+static int
+nffs_read_segment(struct fs_file *fs_file, uint32_t len, void *out_data,
+                  uint32_t *out_len)
+{
+    return nffs_file_read((struct nffs_file *)fs_file, len, out_data, out_len);
+}
+
+static int
+nffs_write_segment(struct fs_file *fs_file, const void *data, int len)
+{
+    return nffs_write_to_file((struct nffs_file *)fs_file, data, len);
+}
+
+/**
+ * Reads data from the specified file handle and appends it to an mbuf chain.
+ * The whole read happens under a single acquisition of the nffs lock.
+ *
+ * @param file              The file to read from.
+ * @param len               The maximum number of bytes to read.
+ * @param om                The chain to append the data to.
+ * @param out_len           On success, the number of bytes actually read
+ *                              gets written here.  Pass null if you don't
+ *                              care.
+ *
+ * @return                  0 on success; nonzero on failure.
+ */
+static int
+nffs_read_mbuf(struct fs_file *fs_file, uint32_t len, struct os_mbuf *om,
+               uint32_t *out_len)
+{
+    uint32_t bytes_read;
+    int rc;
+
+    nffs_lock();
+    rc = fs_mbuf_read_segments(fs_file, nffs_read_segment, len, om,
+                               &bytes_read);
+    nffs_unlock();
+
+    if (out_len != NULL) {
+        *out_len = bytes_read;
+    }
+
+    return rc;
+}
+
+/**
+ * Writes a region of an mbuf chain to the current offset of the specified
+ * file handle.  The whole chain is written under a single acquisition of the
+ * nffs lock.
+ *
+ * @param file              The file to write to.
+ * @param om                The chain holding the data.
+ * @param off               The offset within the chain of the first byte to
+ *                              write.
+ * @param len               The number of bytes to write.
+ *
+ * @return                  0 on success; nonzero on failure.
+ */
+static int
+nffs_write_mbuf(struct fs_file *fs_file, const struct os_mbuf *om, int off,
+                uint32_t len)
+{
+    int rc;
+
+    nffs_lock();
+
+    if (!nffs_misc_ready()) {
+        rc = FS_EUNINIT;
+    } else {
+        rc = fs_mbuf_write_segments(fs_file, nffs_write_segment, om, off, len);
+    }
+
+    nffs_unlock();
+    return rc;
+}
+
+/**
+ * Maps part of the specified file for reading in place.  The file's offset is
+ * not changed.
+ *
+ * @param file              The file to map.
+ * @param offset            The offset within the file to map from.
+ * @param len               The maximum number of bytes to map.
+ * @param out_ptr           On success, the address of the data gets written
+ *                              here.
+ * @param out_len           On success, the number of contiguous bytes
+ *                              mapped gets written here.
+ *
+ * @return                  0 on success; nonzero on failure.
+ */
+static int
+nffs_mmap(struct fs_file *fs_file, uint32_t offset, uint32_t len,
+          const void **out_ptr, uint32_t *out_len)
+{
+    struct nffs_file *file = (struct nffs_file *)fs_file;
+    int rc;
+
+    nffs_lock();
+
+    if (!nffs_misc_ready()) {
+        rc = FS_EUNINIT;
+    } else if (!(file->nf_access_flags & FS_ACCESS_READ)) {
+        rc = FS_EACCESS;
+    } else {
+        rc = nffs_inode_mmap(file->nf_inode_entry, offset, len, out_ptr,
+                             out_len);
+    }
+
+    nffs_unlock();
+    return rc;
+}
+
 /**
  * Unlinks the file or directory at the specified path.  If the path refers to
  * a directory, all the directory's descendants are recursively unlinked.  Any
@@ -681,12 +808,58 @@ nffs_detect(const struct nffs_area_desc *area_descs)
     int rc;
 
     nffs_lock();
+#if MYNEWT_VAL(NFFS_CHECKPOINT)
+    rc = nffs_restore_checkpoint(area_descs);
+    if (rc != 0) {
+        /* Missing or stale checkpoint; make sure a stale one is not used
+         * again and fall back to a scan of all areas.
+         */
+        nffs_checkpoint_invalidate();
+        rc = nffs_restore_full(area_descs);
+    }
+#else
     rc = nffs_restore_full(area_descs);
+#endif
+    nffs_unlock();
+
+    return rc;
+}
+
+#if MYNEWT_VAL(NFFS_CHECKPOINT)
+/**
+ * Writes a checkpoint of the file system to the region configured with
+ * nffs_checkpoint_init().  The next nffs_detect() restores from the
+ * checkpoint and only scans objects written after it, as long as no garbage
+ * collection happened in between.
+ *
+ * @return                  0 on success;
+ *                          FS_ENOENT if no checkpoint region is configured;
+ *                          FS_EFULL if the checkpoint region is too small;
+ *                          other nonzero on error.
+ */
+int
+nffs_checkpoint(void)
+{
+    int rc;
+
+    nffs_lock();
+    rc = nffs_checkpoint_write();
     nffs_unlock();
 
     return rc;
 }
 
+int
+nffs_sysdown(int reason)
+{
+    if (nffs_misc_ready()) {
+        nffs_checkpoint();
+    }
+
+    return SYSDOWN_COMPLETE;
+}
+#endif
+
 /**
  * Initializes internal nffs memory and data structures.  This must be called
  * before any nffs operations are attempted.
@@ -782,6 +955,24 @@ nffs_pkg_init(void)
     rc = nffs_init();
     SYSINIT_PANIC_ASSERT(rc == 0);
 
+#if MYNEWT_VAL(NFFS_CHECKPOINT) && MYNEWT_VAL(NFFS_CHECKPOINT_FLASH_AREA) >= 0
+    {
+        const struct flash_area *fa;
+        struct nffs_area_desc checkpoint_desc;
+
+        rc = flash_area_open(MYNEWT_VAL(NFFS_CHECKPOINT_FLASH_AREA), &fa);
+        SYSINIT_PANIC_ASSERT(rc == 0);
+
+        checkpoint_desc.nad_offset = fa->fa_off;
+        checkpoint_desc.nad_length = fa->fa_size;
+        checkpoint_desc.nad_flash_id = fa->fa_device_id;
+        flash_area_close(fa);
+
+        rc = nffs_checkpoint_init(&checkpoint_desc);
+        SYSINIT_PANIC_ASSERT(rc == 0);
+    }
+#endif
+
     /* Convert the set of flash blocks we intend to use for nffs into an array
      * of nffs area descriptors.
      */
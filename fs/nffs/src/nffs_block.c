@@ -449,6 +449,21 @@ nffs_block_read_data(const struct nffs_block *block, uint16_t offset,
     return 0;
 }
 
+int
+nffs_block_mmap_data(const struct nffs_block *block, uint16_t offset,
+                     uint16_t length, const void **out_ptr)
+{
+    uint32_t area_offset;
+    uint8_t area_idx;
+
+    nffs_flash_loc_expand(block->nb_hash_entry->nhe_flash_loc,
+                         &area_idx, &area_offset);
+    area_offset += sizeof (struct nffs_disk_block);
+    area_offset += offset;
+
+    return nffs_flash_mmap(area_idx, area_offset, length, out_ptr);
+}
+
 int
 nffs_block_is_dummy(struct nffs_hash_entry *entry)
 {
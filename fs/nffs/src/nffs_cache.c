@@ -230,6 +230,113 @@ nffs_cache_reclaim_blocks(void)
     assert(0);
 }
 
+#if NFFS_CACHE_INDEX_SIZE > 0
+static void
+nffs_cache_index_clear(struct nffs_cache_inode *cache_inode)
+{
+    memset(cache_inode->nci_index, 0, sizeof cache_inode->nci_index);
+    cache_inode->nci_index_width = 0;
+}
+
+/**
+ * Makes sure the inode's seek index covers the whole file.  Slots are made
+ * wider, and the index emptied, if the file has grown well beyond what the
+ * index was sized for.
+ */
+static void
+nffs_cache_index_size(struct nffs_cache_inode *cache_inode)
+{
+    uint32_t width;
+
+    width = cache_inode->nci_index_width;
+    if (width != 0 &&
+        cache_inode->nci_file_size <= 2 * NFFS_CACHE_INDEX_SIZE * width) {
+        return;
+    }
+
+    nffs_cache_index_clear(cache_inode);
+
+    width = (cache_inode->nci_file_size + NFFS_CACHE_INDEX_SIZE - 1) /
+            NFFS_CACHE_INDEX_SIZE;
+    if (width < nffs_block_max_data_sz) {
+        width = nffs_block_max_data_sz;
+    }
+    cache_inode->nci_index_width = width;
+}
+
+/**
+ * Records a block visited during a seek in the index slots it covers.  The
+ * last block of a file can still grow, so it is never indexed; the end
+ * offset of any other block stays the same until garbage collection.
+ */
+static void
+nffs_cache_index_note(struct nffs_cache_inode *cache_inode,
+                      struct nffs_hash_entry *block_entry,
+                      uint32_t block_start, uint32_t block_end)
+{
+    struct nffs_cache_index *slot;
+    uint32_t width;
+    uint32_t i;
+
+    width = cache_inode->nci_index_width;
+    if (width == 0 ||
+        block_entry ==
+            cache_inode->nci_inode.ni_inode_entry->nie_last_block_entry) {
+        return;
+    }
+
+    for (i = block_start / width;
+         i < NFFS_CACHE_INDEX_SIZE && (i + 1) * width - 1 < block_end;
+         i++) {
+
+        slot = &cache_inode->nci_index[i];
+        slot->nci_block_entry = block_entry;
+        slot->nci_block_end = block_end;
+    }
+}
+
+/**
+ * Finds the indexed block to start a backwards walk from when seeking to
+ * the specified offset.  The block is picked so that the walk passes over
+ * about readahead blocks following the sought-after one.
+ *
+ * @return                      0 if a block was found; FS_ENOENT otherwise.
+ */
+static int
+nffs_cache_index_find(const struct nffs_cache_inode *cache_inode,
+                      uint32_t seek_offset, int readahead,
+                      struct nffs_hash_entry **out_block_entry,
+                      uint32_t *out_block_end)
+{
+    const struct nffs_cache_index *slot;
+    uint32_t width;
+    int first;
+    int i;
+
+    width = cache_inode->nci_index_width;
+    if (width == 0 || seek_offset / width >= NFFS_CACHE_INDEX_SIZE) {
+        return FS_ENOENT;
+    }
+
+    first = seek_offset / width;
+    i = (seek_offset + (uint32_t)readahead * nffs_block_max_data_sz) / width;
+    if (i >= NFFS_CACHE_INDEX_SIZE) {
+        i = NFFS_CACHE_INDEX_SIZE - 1;
+    }
+
+    for (; i >= first; i--) {
+        slot = &cache_inode->nci_index[i];
+        if (slot->nci_block_entry != NULL) {
+            *out_block_entry = slot->nci_block_entry;
+            *out_block_end = slot->nci_block_end;
+            return 0;
+        }
+    }
+
+    return FS_ENOENT;
+}
+#endif
+
 void
 nffs_cache_inode_delete(const struct nffs_inode_entry *inode_entry)
 {
@@ -253,10 +360,12 @@ nffs_cache_inode_ensure(struct nffs_cache_inode **out_cache_inode,
 
     cache_inode = nffs_cache_inode_find(inode_entry);
     if (cache_inode != NULL) {
+        STATS_INC(nffs_stats, nffs_cache_inode_hit);
         rc = 0;
         goto done;
     }
 
+    STATS_INC(nffs_stats, nffs_cache_inode_miss);
     cache_inode = nffs_cache_inode_acquire();
     rc = nffs_cache_inode_populate(cache_inode, inode_entry);
     if (rc != 0) {
@@ -294,6 +403,10 @@ nffs_cache_inode_refresh(void)
     TAILQ_FOREACH(cache_inode, &nffs_cache_inode_list, nci_link) {
         /* Clear entire block list. */
         nffs_cache_inode_free_blocks(cache_inode);
+#if NFFS_CACHE_INDEX_SIZE > 0
+        /* Blocks may have been merged; the index is stale. */
+        nffs_cache_index_clear(cache_inode);
+#endif
 
         inode_entry = cache_inode->nci_inode.ni_inode_entry;
         rc = nffs_inode_from_entry(&cache_inode->nci_inode, inode_entry);
@@ -344,6 +457,42 @@ nffs_cache_insert_block(struct nffs_cache_inode *cache_inode,
     nffs_cache_log_insert_block(cache_inode, cache_block, tail);
 }
 
+#if NFFS_CACHE_READAHEAD_MAX > 0
+/**
+ * Appends blocks which follow the last cached block to the cache.  The
+ * blocks were picked up while walking the block chain; blocks[0] is the one
+ * immediately after the cache end.  Read-ahead stops early rather than
+ * reclaiming cache blocks if the block pool runs out.
+ */
+static void
+nffs_cache_readahead(struct nffs_cache_inode *cache_inode,
+                     const struct nffs_block *blocks, int num_blocks)
+{
+    struct nffs_cache_block *cache_block;
+    uint32_t file_offset;
+    int i;
+
+    cache_block = TAILQ_LAST(&cache_inode->nci_block_list,
+                             nffs_cache_block_list);
+    file_offset = cache_block->ncb_file_offset +
+                  cache_block->ncb_block.nb_data_len;
+
+    for (i = 0; i < num_blocks; i++) {
+        cache_block = nffs_cache_block_alloc();
+        if (cache_block == NULL) {
+            break;
+        }
+
+        cache_block->ncb_block = blocks[i];
+        cache_block->ncb_file_offset = file_offset;
+        nffs_cache_insert_block(cache_inode, cache_block, 1);
+        STATS_INC(nffs_stats, nffs_cache_readahead);
+
+        file_offset += blocks[i].nb_data_len;
+    }
+}
+#endif
+
 /**
  * Finds the data block containing the specified offset within a file inode.
  * If the block is not yet cached, it gets cached as a result of this
@@ -355,14 +504,22 @@ nffs_cache_insert_block(struct nffs_cache_inode *cache_inode,
  *  2. Else if the requested file offset is less than that of the first cached
  *     block, bridge the gap between the inode's sequence of cached blocks and
  *     the block that now needs to be cached.  This is accomplished by caching
- *     each block in the gap, finishing with the requested block.
+ *     each block in the gap, finishing with the requested block.  If the
+ *     gap is large and the seek index knows a block close to the requested
+ *     one, the cache is cleared and repopulated from there instead.
  *  3. Else (the requested offset is beyond the end of the cache),
  *      a. If the requested offset belongs to the block that immediately
  *         follows the end of the cache, cache the block and append it to the
- *         list.
+ *         list.  If this keeps happening the file is being read
+ *         sequentially, and a growing number of the blocks that follow get
+ *         cached as well (read-ahead).
  *      b. Else, clear the cache, and populate it with the single entry
  *         corresponding to the requested block.
  *
+ * Blocks are only linked to their predecessors, so finding a block beyond
+ * the end of the cache means walking backwards.  The walk starts at the end
+ * of the file, or at the closest block recorded in the inode's seek index.
+ *
  * @param cache_inode           The cached file inode to seek within.
  * @param seek_offset           The file offset to seek to.
  * @param out_cache_block       On success, the requested cached block gets
@@ -385,12 +542,27 @@ nffs_cache_seek(struct nffs_cache_inode *cache_inode, uint32_t seek_offset,
     uint32_t block_start;
     uint32_t block_end;
     int rc;
+#if NFFS_CACHE_READAHEAD_MAX > 0 || NFFS_CACHE_INDEX_SIZE > 0
+    int readahead;
+#endif
+#if NFFS_CACHE_READAHEAD_MAX > 0
+    struct nffs_block ra_blocks[NFFS_CACHE_READAHEAD_MAX];
+    int ra_cnt;
+    int i;
+#endif
 
     /* Empty files have no blocks that can be cached. */
     if (cache_inode->nci_file_size == 0) {
         return FS_ENOENT;
     }
 
+#if NFFS_CACHE_INDEX_SIZE > 0
+    nffs_cache_index_size(cache_inode);
+#endif
+#if NFFS_CACHE_READAHEAD_MAX > 0 || NFFS_CACHE_INDEX_SIZE > 0
+    readahead = 0;
+#endif
+
     nffs_cache_inode_range(cache_inode, &cache_start, &cache_end);
     if (cache_end != 0 && seek_offset < cache_start) {
         /* Seeking prior to cache.  Iterate backwards from cache start. */
@@ -398,12 +570,29 @@ nffs_cache_seek(struct nffs_cache_inode *cache_inode, uint32_t seek_offset,
         block_entry = cache_block->ncb_block.nb_prev;
         block_end = cache_block->ncb_file_offset;
         cache_block = NULL;
+        STATS_INC(nffs_stats, nffs_cache_block_miss);
+
+#if NFFS_CACHE_INDEX_SIZE > 0
+        /* If the sought-after block is far before the cache, starting over
+         * from an indexed block is cheaper than caching the whole gap.
+         */
+        if (cache_start - seek_offset > 2 * cache_inode->nci_index_width &&
+            nffs_cache_index_find(cache_inode, seek_offset, 0,
+                                  &block_entry, &block_end) == 0) {
+
+            STATS_INC(nffs_stats, nffs_cache_index_hit);
+            nffs_cache_inode_free_blocks(cache_inode);
+            cache_start = 0;
+            cache_end = 0;
+        }
+#endif
     } else if (seek_offset < cache_end) {
         /* Seeking within cache.  Iterate backwards from cache end. */
         cache_block = TAILQ_LAST(&cache_inode->nci_block_list,
                                  nffs_cache_block_list);
         block_entry = cache_block->ncb_block.nb_hash_entry;
         block_end = cache_end;
+        STATS_INC(nffs_stats, nffs_cache_block_hit);
     } else {
         /* Seeking beyond end of cache.  Iterate backwards from file end.  If
          * sought-after block is adjacent to cache end, its cache entry will
@@ -414,8 +603,28 @@ nffs_cache_seek(struct nffs_cache_inode *cache_inode, uint32_t seek_offset,
         block_entry =
             cache_inode->nci_inode.ni_inode_entry->nie_last_block_entry;
         block_end = cache_inode->nci_file_size;
+        STATS_INC(nffs_stats, nffs_cache_block_miss);
+
+#if NFFS_CACHE_READAHEAD_MAX > 0
+        /* Looks like the next read of a sequential stream. */
+        if (cache_end != 0 &&
+            seek_offset - cache_end < nffs_block_max_data_sz) {
+
+            readahead = cache_inode->nci_readahead;
+        }
+#endif
+#if NFFS_CACHE_INDEX_SIZE > 0
+        if (nffs_cache_index_find(cache_inode, seek_offset, readahead,
+                                  &block_entry, &block_end) == 0) {
+            STATS_INC(nffs_stats, nffs_cache_index_hit);
+        }
+#endif
     }
 
+#if NFFS_CACHE_READAHEAD_MAX > 0
+    ra_cnt = 0;
+#endif
+
     /* Scan backwards until we find the block containing the seek offest. */
     while (1) {
         if (block_end <= cache_start) {
@@ -453,6 +662,14 @@ nffs_cache_seek(struct nffs_cache_inode *cache_inode, uint32_t seek_offset,
             pred_entry = block.nb_prev;
         }
 
+#if NFFS_CACHE_INDEX_SIZE > 0
+        nffs_cache_index_note(cache_inode,
+                              cache_block != NULL ?
+                                  cache_block->ncb_block.nb_hash_entry :
+                                  block_entry,
+                              block_start, block_end);
+#endif
+
         if (block_start <= seek_offset) {
             /* This block contains the requested address; iteration is
              * complete.
@@ -472,10 +689,28 @@ nffs_cache_seek(struct nffs_cache_inode *cache_inode, uint32_t seek_offset,
                     last_cached_entry == pred_entry) {
 
                     nffs_cache_insert_block(cache_inode, cache_block, 1);
+#if NFFS_CACHE_READAHEAD_MAX > 0
+                    /* Sequential access; widen the read-ahead window. */
+                    if (cache_inode->nci_readahead == 0) {
+                        cache_inode->nci_readahead = 1;
+                    } else if (cache_inode->nci_readahead * 2 <=
+                               NFFS_CACHE_READAHEAD_MAX) {
+                        cache_inode->nci_readahead *= 2;
+                    } else {
+                        cache_inode->nci_readahead = NFFS_CACHE_READAHEAD_MAX;
+                    }
+#endif
                 } else {
                     nffs_cache_inode_free_blocks(cache_inode);
                     nffs_cache_insert_block(cache_inode, cache_block, 0);
+#if NFFS_CACHE_READAHEAD_MAX > 0
+                    cache_inode->nci_readahead = 0;
+#endif
                 }
+
+#if NFFS_CACHE_READAHEAD_MAX > 0
+                nffs_cache_readahead(cache_inode, ra_blocks, ra_cnt);
+#endif
             }
 
             if (out_cache_block != NULL) {
@@ -489,6 +724,21 @@ nffs_cache_seek(struct nffs_cache_inode *cache_inode, uint32_t seek_offset,
             cache_block = TAILQ_PREV(cache_block, nffs_cache_block_list,
                                      ncb_link);
         }
+#if NFFS_CACHE_READAHEAD_MAX > 0
+        else if (readahead > 0) {
+            /* Remember the blocks just after the one being sought; keep
+             * them ordered by file offset.
+             */
+            if (ra_cnt == readahead) {
+                ra_cnt--;
+            }
+            for (i = ra_cnt; i > 0; i--) {
+                ra_blocks[i] = ra_blocks[i - 1];
+            }
+            ra_blocks[0] = block;
+            ra_cnt++;
+        }
+#endif
         block_entry = pred_entry;
         block_end = block_start;
     }
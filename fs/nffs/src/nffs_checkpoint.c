@@ -0,0 +1,568 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+
+#if MYNEWT_VAL(NFFS_CHECKPOINT)
+
+#include <assert.h>
+#include <string.h>
+#include "hal/hal_flash.h"
+#include "nffs_priv.h"
+#include "nffs/nffs.h"
+
+/*
+ * A checkpoint is a copy of the RAM representation of the file system (the
+ * area table and the inode and block hash entries) kept in a flash region
+ * outside of the nffs areas.  Restoring from a checkpoint replaces the scan
+ * of every object in every area; only objects written after the checkpoint
+ * (past each area's recorded write offset) still get scanned.
+ *
+ * A checkpoint is only valid as long as no area it describes has been
+ * rewritten.  The first garbage collection cycle after a checkpoint was
+ * written or restored erases it again.
+ */
+
+/** Where the checkpoint lives; nad_length == 0 means checkpoints are off. */
+static struct nffs_area_desc nffs_checkpoint_desc;
+
+/** Set if the checkpoint region may hold a checkpoint header. */
+static int nffs_checkpoint_present;
+
+/**
+ * Configures the flash region used for checkpoints.  Must be called before
+ * nffs_detect() for the checkpoint to be used when restoring.
+ *
+ * @param area_desc         The region to use; NULL to disable checkpoints.
+ *
+ * @return                  0 on success; nonzero on failure.
+ */
+int
+nffs_checkpoint_init(const struct nffs_area_desc *area_desc)
+{
+    if (area_desc == NULL) {
+        memset(&nffs_checkpoint_desc, 0, sizeof nffs_checkpoint_desc);
+        nffs_checkpoint_present = 0;
+        return 0;
+    }
+
+    if (area_desc->nad_length < sizeof (struct nffs_disk_checkpoint)) {
+        return FS_EINVAL;
+    }
+
+    nffs_checkpoint_desc = *area_desc;
+
+    /* Contents unknown until the first restore or format. */
+    nffs_checkpoint_present = 1;
+
+    return 0;
+}
+
+static int
+nffs_checkpoint_read(uint32_t offset, void *data, uint32_t len,
+                     uint16_t *crc)
+{
+    int rc;
+
+    if (offset + len > nffs_checkpoint_desc.nad_length) {
+        return FS_ECORRUPT;
+    }
+
+    STATS_INC(nffs_stats, nffs_iocnt_read);
+    rc = hal_flash_read(nffs_checkpoint_desc.nad_flash_id,
+                        nffs_checkpoint_desc.nad_offset + offset, data, len);
+    if (rc != 0) {
+        return FS_EHW;
+    }
+
+    if (crc != NULL) {
+        *crc = crc16_ccitt(*crc, data, len);
+    }
+
+    return 0;
+}
+
+/**
+ * Appends one record to the checkpoint being written.  For a dry run, the
+ * record is only accounted for in the offset.
+ */
+static int
+nffs_checkpoint_put(uint32_t *offset, const void *data, uint32_t len,
+                    uint16_t *crc, int dry_run)
+{
+    int rc;
+
+    if (!dry_run) {
+        STATS_INC(nffs_stats, nffs_iocnt_write);
+        rc = hal_flash_write(nffs_checkpoint_desc.nad_flash_id,
+                             nffs_checkpoint_desc.nad_offset + *offset,
+                             data, len);
+        if (rc != 0) {
+            return FS_EHW;
+        }
+        *crc = crc16_ccitt(*crc, data, len);
+    }
+    *offset += len;
+
+    return 0;
+}
+
+static int
+nffs_checkpoint_put_inode(uint32_t *offset, struct nffs_inode_entry *entry,
+                          uint32_t parent_id, uint16_t *crc, int dry_run)
+{
+    struct nffs_disk_checkpoint_inode rec;
+
+    rec.ndci_id = entry->nie_hash_entry.nhe_id;
+    rec.ndci_flash_loc = entry->nie_hash_entry.nhe_flash_loc;
+    rec.ndci_parent_id = parent_id;
+    rec.ndci_lastblock_id = NFFS_ID_NONE;
+    if (nffs_hash_id_is_file(rec.ndci_id) &&
+        entry->nie_last_block_entry != NULL) {
+
+        rec.ndci_lastblock_id = entry->nie_last_block_entry->nhe_id;
+    }
+
+    return nffs_checkpoint_put(offset, &rec, sizeof rec, crc, dry_run);
+}
+
+/**
+ * Writes (or, for a dry run, sizes) the area, block and inode records of a
+ * checkpoint.  Only inodes reachable from the root directory are recorded;
+ * blocks of unlinked files get discarded by the sweep that follows a
+ * restore.
+ */
+static int
+nffs_checkpoint_put_records(struct nffs_disk_checkpoint *hdr,
+                            uint32_t *offset, uint16_t *crc, int dry_run)
+{
+    struct nffs_disk_checkpoint_block block_rec;
+    struct nffs_disk_checkpoint_area area_rec;
+    struct nffs_inode_entry *inode_entry;
+    struct nffs_inode_entry *child;
+    struct nffs_hash_entry *entry;
+    struct nffs_hash_entry *next;
+    int rc;
+    int i;
+
+    for (i = 0; i < nffs_num_areas; i++) {
+        memset(&area_rec, 0, sizeof area_rec);
+        area_rec.ndca_offset = nffs_areas[i].na_offset;
+        area_rec.ndca_length = nffs_areas[i].na_length;
+        area_rec.ndca_cur = nffs_areas[i].na_cur;
+        area_rec.ndca_id = nffs_areas[i].na_id;
+        area_rec.ndca_gc_seq = nffs_areas[i].na_gc_seq;
+        area_rec.ndca_flash_id = nffs_areas[i].na_flash_id;
+        rc = nffs_checkpoint_put(offset, &area_rec, sizeof area_rec, crc,
+                                 dry_run);
+        if (rc != 0) {
+            return rc;
+        }
+    }
+
+    hdr->ndc_num_blocks = 0;
+    NFFS_HASH_FOREACH(entry, i, next) {
+        if (nffs_hash_id_is_block(entry->nhe_id) &&
+            !nffs_hash_entry_is_dummy(entry)) {
+
+            block_rec.ndcb_id = entry->nhe_id;
+            block_rec.ndcb_flash_loc = entry->nhe_flash_loc;
+            rc = nffs_checkpoint_put(offset, &block_rec, sizeof block_rec,
+                                     crc, dry_run);
+            if (rc != 0) {
+                return rc;
+            }
+            hdr->ndc_num_blocks++;
+        }
+    }
+
+    rc = nffs_checkpoint_put_inode(offset, nffs_root_dir, NFFS_ID_NONE, crc,
+                                   dry_run);
+    if (rc != 0) {
+        return rc;
+    }
+    hdr->ndc_num_inodes = 1;
+
+    NFFS_HASH_FOREACH(entry, i, next) {
+        if (!nffs_hash_id_is_dir(entry->nhe_id)) {
+            continue;
+        }
+
+        inode_entry = (struct nffs_inode_entry *)entry;
+        if (inode_entry != nffs_root_dir &&
+            !nffs_inode_getflags(inode_entry, NFFS_INODE_FLAG_INTREE)) {
+
+            continue;
+        }
+
+        SLIST_FOREACH(child, &inode_entry->nie_child_list, nie_sibling_next) {
+            rc = nffs_checkpoint_put_inode(offset, child, entry->nhe_id, crc,
+                                           dry_run);
+            if (rc != 0) {
+                return rc;
+            }
+            hdr->ndc_num_inodes++;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Writes a checkpoint of the current file system state.  The records are
+ * written first and the header last, so a checkpoint that was interrupted is
+ * never mistaken for a valid one.
+ *
+ * @return                      0 on success;
+ *                              FS_ENOENT if checkpoints are not configured;
+ *                              FS_EFULL if the checkpoint region is too
+ *                                  small;
+ *                              nonzero on other failure.
+ */
+int
+nffs_checkpoint_write(void)
+{
+    struct nffs_disk_checkpoint hdr;
+    uint32_t offset;
+    uint16_t crc;
+    int rc;
+
+    if (nffs_checkpoint_desc.nad_length == 0) {
+        return FS_ENOENT;
+    }
+
+    if (!nffs_misc_ready()) {
+        return FS_EUNINIT;
+    }
+
+    memset(&hdr, 0, sizeof hdr);
+    offset = sizeof hdr;
+    crc = 0;
+    rc = nffs_checkpoint_put_records(&hdr, &offset, &crc, 1);
+    if (rc != 0) {
+        return rc;
+    }
+    if (offset > nffs_checkpoint_desc.nad_length) {
+        return FS_EFULL;
+    }
+
+    nffs_checkpoint_present = 1;
+    rc = hal_flash_erase(nffs_checkpoint_desc.nad_flash_id,
+                         nffs_checkpoint_desc.nad_offset, offset);
+    if (rc != 0) {
+        return FS_EHW;
+    }
+
+    offset = sizeof hdr;
+    crc = 0;
+    rc = nffs_checkpoint_put_records(&hdr, &offset, &crc, 0);
+    if (rc != 0) {
+        return rc;
+    }
+
+    hdr.ndc_magic = NFFS_CHECKPOINT_MAGIC;
+    hdr.ndc_next_file_id = nffs_hash_next_file_id;
+    hdr.ndc_next_dir_id = nffs_hash_next_dir_id;
+    hdr.ndc_next_block_id = nffs_hash_next_block_id;
+    hdr.ndc_block_max_data_sz = nffs_block_max_data_sz;
+    hdr.ndc_ver = NFFS_CHECKPOINT_VER;
+    hdr.ndc_num_areas = nffs_num_areas;
+    hdr.ndc_scratch_area_idx = nffs_scratch_area_idx;
+    hdr.ndc_crc16 = crc16_ccitt(crc, &hdr, NFFS_DISK_CHECKPOINT_OFFSET_CRC);
+
+    offset = 0;
+    return nffs_checkpoint_put(&offset, &hdr, sizeof hdr, &crc, 0);
+}
+
+/**
+ * Erases the checkpoint header, if one may be present.  Called before any
+ * area gets rewritten, as the checkpoint no longer describes the areas
+ * afterwards.
+ *
+ * @return                      0 on success; nonzero on failure.
+ */
+int
+nffs_checkpoint_invalidate(void)
+{
+    int rc;
+
+    if (!nffs_checkpoint_present) {
+        return 0;
+    }
+
+    rc = hal_flash_erase(nffs_checkpoint_desc.nad_flash_id,
+                         nffs_checkpoint_desc.nad_offset,
+                         sizeof (struct nffs_disk_checkpoint));
+    if (rc != 0) {
+        return FS_EHW;
+    }
+    nffs_checkpoint_present = 0;
+
+    return 0;
+}
+
+static const struct nffs_area_desc *
+nffs_checkpoint_find_desc(const struct nffs_area_desc *area_descs,
+                          const struct nffs_disk_checkpoint_area *rec)
+{
+    int i;
+
+    for (i = 0; area_descs[i].nad_length != 0; i++) {
+        if (area_descs[i].nad_offset == rec->ndca_offset &&
+            area_descs[i].nad_length == rec->ndca_length &&
+            area_descs[i].nad_flash_id == rec->ndca_flash_id) {
+
+            return area_descs + i;
+        }
+    }
+
+    return NULL;
+}
+
+static int
+nffs_checkpoint_load_inode(const struct nffs_disk_checkpoint_inode *rec)
+{
+    struct nffs_inode_entry *inode_entry;
+    uint8_t area_idx;
+    uint32_t area_offset;
+
+    nffs_flash_loc_expand(rec->ndci_flash_loc, &area_idx, &area_offset);
+    if (!nffs_hash_id_is_inode(rec->ndci_id) || area_idx >= nffs_num_areas ||
+        nffs_hash_find(rec->ndci_id) != NULL) {
+
+        return FS_ECORRUPT;
+    }
+
+    inode_entry = nffs_inode_entry_alloc();
+    if (inode_entry == NULL) {
+        return FS_ENOMEM;
+    }
+    inode_entry->nie_hash_entry.nhe_id = rec->ndci_id;
+    inode_entry->nie_hash_entry.nhe_flash_loc = rec->ndci_flash_loc;
+    inode_entry->nie_refcnt = 1;
+
+    if (nffs_hash_id_is_file(rec->ndci_id)) {
+        if (rec->ndci_lastblock_id != NFFS_ID_NONE) {
+            inode_entry->nie_last_block_entry =
+                nffs_hash_find_block(rec->ndci_lastblock_id);
+            if (inode_entry->nie_last_block_entry == NULL) {
+                nffs_inode_entry_free(inode_entry);
+                return FS_ECORRUPT;
+            }
+        }
+    } else {
+        SLIST_INIT(&inode_entry->nie_child_list);
+    }
+
+    nffs_hash_insert(&inode_entry->nie_hash_entry);
+
+    if (rec->ndci_id == NFFS_ID_ROOT_DIR) {
+        nffs_root_dir = inode_entry;
+        nffs_inode_setflags(nffs_root_dir, NFFS_INODE_FLAG_INTREE);
+    }
+
+    return 0;
+}
+
+/**
+ * Loads a checkpoint into the RAM representation.  The caller must have reset
+ * the RAM representation beforehand and must scan the areas past the
+ * recorded write offsets afterwards.  The area headers are not checked here.
+ *
+ * @param area_descs            The area set being restored.
+ * @param out_block_max_data_sz On success, the maximum block data size in
+ *                                  effect when the checkpoint was written.
+ *
+ * @return                      0 on success;
+ *                              FS_ENOENT if there is no checkpoint;
+ *                              FS_ECORRUPT if the checkpoint does not match
+ *                                  the area set or fails its CRC check;
+ *                              nonzero on other failure.
+ */
+int
+nffs_checkpoint_load(const struct nffs_area_desc *area_descs,
+                     uint16_t *out_block_max_data_sz)
+{
+    struct nffs_disk_checkpoint_inode inode_rec;
+    struct nffs_disk_checkpoint_block block_rec;
+    struct nffs_disk_checkpoint_area area_rec;
+    struct nffs_disk_checkpoint hdr;
+    struct nffs_inode_entry *parent;
+    struct nffs_inode_entry *child;
+    struct nffs_inode_entry *prev;
+    struct nffs_hash_entry *entry;
+    uint32_t inode_offset;
+    uint32_t area_offset;
+    uint32_t offset;
+    uint16_t crc;
+    uint8_t area_idx;
+    int num_descs;
+    int rc;
+    int i;
+
+    if (nffs_checkpoint_desc.nad_length == 0) {
+        return FS_ENOENT;
+    }
+
+    rc = nffs_checkpoint_read(0, &hdr, sizeof hdr, NULL);
+    if (rc != 0) {
+        return rc;
+    }
+    if (hdr.ndc_magic != NFFS_CHECKPOINT_MAGIC) {
+        nffs_checkpoint_present = 0;
+        return FS_ENOENT;
+    }
+    nffs_checkpoint_present = 1;
+
+    for (num_descs = 0; area_descs[num_descs].nad_length != 0; num_descs++);
+    if (hdr.ndc_ver != NFFS_CHECKPOINT_VER ||
+        hdr.ndc_num_areas != num_descs ||
+        hdr.ndc_scratch_area_idx >= hdr.ndc_num_areas) {
+
+        return FS_ECORRUPT;
+    }
+
+    rc = nffs_misc_set_num_areas(hdr.ndc_num_areas);
+    if (rc != 0) {
+        return rc;
+    }
+
+    crc = 0;
+    offset = sizeof hdr;
+    for (i = 0; i < hdr.ndc_num_areas; i++) {
+        rc = nffs_checkpoint_read(offset, &area_rec, sizeof area_rec, &crc);
+        if (rc != 0) {
+            return rc;
+        }
+        offset += sizeof area_rec;
+
+        if (nffs_checkpoint_find_desc(area_descs, &area_rec) == NULL ||
+            area_rec.ndca_cur > area_rec.ndca_length) {
+
+            return FS_ECORRUPT;
+        }
+
+        nffs_areas[i].na_offset = area_rec.ndca_offset;
+        nffs_areas[i].na_length = area_rec.ndca_length;
+        nffs_areas[i].na_cur = area_rec.ndca_cur;
+        nffs_areas[i].na_id = area_rec.ndca_id;
+        nffs_areas[i].na_gc_seq = area_rec.ndca_gc_seq;
+        nffs_areas[i].na_flash_id = area_rec.ndca_flash_id;
+    }
+    nffs_scratch_area_idx = hdr.ndc_scratch_area_idx;
+
+    for (i = 0; i < hdr.ndc_num_blocks; i++) {
+        rc = nffs_checkpoint_read(offset, &block_rec, sizeof block_rec, &crc);
+        if (rc != 0) {
+            return rc;
+        }
+        offset += sizeof block_rec;
+
+        nffs_flash_loc_expand(block_rec.ndcb_flash_loc, &area_idx,
+                              &area_offset);
+        if (!nffs_hash_id_is_block(block_rec.ndcb_id) ||
+            area_idx >= nffs_num_areas ||
+            nffs_hash_find(block_rec.ndcb_id) != NULL) {
+
+            return FS_ECORRUPT;
+        }
+
+        entry = nffs_block_entry_alloc();
+        if (entry == NULL) {
+            return FS_ENOMEM;
+        }
+        entry->nhe_id = block_rec.ndcb_id;
+        entry->nhe_flash_loc = block_rec.ndcb_flash_loc;
+        nffs_hash_insert(entry);
+    }
+
+    inode_offset = offset;
+    for (i = 0; i < hdr.ndc_num_inodes; i++) {
+        rc = nffs_checkpoint_read(offset, &inode_rec, sizeof inode_rec, &crc);
+        if (rc != 0) {
+            return rc;
+        }
+        offset += sizeof inode_rec;
+
+        rc = nffs_checkpoint_load_inode(&inode_rec);
+        if (rc != 0) {
+            return rc;
+        }
+    }
+
+    crc = crc16_ccitt(crc, &hdr, NFFS_DISK_CHECKPOINT_OFFSET_CRC);
+    if (crc != hdr.ndc_crc16 || nffs_root_dir == NULL) {
+        return FS_ECORRUPT;
+    }
+
+    /* Every inode is in RAM now; link the directory tree.  The children of a
+     * directory are recorded next to each other and already sorted.
+     */
+    parent = NULL;
+    prev = NULL;
+    offset = inode_offset;
+    for (i = 0; i < hdr.ndc_num_inodes; i++) {
+        rc = nffs_checkpoint_read(offset, &inode_rec, sizeof inode_rec, NULL);
+        if (rc != 0) {
+            return rc;
+        }
+        offset += sizeof inode_rec;
+
+        if (inode_rec.ndci_parent_id == NFFS_ID_NONE) {
+            continue;
+        }
+
+        if (parent == NULL ||
+            parent->nie_hash_entry.nhe_id != inode_rec.ndci_parent_id) {
+
+            parent = nffs_hash_find_inode(inode_rec.ndci_parent_id);
+            if (parent == NULL ||
+                !nffs_hash_id_is_dir(inode_rec.ndci_parent_id) ||
+                !SLIST_EMPTY(&parent->nie_child_list)) {
+
+                return FS_ECORRUPT;
+            }
+            prev = NULL;
+        }
+
+        child = nffs_hash_find_inode(inode_rec.ndci_id);
+        assert(child != NULL);
+        if (nffs_inode_getflags(child, NFFS_INODE_FLAG_INTREE)) {
+            return FS_ECORRUPT;
+        }
+
+        if (prev == NULL) {
+            SLIST_INSERT_HEAD(&parent->nie_child_list, child,
+                              nie_sibling_next);
+        } else {
+            SLIST_INSERT_AFTER(prev, child, nie_sibling_next);
+        }
+        nffs_inode_setflags(child, NFFS_INODE_FLAG_INTREE);
+        prev = child;
+    }
+
+    nffs_hash_next_file_id = hdr.ndc_next_file_id;
+    nffs_hash_next_dir_id = hdr.ndc_next_dir_id;
+    nffs_hash_next_block_id = hdr.ndc_next_block_id;
+    *out_block_max_data_sz = hdr.ndc_block_max_data_sz;
+
+    return 0;
+}
+
+#endif
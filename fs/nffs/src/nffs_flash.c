@@ -18,6 +18,7 @@
  */
 
 #include <assert.h>
+#include "defs/error.h"
 #include "hal/hal_flash.h"
 #include "nffs/nffs.h"
 #include "nffs_priv.h"
@@ -64,6 +65,47 @@ nffs_flash_read(uint8_t area_idx, uint32_t area_offset, void *data,
     return 0;
 }
 
+/**
+ * Gets a pointer through which a chunk of flash can be read in place.
+ *
+ * @param area_idx              The index of the area to map.
+ * @param area_offset           The offset within the area to map.
+ * @param len                   The number of bytes to map.
+ * @param out_ptr               On success, the chunk's address in memory.
+ *
+ * @return                      0 on success;
+ *                              FS_EOFFSET on an attempt to map an invalid
+ *                                  address range;
+ *                              FS_ENOTSUP if the flash isn't memory mapped;
+ *                              FS_EHW on flash error.
+ */
+int
+nffs_flash_mmap(uint8_t area_idx, uint32_t area_offset, uint32_t len,
+                const void **out_ptr)
+{
+    const struct nffs_area *area;
+    int rc;
+
+    assert(area_idx < nffs_num_areas);
+
+    area = nffs_areas + area_idx;
+
+    if (area_offset + len > area->na_length) {
+        return FS_EOFFSET;
+    }
+
+    rc = hal_flash_mmap(area->na_flash_id, area->na_offset + area_offset, len,
+                        out_ptr);
+    if (rc == SYS_ENOTSUP) {
+        return FS_ENOTSUP;
+    }
+    if (rc != 0) {
+        return FS_EHW;
+    }
+
+    return 0;
+}
+
 /**
  * Writes a chunk of data to flash.
  *
@@ -113,6 +113,13 @@ nffs_format_full(const struct nffs_area_desc *area_descs)
     /* Start from a clean state. */
     nffs_misc_reset();
 
+#if MYNEWT_VAL(NFFS_CHECKPOINT)
+    rc = nffs_checkpoint_invalidate();
+    if (rc != 0) {
+        goto err;
+    }
+#endif
+
     /* Select largest area to be the initial scratch area. */
     nffs_scratch_area_idx = 0;
     for (i = 1; area_descs[i].nad_length != 0; i++) {
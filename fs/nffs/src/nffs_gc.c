@@ -217,7 +217,7 @@ nffs_gc_block_chain_collate(struct nffs_hash_entry *last_entry,
 
         if (entry != last_entry) {
             if (inout_next != NULL && *inout_next == entry) {
-                *inout_next = SLIST_NEXT(entry, nhe_next);
+                *inout_next = nffs_hash_next(entry);
             }
             nffs_block_delete_from_ram(entry);
         } else {
@@ -457,6 +457,14 @@ nffs_gc(uint8_t *out_area_idx)
     int rc;
     int i;
 
+#if MYNEWT_VAL(NFFS_CHECKPOINT)
+    /* A checkpoint does not describe the areas once they get rewritten. */
+    rc = nffs_checkpoint_invalidate();
+    if (rc != 0) {
+        return rc;
+    }
+#endif
+
     from_area_idx = nffs_gc_select_area();
     from_area = nffs_areas + from_area_idx;
     to_area = nffs_areas + nffs_scratch_area_idx;
@@ -467,37 +475,30 @@ nffs_gc(uint8_t *out_area_idx)
         return rc;
     }
 
-    for (i = 0; i < NFFS_HASH_SIZE; i++) {
-        entry = SLIST_FIRST(nffs_hash + i);
-        while (entry != NULL) {
-            next = SLIST_NEXT(entry, nhe_next);
-
-            if (nffs_hash_id_is_inode(entry->nhe_id)) {
-                /* The inode gets copied if it is in the source area. */
-                nffs_flash_loc_expand(entry->nhe_flash_loc,
-                                      &area_idx, &area_offset);
-                inode_entry = (struct nffs_inode_entry *)entry;
-                if (area_idx == from_area_idx) {
-                    rc = nffs_gc_copy_inode(inode_entry,
-                                            nffs_scratch_area_idx);
-                    if (rc != 0) {
-                        return rc;
-                    }
+    NFFS_HASH_FOREACH(entry, i, next) {
+        if (nffs_hash_id_is_inode(entry->nhe_id)) {
+            /* The inode gets copied if it is in the source area. */
+            nffs_flash_loc_expand(entry->nhe_flash_loc,
+                                  &area_idx, &area_offset);
+            inode_entry = (struct nffs_inode_entry *)entry;
+            if (area_idx == from_area_idx) {
+                rc = nffs_gc_copy_inode(inode_entry,
+                                        nffs_scratch_area_idx);
+                if (rc != 0) {
+                    return rc;
                 }
+            }
 
-                /* If the inode is a file, all constituent data blocks that are
-                 * resident in the source area get copied.
-                 */
-                if (nffs_hash_id_is_file(entry->nhe_id)) {
-                    rc = nffs_gc_inode_blocks(inode_entry, from_area_idx,
-                                              nffs_scratch_area_idx, &next);
-                    if (rc != 0) {
-                        return rc;
-                    }
+            /* If the inode is a file, all constituent data blocks that are
+             * resident in the source area get copied.
+             */
+            if (nffs_hash_id_is_file(entry->nhe_id)) {
+                rc = nffs_gc_inode_blocks(inode_entry, from_area_idx,
+                                          nffs_scratch_area_idx, &next);
+                if (rc != 0) {
+                    return rc;
                 }
             }
-
-            entry = next;
         }
     }
 
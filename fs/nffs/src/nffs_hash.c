@@ -23,7 +23,9 @@
 #include "nffs/nffs.h"
 #include "nffs_priv.h"
 
+#if !MYNEWT_VAL(NFFS_HASH_OPEN_ADDR)
 struct nffs_hash_list *nffs_hash;
+#endif
 
 uint32_t nffs_hash_next_dir_id;
 uint32_t nffs_hash_next_file_id;
@@ -53,6 +55,340 @@ nffs_hash_id_is_block(uint32_t id)
     return id >= NFFS_ID_BLOCK_MIN && id < NFFS_ID_BLOCK_MAX;
 }
 
+#if MYNEWT_VAL(NFFS_HASH_OPEN_ADDR)
+
+#if MYNEWT_VAL(NFFS_HASH_OPEN_ADDR_SIZE) < 2 || \
+    (MYNEWT_VAL(NFFS_HASH_OPEN_ADDR_SIZE) & \
+     (MYNEWT_VAL(NFFS_HASH_OPEN_ADDR_SIZE) - 1)) != 0
+#error "NFFS_HASH_OPEN_ADDR_SIZE must be a power of two"
+#endif
+
+/** Extra slots past the last home slot for runs that start near the end. */
+#define NFFS_HASH_TAIL          32
+
+/**
+ * Open addressing table.  Entries are kept sorted by key; each entry sits at
+ * or after its home slot with no empty slot in between (Robin Hood linear
+ * probing with ties broken by key).  A lookup stops at the first empty slot
+ * or larger key, and the table can be walked in key order while entries are
+ * inserted and removed.
+ */
+static struct nffs_hash_entry **nffs_hash_slots;
+static uint32_t nffs_hash_num_slots;
+static uint32_t nffs_hash_count;
+static uint8_t nffs_hash_bits;
+
+/**
+ * Entries that did not fit because the table could not be grown.  Linked
+ * through nhe_next and walked after the table.
+ */
+static struct nffs_hash_list nffs_hash_spill;
+
+static uint32_t
+nffs_hash_key(uint32_t id)
+{
+    /* Multiplying by an odd constant is a bijection on 32-bit IDs. */
+    return id * 0x9e3779b1;
+}
+
+static uint32_t
+nffs_hash_home(uint32_t key, uint8_t bits)
+{
+    return key >> (32 - bits);
+}
+
+static uint32_t
+nffs_hash_slot_key(uint32_t idx)
+{
+    return nffs_hash_key(nffs_hash_slots[idx]->nhe_id);
+}
+
+/**
+ * Finds the slot holding the specified key.
+ *
+ * @return                      The slot index on success; -1 if the key is
+ *                                  not in the table.
+ */
+static int32_t
+nffs_hash_slot_find(uint32_t key)
+{
+    uint32_t slot_key;
+    uint32_t idx;
+
+    for (idx = nffs_hash_home(key, nffs_hash_bits);
+         idx < nffs_hash_num_slots && nffs_hash_slots[idx] != NULL;
+         idx++) {
+
+        slot_key = nffs_hash_slot_key(idx);
+        if (slot_key == key) {
+            return idx;
+        }
+        if (slot_key > key) {
+            break;
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * Places an entry in the table, shifting the run of larger keys after it
+ * one slot towards the next empty slot.
+ *
+ * @return                      0 on success; -1 if there is no empty slot
+ *                                  between the entry's home and the end of
+ *                                  the table.
+ */
+static int
+nffs_hash_slot_insert(struct nffs_hash_entry *entry)
+{
+    uint32_t empty;
+    uint32_t key;
+    uint32_t idx;
+
+    key = nffs_hash_key(entry->nhe_id);
+    idx = nffs_hash_home(key, nffs_hash_bits);
+    while (idx < nffs_hash_num_slots && nffs_hash_slots[idx] != NULL &&
+           nffs_hash_slot_key(idx) < key) {
+
+        idx++;
+    }
+
+    for (empty = idx; empty < nffs_hash_num_slots; empty++) {
+        if (nffs_hash_slots[empty] == NULL) {
+            break;
+        }
+    }
+    if (empty >= nffs_hash_num_slots) {
+        return -1;
+    }
+
+    memmove(nffs_hash_slots + idx + 1, nffs_hash_slots + idx,
+            (empty - idx) * sizeof *nffs_hash_slots);
+    nffs_hash_slots[idx] = entry;
+    nffs_hash_count++;
+
+    return 0;
+}
+
+/**
+ * Empties a slot, shifting back each following entry that is not at its
+ * home slot.
+ */
+static void
+nffs_hash_slot_remove(uint32_t idx)
+{
+    uint32_t end;
+
+    for (end = idx + 1; end < nffs_hash_num_slots; end++) {
+        if (nffs_hash_slots[end] == NULL ||
+            nffs_hash_home(nffs_hash_slot_key(end), nffs_hash_bits) == end) {
+
+            break;
+        }
+    }
+
+    memmove(nffs_hash_slots + idx, nffs_hash_slots + idx + 1,
+            (end - idx - 1) * sizeof *nffs_hash_slots);
+    nffs_hash_slots[end - 1] = NULL;
+    nffs_hash_count--;
+}
+
+/**
+ * Allocates a table with the specified number of home slots and moves every
+ * entry into it.  Entries keep their relative order, so a walk of the table
+ * in progress continues correctly.
+ *
+ * @return                      0 on success; FS_ENOMEM if the table could
+ *                                  not be allocated or the entries do not
+ *                                  fit.  The old table is kept on failure.
+ */
+static int
+nffs_hash_resize(uint8_t bits)
+{
+    struct nffs_hash_entry **slots;
+    uint32_t num_slots;
+    uint32_t home;
+    uint32_t next;
+    uint32_t i;
+
+    num_slots = (1UL << bits) + NFFS_HASH_TAIL;
+    slots = calloc(num_slots, sizeof *slots);
+    if (slots == NULL) {
+        return FS_ENOMEM;
+    }
+
+    next = 0;
+    for (i = 0; i < nffs_hash_num_slots; i++) {
+        if (nffs_hash_slots[i] == NULL) {
+            continue;
+        }
+
+        home = nffs_hash_home(nffs_hash_slot_key(i), bits);
+        if (home > next) {
+            next = home;
+        }
+        if (next >= num_slots) {
+            free(slots);
+            return FS_ENOMEM;
+        }
+        slots[next++] = nffs_hash_slots[i];
+    }
+
+    free(nffs_hash_slots);
+    nffs_hash_slots = slots;
+    nffs_hash_num_slots = num_slots;
+    nffs_hash_bits = bits;
+
+    return 0;
+}
+
+static struct nffs_hash_entry *
+nffs_hash_spill_find(uint32_t id)
+{
+    struct nffs_hash_entry *entry;
+
+    SLIST_FOREACH(entry, &nffs_hash_spill, nhe_next) {
+        if (entry->nhe_id == id) {
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+/* An entry's slot is fixed by its key; there is nothing to reorder. */
+static struct nffs_hash_entry *
+nffs_hash_find_reorder(uint32_t id)
+{
+    return nffs_hash_find(id);
+}
+
+struct nffs_hash_entry *
+nffs_hash_find(uint32_t id)
+{
+    int32_t idx;
+
+    idx = nffs_hash_slot_find(nffs_hash_key(id));
+    if (idx >= 0) {
+        return nffs_hash_slots[idx];
+    }
+
+    return nffs_hash_spill_find(id);
+}
+
+/**
+ * Returns the first entry at or after the specified slot; continues with the
+ * spilled entries once the end of the table is reached.
+ */
+static struct nffs_hash_entry *
+nffs_hash_first_from(uint32_t idx)
+{
+    for (; idx < nffs_hash_num_slots; idx++) {
+        if (nffs_hash_slots[idx] != NULL) {
+            return nffs_hash_slots[idx];
+        }
+    }
+
+    return SLIST_FIRST(&nffs_hash_spill);
+}
+
+struct nffs_hash_entry *
+nffs_hash_first(void)
+{
+    return nffs_hash_first_from(0);
+}
+
+struct nffs_hash_entry *
+nffs_hash_next(struct nffs_hash_entry *entry)
+{
+    int32_t idx;
+
+    idx = nffs_hash_slot_find(nffs_hash_key(entry->nhe_id));
+    if (idx < 0) {
+        return SLIST_NEXT(entry, nhe_next);
+    }
+
+    return nffs_hash_first_from(idx + 1);
+}
+
+struct nffs_hash_entry *
+nffs_hash_resume(uint32_t id)
+{
+    uint32_t key;
+    uint32_t idx;
+
+    key = nffs_hash_key(id);
+    for (idx = nffs_hash_home(key, nffs_hash_bits);
+         idx < nffs_hash_num_slots;
+         idx++) {
+
+        if (nffs_hash_slots[idx] != NULL && nffs_hash_slot_key(idx) >= key) {
+            return nffs_hash_slots[idx];
+        }
+    }
+
+    return SLIST_FIRST(&nffs_hash_spill);
+}
+
+static void
+nffs_hash_add(struct nffs_hash_entry *entry)
+{
+    /* Grow at 3/4 load.  Failing to grow is not an error; the entry still
+     * goes in the current table, or in the spill list if no slot is left
+     * for it.
+     */
+    if ((nffs_hash_count + 1) * 4 > (1UL << nffs_hash_bits) * 3) {
+        nffs_hash_resize(nffs_hash_bits + 1);
+    }
+
+    if (nffs_hash_slot_insert(entry) != 0 &&
+        (nffs_hash_resize(nffs_hash_bits + 1) != 0 ||
+         nffs_hash_slot_insert(entry) != 0)) {
+
+        SLIST_INSERT_HEAD(&nffs_hash_spill, entry, nhe_next);
+    }
+}
+
+static void
+nffs_hash_del(struct nffs_hash_entry *entry)
+{
+    int32_t idx;
+
+    idx = nffs_hash_slot_find(nffs_hash_key(entry->nhe_id));
+    if (idx >= 0) {
+        nffs_hash_slot_remove(idx);
+    } else {
+        SLIST_REMOVE(&nffs_hash_spill, entry, nffs_hash_entry, nhe_next);
+    }
+}
+
+static int
+nffs_hash_alloc(void)
+{
+    free(nffs_hash_slots);
+
+    for (nffs_hash_bits = 1;
+         (1UL << nffs_hash_bits) < MYNEWT_VAL(NFFS_HASH_OPEN_ADDR_SIZE);
+         nffs_hash_bits++)
+        ;
+
+    nffs_hash_count = 0;
+    SLIST_INIT(&nffs_hash_spill);
+
+    nffs_hash_num_slots = MYNEWT_VAL(NFFS_HASH_OPEN_ADDR_SIZE) +
+                          NFFS_HASH_TAIL;
+    nffs_hash_slots = calloc(nffs_hash_num_slots, sizeof *nffs_hash_slots);
+    if (nffs_hash_slots == NULL) {
+        nffs_hash_num_slots = 0;
+        return FS_ENOMEM;
+    }
+
+    return 0;
+}
+
+#else
+
 static int
 nffs_hash_fn(uint32_t id)
 {
@@ -106,6 +442,69 @@ nffs_hash_find(uint32_t id)
     return NULL;
 }
 
+struct nffs_hash_entry *
+nffs_hash_first(void)
+{
+    struct nffs_hash_entry *entry;
+    int i;
+
+    for (i = 0; i < NFFS_HASH_SIZE; i++) {
+        entry = SLIST_FIRST(nffs_hash + i);
+        if (entry != NULL) {
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+struct nffs_hash_entry *
+nffs_hash_next(struct nffs_hash_entry *entry)
+{
+    return SLIST_NEXT(entry, nhe_next);
+}
+
+struct nffs_hash_entry *
+nffs_hash_resume(uint32_t id)
+{
+    return SLIST_FIRST(nffs_hash + nffs_hash_fn(id));
+}
+
+static void
+nffs_hash_add(struct nffs_hash_entry *entry)
+{
+    SLIST_INSERT_HEAD(nffs_hash + nffs_hash_fn(entry->nhe_id), entry,
+                      nhe_next);
+}
+
+static void
+nffs_hash_del(struct nffs_hash_entry *entry)
+{
+    SLIST_REMOVE(nffs_hash + nffs_hash_fn(entry->nhe_id), entry,
+                 nffs_hash_entry, nhe_next);
+}
+
+static int
+nffs_hash_alloc(void)
+{
+    int i;
+
+    free(nffs_hash);
+
+    nffs_hash = malloc(NFFS_HASH_SIZE * sizeof *nffs_hash);
+    if (nffs_hash == NULL) {
+        return FS_ENOMEM;
+    }
+
+    for (i = 0; i < NFFS_HASH_SIZE; i++) {
+        SLIST_INIT(nffs_hash + i);
+    }
+
+    return 0;
+}
+
+#endif
+
 struct nffs_inode_entry *
 nffs_hash_find_inode(uint32_t id)
 {
@@ -147,15 +546,11 @@ nffs_hash_id_is_dummy(uint32_t id)
 void
 nffs_hash_insert(struct nffs_hash_entry *entry)
 {
-    struct nffs_hash_list *list;
     struct nffs_inode_entry *nie;
-    int idx;
 
     assert(nffs_hash_find(entry->nhe_id) == NULL);
-    idx = nffs_hash_fn(entry->nhe_id);
-    list = nffs_hash + idx;
 
-    SLIST_INSERT_HEAD(list, entry, nhe_next);
+    nffs_hash_add(entry);
     STATS_INC(nffs_stats, nffs_hashcnt_ins);
 
     if (nffs_hash_id_is_inode(entry->nhe_id)) {
@@ -170,9 +565,7 @@ nffs_hash_insert(struct nffs_hash_entry *entry)
 void
 nffs_hash_remove(struct nffs_hash_entry *entry)
 {
-    struct nffs_hash_list *list;
     struct nffs_inode_entry *nie = NULL;
-    int idx;
 
     if (nffs_hash_id_is_inode(entry->nhe_id)) {
         nie = nffs_hash_find_inode(entry->nhe_id);
@@ -182,10 +575,7 @@ nffs_hash_remove(struct nffs_hash_entry *entry)
         assert(nffs_hash_find(entry->nhe_id));
     }
 
-    idx = nffs_hash_fn(entry->nhe_id);
-    list = nffs_hash + idx;
-
-    SLIST_REMOVE(list, entry, nffs_hash_entry, nhe_next);
+    nffs_hash_del(entry);
     STATS_INC(nffs_stats, nffs_hashcnt_rm);
 
     if (nffs_hash_id_is_inode(entry->nhe_id) && nie) {
@@ -197,18 +587,5 @@ nffs_hash_remove(struct nffs_hash_entry *entry)
 int
 nffs_hash_init(void)
 {
-    int i;
-
-    free(nffs_hash);
-
-    nffs_hash = malloc(NFFS_HASH_SIZE * sizeof *nffs_hash);
-    if (nffs_hash == NULL) {
-        return FS_ENOMEM;
-    }
-
-    for (i = 0; i < NFFS_HASH_SIZE; i++) {
-        SLIST_INIT(nffs_hash + i);
-    }
-
-    return 0;
+    return nffs_hash_alloc();
 }
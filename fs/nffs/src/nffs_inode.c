@@ -1118,6 +1118,65 @@ nffs_inode_read(struct nffs_inode_entry *inode_entry, uint32_t offset,
     return 0;
 }
 
+/**
+ * Maps data from the specified file inode for reading in place.  Only the
+ * block containing the requested offset is mapped, so fewer than len bytes
+ * may be returned even when the file extends further.
+ *
+ * @param inode_entry           The inode to map.
+ * @param offset                The offset within the file to map from.
+ * @param len                   The maximum number of bytes to map.
+ * @param out_ptr               On success, the address of the data at offset
+ *                                  gets written here.
+ * @param out_len               On success, the number of bytes mapped gets
+ *                                  written here.
+ *
+ * @return                      0 on success;
+ *                              FS_EOFFSET if offset is at or past the end of
+ *                                  the file;
+ *                              FS_ENOTSUP if the flash isn't memory mapped;
+ *                              other nonzero on failure.
+ */
+int
+nffs_inode_mmap(struct nffs_inode_entry *inode_entry, uint32_t offset,
+                uint32_t len, const void **out_ptr, uint32_t *out_len)
+{
+    struct nffs_cache_inode *cache_inode;
+    struct nffs_cache_block *cache_block;
+    uint16_t block_off;
+    uint32_t chunk_sz;
+    int rc;
+
+    rc = nffs_cache_inode_ensure(&cache_inode, inode_entry);
+    if (rc != 0) {
+        return rc;
+    }
+
+    if (offset >= cache_inode->nci_file_size) {
+        return FS_EOFFSET;
+    }
+
+    rc = nffs_cache_seek(cache_inode, offset, &cache_block);
+    if (rc != 0) {
+        return rc;
+    }
+
+    block_off = offset - cache_block->ncb_file_offset;
+    chunk_sz = cache_block->ncb_block.nb_data_len - block_off;
+    if (chunk_sz > len) {
+        chunk_sz = len;
+    }
+
+    rc = nffs_block_mmap_data(&cache_block->ncb_block, block_off, chunk_sz,
+                              out_ptr);
+    if (rc != 0) {
+        return rc;
+    }
+
+    *out_len = chunk_sz;
+    return 0;
+}
+
 static int
 nffs_inode_unlink_from_ram_priv(struct nffs_inode *inode,
                                 int ignore_corruption,
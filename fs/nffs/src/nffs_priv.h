@@ -106,6 +106,60 @@ struct nffs_disk_block {
 
 #define NFFS_DISK_BLOCK_OFFSET_CRC  18
 
+#define NFFS_CHECKPOINT_MAGIC        0x6c3e9d15
+#define NFFS_CHECKPOINT_VER          0
+
+/**
+ * On-disk representation of a checkpoint header.  The header is followed by
+ * ndc_num_areas area records, ndc_num_blocks block records and ndc_num_inodes
+ * inode records, in that order.
+ */
+struct nffs_disk_checkpoint {
+    uint32_t ndc_magic;         /* NFFS_CHECKPOINT_MAGIC */
+    uint32_t ndc_next_file_id;
+    uint32_t ndc_next_dir_id;
+    uint32_t ndc_next_block_id;
+    uint32_t ndc_num_blocks;
+    uint32_t ndc_num_inodes;
+    uint16_t ndc_block_max_data_sz;
+    uint8_t ndc_ver;            /* NFFS_CHECKPOINT_VER */
+    uint8_t ndc_num_areas;
+    uint8_t ndc_scratch_area_idx;
+    uint8_t reserved8;
+    uint16_t ndc_crc16;         /* Covers all records and rest of header. */
+};
+
+#define NFFS_DISK_CHECKPOINT_OFFSET_CRC  30
+
+/** Checkpointed state of one area. */
+struct nffs_disk_checkpoint_area {
+    uint32_t ndca_offset;
+    uint32_t ndca_length;
+    uint32_t ndca_cur;          /* Objects at or past this offset were
+                                   written after the checkpoint. */
+    uint8_t ndca_id;
+    uint8_t ndca_gc_seq;
+    uint8_t ndca_flash_id;
+    uint8_t reserved8;
+};
+
+/** Checkpointed data block hash entry. */
+struct nffs_disk_checkpoint_block {
+    uint32_t ndcb_id;
+    uint32_t ndcb_flash_loc;
+};
+
+/**
+ * Checkpointed inode hash entry.  Inodes are recorded root first, followed by
+ * the children of each directory in the order of its child list.
+ */
+struct nffs_disk_checkpoint_inode {
+    uint32_t ndci_id;
+    uint32_t ndci_flash_loc;
+    uint32_t ndci_parent_id;
+    uint32_t ndci_lastblock_id;
+};
+
 /**
  * What gets stored in the hash table.  Each entry represents a data block or
  * an inode.
@@ -228,12 +282,34 @@ struct nffs_cache_block {
 
 TAILQ_HEAD(nffs_cache_block_list, nffs_cache_block);
 
+#define NFFS_CACHE_INDEX_SIZE       MYNEWT_VAL(NFFS_CACHE_INDEX_SIZE)
+#define NFFS_CACHE_READAHEAD_MAX    MYNEWT_VAL(NFFS_CACHE_READAHEAD_MAX)
+
+/**
+ * Seek index slot.  Slot i of a cached inode refers to the block containing
+ * file offset (i + 1) * nci_index_width - 1.
+ */
+struct nffs_cache_index {
+    struct nffs_hash_entry *nci_block_entry;    /* Null if slot is unset. */
+    uint32_t nci_block_end;                     /* File offset of block end. */
+};
+
 /** Represents a single cached file inode. */
 struct nffs_cache_inode {
     TAILQ_ENTRY(nffs_cache_inode) nci_link;        /* Sorted; LRU at tail. */
     struct nffs_inode nci_inode;                   /* Full inode. */
     struct nffs_cache_block_list nci_block_list;   /* List of cached blocks. */
     uint32_t nci_file_size;                        /* Total file size. */
+#if NFFS_CACHE_READAHEAD_MAX > 0
+    uint8_t nci_readahead;                         /* # blocks to read ahead
+                                                      on next sequential
+                                                      miss. */
+#endif
+#if NFFS_CACHE_INDEX_SIZE > 0
+    uint32_t nci_index_width;                      /* Bytes per index slot;
+                                                      0 if index is empty. */
+    struct nffs_cache_index nci_index[NFFS_CACHE_INDEX_SIZE];
+#endif
 };
 
 struct nffs_dirent {
@@ -267,6 +343,12 @@ STATS_SECT_START(nffs_stats)
     STATS_SECT_ENTRY(nffs_readcnt_filename)
     STATS_SECT_ENTRY(nffs_readcnt_object)
     STATS_SECT_ENTRY(nffs_readcnt_detect)
+    STATS_SECT_ENTRY(nffs_cache_inode_hit)
+    STATS_SECT_ENTRY(nffs_cache_inode_miss)
+    STATS_SECT_ENTRY(nffs_cache_block_hit)
+    STATS_SECT_ENTRY(nffs_cache_block_miss)
+    STATS_SECT_ENTRY(nffs_cache_index_hit)
+    STATS_SECT_ENTRY(nffs_cache_readahead)
 STATS_SECT_END
 extern STATS_SECT_DECL(nffs_stats) nffs_stats;
 
@@ -295,7 +377,9 @@ extern struct nffs_area_desc *nffs_current_area_descs;
 #define NFFS_FLASH_BUF_SZ        256
 extern uint8_t nffs_flash_buf[NFFS_FLASH_BUF_SZ];
 
+#if !MYNEWT_VAL(NFFS_HASH_OPEN_ADDR)
 extern struct nffs_hash_list *nffs_hash;
+#endif
 extern struct nffs_inode_entry *nffs_root_dir;
 extern struct nffs_inode_entry *nffs_lost_found_dir;
 
@@ -333,6 +417,8 @@ int nffs_block_from_hash_entry(struct nffs_block *out_block,
                                struct nffs_hash_entry *entry);
 int nffs_block_read_data(const struct nffs_block *block, uint16_t offset,
                          uint16_t length, void *dst);
+int nffs_block_mmap_data(const struct nffs_block *block, uint16_t offset,
+                         uint16_t length, const void **out_ptr);
 int nffs_block_is_dummy(struct nffs_hash_entry *entry);
 
 /* @cache */
@@ -359,6 +445,12 @@ int nffs_crc_disk_inode_validate(const struct nffs_disk_inode *disk_inode,
 void nffs_crc_disk_inode_fill(struct nffs_disk_inode *disk_inode,
                               const char *filename);
 
+/* @checkpoint */
+int nffs_checkpoint_write(void);
+int nffs_checkpoint_load(const struct nffs_area_desc *area_descs,
+                         uint16_t *out_block_max_data_sz);
+int nffs_checkpoint_invalidate(void);
+
 /* @config */
 void nffs_config_init(void);
 
@@ -391,6 +483,8 @@ int nffs_gc_until(uint32_t space, uint8_t *out_area_idx);
 struct nffs_area *nffs_flash_find_area(uint16_t logical_id);
 int nffs_flash_read(uint8_t area_idx, uint32_t offset,
                     void *data, uint32_t len);
+int nffs_flash_mmap(uint8_t area_idx, uint32_t offset, uint32_t len,
+                    const void **out_ptr);
 int nffs_flash_write(uint8_t area_idx, uint32_t offset,
                      const void *data, uint32_t len);
 int nffs_flash_copy(uint8_t area_id_from, uint32_t offset_from,
@@ -413,6 +507,9 @@ void nffs_hash_remove(struct nffs_hash_entry *entry);
 int nffs_hash_init(void);
 int nffs_hash_entry_is_dummy(struct nffs_hash_entry *he);
 int nffs_hash_id_is_dummy(uint32_t id);
+struct nffs_hash_entry *nffs_hash_first(void);
+struct nffs_hash_entry *nffs_hash_next(struct nffs_hash_entry *entry);
+struct nffs_hash_entry *nffs_hash_resume(uint32_t id);
 
 /* @inode */
 struct nffs_inode_entry *nffs_inode_entry_alloc(void);
@@ -455,6 +552,8 @@ int nffs_inode_filename_cmp_flash(const struct nffs_inode *inode1,
                                   int *result);
 int nffs_inode_read(struct nffs_inode_entry *inode_entry, uint32_t offset,
                     uint32_t len, void *data, uint32_t *out_len);
+int nffs_inode_mmap(struct nffs_inode_entry *inode_entry, uint32_t offset,
+                    uint32_t len, const void **out_ptr, uint32_t *out_len);
 int nffs_inode_seek(struct nffs_inode_entry *inode_entry, uint32_t offset,
                     uint32_t length, struct nffs_seek_info *out_seek_info);
 int nffs_inode_from_entry(struct nffs_inode *out_inode,
@@ -497,16 +596,31 @@ int nffs_path_new_dir(const char *path,
 
 /* @restore */
 int nffs_restore_full(const struct nffs_area_desc *area_descs);
+int nffs_restore_checkpoint(const struct nffs_area_desc *area_descs);
 
 /* @write */
 int nffs_write_to_file(struct nffs_file *file, const void *data, int len);
 
 
+/**
+ * Walks every hash entry.  The current entry may be removed from the hash
+ * during the walk.  If other entries get removed, next must be recomputed:
+ * nffs_hash_next() of an entry before it is removed, or nffs_hash_resume()
+ * with the ID of the current entry to continue from where it was.  Entries
+ * walked already may then be visited again.
+ */
+#if MYNEWT_VAL(NFFS_HASH_OPEN_ADDR)
+#define NFFS_HASH_FOREACH(entry, i, next)                               \
+    for ((i) = 0, (entry) = nffs_hash_first();                          \
+         (entry) && (((next)) = nffs_hash_next(entry), 1);              \
+         (entry) = ((next)), (i)++)
+#else
 #define NFFS_HASH_FOREACH(entry, i, next)                               \
     for ((i) = 0; (i) < NFFS_HASH_SIZE; (i)++)                          \
         for ((entry) = SLIST_FIRST(nffs_hash + (i));                    \
              (entry) && (((next)) = SLIST_NEXT((entry), nhe_next), 1);  \
              (entry) = ((next)))
+#endif
 
 #define NFFS_FLASH_LOC_NONE  nffs_flash_loc(NFFS_AREA_ID_NONE, 0)
 
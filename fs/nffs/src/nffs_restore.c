@@ -271,29 +271,38 @@ nffs_restore_should_sweep_inode_entry(struct nffs_inode_entry *inode_entry,
  *
  * @return                      0 on success; nonzero on failure.
  */
+#if MYNEWT_VAL(NFFS_HASH_OPEN_ADDR)
+#define NFFS_RESTORE_SWEEP_PASSES   2
+#else
+#define NFFS_RESTORE_SWEEP_PASSES   1
+#endif
+
 int
 nffs_restore_sweep(void)
 {
     struct nffs_inode_entry *inode_entry;
     struct nffs_hash_entry *entry;
     struct nffs_hash_entry *next;
-    struct nffs_hash_list *list;
     struct nffs_inode inode;
     struct nffs_block block;
+    uint32_t id;
+    int pass;
     int del = 0;
     int rc;
     int i;
 
     /* Iterate through every object in the hash table, deleting all inodes that
-     * should be removed.
+     * should be removed.  The open addressing table walks entries in hashed
+     * key order, so a block can come up before its inode; sweep inodes in a
+     * first pass there.  An inode whose last block was never restored points
+     * at a dummy block entry, which gets deleted along with the inode and
+     * must not be freed on its own first.  The chained table keeps its
+     * single pass in bucket order.
      */
-    for (i = 0; i < NFFS_HASH_SIZE; i++) {
-        list = nffs_hash + i;
-
-        entry = SLIST_FIRST(list);
-        while (entry != NULL) {
-            next = SLIST_NEXT(entry, nhe_next);
-            if (nffs_hash_id_is_inode(entry->nhe_id)) {
+    for (pass = 0; pass < NFFS_RESTORE_SWEEP_PASSES; pass++) {
+        NFFS_HASH_FOREACH(entry, i, next) {
+            id = entry->nhe_id;
+            if (pass == 0 && nffs_hash_id_is_inode(entry->nhe_id)) {
                 inode_entry = (struct nffs_inode_entry *)entry;
 
                 /*
@@ -329,9 +338,10 @@ nffs_restore_sweep(void)
                     if (rc != 0) {
                         return rc;
                     }
-                    next = SLIST_FIRST(list);
+                    next = nffs_hash_resume(id);
                 }
-            } else if (nffs_hash_id_is_block(entry->nhe_id)) {
+            } else if (pass == NFFS_RESTORE_SWEEP_PASSES - 1 &&
+                       nffs_hash_id_is_block(entry->nhe_id)) {
                 if (nffs_hash_id_is_dummy(entry->nhe_id)) {
                     del = 1;
                     nffs_block_delete_from_ram(entry);
@@ -344,11 +354,9 @@ nffs_restore_sweep(void)
                 }
                 if (del) {
                     del = 0;
-                    next = SLIST_FIRST(list);
+                    next = nffs_hash_resume(id);
                 }
             }
-
-            entry = next;
         }
     }
 
@@ -1030,7 +1038,7 @@ nffs_restore_disk_object_size(const struct nffs_disk_object *disk_object)
 
 /**
  * Reads the specified area from disk and loads its contents into the RAM
- * representation.
+ * representation.  Reading starts at the area's current offset.
  *
  * @param area_idx              The index of the area to read.
  *
@@ -1045,7 +1053,6 @@ nffs_restore_area_contents(int area_idx)
 
     area = nffs_areas + area_idx;
 
-    area->na_cur = sizeof (struct nffs_disk_area);
     while (1) {
         rc = nffs_restore_disk_object(area_idx, area->na_cur,  &disk_object);
         switch (rc) {
@@ -1159,32 +1166,26 @@ nffs_restore_corrupt_scratch(void)
     }
 
     /* Invalidate all objects resident in the bad area. */
-    for (i = 0; i < NFFS_HASH_SIZE; i++) {
-        entry = SLIST_FIRST(&nffs_hash[i]);
-        while (entry != NULL) {
-            next = SLIST_NEXT(entry, nhe_next);
-
-            nffs_flash_loc_expand(entry->nhe_flash_loc,
-                                 &area_idx, &area_offset);
-            if (area_idx == bad_idx) {
-                if (nffs_hash_id_is_block(entry->nhe_id)) {
-                    rc = nffs_block_delete_from_ram(entry);
-                    if (rc != 0) {
-                        return rc;
-                    }
-                } else {
-                    inode_entry = (struct nffs_inode_entry *)entry;
-                    nffs_inode_setflags(inode_entry, NFFS_INODE_FLAG_OBSOLETE);
+    NFFS_HASH_FOREACH(entry, i, next) {
+        nffs_flash_loc_expand(entry->nhe_flash_loc,
+                             &area_idx, &area_offset);
+        if (area_idx == bad_idx) {
+            if (nffs_hash_id_is_block(entry->nhe_id)) {
+                rc = nffs_block_delete_from_ram(entry);
+                if (rc != 0) {
+                    return rc;
                 }
+            } else {
+                inode_entry = (struct nffs_inode_entry *)entry;
+                nffs_inode_setflags(inode_entry, NFFS_INODE_FLAG_OBSOLETE);
             }
-
-            entry = next;
         }
     }
 
     /* Now that the objects in the scratch area have been invalidated, reload
      * everything from the good area.
      */
+    nffs_areas[good_idx].na_cur = sizeof (struct nffs_disk_area);
     rc = nffs_restore_area_contents(good_idx);
     if (rc != 0) {
         return rc;
@@ -1273,6 +1274,68 @@ nffs_log_contents(void)
     }
 }
 
+/**
+ * Completes a restore once the contents of all areas are in RAM: repairs or
+ * validates the scratch area, ensures the root and lost+found directories
+ * exist and sweeps invalidated objects.
+ *
+ * @return                      0 on success; nonzero on failure.
+ */
+static int
+nffs_restore_finish(void)
+{
+    int rc;
+
+    if (nffs_scratch_area_idx == NFFS_AREA_ID_NONE) {
+        /* No scratch area.  The system may have been rebooted in the middle of
+         * a garbage collection cycle.  Look for a candidate scratch area.
+         */
+        rc = nffs_restore_corrupt_scratch();
+        if (rc != 0) {
+            if (rc == FS_ENOENT) {
+                rc = FS_ECORRUPT;
+            }
+            return rc;
+        }
+    }
+
+    /* Ensure this file system contains a valid scratch area. */
+    rc = nffs_misc_validate_scratch();
+    if (rc != 0) {
+        return rc;
+    }
+
+    /* Make sure the file system contains a valid root directory. */
+    rc = nffs_misc_validate_root_dir();
+    if (rc != 0) {
+        return rc;
+    }
+
+    /* Ensure there is a "/lost+found" directory. */
+    rc = nffs_misc_create_lost_found_dir();
+    if (rc != 0) {
+        return rc;
+    }
+
+    /* Delete from RAM any objects that were invalidated when subsequent areas
+     * were restored.
+     */
+    nffs_restore_sweep();
+
+    /* Set the maximum data block size according to the size of the smallest
+     * area.
+     */
+    rc = nffs_misc_set_max_block_data_len(nffs_restore_largest_block_data_len);
+    if (rc != 0) {
+        return rc;
+    }
+
+    NFFS_LOG_DEBUG("CONTENTS\n");
+    nffs_log_contents();
+
+    return 0;
+}
+
 /**
  * Searches for a valid nffs file system among the specified areas.  This
  * function succeeds if a file system is detected among any subset of the
@@ -1363,57 +1426,92 @@ nffs_restore_full(const struct nffs_area_desc *area_descs)
     }
 
     /* All areas have been restored from flash. */
-
-    if (nffs_scratch_area_idx == NFFS_AREA_ID_NONE) {
-        /* No scratch area.  The system may have been rebooted in the middle of
-         * a garbage collection cycle.  Look for a candidate scratch area.
-         */
-        rc = nffs_restore_corrupt_scratch();
-        if (rc != 0) {
-            if (rc == FS_ENOENT) {
-                rc = FS_ECORRUPT;
-            }
-            goto err;
-        }
-    }
-
-    /* Ensure this file system contains a valid scratch area. */
-    rc = nffs_misc_validate_scratch();
+    rc = nffs_restore_finish();
     if (rc != 0) {
         goto err;
     }
 
-    /* Make sure the file system contains a valid root directory. */
-    rc = nffs_misc_validate_root_dir();
-    if (rc != 0) {
-        goto err;
+    return 0;
+
+err:
+    nffs_misc_reset();
+    return rc;
+}
+
+#if MYNEWT_VAL(NFFS_CHECKPOINT)
+/**
+ * Restores the file system from the checkpoint written by
+ * nffs_checkpoint().  Only objects written after the checkpoint get read
+ * from the areas.  The checkpoint is rejected if any area header differs
+ * from the one recorded in it; nffs_restore_full() must be used then.
+ *
+ * @param area_descs        The area set to restore.  This array must be
+ *                              terminated with a 0-length area.
+ *
+ * @return                  0 on success;
+ *                          FS_ENOENT if there is no checkpoint;
+ *                          FS_ECORRUPT if the checkpoint is stale or
+ *                              corrupt;
+ *                          other nonzero on error.
+ */
+int
+nffs_restore_checkpoint(const struct nffs_area_desc *area_descs)
+{
+    struct nffs_disk_area disk_area;
+    struct nffs_area *area;
+    int rc;
+    int i;
+
+    rc = nffs_misc_reset();
+    if (rc) {
+        return rc;
     }
+    nffs_current_area_descs = (struct nffs_area_desc*) area_descs;
 
-    /* Ensure there is a "/lost+found" directory. */
-    rc = nffs_misc_create_lost_found_dir();
+    rc = nffs_checkpoint_load(area_descs,
+                              &nffs_restore_largest_block_data_len);
     if (rc != 0) {
         goto err;
     }
 
-    /* Delete from RAM any objects that were invalidated when subsequent areas
-     * were restored.
-     */
-    nffs_restore_sweep();
+    for (i = 0; i < nffs_num_areas; i++) {
+        area = nffs_areas + i;
 
-    /* Set the maximum data block size according to the size of the smallest
-     * area.
-     */
-    rc = nffs_misc_set_max_block_data_len(nffs_restore_largest_block_data_len);
+        rc = nffs_restore_detect_one_area(area->na_flash_id, area->na_offset,
+                                          &disk_area);
+        if (rc == FS_EUNEXP) {
+            rc = FS_ECORRUPT;
+        }
+        if (rc != 0) {
+            goto err;
+        }
+
+        if (disk_area.nda_id != area->na_id ||
+            disk_area.nda_gc_seq != area->na_gc_seq ||
+            disk_area.nda_length != area->na_length) {
+
+            rc = FS_ECORRUPT;
+            goto err;
+        }
+
+        /* Pick up objects written after the checkpoint. */
+        if (i != nffs_scratch_area_idx) {
+            rc = nffs_restore_area_contents(i);
+            if (rc != 0) {
+                goto err;
+            }
+        }
+    }
+
+    rc = nffs_restore_finish();
     if (rc != 0) {
         goto err;
     }
 
-    NFFS_LOG_DEBUG("CONTENTS\n");
-    nffs_log_contents();
-
     return 0;
 
 err:
     nffs_misc_reset();
     return rc;
 }
+#endif
@@ -0,0 +1,120 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef __FLASH_CACHE_H__
+#define __FLASH_CACHE_H__
+
+#include <os/mynewt.h>
+#include <hal/hal_flash_int.h>
+#include <stats/stats.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Write-back cache in front of another flash device.
+ *
+ * Reads shorter than a line fill the whole line from the underlying
+ * device, so that following small reads are served from RAM.  Writes
+ * shorter than a line are collected in the line and written out as one
+ * transaction when the line is evicted or flushed.  Data is only held
+ * back while it goes to erased flash; overwrites go straight through.
+ *
+ * Dirty lines are written back on eviction, on HAL_FLASH_IOCTL_FLUSH and
+ * at sysdown.  Lines in a sector being erased are dropped instead.
+ * Writes reach the underlying device in the order they were made: a write
+ * is only merged into the line dirtied last, and a line goes out after
+ * every line dirtied before it.  Overwrites, writes bypassing the cache
+ * and erases first write back everything still pending.
+ *
+ * The cache is not power-loss safe.  Data held in dirty lines is lost on
+ * reset or power loss, so flash may lag behind what callers have been
+ * told was written.  Because order is kept, what does reach flash is
+ * always a prefix of the writes made, which is what FCB and log recovery
+ * expect.  Issue HAL_FLASH_IOCTL_FLUSH where data must be durable.
+ *
+ * To use, declare the device in the BSP and return it from
+ * hal_bsp_flash_dev() in place of the device it wraps:
+ *
+ *     static struct flash_cache_dev spiflash_cache = {
+ *         .fcd_hal = { .hf_itf = &flash_cache_funcs },
+ *         .fcd_hwdev = &spiflash_dev.hal,
+ *         .fcd_name = "spiflash_cache",
+ *     };
+ */
+
+#define FLASH_CACHE_LINE_SZ     MYNEWT_VAL(FLASH_CACHE_LINE_SIZE)
+
+STATS_SECT_START(flash_cache_stats)
+    STATS_SECT_ENTRY(read_hits)
+    STATS_SECT_ENTRY(read_misses)
+    STATS_SECT_ENTRY(read_bypass)
+    STATS_SECT_ENTRY(write_hits)
+    STATS_SECT_ENTRY(write_misses)
+    STATS_SECT_ENTRY(write_bypass)
+    STATS_SECT_ENTRY(write_through)
+    STATS_SECT_ENTRY(writebacks)
+    STATS_SECT_ENTRY(evictions)
+    STATS_SECT_ENTRY(flushes)
+STATS_SECT_END
+
+struct flash_cache_line {
+    uint32_t fcl_addr;          /* address of the line, ~0 if unused */
+    uint32_t fcl_used;          /* LRU stamp */
+    uint32_t fcl_dirty_seq;     /* when the line became dirty */
+    uint16_t fcl_dirty_lo;      /* dirty range [lo, hi), empty if lo == hi */
+    uint16_t fcl_dirty_hi;
+    uint8_t fcl_data[FLASH_CACHE_LINE_SZ];
+};
+
+struct flash_cache_dev {
+    struct hal_flash fcd_hal;
+    const struct hal_flash *fcd_hwdev; /* pointer to underlying dev */
+    const char *fcd_name;       /* name of stats entry, NULL for default */
+
+    struct os_mutex fcd_lock;
+    uint32_t fcd_clock;
+    uint32_t fcd_seq;           /* dirty_seq of the line dirtied last */
+    struct flash_cache_line fcd_lines[MYNEWT_VAL(FLASH_CACHE_LINE_CNT)];
+    STATS_SECT_DECL(flash_cache_stats) fcd_stats;
+    SLIST_ENTRY(flash_cache_dev) fcd_next;
+};
+
+extern const struct hal_flash_funcs flash_cache_funcs;
+
+/**
+ * Writes all dirty lines of a cache device back to the underlying flash.
+ *
+ * @param dev                   The cache device.
+ *
+ * @return 0 on success; nonzero on failure.
+ */
+int flash_cache_flush(struct flash_cache_dev *dev);
+
+/**
+ * Writes back all cache devices.  Called at sysdown.
+ */
+int flash_cache_sysdown(int reason);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __FLASH_CACHE_H__ */
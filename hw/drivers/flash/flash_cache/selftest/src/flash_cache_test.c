@@ -0,0 +1,149 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+
+#include "os/mynewt.h"
+#include <mcu/native_bsp.h>
+#include <testutil/testutil.h>
+#include "flash_cache_test.h"
+
+static int fc_test_count_read(const struct hal_flash *h_dev, uint32_t addr,
+                              void *buf, uint32_t len);
+static int fc_test_count_write(const struct hal_flash *h_dev, uint32_t addr,
+                               const void *buf, uint32_t len);
+static int fc_test_count_erase_sector(const struct hal_flash *h_dev,
+                                      uint32_t addr);
+static int fc_test_count_sector_info(const struct hal_flash *h_dev, int idx,
+                                     uint32_t *addr, uint32_t *sz);
+static int fc_test_count_init(const struct hal_flash *h_dev);
+
+static const struct hal_flash_funcs fc_test_count_funcs = {
+    .hff_read         = fc_test_count_read,
+    .hff_write        = fc_test_count_write,
+    .hff_erase_sector = fc_test_count_erase_sector,
+    .hff_sector_info  = fc_test_count_sector_info,
+    .hff_init         = fc_test_count_init,
+};
+
+struct fc_test_count_dev fc_test_count_dev = {
+    .fctc_hal = {
+        .hf_itf = &fc_test_count_funcs,
+    },
+};
+
+struct flash_cache_dev fc_test_cache_dev = {
+    .fcd_hal = {
+        .hf_itf = &flash_cache_funcs,
+    },
+    .fcd_hwdev = &fc_test_count_dev.fctc_hal,
+    .fcd_name = "fc_test",
+};
+
+static int
+fc_test_count_read(const struct hal_flash *h_dev, uint32_t addr, void *buf,
+                   uint32_t len)
+{
+    fc_test_count_dev.fctc_reads++;
+    fc_test_count_dev.fctc_bytes += len;
+    return native_flash_dev.hf_itf->hff_read(&native_flash_dev, addr, buf,
+                                             len);
+}
+
+static int
+fc_test_count_write(const struct hal_flash *h_dev, uint32_t addr,
+                    const void *buf, uint32_t len)
+{
+    if (fc_test_count_dev.fctc_writes < FC_TEST_WLOG_MAX) {
+        fc_test_count_dev.fctc_wlog[fc_test_count_dev.fctc_writes] = addr;
+    }
+    fc_test_count_dev.fctc_writes++;
+    fc_test_count_dev.fctc_bytes += len;
+    return native_flash_dev.hf_itf->hff_write(&native_flash_dev, addr, buf,
+                                              len);
+}
+
+static int
+fc_test_count_erase_sector(const struct hal_flash *h_dev, uint32_t addr)
+{
+    fc_test_count_dev.fctc_erases++;
+    return native_flash_dev.hf_itf->hff_erase_sector(&native_flash_dev, addr);
+}
+
+static int
+fc_test_count_sector_info(const struct hal_flash *h_dev, int idx,
+                          uint32_t *addr, uint32_t *sz)
+{
+    return native_flash_dev.hf_itf->hff_sector_info(&native_flash_dev, idx,
+                                                    addr, sz);
+}
+
+static int
+fc_test_count_init(const struct hal_flash *h_dev)
+{
+    fc_test_count_dev.fctc_hal.hf_base_addr = native_flash_dev.hf_base_addr;
+    fc_test_count_dev.fctc_hal.hf_size = native_flash_dev.hf_size;
+    fc_test_count_dev.fctc_hal.hf_sector_cnt = native_flash_dev.hf_sector_cnt;
+    fc_test_count_dev.fctc_hal.hf_align = native_flash_dev.hf_align;
+    fc_test_count_dev.fctc_hal.hf_erased_val = native_flash_dev.hf_erased_val;
+    return 0;
+}
+
+void
+fc_test_count_reset(void)
+{
+    fc_test_count_dev.fctc_reads = 0;
+    fc_test_count_dev.fctc_writes = 0;
+    fc_test_count_dev.fctc_erases = 0;
+    fc_test_count_dev.fctc_bytes = 0;
+}
+
+void
+fc_test_init(void)
+{
+    const struct hal_flash *hf;
+    int rc;
+
+    hf = &fc_test_count_dev.fctc_hal;
+    rc = hf->hf_itf->hff_init(hf);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    hf = &fc_test_cache_dev.fcd_hal;
+    rc = hf->hf_itf->hff_init(hf);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    rc = hf->hf_itf->hff_erase_sector(hf, FC_TEST_SECTOR_ADDR);
+    TEST_ASSERT_FATAL(rc == 0);
+    fc_test_count_reset();
+}
+
+TEST_SUITE(flash_cache_test_all)
+{
+    flash_cache_test_rw();
+    flash_cache_test_erase();
+    flash_cache_test_order();
+    flash_cache_test_bench();
+}
+
+int
+main(int argc, char **argv)
+{
+    flash_cache_test_all();
+    return tu_any_failed;
+}
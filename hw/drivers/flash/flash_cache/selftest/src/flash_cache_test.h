@@ -0,0 +1,68 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef __FLASH_CACHE_TEST_H_
+#define __FLASH_CACHE_TEST_H_
+
+#include <testutil/testutil.h>
+#include <hal/hal_flash_int.h>
+#include <flash_cache/flash_cache.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Tests run in one 128kB sector of the native flash simulator.
+ */
+#define FC_TEST_SECTOR_ADDR     0x00020000
+#define FC_TEST_SECTOR_SIZE     (128 * 1024)
+
+/*
+ * Pass-through device in front of the native flash simulator which
+ * counts the transactions reaching it, and records where the first
+ * FC_TEST_WLOG_MAX writes went.
+ */
+#define FC_TEST_WLOG_MAX        32
+
+struct fc_test_count_dev {
+    struct hal_flash fctc_hal;
+    uint32_t fctc_reads;
+    uint32_t fctc_writes;
+    uint32_t fctc_erases;
+    uint32_t fctc_bytes;
+    uint32_t fctc_wlog[FC_TEST_WLOG_MAX];
+};
+
+extern struct fc_test_count_dev fc_test_count_dev;
+extern struct flash_cache_dev fc_test_cache_dev;
+
+void fc_test_init(void);
+void fc_test_count_reset(void);
+
+TEST_CASE_DECL(flash_cache_test_rw)
+TEST_CASE_DECL(flash_cache_test_erase)
+TEST_CASE_DECL(flash_cache_test_order)
+TEST_CASE_DECL(flash_cache_test_bench)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,143 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "os/mynewt.h"
+#include <hal/hal_flash.h>
+#include "flash_cache_test.h"
+
+#define FCTB_RECORDS    1500
+
+struct fctb_result {
+    uint32_t reads;
+    uint32_t writes;
+    uint32_t bytes;
+    uint64_t usecs;
+};
+
+static uint8_t fctb_image[64 * 1024];
+
+/*
+ * Same access pattern as FCB: each record is a 2 byte length, the data
+ * and a 1 byte CRC, written and later read back in separate calls.
+ */
+static void
+fctb_run(const struct hal_flash *hf, struct fctb_result *res)
+{
+    uint8_t data[48];
+    uint8_t hdr[2];
+    uint8_t crc;
+    uint32_t off;
+    uint64_t start;
+    int len;
+    int rc;
+    int i;
+
+    rc = hf->hf_itf->hff_erase_sector(hf, FC_TEST_SECTOR_ADDR);
+    TEST_ASSERT_FATAL(rc == 0);
+    fc_test_count_reset();
+
+    start = os_get_uptime_usec();
+    off = FC_TEST_SECTOR_ADDR;
+    for (i = 0; i < FCTB_RECORDS; i++) {
+        len = 20 + i % 21;
+        hdr[0] = len;
+        hdr[1] = i;
+        memset(data, i, len);
+        crc = i ^ len;
+
+        rc = hf->hf_itf->hff_write(hf, off, hdr, sizeof(hdr));
+        TEST_ASSERT_FATAL(rc == 0);
+        rc = hf->hf_itf->hff_write(hf, off + sizeof(hdr), data, len);
+        TEST_ASSERT_FATAL(rc == 0);
+        rc = hf->hf_itf->hff_write(hf, off + sizeof(hdr) + len, &crc, 1);
+        TEST_ASSERT_FATAL(rc == 0);
+        off += sizeof(hdr) + len + 1;
+    }
+
+    off = FC_TEST_SECTOR_ADDR;
+    for (i = 0; i < FCTB_RECORDS; i++) {
+        rc = hf->hf_itf->hff_read(hf, off, hdr, sizeof(hdr));
+        TEST_ASSERT_FATAL(rc == 0);
+        len = hdr[0];
+        TEST_ASSERT_FATAL(len == 20 + i % 21);
+        rc = hf->hf_itf->hff_read(hf, off + sizeof(hdr), data, len);
+        TEST_ASSERT_FATAL(rc == 0);
+        TEST_ASSERT_FATAL(data[0] == (uint8_t)i && data[len - 1] == data[0]);
+        rc = hf->hf_itf->hff_read(hf, off + sizeof(hdr) + len, &crc, 1);
+        TEST_ASSERT_FATAL(rc == 0);
+        TEST_ASSERT_FATAL(crc == (uint8_t)(i ^ len));
+        off += sizeof(hdr) + len + 1;
+    }
+    rc = hf->hf_itf->hff_ioctl ?
+        hf->hf_itf->hff_ioctl(hf, HAL_FLASH_IOCTL_FLUSH, NULL) : 0;
+    TEST_ASSERT_FATAL(rc == 0);
+    res->usecs = os_get_uptime_usec() - start;
+
+    res->reads = fc_test_count_dev.fctc_reads;
+    res->writes = fc_test_count_dev.fctc_writes;
+    res->bytes = fc_test_count_dev.fctc_bytes;
+
+    TEST_ASSERT_FATAL(off - FC_TEST_SECTOR_ADDR <= sizeof(fctb_image));
+}
+
+TEST_CASE_SELF(flash_cache_test_bench)
+{
+    struct fctb_result direct;
+    struct fctb_result cached;
+    const struct hal_flash *hf;
+    uint8_t buf[256];
+    uint32_t off;
+    int rc;
+
+    fc_test_init();
+
+    hf = &fc_test_count_dev.fctc_hal;
+    fctb_run(hf, &direct);
+    rc = hf->hf_itf->hff_read(hf, FC_TEST_SECTOR_ADDR, fctb_image,
+                              sizeof(fctb_image));
+    TEST_ASSERT_FATAL(rc == 0);
+
+    hf = &fc_test_cache_dev.fcd_hal;
+    fctb_run(hf, &cached);
+
+    /* Both leave the same bytes in flash. */
+    hf = &fc_test_count_dev.fctc_hal;
+    for (off = 0; off < sizeof(fctb_image); off += sizeof(buf)) {
+        rc = hf->hf_itf->hff_read(hf, FC_TEST_SECTOR_ADDR + off, buf,
+                                  sizeof(buf));
+        TEST_ASSERT_FATAL(rc == 0);
+        TEST_ASSERT_FATAL(!memcmp(buf, &fctb_image[off], sizeof(buf)));
+    }
+
+    TEST_ASSERT(cached.reads * 2 < direct.reads);
+    TEST_ASSERT(cached.writes * 4 < direct.writes);
+
+    printf("flash_cache: %d records, %d byte lines x %d\n",
+           FCTB_RECORDS, FLASH_CACHE_LINE_SZ,
+           MYNEWT_VAL(FLASH_CACHE_LINE_CNT));
+    printf("  direct: %u reads, %u writes, %u bytes, %llu us\n",
+           (unsigned)direct.reads, (unsigned)direct.writes,
+           (unsigned)direct.bytes, (unsigned long long)direct.usecs);
+    printf("  cached: %u reads, %u writes, %u bytes, %llu us\n",
+           (unsigned)cached.reads, (unsigned)cached.writes,
+           (unsigned)cached.bytes, (unsigned long long)cached.usecs);
+}
@@ -0,0 +1,84 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+
+#include "os/mynewt.h"
+#include <hal/hal_flash.h>
+#include "flash_cache_test.h"
+
+/*
+ * Erasing drops cached data, written back or not.
+ */
+TEST_CASE_SELF(flash_cache_test_erase)
+{
+    const struct hal_flash *hf;
+    uint8_t data[8];
+    uint8_t buf[8];
+    int rc;
+    int i;
+
+    fc_test_init();
+    hf = &fc_test_cache_dev.fcd_hal;
+
+    for (i = 0; i < sizeof(data); i++) {
+        data[i] = i;
+    }
+
+    rc = hf->hf_itf->hff_write(hf, FC_TEST_SECTOR_ADDR + 8, data,
+                               sizeof(data));
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(fc_test_count_dev.fctc_writes == 0);
+
+    rc = hf->hf_itf->hff_is_empty(hf, FC_TEST_SECTOR_ADDR + 8, buf,
+                                  sizeof(buf));
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(!memcmp(buf, data, sizeof(data)));
+
+    /* Dirty data is dropped, not written. */
+    rc = hf->hf_itf->hff_erase_sector(hf, FC_TEST_SECTOR_ADDR);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(fc_test_count_dev.fctc_writes == 0);
+
+    rc = hf->hf_itf->hff_is_empty(hf, FC_TEST_SECTOR_ADDR + 8, buf,
+                                  sizeof(buf));
+    TEST_ASSERT(rc == 1);
+
+    /* Written back data is not served from the cache after erase. */
+    rc = hf->hf_itf->hff_write(hf, FC_TEST_SECTOR_ADDR + 8, data,
+                               sizeof(data));
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = hal_flash_is_erased(hf, FC_TEST_SECTOR_ADDR + 8, buf, sizeof(buf));
+    TEST_ASSERT(rc == 0);
+    rc = flash_cache_flush(&fc_test_cache_dev);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(fc_test_count_dev.fctc_writes == 1);
+
+    rc = hf->hf_itf->hff_erase(hf, FC_TEST_SECTOR_ADDR, FC_TEST_SECTOR_SIZE);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = hf->hf_itf->hff_read(hf, FC_TEST_SECTOR_ADDR + 8, buf, sizeof(buf));
+    TEST_ASSERT_FATAL(rc == 0);
+    for (i = 0; i < sizeof(buf); i++) {
+        TEST_ASSERT(buf[i] == 0xff);
+    }
+
+    /* Unknown commands are passed down. */
+    rc = hf->hf_itf->hff_ioctl(hf, 0xffff, NULL);
+    TEST_ASSERT(rc == 0);
+}
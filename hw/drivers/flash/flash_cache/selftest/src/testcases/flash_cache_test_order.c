@@ -0,0 +1,118 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+
+#include "os/mynewt.h"
+#include <hal/hal_flash.h>
+#include "flash_cache_test.h"
+
+#define FCTO_ADDR(off)  (FC_TEST_SECTOR_ADDR + (off))
+#define FCTO_LINE(n)    FCTO_ADDR((n) * FLASH_CACHE_LINE_SZ)
+
+static void
+fcto_write(const struct hal_flash *hf, uint32_t addr, int len)
+{
+    uint8_t data[FLASH_CACHE_LINE_SZ];
+    int rc;
+
+    memset(data, 0x5a, len);
+    rc = hf->hf_itf->hff_write(hf, addr, data, len);
+    TEST_ASSERT_FATAL(rc == 0);
+}
+
+static void
+fcto_flush(const struct hal_flash *hf)
+{
+    int rc;
+
+    rc = hf->hf_itf->hff_ioctl(hf, HAL_FLASH_IOCTL_FLUSH, NULL);
+    TEST_ASSERT_FATAL(rc == 0);
+}
+
+/*
+ * Writes reach the underlying device in the order they were made.
+ */
+TEST_CASE_SELF(flash_cache_test_order)
+{
+    const struct hal_flash *hf;
+    uint32_t addr;
+    uint32_t last;
+    int cnt;
+    int i;
+
+    fc_test_init();
+    hf = &fc_test_cache_dev.fcd_hal;
+
+    /* A write to an older dirty line is not merged ahead of newer ones. */
+    fcto_write(hf, FCTO_LINE(0), 4);
+    fcto_write(hf, FCTO_LINE(1), 4);
+    fcto_write(hf, FCTO_LINE(0) + 4, 4);
+    fcto_flush(hf);
+    TEST_ASSERT_FATAL(fc_test_count_dev.fctc_writes == 3);
+    TEST_ASSERT(fc_test_count_dev.fctc_wlog[0] == FCTO_LINE(0));
+    TEST_ASSERT(fc_test_count_dev.fctc_wlog[1] == FCTO_LINE(1));
+    TEST_ASSERT(fc_test_count_dev.fctc_wlog[2] == FCTO_LINE(0) + 4);
+
+    /* Appends to the line dirtied last are merged. */
+    fc_test_count_reset();
+    fcto_write(hf, FCTO_LINE(2), 4);
+    fcto_write(hf, FCTO_LINE(2) + 4, 4);
+    fcto_flush(hf);
+    TEST_ASSERT(fc_test_count_dev.fctc_writes == 1);
+
+    /* Lines evicted to make room go out in write order. */
+    fc_test_count_reset();
+    cnt = min(2 * MYNEWT_VAL(FLASH_CACHE_LINE_CNT), FC_TEST_WLOG_MAX);
+    for (i = 0; i < cnt; i++) {
+        fcto_write(hf, FCTO_LINE(16 + i), 4);
+        if (i % 3 == 0) {
+            /* Touch an older line so that LRU order differs. */
+            fcto_write(hf, FCTO_LINE(1) + 4 + i, 1);
+        }
+    }
+    fcto_flush(hf);
+    TEST_ASSERT_FATAL(fc_test_count_dev.fctc_writes >= cnt);
+    TEST_ASSERT_FATAL(fc_test_count_dev.fctc_writes <= FC_TEST_WLOG_MAX);
+    last = 0;
+    for (i = 0; i < fc_test_count_dev.fctc_writes; i++) {
+        addr = fc_test_count_dev.fctc_wlog[i];
+        if (addr >= FCTO_LINE(16)) {
+            TEST_ASSERT(addr > last);
+            last = addr;
+        }
+    }
+    TEST_ASSERT(last == FCTO_LINE(16 + cnt - 1));
+
+    /* An overwrite goes out after the writes pending before it. */
+    fc_test_count_reset();
+    fcto_write(hf, FCTO_LINE(3), 4);
+    fcto_write(hf, FCTO_LINE(0), 1);
+    TEST_ASSERT_FATAL(fc_test_count_dev.fctc_writes == 2);
+    TEST_ASSERT(fc_test_count_dev.fctc_wlog[0] == FCTO_LINE(3));
+    TEST_ASSERT(fc_test_count_dev.fctc_wlog[1] == FCTO_LINE(0));
+
+    /* So does a write bypassing the cache. */
+    fc_test_count_reset();
+    fcto_write(hf, FCTO_LINE(4), 4);
+    fcto_write(hf, FCTO_LINE(5), FLASH_CACHE_LINE_SZ);
+    TEST_ASSERT_FATAL(fc_test_count_dev.fctc_writes == 2);
+    TEST_ASSERT(fc_test_count_dev.fctc_wlog[0] == FCTO_LINE(4));
+    TEST_ASSERT(fc_test_count_dev.fctc_wlog[1] == FCTO_LINE(5));
+}
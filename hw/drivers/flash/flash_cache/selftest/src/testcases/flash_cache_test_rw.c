@@ -0,0 +1,130 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+
+#include "os/mynewt.h"
+#include <mcu/native_bsp.h>
+#include <hal/hal_flash.h>
+#include "flash_cache_test.h"
+
+#define FCTR_WINDOW     (8 * 1024)
+#define FCTR_ITERS      4000
+
+static uint8_t fctr_model[FCTR_WINDOW];
+static uint8_t fctr_buf[128];
+static uint32_t fctr_seed;
+
+static uint32_t
+fctr_rand(void)
+{
+    fctr_seed = fctr_seed * 1103515245 + 12345;
+    return fctr_seed >> 8;
+}
+
+/*
+ * Mix of small appends, gaps, and short and long reads, checked against
+ * a copy kept in RAM.
+ */
+TEST_CASE_SELF(flash_cache_test_rw)
+{
+    const struct hal_flash *hf;
+    uint32_t pos;
+    uint32_t off;
+    uint32_t len;
+    int rc;
+    int i;
+
+    fc_test_init();
+    hf = &fc_test_cache_dev.fcd_hal;
+    memset(fctr_model, 0xff, sizeof(fctr_model));
+    fctr_seed = 1;
+    pos = 0;
+
+    for (i = 0; i < FCTR_ITERS; i++) {
+        switch (fctr_rand() % 4) {
+        case 0:
+        case 1:
+            if (fctr_rand() % 8 == 0) {
+                len = 64 + fctr_rand() % 64;
+            } else {
+                len = 1 + fctr_rand() % 40;
+            }
+            if (pos + len > FCTR_WINDOW) {
+                break;
+            }
+            for (off = 0; off < len; off++) {
+                fctr_buf[off] = fctr_rand();
+            }
+            rc = hf->hf_itf->hff_write(hf, FC_TEST_SECTOR_ADDR + pos,
+                                       fctr_buf, len);
+            TEST_ASSERT_FATAL(rc == 0);
+            memcpy(&fctr_model[pos], fctr_buf, len);
+            pos += len;
+            if (fctr_rand() % 4 == 0) {
+                /* Leave some erased bytes behind. */
+                pos += fctr_rand() % 8;
+            }
+            break;
+        case 2:
+            len = 1 + fctr_rand() % 16;
+            off = fctr_rand() % (FCTR_WINDOW - len);
+            rc = hf->hf_itf->hff_read(hf, FC_TEST_SECTOR_ADDR + off,
+                                      fctr_buf, len);
+            TEST_ASSERT_FATAL(rc == 0);
+            TEST_ASSERT_FATAL(!memcmp(fctr_buf, &fctr_model[off], len));
+            break;
+        case 3:
+            len = 1 + fctr_rand() % sizeof(fctr_buf);
+            off = pos > len ? pos - len : 0;
+            if (off + len > FCTR_WINDOW) {
+                off = FCTR_WINDOW - len;
+            }
+            rc = hf->hf_itf->hff_read(hf, FC_TEST_SECTOR_ADDR + off,
+                                      fctr_buf, len);
+            TEST_ASSERT_FATAL(rc == 0);
+            TEST_ASSERT_FATAL(!memcmp(fctr_buf, &fctr_model[off], len));
+            break;
+        }
+    }
+
+    /*
+     * After a flush, the underlying flash holds everything.
+     */
+    rc = hf->hf_itf->hff_ioctl(hf, HAL_FLASH_IOCTL_FLUSH, NULL);
+    TEST_ASSERT(rc == 0);
+    for (off = 0; off < FCTR_WINDOW; off += sizeof(fctr_buf)) {
+        rc = native_flash_dev.hf_itf->hff_read(&native_flash_dev,
+                                               FC_TEST_SECTOR_ADDR + off,
+                                               fctr_buf, sizeof(fctr_buf));
+        TEST_ASSERT_FATAL(rc == 0);
+        TEST_ASSERT_FATAL(!memcmp(fctr_buf, &fctr_model[off],
+                                  sizeof(fctr_buf)));
+    }
+
+    /* Nothing left to write. */
+    fc_test_count_reset();
+    rc = flash_cache_flush(&fc_test_cache_dev);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(fc_test_count_dev.fctc_writes == 0);
+
+    TEST_ASSERT(fc_test_cache_dev.fcd_stats.sread_hits > 0);
+    TEST_ASSERT(fc_test_cache_dev.fcd_stats.swrite_hits > 0);
+    TEST_ASSERT(fc_test_cache_dev.fcd_stats.sevictions > 0);
+}
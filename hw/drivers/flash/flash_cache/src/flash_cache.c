@@ -0,0 +1,685 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include <string.h>
+
+#include <os/mynewt.h>
+#include <hal/hal_flash.h>
+
+#include "flash_cache/flash_cache.h"
+
+#define HAL_TO_FC(dev)          ((struct flash_cache_dev *)(dev))
+
+#define FC_LINE_CNT             MYNEWT_VAL(FLASH_CACHE_LINE_CNT)
+#define FC_LINE_MASK            (FLASH_CACHE_LINE_SZ - 1)
+#define FC_NO_ADDR              0xffffffff
+
+#if (FLASH_CACHE_LINE_SZ & FC_LINE_MASK) != 0
+#error "FLASH_CACHE_LINE_SIZE must be a power of two"
+#endif
+
+static int flash_cache_read(const struct hal_flash *h_dev, uint32_t addr,
+                            void *buf, uint32_t len);
+static int flash_cache_write(const struct hal_flash *h_dev, uint32_t addr,
+                             const void *buf, uint32_t len);
+static int flash_cache_erase_sector(const struct hal_flash *h_dev,
+                                    uint32_t addr);
+static int flash_cache_sector_info(const struct hal_flash *h_dev, int idx,
+                                   uint32_t *addr, uint32_t *sz);
+static int flash_cache_is_empty(const struct hal_flash *h_dev, uint32_t addr,
+                                void *buf, uint32_t len);
+static int flash_cache_init(const struct hal_flash *h_dev);
+static int flash_cache_erase(const struct hal_flash *h_dev, uint32_t addr,
+                             uint32_t len);
+static int flash_cache_ioctl(const struct hal_flash *h_dev, uint32_t cmd,
+                             void *args);
+
+const struct hal_flash_funcs flash_cache_funcs = {
+    .hff_read         = flash_cache_read,
+    .hff_write        = flash_cache_write,
+    .hff_erase_sector = flash_cache_erase_sector,
+    .hff_sector_info  = flash_cache_sector_info,
+    .hff_is_empty     = flash_cache_is_empty,
+    .hff_init         = flash_cache_init,
+    .hff_erase        = flash_cache_erase,
+    .hff_ioctl        = flash_cache_ioctl,
+};
+
+STATS_NAME_START(flash_cache_stats)
+    STATS_NAME(flash_cache_stats, read_hits)
+    STATS_NAME(flash_cache_stats, read_misses)
+    STATS_NAME(flash_cache_stats, read_bypass)
+    STATS_NAME(flash_cache_stats, write_hits)
+    STATS_NAME(flash_cache_stats, write_misses)
+    STATS_NAME(flash_cache_stats, write_bypass)
+    STATS_NAME(flash_cache_stats, write_through)
+    STATS_NAME(flash_cache_stats, writebacks)
+    STATS_NAME(flash_cache_stats, evictions)
+    STATS_NAME(flash_cache_stats, flushes)
+STATS_NAME_END(flash_cache_stats)
+
+static SLIST_HEAD(, flash_cache_dev) flash_cache_devs =
+    SLIST_HEAD_INITIALIZER(flash_cache_devs);
+
+static void
+flash_cache_lock(struct flash_cache_dev *dev)
+{
+    int rc;
+
+    rc = os_mutex_pend(&dev->fcd_lock, OS_TIMEOUT_NEVER);
+    assert(rc == 0 || rc == OS_NOT_STARTED);
+}
+
+static void
+flash_cache_unlock(struct flash_cache_dev *dev)
+{
+    int rc;
+
+    rc = os_mutex_release(&dev->fcd_lock);
+    assert(rc == 0 || rc == OS_NOT_STARTED);
+}
+
+static void
+flash_cache_line_inval(struct flash_cache_line *line)
+{
+    line->fcl_addr = FC_NO_ADDR;
+    line->fcl_dirty_lo = 0;
+    line->fcl_dirty_hi = 0;
+}
+
+static int
+flash_cache_line_dirty(const struct flash_cache_line *line)
+{
+    return line->fcl_dirty_lo != line->fcl_dirty_hi;
+}
+
+static int
+flash_cache_line_writeback(struct flash_cache_dev *dev,
+                           struct flash_cache_line *line)
+{
+    const struct hal_flash *hwdev;
+    uint16_t lo;
+    uint16_t hi;
+
+    lo = line->fcl_dirty_lo;
+    hi = line->fcl_dirty_hi;
+    if (lo == hi) {
+        return 0;
+    }
+    line->fcl_dirty_lo = 0;
+    line->fcl_dirty_hi = 0;
+
+    hwdev = dev->fcd_hwdev;
+    STATS_INC(dev->fcd_stats, writebacks);
+    return hwdev->hf_itf->hff_write(hwdev, line->fcl_addr + lo,
+                                    &line->fcl_data[lo], hi - lo);
+}
+
+/*
+ * Writes back, oldest first, every line which became dirty no later than
+ * seq.  Data reaches the underlying device in the order it was written to
+ * the cache.
+ */
+static int
+flash_cache_writeback_upto(struct flash_cache_dev *dev, uint32_t seq)
+{
+    struct flash_cache_line *line;
+    struct flash_cache_line *oldest;
+    int rc;
+    int i;
+
+    while (1) {
+        oldest = NULL;
+        for (i = 0; i < FC_LINE_CNT; i++) {
+            line = &dev->fcd_lines[i];
+            if (!flash_cache_line_dirty(line) ||
+                (int32_t)(line->fcl_dirty_seq - seq) > 0) {
+                continue;
+            }
+            if (!oldest ||
+                (int32_t)(line->fcl_dirty_seq - oldest->fcl_dirty_seq) < 0) {
+                oldest = line;
+            }
+        }
+        if (!oldest) {
+            return 0;
+        }
+        rc = flash_cache_line_writeback(dev, oldest);
+        if (rc) {
+            flash_cache_line_inval(oldest);
+            return rc;
+        }
+    }
+}
+
+/*
+ * Writes back all dirty lines, oldest first.
+ */
+static int
+flash_cache_writeback_all(struct flash_cache_dev *dev)
+{
+    return flash_cache_writeback_upto(dev, dev->fcd_seq);
+}
+
+static struct flash_cache_line *
+flash_cache_line_find(struct flash_cache_dev *dev, uint32_t line_addr)
+{
+    struct flash_cache_line *line;
+    int i;
+
+    for (i = 0; i < FC_LINE_CNT; i++) {
+        line = &dev->fcd_lines[i];
+        if (line->fcl_addr == line_addr) {
+            line->fcl_used = ++dev->fcd_clock;
+            return line;
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Takes over a line for line_addr and fills it from the underlying device.
+ * The least recently used clean line is taken if there is one; otherwise
+ * the line which has been dirty the longest, so that writing it back
+ * keeps data in order.
+ */
+static int
+flash_cache_line_load(struct flash_cache_dev *dev, uint32_t line_addr,
+                      struct flash_cache_line **out_line)
+{
+    const struct hal_flash *hwdev;
+    struct flash_cache_line *line;
+    struct flash_cache_line *victim;
+    int rc;
+    int i;
+
+    victim = NULL;
+    for (i = 0; i < FC_LINE_CNT; i++) {
+        line = &dev->fcd_lines[i];
+        if (line->fcl_addr == FC_NO_ADDR) {
+            victim = line;
+            break;
+        }
+        if (!victim) {
+            victim = line;
+        } else if (flash_cache_line_dirty(line) !=
+                   flash_cache_line_dirty(victim)) {
+            if (!flash_cache_line_dirty(line)) {
+                victim = line;
+            }
+        } else if (flash_cache_line_dirty(line)) {
+            if ((int32_t)(line->fcl_dirty_seq - victim->fcl_dirty_seq) < 0) {
+                victim = line;
+            }
+        } else if ((int32_t)(line->fcl_used - victim->fcl_used) < 0) {
+            victim = line;
+        }
+    }
+
+    if (victim->fcl_addr != FC_NO_ADDR) {
+        STATS_INC(dev->fcd_stats, evictions);
+        if (flash_cache_line_dirty(victim)) {
+            rc = flash_cache_writeback_upto(dev, victim->fcl_dirty_seq);
+            if (rc) {
+                flash_cache_line_inval(victim);
+                return rc;
+            }
+        }
+    }
+
+    hwdev = dev->fcd_hwdev;
+    rc = hwdev->hf_itf->hff_read(hwdev, line_addr, victim->fcl_data,
+                                 FLASH_CACHE_LINE_SZ);
+    if (rc) {
+        flash_cache_line_inval(victim);
+        return rc;
+    }
+    victim->fcl_addr = line_addr;
+    victim->fcl_used = ++dev->fcd_clock;
+    *out_line = victim;
+
+    return 0;
+}
+
+/*
+ * Writes back lines overlapping [addr, addr + len), along with any line
+ * which became dirty before them.
+ */
+static int
+flash_cache_flush_range(struct flash_cache_dev *dev, uint32_t addr,
+                        uint32_t len)
+{
+    struct flash_cache_line *line;
+    struct flash_cache_line *newest;
+    int i;
+
+    newest = NULL;
+    for (i = 0; i < FC_LINE_CNT; i++) {
+        line = &dev->fcd_lines[i];
+        if (!flash_cache_line_dirty(line) ||
+            line->fcl_addr + FLASH_CACHE_LINE_SZ <= addr ||
+            line->fcl_addr >= addr + len) {
+            continue;
+        }
+        if (!newest ||
+            (int32_t)(line->fcl_dirty_seq - newest->fcl_dirty_seq) > 0) {
+            newest = line;
+        }
+    }
+    if (!newest) {
+        return 0;
+    }
+    return flash_cache_writeback_upto(dev, newest->fcl_dirty_seq);
+}
+
+/*
+ * Drops lines overlapping [addr, addr + len) without writing them back;
+ * the range is about to be erased.
+ */
+static void
+flash_cache_inval_range(struct flash_cache_dev *dev, uint32_t addr,
+                        uint32_t len)
+{
+    struct flash_cache_line *line;
+    int i;
+
+    for (i = 0; i < FC_LINE_CNT; i++) {
+        line = &dev->fcd_lines[i];
+        if (line->fcl_addr != FC_NO_ADDR &&
+            line->fcl_addr + FLASH_CACHE_LINE_SZ > addr &&
+            line->fcl_addr < addr + len) {
+            flash_cache_line_inval(line);
+        }
+    }
+}
+
+static int
+flash_cache_read(const struct hal_flash *h_dev, uint32_t addr, void *buf,
+                 uint32_t len)
+{
+    struct flash_cache_dev *dev = HAL_TO_FC(h_dev);
+    const struct hal_flash *hwdev;
+    struct flash_cache_line *line;
+    uint8_t *bufb = buf;
+    uint32_t off;
+    uint32_t cnt;
+    int rc;
+
+    hwdev = dev->fcd_hwdev;
+
+    flash_cache_lock(dev);
+
+    if (len >= FLASH_CACHE_LINE_SZ) {
+        /*
+         * Large reads would only thrash the cache.  Make sure flash is
+         * up to date and read directly.
+         */
+        STATS_INC(dev->fcd_stats, read_bypass);
+        rc = flash_cache_flush_range(dev, addr, len);
+        if (!rc) {
+            rc = hwdev->hf_itf->hff_read(hwdev, addr, buf, len);
+        }
+        goto out;
+    }
+
+    rc = 0;
+    while (len) {
+        off = addr & FC_LINE_MASK;
+        cnt = min(len, FLASH_CACHE_LINE_SZ - off);
+
+        line = flash_cache_line_find(dev, addr - off);
+        if (line) {
+            STATS_INC(dev->fcd_stats, read_hits);
+        } else {
+            STATS_INC(dev->fcd_stats, read_misses);
+            rc = flash_cache_line_load(dev, addr - off, &line);
+            if (rc) {
+                break;
+            }
+        }
+        memcpy(bufb, &line->fcl_data[off], cnt);
+
+        addr += cnt;
+        bufb += cnt;
+        len -= cnt;
+    }
+out:
+    flash_cache_unlock(dev);
+    return rc;
+}
+
+static int
+flash_cache_write_line(struct flash_cache_dev *dev, uint32_t addr,
+                       const uint8_t *buf, uint32_t cnt)
+{
+    const struct hal_flash *hwdev;
+    struct flash_cache_line *line;
+    uint32_t off;
+    uint32_t i;
+    int rc;
+
+    hwdev = dev->fcd_hwdev;
+    off = addr & FC_LINE_MASK;
+
+    line = flash_cache_line_find(dev, addr - off);
+    if (line) {
+        STATS_INC(dev->fcd_stats, write_hits);
+    } else {
+        STATS_INC(dev->fcd_stats, write_misses);
+        rc = flash_cache_line_load(dev, addr - off, &line);
+        if (rc) {
+            return rc;
+        }
+    }
+
+    for (i = off; i < off + cnt; i++) {
+        if (line->fcl_data[i] != dev->fcd_hal.hf_erased_val) {
+            /*
+             * Not writing to erased flash; let the underlying device deal
+             * with it in program order.
+             */
+            STATS_INC(dev->fcd_stats, write_through);
+            rc = flash_cache_writeback_all(dev);
+            flash_cache_line_inval(line);
+            if (rc) {
+                return rc;
+            }
+            return hwdev->hf_itf->hff_write(hwdev, addr, buf, cnt);
+        }
+    }
+
+    if (flash_cache_line_dirty(line) &&
+        (line->fcl_dirty_seq != dev->fcd_seq ||
+         off > line->fcl_dirty_hi || off + cnt < line->fcl_dirty_lo)) {
+        /*
+         * Only keep a single contiguous range per line.  Writes are only
+         * merged into the line dirtied last; otherwise this line, and
+         * everything dirtied before it, goes out first.
+         */
+        rc = flash_cache_writeback_upto(dev, line->fcl_dirty_seq);
+        if (rc) {
+            return rc;
+        }
+    }
+    if (!flash_cache_line_dirty(line)) {
+        line->fcl_dirty_lo = off;
+        line->fcl_dirty_hi = off + cnt;
+        line->fcl_dirty_seq = ++dev->fcd_seq;
+    } else {
+        line->fcl_dirty_lo = min(line->fcl_dirty_lo, off);
+        line->fcl_dirty_hi = max(line->fcl_dirty_hi, off + cnt);
+    }
+    memcpy(&line->fcl_data[off], buf, cnt);
+
+    return 0;
+}
+
+static int
+flash_cache_write(const struct hal_flash *h_dev, uint32_t addr,
+                  const void *buf, uint32_t len)
+{
+    struct flash_cache_dev *dev = HAL_TO_FC(h_dev);
+    const struct hal_flash *hwdev;
+    const uint8_t *bufb = buf;
+    uint32_t cnt;
+    int rc;
+
+    hwdev = dev->fcd_hwdev;
+
+    flash_cache_lock(dev);
+
+    if (len >= FLASH_CACHE_LINE_SZ) {
+        STATS_INC(dev->fcd_stats, write_bypass);
+        rc = flash_cache_writeback_all(dev);
+        flash_cache_inval_range(dev, addr, len);
+        if (!rc) {
+            rc = hwdev->hf_itf->hff_write(hwdev, addr, buf, len);
+        }
+        goto out;
+    }
+
+    rc = 0;
+    while (len) {
+        cnt = min(len, FLASH_CACHE_LINE_SZ - (addr & FC_LINE_MASK));
+        rc = flash_cache_write_line(dev, addr, bufb, cnt);
+        if (rc) {
+            break;
+        }
+        addr += cnt;
+        bufb += cnt;
+        len -= cnt;
+    }
+out:
+    flash_cache_unlock(dev);
+    return rc;
+}
+
+static int
+flash_cache_erase_sector(const struct hal_flash *h_dev, uint32_t addr)
+{
+    struct flash_cache_dev *dev = HAL_TO_FC(h_dev);
+    const struct hal_flash *hwdev;
+    uint32_t start;
+    uint32_t size;
+    int rc;
+    int i;
+
+    hwdev = dev->fcd_hwdev;
+
+    flash_cache_lock(dev);
+    for (i = 0; i < hwdev->hf_sector_cnt; i++) {
+        rc = hwdev->hf_itf->hff_sector_info(hwdev, i, &start, &size);
+        assert(rc == 0);
+        if (addr >= start && addr < start + size) {
+            flash_cache_inval_range(dev, start, size);
+            break;
+        }
+    }
+    /* Writes made before the erase land before it. */
+    rc = flash_cache_writeback_all(dev);
+    if (!rc) {
+        rc = hwdev->hf_itf->hff_erase_sector(hwdev, addr);
+    }
+    flash_cache_unlock(dev);
+
+    return rc;
+}
+
+static int
+flash_cache_erase(const struct hal_flash *h_dev, uint32_t addr, uint32_t len)
+{
+    struct flash_cache_dev *dev = HAL_TO_FC(h_dev);
+    const struct hal_flash *hwdev;
+    uint32_t start;
+    uint32_t size;
+    uint32_t end;
+    int rc;
+    int i;
+
+    hwdev = dev->fcd_hwdev;
+    end = addr + len;
+
+    flash_cache_lock(dev);
+    for (i = 0; i < hwdev->hf_sector_cnt; i++) {
+        rc = hwdev->hf_itf->hff_sector_info(hwdev, i, &start, &size);
+        assert(rc == 0);
+        if (start + size > addr && start < end) {
+            flash_cache_inval_range(dev, start, size);
+        }
+    }
+    /* Writes made before the erase land before it. */
+    rc = flash_cache_writeback_all(dev);
+    if (rc) {
+        goto out;
+    }
+    for (i = 0; i < hwdev->hf_sector_cnt; i++) {
+        rc = hwdev->hf_itf->hff_sector_info(hwdev, i, &start, &size);
+        assert(rc == 0);
+        if (start + size <= addr || start >= end) {
+            continue;
+        }
+        if (!hwdev->hf_itf->hff_erase) {
+            rc = hwdev->hf_itf->hff_erase_sector(hwdev, start);
+            if (rc) {
+                goto out;
+            }
+        }
+    }
+    if (hwdev->hf_itf->hff_erase) {
+        rc = hwdev->hf_itf->hff_erase(hwdev, addr, len);
+    }
+out:
+    flash_cache_unlock(dev);
+    return rc;
+}
+
+static int
+flash_cache_sector_info(const struct hal_flash *h_dev, int idx,
+                        uint32_t *addr, uint32_t *sz)
+{
+    struct flash_cache_dev *dev = HAL_TO_FC(h_dev);
+
+    h_dev = dev->fcd_hwdev;
+
+    return h_dev->hf_itf->hff_sector_info(h_dev, idx, addr, sz);
+}
+
+static int
+flash_cache_is_empty(const struct hal_flash *h_dev, uint32_t addr, void *buf,
+                     uint32_t len)
+{
+    struct flash_cache_dev *dev = HAL_TO_FC(h_dev);
+    const struct hal_flash *hwdev;
+    int rc;
+
+    hwdev = dev->fcd_hwdev;
+
+    if (hwdev->hf_itf->hff_is_empty) {
+        flash_cache_lock(dev);
+        rc = flash_cache_flush_range(dev, addr, len);
+        if (!rc) {
+            rc = hwdev->hf_itf->hff_is_empty(hwdev, addr, buf, len);
+        }
+        flash_cache_unlock(dev);
+        return rc;
+    } else {
+        return hal_flash_is_erased(h_dev, addr, buf, len);
+    }
+}
+
+int
+flash_cache_flush(struct flash_cache_dev *dev)
+{
+    int rc;
+
+    flash_cache_lock(dev);
+    STATS_INC(dev->fcd_stats, flushes);
+    rc = flash_cache_writeback_all(dev);
+    flash_cache_unlock(dev);
+
+    return rc;
+}
+
+static int
+flash_cache_ioctl(const struct hal_flash *h_dev, uint32_t cmd, void *args)
+{
+    struct flash_cache_dev *dev = HAL_TO_FC(h_dev);
+
+    h_dev = dev->fcd_hwdev;
+
+    if (cmd == HAL_FLASH_IOCTL_FLUSH) {
+        return flash_cache_flush(dev);
+    }
+    if (h_dev->hf_itf->hff_ioctl) {
+        return h_dev->hf_itf->hff_ioctl(h_dev, cmd, args);
+    }
+    return 0;
+}
+
+static int
+flash_cache_init(const struct hal_flash *h_dev)
+{
+    struct flash_cache_dev *dev = HAL_TO_FC(h_dev);
+    struct flash_cache_dev *cur;
+    uint32_t start;
+    uint32_t size;
+    int rc;
+    int i;
+
+    h_dev = dev->fcd_hwdev;
+
+    dev->fcd_hal.hf_base_addr = h_dev->hf_base_addr;
+    dev->fcd_hal.hf_size = h_dev->hf_size;
+    dev->fcd_hal.hf_sector_cnt = h_dev->hf_sector_cnt;
+    dev->fcd_hal.hf_align = h_dev->hf_align;
+    dev->fcd_hal.hf_erased_val = h_dev->hf_erased_val;
+
+    /*
+     * Lines must not straddle sectors, and flushing a line must not
+     * produce unaligned writes.
+     */
+    if (FLASH_CACHE_LINE_SZ % h_dev->hf_align) {
+        return SYS_EINVAL;
+    }
+    for (i = 0; i < h_dev->hf_sector_cnt; i++) {
+        rc = h_dev->hf_itf->hff_sector_info(h_dev, i, &start, &size);
+        if (rc) {
+            return rc;
+        }
+        if ((start | size) & FC_LINE_MASK) {
+            return SYS_EINVAL;
+        }
+    }
+
+    SLIST_FOREACH(cur, &flash_cache_devs, fcd_next) {
+        if (cur == dev) {
+            /* Already set up. */
+            return 0;
+        }
+    }
+
+    for (i = 0; i < FC_LINE_CNT; i++) {
+        flash_cache_line_inval(&dev->fcd_lines[i]);
+    }
+    os_mutex_init(&dev->fcd_lock);
+
+    rc = stats_init_and_reg(STATS_HDR(dev->fcd_stats),
+                            STATS_SIZE_INIT_PARMS(dev->fcd_stats,
+                                                  STATS_SIZE_32),
+                            STATS_NAME_INIT_PARMS(flash_cache_stats),
+                            dev->fcd_name ? dev->fcd_name : "flash_cache");
+    if (rc) {
+        return rc;
+    }
+    SLIST_INSERT_HEAD(&flash_cache_devs, dev, fcd_next);
+
+    return 0;
+}
+
+int
+flash_cache_sysdown(int reason)
+{
+    struct flash_cache_dev *dev;
+
+    SLIST_FOREACH(dev, &flash_cache_devs, fcd_next) {
+        flash_cache_flush(dev);
+    }
+    return SYSDOWN_COMPLETE;
+}
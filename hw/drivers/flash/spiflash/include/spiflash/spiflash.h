@@ -69,9 +69,15 @@ struct spiflash_dev {
     /* Pointer to one of the supported chips */
     const struct spiflash_chip *flash_chip;
     const struct spiflash_characteristics *characteristics;
+    /* hal.hf_erase_blocks: chip, 64kB and 32kB block, 0 terminated */
+    uint32_t erase_blocks[4];
 #if MYNEWT_VAL(OS_SCHEDULING)
     struct os_mutex lock;
 #endif
+#if MYNEWT_VAL(HAL_FLASH_ASYNC)
+    /* Max time of the command started for the async API, 0 when idle */
+    uint32_t async_max_us;
+#endif
 #if MYNEWT_VAL(SPIFLASH_AUTO_POWER_DOWN)
 #if MYNEWT_VAL(OS_SCHEDULING)
     struct os_callout apd_tmo_co;   /* Auto power down timeout callout */
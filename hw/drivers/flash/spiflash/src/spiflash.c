@@ -589,6 +589,16 @@ static int hal_spiflash_sector_info(const struct hal_flash *hal_flash_dev, int i
 static int hal_spiflash_init(const struct hal_flash *dev);
 static int hal_spiflash_erase(const struct hal_flash *hal_flash_dev,
         uint32_t address, uint32_t sz);
+static int hal_spiflash_erase_block(const struct hal_flash *hal_flash_dev,
+        uint32_t address, uint32_t sz);
+#if MYNEWT_VAL(HAL_FLASH_ASYNC)
+static int hal_spiflash_erase_start(const struct hal_flash *hal_flash_dev,
+        uint32_t address, uint32_t sz, uint32_t *done, uint32_t *wait_us);
+static int hal_spiflash_write_start(const struct hal_flash *hal_flash_dev,
+        uint32_t addr, const void *buf, uint32_t len, uint32_t *done,
+        uint32_t *wait_us);
+static int hal_spiflash_busy(const struct hal_flash *hal_flash_dev);
+#endif
 
 static const struct hal_flash_funcs spiflash_flash_funcs = {
     .hff_read         = hal_spiflash_read,
@@ -597,6 +607,12 @@ static const struct hal_flash_funcs spiflash_flash_funcs = {
     .hff_sector_info  = hal_spiflash_sector_info,
     .hff_init         = hal_spiflash_init,
     .hff_erase        = hal_spiflash_erase,
+    .hff_erase_block  = hal_spiflash_erase_block,
+#if MYNEWT_VAL(HAL_FLASH_ASYNC)
+    .hff_erase_start  = hal_spiflash_erase_start,
+    .hff_write_start  = hal_spiflash_write_start,
+    .hff_busy         = hal_spiflash_busy,
+#endif
 };
 
 static const struct spiflash_characteristics spiflash_characteristics = {
@@ -921,6 +937,11 @@ bool
 spiflash_device_ready(struct spiflash_dev *dev)
 {
     dev->ready = !(spiflash_read_status(dev) & SPIFLASH_STATUS_BUSY);
+#if MYNEWT_VAL(HAL_FLASH_ASYNC)
+    if (dev->ready) {
+        dev->async_max_us = 0;
+    }
+#endif
 
     return dev->ready;
 }
@@ -967,7 +988,18 @@ spiflash_wait_ready(struct spiflash_dev *dev, uint32_t timeout_ms)
      * If it would be shorter time than SPIFLASH_READ_STATUS_INTERVAL
      * number of timer status register is checked will be smaler.
      */
-    return spiflash_wait_ready_till(dev, timeout_ms * 1000, timeout_ms * 10);
+    uint32_t timeout_us = timeout_ms * 1000;
+
+#if MYNEWT_VAL(HAL_FLASH_ASYNC)
+    /*
+     * A command started by the async queue (e.g. a chip erase) may still
+     * be running, give it all the time it can take.
+     */
+    if (dev->async_max_us > timeout_us) {
+        timeout_us = dev->async_max_us;
+    }
+#endif
+    return spiflash_wait_ready_till(dev, timeout_us, timeout_us / 100);
 }
 
 int
@@ -1081,14 +1113,54 @@ hal_spiflash_read(const struct hal_flash *hal_flash_dev, uint32_t addr, void *bu
     return 0;
 }
 
+/*
+ * Sends a page program command for as much of the data as fits in the
+ * page addr is in.  Does not wait for the program to finish.
+ *
+ * @return number of bytes being programmed.
+ */
+static uint32_t
+spiflash_page_program(struct spiflash_dev *dev, uint32_t addr,
+                      const uint8_t *u8buf, uint32_t len)
+{
+    uint8_t cmd[4] = { SPIFLASH_PAGE_PROGRAM };
+    uint32_t page_limit;
+    uint32_t to_write;
+
+    spiflash_write_enable(dev);
+
+    cmd[1] = (uint8_t)(addr >> 16);
+    cmd[2] = (uint8_t)(addr >> 8);
+    cmd[3] = (uint8_t)(addr);
+
+    page_limit = (addr & ~(dev->page_size - 1)) + dev->page_size;
+    to_write = page_limit - addr > len ? len :  page_limit - addr;
+
+#if MYNEWT_VAL(BUS_DRIVER_PRESENT)
+    bus_node_lock((struct os_dev *)&dev->dev,
+        BUS_NODE_LOCK_DEFAULT_TIMEOUT);
+    bus_node_write((struct os_dev *)&dev->dev,
+        cmd, 4, BUS_NODE_LOCK_DEFAULT_TIMEOUT, BUS_F_NOSTOP);
+    bus_node_simple_write((struct os_dev *)&dev->dev, u8buf, to_write);
+    bus_node_unlock((struct os_dev *)&dev->dev);
+#else
+    spiflash_cs_activate(dev);
+    hal_spi_txrx(dev->spi_num, cmd, NULL, sizeof cmd);
+    hal_spi_txrx(dev->spi_num, (void *)u8buf, NULL, to_write);
+    spiflash_cs_deactivate(dev);
+#endif
+    /* Now we know that device is not ready */
+    dev->ready = false;
+
+    return to_write;
+}
+
 static int
 hal_spiflash_write(const struct hal_flash *hal_flash_dev, uint32_t addr,
         const void *buf, uint32_t len)
 {
-    uint8_t cmd[4] = { SPIFLASH_PAGE_PROGRAM };
     const uint8_t *u8buf = buf;
     struct spiflash_dev *dev = (struct spiflash_dev *)hal_flash_dev;
-    uint32_t page_limit;
     uint32_t to_write;
     uint32_t pp_time_typical;
     uint32_t pp_time_maximum;
@@ -1114,30 +1186,7 @@ hal_spiflash_write(const struct hal_flash *hal_flash_dev, uint32_t addr,
     }
 
     while (len) {
-        spiflash_write_enable(dev);
-
-        cmd[1] = (uint8_t)(addr >> 16);
-        cmd[2] = (uint8_t)(addr >> 8);
-        cmd[3] = (uint8_t)(addr);
-
-        page_limit = (addr & ~(dev->page_size - 1)) + dev->page_size;
-        to_write = page_limit - addr > len ? len :  page_limit - addr;
-
-#if MYNEWT_VAL(BUS_DRIVER_PRESENT)
-        bus_node_lock((struct os_dev *)&dev->dev,
-            BUS_NODE_LOCK_DEFAULT_TIMEOUT);
-        bus_node_write((struct os_dev *)&dev->dev,
-            cmd, 4, BUS_NODE_LOCK_DEFAULT_TIMEOUT, BUS_F_NOSTOP);
-        bus_node_simple_write((struct os_dev *)&dev->dev, u8buf, to_write);
-        bus_node_unlock((struct os_dev *)&dev->dev);
-#else
-        spiflash_cs_activate(dev);
-        hal_spi_txrx(dev->spi_num, cmd, NULL, sizeof cmd);
-        hal_spi_txrx(dev->spi_num, (void *)u8buf, NULL, to_write);
-        spiflash_cs_deactivate(dev);
-#endif
-        /* Now we know that device is not ready */
-        dev->ready = false;
+        to_write = spiflash_page_program(dev, addr, u8buf, len);
         spiflash_delay_us(pp_time_typical);
         rc = spiflash_wait_ready_till(dev, pp_time_maximum - pp_time_typical,
             (pp_time_maximum - pp_time_typical) / 10);
@@ -1172,14 +1221,14 @@ hal_spiflash_erase(const struct hal_flash *hal_flash_dev,
     return spiflash_erase(dev, address, size);
 }
 
+/*
+ * Sends an erase command.  Does not wait for the erase to finish.
+ */
 static int
-spiflash_execute_erase(struct spiflash_dev *dev, const uint8_t *buf,
-                       uint32_t size,
-                       const struct spiflash_time_spec *delay_spec)
+spiflash_start_erase(struct spiflash_dev *dev, const uint8_t *buf,
+                     uint32_t size)
 {
     int rc = 0;
-    uint32_t wait_time_us;
-    uint32_t start_time;
 
     spiflash_lock(dev);
 
@@ -1207,6 +1256,27 @@ spiflash_execute_erase(struct spiflash_dev *dev, const uint8_t *buf,
 #endif
     /* Now we know that device is not ready */
     dev->ready = false;
+err:
+    spiflash_unlock(dev);
+
+    return rc;
+}
+
+static int
+spiflash_execute_erase(struct spiflash_dev *dev, const uint8_t *buf,
+                       uint32_t size,
+                       const struct spiflash_time_spec *delay_spec)
+{
+    int rc = 0;
+    uint32_t wait_time_us;
+    uint32_t start_time;
+
+    spiflash_lock(dev);
+
+    rc = spiflash_start_erase(dev, buf, size);
+    if (rc) {
+        goto err;
+    }
 
     start_time = os_cputime_get32();
     /* Wait typical erase time before starting polling for ready */
@@ -1282,55 +1352,177 @@ spiflash_chip_erase(struct spiflash_dev *dev)
                                   &dev->characteristics->tce);
 }
 
-int
-spiflash_erase(struct spiflash_dev *dev, uint32_t address, uint32_t size)
+/*
+ * Fills in the command which erases size bytes at addr.  size is either
+ * the sector size or one of dev->erase_blocks.
+ *
+ * @return length of the command, 0 if there is no such command.
+ */
+static uint32_t
+spiflash_erase_cmd_fill(struct spiflash_dev *dev, uint32_t addr,
+                        uint32_t size, uint8_t *buf,
+                        const struct spiflash_time_spec **spec)
 {
-    int rc = 0;
-
-    if (address == 0 && size == dev->hal.hf_size) {
-        return spiflash_chip_erase(dev);
+    if (size == dev->hal.hf_size) {
+        buf[0] = SPIFLASH_CHIP_ERASE;
+        *spec = &dev->characteristics->tce;
+        return 1;
     }
-    address &= ~0xFFFU;
-    while (size) {
+    if (size == dev->sector_size) {
+        buf[0] = SPIFLASH_SECTOR_ERASE;
+        *spec = &dev->characteristics->tse;
 #if MYNEWT_VAL(SPIFLASH_BLOCK_ERASE_64BK)
-        if ((address & 0xFFFFU) == 0 && (size >= 0x10000)) {
-            /* 64 KB erase if possible */
-            rc = spiflash_block_64k_erase(dev, address);
-            if (rc) {
-                goto err;
-            }
-            address += 0x10000;
-            size -= 0x10000;
-            continue;
-        }
+    } else if (size == 0x10000) {
+        buf[0] = SPIFLASH_BLOCK_ERASE_64KB;
+        *spec = &dev->characteristics->tbe2;
 #endif
 #if MYNEWT_VAL(SPIFLASH_BLOCK_ERASE_32BK)
-        if ((address & 0x7FFFU) == 0 && (size >= 0x8000)) {
-            /* 32 KB erase if possible */
-            rc = spiflash_block_32k_erase(dev, address);
-            if (rc) {
-                goto err;
-            }
-            address += 0x8000;
-            size -= 0x8000;
-            continue;
-        }
+    } else if (size == 0x8000) {
+        buf[0] = SPIFLASH_BLOCK_ERASE_32KB;
+        *spec = &dev->characteristics->tbe1;
 #endif
-        rc = spiflash_sector_erase(dev, address);
+    } else {
+        return 0;
+    }
+    buf[1] = (uint8_t)(addr >> 16U);
+    buf[2] = (uint8_t)(addr >> 8U);
+    buf[3] = (uint8_t)addr;
+
+    return 4;
+}
+
+static int
+hal_spiflash_erase_block(const struct hal_flash *hal_flash_dev,
+                         uint32_t address, uint32_t size)
+{
+    struct spiflash_dev *dev = (struct spiflash_dev *)hal_flash_dev;
+    const struct spiflash_time_spec *spec;
+    uint8_t buf[4];
+    uint32_t len;
+
+    len = spiflash_erase_cmd_fill(dev, address, size, buf, &spec);
+    if (len == 0) {
+        return -1;
+    }
+    return spiflash_execute_erase(dev, buf, len, spec);
+}
+
+int
+spiflash_erase(struct spiflash_dev *dev, uint32_t address, uint32_t size)
+{
+    uint32_t end;
+    uint32_t len;
+    int rc = 0;
+
+    end = address + size;
+    address -= address % dev->sector_size;
+    while (address < end) {
+        len = hal_flash_erase_unit(&dev->hal, address, end, dev->sector_size);
+        rc = hal_spiflash_erase_block(&dev->hal, address, len);
         if (rc) {
-            goto err;
-        }
-        address += MYNEWT_VAL(SPIFLASH_SECTOR_SIZE);
-        if (size > MYNEWT_VAL(SPIFLASH_SECTOR_SIZE)) {
-            size -= MYNEWT_VAL(SPIFLASH_SECTOR_SIZE);
-        } else {
-            size = 0;
+            break;
         }
+        address += len;
     }
-err:
     return rc;
 }
 
+#if MYNEWT_VAL(HAL_FLASH_ASYNC)
+/*
+ * The queue polls hff_busy before starting the next command; if something
+ * else got to the device in between, report no progress rather than wait.
+ */
+static bool
+spiflash_async_ready(struct spiflash_dev *dev)
+{
+    return dev->ready || spiflash_device_ready(dev);
+}
+
+static int
+hal_spiflash_erase_start(const struct hal_flash *hal_flash_dev,
+                         uint32_t address, uint32_t size, uint32_t *done,
+                         uint32_t *wait_us)
+{
+    struct spiflash_dev *dev = (struct spiflash_dev *)hal_flash_dev;
+    const struct spiflash_time_spec *spec;
+    uint8_t buf[4];
+    uint32_t cmd_len;
+    uint32_t start;
+    uint32_t len;
+    int rc = 0;
+
+    *done = 0;
+    *wait_us = 0;
+
+    spiflash_lock(dev);
+
+    if (!spiflash_async_ready(dev)) {
+        goto out;
+    }
+
+    start = address - address % dev->sector_size;
+    len = hal_flash_erase_unit(&dev->hal, start, address + size,
+                               dev->sector_size);
+    cmd_len = spiflash_erase_cmd_fill(dev, start, len, buf, &spec);
+    if (cmd_len == 0) {
+        rc = -1;
+        goto out;
+    }
+    rc = spiflash_start_erase(dev, buf, cmd_len);
+    if (rc == 0) {
+        dev->async_max_us = spec->maximum;
+        *done = start + len - address;
+        *wait_us = spec->typical;
+    }
+out:
+    spiflash_unlock(dev);
+
+    return rc;
+}
+
+static int
+hal_spiflash_write_start(const struct hal_flash *hal_flash_dev, uint32_t addr,
+                         const void *buf, uint32_t len, uint32_t *done,
+                         uint32_t *wait_us)
+{
+    struct spiflash_dev *dev = (struct spiflash_dev *)hal_flash_dev;
+
+    *done = 0;
+    *wait_us = 0;
+
+    spiflash_lock(dev);
+
+    if (!spiflash_async_ready(dev)) {
+        goto out;
+    }
+
+#if MYNEWT_VAL(SPIFLASH_CACHE_SIZE)
+    dev->cached_addr = 0xFFFFFFFF;
+#endif
+
+    *done = spiflash_page_program(dev, addr, buf, len);
+    *wait_us = dev->characteristics->tpp.typical;
+    dev->async_max_us = max(dev->characteristics->tpp.maximum, *wait_us);
+out:
+    spiflash_unlock(dev);
+
+    return 0;
+}
+
+static int
+hal_spiflash_busy(const struct hal_flash *hal_flash_dev)
+{
+    struct spiflash_dev *dev = (struct spiflash_dev *)hal_flash_dev;
+    bool ready;
+
+    spiflash_lock(dev);
+    ready = spiflash_device_ready(dev);
+    spiflash_unlock(dev);
+
+    return ready ? 0 : 1;
+}
+#endif
+
 int
 spiflash_identify(struct spiflash_dev *dev)
 {
@@ -1420,6 +1612,26 @@ err:
     return rc;
 }
 
+/*
+ * Erase units besides a sector, for hal_flash_erase_unit(): the whole chip
+ * and the block erases the chip supports.
+ */
+static void
+spiflash_erase_blocks_init(struct spiflash_dev *dev)
+{
+    int i = 0;
+
+    dev->erase_blocks[i++] = dev->hal.hf_size;
+#if MYNEWT_VAL(SPIFLASH_BLOCK_ERASE_64BK)
+    dev->erase_blocks[i++] = 0x10000;
+#endif
+#if MYNEWT_VAL(SPIFLASH_BLOCK_ERASE_32BK)
+    dev->erase_blocks[i++] = 0x8000;
+#endif
+    dev->erase_blocks[i] = 0;
+    dev->hal.hf_erase_blocks = dev->erase_blocks;
+}
+
 static int
 hal_spiflash_init(const struct hal_flash *hal_flash_dev)
 {
@@ -1451,6 +1663,9 @@ hal_spiflash_init(const struct hal_flash *hal_flash_dev)
     }
 #endif
     rc = spiflash_identify(dev);
+    if (rc == 0) {
+        spiflash_erase_blocks_init(dev);
+    }
 
     return rc;
 }
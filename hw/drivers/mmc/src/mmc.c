@@ -63,15 +63,21 @@
 
 #define BLOCK_LEN           (512)
 
+/* Bytes clocked while busy polling before falling back to os_time_delay() */
+#define POLL_SPIN           (1024)
+
+/* Clock used during card identification, in KHz */
+#define INIT_BAUDRATE       (125)
+
 static uint8_t g_block_buf[BLOCK_LEN];
 
-static struct hal_spi_settings mmc_settings = {
+/* Settings each device starts from; mmc_init() copies them. */
+static const struct hal_spi_settings mmc_settings = {
     .data_order = HAL_SPI_MSB_FIRST,
     .data_mode  = HAL_SPI_MODE0,
     /* XXX: MMC initialization accepts clocks in the range 100-400KHz */
-    /* TODO: switch to high-speed aka 25MHz after initialization. */
     /* Currently the lowest clock acceptable is 125KHz */
-    .baudrate   = 125,
+    .baudrate   = INIT_BAUDRATE,
     .word_size  = HAL_SPI_WORD_SIZE_8BIT,
 };
 
@@ -80,7 +86,7 @@ static struct mmc_cfg {
     int                      spi_num;
     int                      ss_pin;
     void                     *spi_cfg;
-    struct hal_spi_settings  *settings;
+    struct hal_spi_settings  settings;
 } g_mmc_cfg;
 
 static int
@@ -193,7 +199,7 @@ mmc_init(int spi_num, void *spi_cfg, int ss_pin)
     mmc->spi_num = spi_num;
     mmc->ss_pin = ss_pin;
     mmc->spi_cfg = spi_cfg;
-    mmc->settings = &mmc_settings;
+    mmc->settings = mmc_settings;
 
     hal_gpio_init_out(mmc->ss_pin, 1);
 
@@ -202,7 +208,7 @@ mmc_init(int spi_num, void *spi_cfg, int ss_pin)
         return (rc);
     }
 
-    rc = hal_spi_config(mmc->spi_num, mmc->settings);
+    rc = hal_spi_config(mmc->spi_num, &mmc->settings);
     if (rc) {
         return (rc);
     }
@@ -336,6 +342,19 @@ mmc_init(int spi_num, void *spi_cfg, int ss_pin)
 
 out:
     hal_gpio_write(mmc->ss_pin, 1);
+
+#if MYNEWT_VAL(MMC_SPI_BAUDRATE) > 0
+    /* Identification is done, switch to the data transfer clock */
+    if (rc == 0) {
+        hal_spi_disable(mmc->spi_num);
+        mmc->settings.baudrate = MYNEWT_VAL(MMC_SPI_BAUDRATE);
+        rc = hal_spi_config(mmc->spi_num, &mmc->settings);
+        if (rc == 0) {
+            rc = hal_spi_enable(mmc->spi_num);
+        }
+    }
+#endif
+
     return rc;
 }
 
@@ -349,6 +368,18 @@ wait_busy(struct mmc_cfg *mmc)
 {
     os_time_t timeout;
     uint8_t res;
+    int n;
+
+    /*
+     * Most block writes finish within a few hundred microseconds, so poll
+     * the bus for a while before giving up the CPU for a full tick.
+     */
+    for (n = 0; n < POLL_SPIN; n++) {
+        res = hal_spi_tx_val(mmc->spi_num, 0xff);
+        if (res) {
+            return res;
+        }
+    }
 
     timeout = os_time_get() + OS_TICKS_PER_SEC / 2;
     do {
@@ -360,6 +391,35 @@ wait_busy(struct mmc_cfg *mmc)
     return res;
 }
 
+/**
+ * 7.3.3 Control tokens
+ *   Wait up to 200ms for the token that starts a data block. Every block of
+ *   a multiple block read (CMD18) is preceded by its own start token.
+ */
+static uint8_t
+wait_data_token(struct mmc_cfg *mmc)
+{
+    os_time_t timeout;
+    uint8_t res;
+    int n;
+
+    for (n = 0; n < POLL_SPIN; n++) {
+        res = hal_spi_tx_val(mmc->spi_num, 0xff);
+        if (res != 0xff) {
+            return res;
+        }
+    }
+
+    timeout = os_time_get() + OS_TICKS_PER_SEC / 5;
+    do {
+        res = hal_spi_tx_val(mmc->spi_num, 0xff);
+        if (res != 0xff) break;
+        os_time_delay(OS_TICKS_PER_SEC / 20);
+    } while (os_time_get() < timeout);
+
+    return res;
+}
+
 /**
  * @return 0 on success, non-zero on failure
  */
@@ -372,11 +432,11 @@ mmc_read(uint8_t mmc_id, uint32_t addr, void *buf, uint32_t len)
     uint32_t n;
     size_t block_len;
     size_t block_count;
-    os_time_t timeout;
     uint32_t block_addr;
     size_t offset;
     size_t index;
     size_t amount;
+    uint8_t *dst;
     struct mmc_cfg *mmc;
 
     mmc = mmc_cfg_dev(mmc_id);
@@ -400,38 +460,36 @@ mmc_read(uint8_t mmc_id, uint32_t addr, void *buf, uint32_t len)
         goto out;
     }
 
-    /**
-     * 7.3.3 Control tokens
-     *   Wait up to 200ms for control token.
-     */
-    timeout = os_time_get() + OS_TICKS_PER_SEC / 5;
-    do {
-        res = hal_spi_tx_val(mmc->spi_num, 0xff);
-        if (res != 0xFF) break;
-        os_time_delay(OS_TICKS_PER_SEC / 20);
-    } while (os_time_get() < timeout);
-
-    /**
-     * 7.3.3.2 Start Block Tokens and Stop Tran Token
-     */
-    if (res != START_BLOCK) {
-        rc = MMC_TIMEOUT;
-        goto out;
-    }
-
     index = 0;
     while (block_count--) {
+        /**
+         * 7.3.3.2 Start Block Tokens and Stop Tran Token
+         */
+        res = wait_data_token(mmc);
+        if (res != START_BLOCK) {
+            rc = MMC_TIMEOUT;
+            break;
+        }
+
+        /* Whole blocks go straight to the caller's buffer */
+        amount = MIN(BLOCK_LEN - offset, len);
+        if (amount == BLOCK_LEN) {
+            dst = (uint8_t *)buf + index;
+        } else {
+            dst = g_block_buf;
+        }
+
         for (n = 0; n < BLOCK_LEN; n++) {
-            g_block_buf[n] = hal_spi_tx_val(mmc->spi_num, 0xff);
+            dst[n] = hal_spi_tx_val(mmc->spi_num, 0xff);
         }
 
         /* TODO: CRC-16 not used here but would be cool to have */
         hal_spi_tx_val(mmc->spi_num, 0xff);
         hal_spi_tx_val(mmc->spi_num, 0xff);
 
-        amount = MIN(BLOCK_LEN - offset, len);
-
-        memcpy(((uint8_t *)buf + index), &g_block_buf[offset], amount);
+        if (dst == g_block_buf) {
+            memcpy(((uint8_t *)buf + index), &g_block_buf[offset], amount);
+        }
 
         offset = 0;
         len -= amount;
@@ -459,11 +517,11 @@ mmc_write(uint8_t mmc_id, uint32_t addr, const void *buf, uint32_t len)
     uint32_t n;
     size_t block_len;
     size_t block_count;
-    os_time_t timeout;
     uint32_t block_addr;
     size_t offset;
     size_t index;
     size_t amount;
+    const uint8_t *src;
     int rc;
     struct mmc_cfg *mmc;
 
@@ -494,13 +552,7 @@ mmc_write(uint8_t mmc_id, uint32_t addr, const void *buf, uint32_t len)
             goto out;
         }
 
-        timeout = os_time_get() + OS_TICKS_PER_SEC / 5;
-        do {
-            res = hal_spi_tx_val(mmc->spi_num, 0xff);
-            if (res != 0xff) break;
-            os_time_delay(OS_TICKS_PER_SEC / 20);
-        } while (os_time_get() < timeout);
-
+        res = wait_data_token(mmc);
         if (res != START_BLOCK) {
             rc = MMC_CARD_ERROR;
             goto out;
@@ -534,11 +586,17 @@ mmc_write(uint8_t mmc_id, uint32_t addr, const void *buf, uint32_t len)
             hal_spi_tx_val(mmc->spi_num, START_BLOCK_TOKEN);
         }
 
+        /* Whole blocks are sent straight from the caller's buffer */
         amount = MIN(BLOCK_LEN - offset, len);
-        memcpy(&g_block_buf[offset], ((uint8_t *)buf + index), amount);
+        if (amount == BLOCK_LEN) {
+            src = (const uint8_t *)buf + index;
+        } else {
+            memcpy(&g_block_buf[offset], ((uint8_t *)buf + index), amount);
+            src = g_block_buf;
+        }
 
         for (n = 0; n < BLOCK_LEN; n++) {
-            hal_spi_tx_val(mmc->spi_num, g_block_buf[n]);
+            hal_spi_tx_val(mmc->spi_num, src[n]);
         }
 
         /* CRC */
@@ -32,7 +32,26 @@ extern "C" {
 #endif
 
 #include <inttypes.h>
+#include "os/os_eventq.h"
+#include "os/queue.h"
 
+/**
+ * Write any data a caching flash device holds back to the underlying flash.
+ * args is unused.
+ */
+#define HAL_FLASH_IOCTL_FLUSH           1
+
+/**
+ * @brief Issues a device specific control command.
+ *
+ * Devices which do not implement the command return 0.
+ *
+ * @param flash_id              The ID of the flash device.
+ * @param cmd                   The command, one of HAL_FLASH_IOCTL_*.
+ * @param args                  Command specific argument.
+ *
+ * @return 0 on success; nonzero on failure.
+ */
 int hal_flash_ioctl(uint8_t flash_id, uint32_t cmd, void *args);
 
 /**
@@ -50,6 +69,25 @@ int hal_flash_ioctl(uint8_t flash_id, uint32_t cmd, void *args);
 int hal_flash_read(uint8_t flash_id, uint32_t address, void *dst,
   uint32_t num_bytes);
 
+/**
+ * @brief Gets a pointer through which a range of flash can be read directly.
+ *
+ * Only devices that are mapped into the CPU address space (e.g. internal
+ * flash supporting execute in place) support this.  The contents seen
+ * through the pointer change when the range is written or erased.
+ *
+ * @param flash_id              The ID of the flash device.
+ * @param address               The start of the range.
+ * @param num_bytes             The size of the range.
+ * @param out_ptr               On success, the range's address in memory.
+ *
+ * @return                      0 on success;
+ *                              SYS_EINVAL on bad argument error;
+ *                              SYS_ENOTSUP if the device isn't memory mapped.
+ */
+int hal_flash_mmap(uint8_t flash_id, uint32_t address, uint32_t num_bytes,
+  const void **out_ptr);
+
 /**
  * @brief Writes a block of data to flash.
  *
@@ -163,6 +201,87 @@ uint8_t hal_flash_erased_val(uint8_t flash_id);
  */
 int hal_flash_init(void);
 
+#define HAL_FLASH_OP_ERASE              1
+#define HAL_FLASH_OP_WRITE              2
+
+/**
+ * A queued erase or write.  Before submitting, the caller sets up
+ * hfo_ev, and optionally hfo_evq; the remaining fields are filled in by
+ * hal_flash_erase_async() and hal_flash_write_async().  The structure
+ * must stay valid until hfo_ev has been delivered.
+ */
+struct hal_flash_op {
+    /** Posted when the operation finishes; hfo_rc holds the result. */
+    struct os_event hfo_ev;
+    /** Queue to post hfo_ev to; NULL for the default event queue. */
+    struct os_eventq *hfo_evq;
+    /** 0 on success, SYS_E[...] on failure. */
+    int hfo_rc;
+
+    uint8_t hfo_type;
+    uint8_t hfo_flash_id;
+    uint32_t hfo_addr;
+    uint32_t hfo_len;
+    const void *hfo_buf;
+
+    /* Private */
+    uint32_t hfo_off;
+    STAILQ_ENTRY(hal_flash_op) hfo_next;
+};
+
+/**
+ * @brief Queues an erase of a contiguous sequence of flash sectors.
+ *
+ * Same as `hal_flash_erase()`, except that the function returns right
+ * away and op->hfo_ev gets posted when the erase is done.  Operations are
+ * carried out one at a time, in the order they were queued.  Drivers
+ * which implement hff_erase_start are polled from a callout while the
+ * erase is in progress; with others, the erase is done in one go from
+ * the flash task's event queue.
+ *
+ * @param flash_id              The ID of the flash device to erase.
+ * @param address               An address within the sector to begin the
+ *                                  erase at.
+ * @param num_bytes             The length, in bytes, of the region to erase.
+ * @param op                    The operation to queue.
+ *
+ * @return                      0 if the operation was queued;
+ *                              SYS_EINVAL on bad argument error;
+ *                              SYS_EACCES if flash region is write protected.
+ */
+int hal_flash_erase_async(uint8_t flash_id, uint32_t address,
+                          uint32_t num_bytes, struct hal_flash_op *op);
+
+/**
+ * @brief Queues a write of a block of data to flash.
+ *
+ * Same as `hal_flash_write()`, except that the function returns right away
+ * and op->hfo_ev gets posted when the write is done.  src must stay valid
+ * until then.
+ *
+ * @param flash_id              The ID of the flash device to write to.
+ * @param address               The address to write to.
+ * @param src                   A buffer containing the data to be written.
+ * @param num_bytes             The number of bytes to write.
+ * @param op                    The operation to queue.
+ *
+ * @return                      0 if the operation was queued;
+ *                              SYS_EINVAL on bad argument error;
+ *                              SYS_EACCES if flash region is write protected.
+ */
+int hal_flash_write_async(uint8_t flash_id, uint32_t address, const void *src,
+                          uint32_t num_bytes, struct hal_flash_op *op);
+
+/**
+ * @brief Sets the event queue queued flash operations are run from.
+ *
+ * Defaults to the default event queue.  Must be called before any
+ * operations are queued.
+ *
+ * @param evq                   The event queue to use.
+ */
+void hal_flash_async_evq_set(struct os_eventq *evq);
+
 /**
  * @brief Set or clears write protection
  *
@@ -45,6 +45,38 @@ struct hal_flash_funcs {
     int (*hff_init)(const struct hal_flash *dev);
     int (*hff_erase)(const struct hal_flash *dev, uint32_t address,
             uint32_t num_bytes);
+    int (*hff_ioctl)(const struct hal_flash *dev, uint32_t cmd, void *args);
+
+    /*
+     * Optional, used by the asynchronous API.  hff_erase_start and
+     * hff_write_start issue a single device command for the start of the
+     * range and return without waiting for it to finish.  They report the
+     * number of bytes the command takes care of and how long it typically
+     * takes.  They must not wait for the device; if it is still busy
+     * with an earlier command they return 0 with *done set to 0, and are
+     * called again later.  hff_busy returns 1 while the command is
+     * running, 0 once it is done and negative on error.
+     */
+    int (*hff_erase_start)(const struct hal_flash *dev, uint32_t address,
+            uint32_t num_bytes, uint32_t *done, uint32_t *wait_us);
+    int (*hff_write_start)(const struct hal_flash *dev, uint32_t address,
+            const void *src, uint32_t num_bytes, uint32_t *done,
+            uint32_t *wait_us);
+    int (*hff_busy)(const struct hal_flash *dev);
+
+    /*
+     * Optional, erases one of the blocks listed in hf_erase_blocks.  size
+     * is the block size and address is aligned to it.
+     */
+    int (*hff_erase_block)(const struct hal_flash *dev, uint32_t address,
+            uint32_t size);
+
+    /*
+     * Optional, for devices the CPU can read directly.  Returns in out_ptr
+     * the memory address at which address can be read.
+     */
+    int (*hff_mmap)(const struct hal_flash *dev, uint32_t address,
+            const void **out_ptr);
 };
 
 struct hal_flash {
@@ -54,6 +86,12 @@ struct hal_flash {
     int hf_sector_cnt;
     int hf_align;       /* Alignment requirement. 1 if unrestricted. */
     uint8_t hf_erased_val;
+    /*
+     * Optional.  Block sizes the device can erase in one command besides
+     * a sector, largest first and 0 terminated.  Blocks are aligned to
+     * their size, counting from hf_base_addr.
+     */
+    const uint32_t *hf_erase_blocks;
 };
 
 /*
@@ -61,6 +99,16 @@ struct hal_flash {
  */
 uint32_t hal_flash_sector_size(const struct hal_flash *hf, int sec_idx);
 
+/*
+ * Erase planner.  address is the start of a sector which is sector_size
+ * bytes long.  Returns the number of bytes to erase at address in one
+ * operation without going past end; this is the largest block from
+ * hf_erase_blocks which is aligned at address and fits, or sector_size
+ * if there is none.
+ */
+uint32_t hal_flash_erase_unit(const struct hal_flash *hf, uint32_t address,
+                              uint32_t end, uint32_t sector_size);
+
 int hal_flash_is_erased(const struct hal_flash *, uint32_t, void *, uint32_t);
 
 #ifdef __cplusplus
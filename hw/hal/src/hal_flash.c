@@ -83,6 +83,23 @@ hal_flash_sector_size(const struct hal_flash *hf, int sec_idx)
     return size;
 }
 
+uint32_t
+hal_flash_erase_unit(const struct hal_flash *hf, uint32_t address,
+                     uint32_t end, uint32_t sector_size)
+{
+    const uint32_t *bs;
+
+    if (hf->hf_erase_blocks) {
+        for (bs = hf->hf_erase_blocks; *bs; bs++) {
+            if ((address - hf->hf_base_addr) % *bs == 0 &&
+                end - address >= *bs) {
+                return *bs;
+            }
+        }
+    }
+    return sector_size;
+}
+
 static int
 hal_flash_check_addr(const struct hal_flash *hf, uint32_t addr)
 {
@@ -115,6 +132,27 @@ hal_flash_read(uint8_t id, uint32_t address, void *dst, uint32_t num_bytes)
     return 0;
 }
 
+int
+hal_flash_mmap(uint8_t id, uint32_t address, uint32_t num_bytes,
+               const void **out_ptr)
+{
+    const struct hal_flash *hf;
+
+    hf = hal_bsp_flash_dev(id);
+    if (!hf) {
+        return SYS_EINVAL;
+    }
+    if (hal_flash_check_addr(hf, address) ||
+      hal_flash_check_addr(hf, address + num_bytes)) {
+        return SYS_EINVAL;
+    }
+    if (!hf->hf_itf->hff_mmap) {
+        return SYS_ENOTSUP;
+    }
+
+    return hf->hf_itf->hff_mmap(hf, address, out_ptr);
+}
+
 #if MYNEWT_VAL(HAL_FLASH_VERIFY_WRITES)
 /**
  * Verifies that the specified range of flash contains the given contents.
@@ -244,6 +282,8 @@ hal_flash_erase(uint8_t id, uint32_t address, uint32_t num_bytes)
     uint32_t start, size;
     uint32_t end;
     uint32_t end_area;
+    uint32_t erased;
+    uint32_t len;
     int i;
     int rc;
 
@@ -276,22 +316,40 @@ hal_flash_erase(uint8_t id, uint32_t address, uint32_t num_bytes)
         assert(hal_flash_isempty_no_buf(id, address, num_bytes) == 1);
 #endif
     } else {
+        erased = hf->hf_base_addr;
         for (i = 0; i < hf->hf_sector_cnt; i++) {
             rc = hf->hf_itf->hff_sector_info(hf, i, &start, &size);
             assert(rc == 0);
             end_area = start + size;
+            if (start < erased) {
+                /*
+                 * Already taken care of by a block erase.
+                 */
+                continue;
+            }
             if (address < end_area && end > start) {
                 /*
                  * If some region of eraseable area falls inside sector,
-                 * erase the sector.
+                 * erase the sector, or a block starting with it if the
+                 * whole block is inside the area.
                  */
-                if (hf->hf_itf->hff_erase_sector(hf, start)) {
+                len = size;
+                if (hf->hf_itf->hff_erase_block) {
+                    len = hal_flash_erase_unit(hf, start, end, size);
+                }
+                if (len > size) {
+                    rc = hf->hf_itf->hff_erase_block(hf, start, len);
+                } else {
+                    rc = hf->hf_itf->hff_erase_sector(hf, start);
+                }
+                if (rc) {
                     return SYS_EIO;
                 }
 
 #if MYNEWT_VAL(HAL_FLASH_VERIFY_ERASES)
-                assert(hal_flash_isempty_no_buf(id, start, size) == 1);
+                assert(hal_flash_isempty_no_buf(id, start, len) == 1);
 #endif
+                erased = start + len;
             }
         }
     }
@@ -376,9 +434,243 @@ hal_flash_isempty_no_buf(uint8_t id, uint32_t address, uint32_t num_bytes)
 int
 hal_flash_ioctl(uint8_t id, uint32_t cmd, void *args)
 {
+    const struct hal_flash *hf;
+
+    hf = hal_bsp_flash_dev(id);
+    if (!hf) {
+        return SYS_EINVAL;
+    }
+    if (hf->hf_itf->hff_ioctl) {
+        return hf->hf_itf->hff_ioctl(hf, cmd, args);
+    }
     return 0;
 }
 
+#if MYNEWT_VAL(HAL_FLASH_ASYNC)
+
+#define HAL_FLASH_OP_POLL_TICKS                                         \
+    max(os_time_ms_to_ticks32(MYNEWT_VAL(HAL_FLASH_ASYNC_POLL_MS)), 1)
+
+static STAILQ_HEAD(, hal_flash_op) hal_flash_ops =
+    STAILQ_HEAD_INITIALIZER(hal_flash_ops);
+static struct os_eventq *hal_flash_op_evq;
+static struct os_callout hal_flash_op_co;
+/* Set while the op at the head of the queue waits for the device. */
+static bool hal_flash_op_waiting;
+
+static void hal_flash_op_run(struct os_event *ev);
+
+void
+hal_flash_async_evq_set(struct os_eventq *evq)
+{
+    assert(STAILQ_EMPTY(&hal_flash_ops));
+
+    hal_flash_op_evq = evq;
+    os_callout_init(&hal_flash_op_co, evq, hal_flash_op_run, NULL);
+}
+
+static void
+hal_flash_op_kick(void)
+{
+    os_eventq_put(hal_flash_op_evq, &hal_flash_op_co.c_ev);
+}
+
+static void
+hal_flash_op_done(struct hal_flash_op *op, int rc)
+{
+    struct os_eventq *evq;
+    os_sr_t sr;
+    int more;
+
+    OS_ENTER_CRITICAL(sr);
+    STAILQ_REMOVE_HEAD(&hal_flash_ops, hfo_next);
+    more = !STAILQ_EMPTY(&hal_flash_ops);
+    OS_EXIT_CRITICAL(sr);
+
+    op->hfo_rc = rc;
+    evq = op->hfo_evq;
+    if (!evq) {
+        evq = os_eventq_dflt_get();
+    }
+    os_eventq_put(evq, &op->hfo_ev);
+
+    if (more) {
+        hal_flash_op_kick();
+    }
+}
+
+/*
+ * Moves the operation at the head of the queue along.  Drivers with
+ * hff_erase_start/hff_write_start get one command issued per call, and
+ * the callout brings us back here to poll hff_busy.  Others do the whole
+ * operation here.
+ */
+static void
+hal_flash_op_run(struct os_event *ev)
+{
+    const struct hal_flash *hf;
+    struct hal_flash_op *op;
+    uint32_t wait_us;
+    uint32_t done;
+    os_time_t ticks;
+    os_sr_t sr;
+    int rc;
+
+    OS_ENTER_CRITICAL(sr);
+    op = STAILQ_FIRST(&hal_flash_ops);
+    OS_EXIT_CRITICAL(sr);
+    if (!op) {
+        return;
+    }
+    hf = hal_bsp_flash_dev(op->hfo_flash_id);
+
+    if (hal_flash_op_waiting) {
+        rc = hf->hf_itf->hff_busy(hf);
+        if (rc > 0) {
+            os_callout_reset(&hal_flash_op_co, HAL_FLASH_OP_POLL_TICKS);
+            return;
+        }
+        hal_flash_op_waiting = false;
+        if (rc < 0) {
+            hal_flash_op_done(op, SYS_EIO);
+            return;
+        }
+    }
+
+    if (op->hfo_off >= op->hfo_len) {
+#if MYNEWT_VAL(HAL_FLASH_VERIFY_WRITES)
+        if (op->hfo_type == HAL_FLASH_OP_WRITE) {
+            assert(hal_flash_cmp(hf, op->hfo_addr, op->hfo_buf,
+                                 op->hfo_len) == 0);
+        }
+#endif
+#if MYNEWT_VAL(HAL_FLASH_VERIFY_ERASES)
+        if (op->hfo_type == HAL_FLASH_OP_ERASE) {
+            assert(hal_flash_isempty_no_buf(op->hfo_flash_id,
+                                            op->hfo_addr,
+                                            op->hfo_len) == 1);
+        }
+#endif
+        hal_flash_op_done(op, 0);
+        return;
+    }
+
+    wait_us = 0;
+    if (op->hfo_type == HAL_FLASH_OP_ERASE && hf->hf_itf->hff_erase_start) {
+        rc = hf->hf_itf->hff_erase_start(hf, op->hfo_addr + op->hfo_off,
+                                         op->hfo_len - op->hfo_off,
+                                         &done, &wait_us);
+    } else if (op->hfo_type == HAL_FLASH_OP_WRITE &&
+               hf->hf_itf->hff_write_start) {
+        rc = hf->hf_itf->hff_write_start(hf, op->hfo_addr + op->hfo_off,
+                                 (const uint8_t *)op->hfo_buf + op->hfo_off,
+                                 op->hfo_len - op->hfo_off,
+                                 &done, &wait_us);
+    } else {
+        if (op->hfo_type == HAL_FLASH_OP_ERASE) {
+            rc = hal_flash_erase(op->hfo_flash_id, op->hfo_addr,
+                                 op->hfo_len);
+        } else {
+            rc = hal_flash_write(op->hfo_flash_id, op->hfo_addr,
+                                 op->hfo_buf, op->hfo_len);
+        }
+        hal_flash_op_done(op, rc);
+        return;
+    }
+    if (rc != 0) {
+        hal_flash_op_done(op, SYS_EIO);
+        return;
+    }
+    hal_flash_op_waiting = true;
+    if (done == 0) {
+        /* Device is busy with something else, try again later. */
+        os_callout_reset(&hal_flash_op_co, HAL_FLASH_OP_POLL_TICKS);
+        return;
+    }
+    op->hfo_off += done;
+
+    /*
+     * Commands shorter than a tick, e.g. a page program, still go
+     * through the callout; never spin here, the event queue is shared.
+     */
+    ticks = os_time_ms_to_ticks32(wait_us / 1000);
+    os_callout_reset(&hal_flash_op_co, max(ticks, 1));
+}
+
+static int
+hal_flash_op_submit(const struct hal_flash *hf, struct hal_flash_op *op)
+{
+    os_sr_t sr;
+    int idle;
+
+    if (hal_flash_check_addr(hf, op->hfo_addr) ||
+      hal_flash_check_addr(hf, op->hfo_addr + op->hfo_len) ||
+      op->hfo_addr + op->hfo_len < op->hfo_addr) {
+        return SYS_EINVAL;
+    }
+    if (protected_flash[op->hfo_flash_id / 8] &
+      (1 << (op->hfo_flash_id & 7))) {
+        return SYS_EACCES;
+    }
+
+    if (!hal_flash_op_evq) {
+        hal_flash_async_evq_set(os_eventq_dflt_get());
+    }
+
+    op->hfo_rc = 0;
+    op->hfo_off = 0;
+
+    OS_ENTER_CRITICAL(sr);
+    idle = STAILQ_EMPTY(&hal_flash_ops);
+    STAILQ_INSERT_TAIL(&hal_flash_ops, op, hfo_next);
+    OS_EXIT_CRITICAL(sr);
+
+    if (idle) {
+        hal_flash_op_kick();
+    }
+    return 0;
+}
+
+int
+hal_flash_erase_async(uint8_t id, uint32_t address, uint32_t num_bytes,
+                      struct hal_flash_op *op)
+{
+    const struct hal_flash *hf;
+
+    hf = hal_bsp_flash_dev(id);
+    if (!hf) {
+        return SYS_EINVAL;
+    }
+    op->hfo_type = HAL_FLASH_OP_ERASE;
+    op->hfo_flash_id = id;
+    op->hfo_addr = address;
+    op->hfo_len = num_bytes;
+    op->hfo_buf = NULL;
+
+    return hal_flash_op_submit(hf, op);
+}
+
+int
+hal_flash_write_async(uint8_t id, uint32_t address, const void *src,
+                      uint32_t num_bytes, struct hal_flash_op *op)
+{
+    const struct hal_flash *hf;
+
+    hf = hal_bsp_flash_dev(id);
+    if (!hf) {
+        return SYS_EINVAL;
+    }
+    op->hfo_type = HAL_FLASH_OP_WRITE;
+    op->hfo_flash_id = id;
+    op->hfo_addr = address;
+    op->hfo_len = num_bytes;
+    op->hfo_buf = src;
+
+    return hal_flash_op_submit(hf, op);
+}
+
+#endif
+
 int
 hal_flash_write_protect(uint8_t id, uint8_t protect)
 {
@@ -41,15 +41,35 @@ static int native_flash_write(const struct hal_flash *dev, uint32_t address,
         const void *src, uint32_t length);
 static int native_flash_erase_sector(const struct hal_flash *dev,
         uint32_t sector_address);
+static int native_flash_erase_block(const struct hal_flash *dev,
+        uint32_t address, uint32_t size);
 static int native_flash_sector_info(const struct hal_flash *dev, int idx,
         uint32_t *address, uint32_t *size);
+static int native_flash_mmap(const struct hal_flash *dev, uint32_t address,
+        const void **out_ptr);
+#if MYNEWT_VAL(HAL_FLASH_ASYNC)
+static int native_flash_erase_start(const struct hal_flash *dev,
+        uint32_t address, uint32_t num_bytes, uint32_t *done,
+        uint32_t *wait_us);
+static int native_flash_write_start(const struct hal_flash *dev,
+        uint32_t address, const void *src, uint32_t num_bytes,
+        uint32_t *done, uint32_t *wait_us);
+static int native_flash_busy(const struct hal_flash *dev);
+#endif
 
 static const struct hal_flash_funcs native_flash_funcs = {
     .hff_read = native_flash_read,
     .hff_write = native_flash_write,
     .hff_erase_sector = native_flash_erase_sector,
+    .hff_erase_block = native_flash_erase_block,
     .hff_sector_info = native_flash_sector_info,
-    .hff_init = native_flash_init
+    .hff_init = native_flash_init,
+    .hff_mmap = native_flash_mmap,
+#if MYNEWT_VAL(HAL_FLASH_ASYNC)
+    .hff_erase_start = native_flash_erase_start,
+    .hff_write_start = native_flash_write_start,
+    .hff_busy = native_flash_busy,
+#endif
 };
 
 #if MYNEWT_VAL(MCU_FLASH_STYLE_ST)
@@ -76,6 +96,16 @@ static uint32_t native_flash_sectors[1024 * 1024 / 2048];
 #define FLASH_NUM_AREAS   (int)(sizeof native_flash_sectors /           \
                                 sizeof native_flash_sectors[0])
 
+/*
+ * Block erase, like a SPI NOR part.  Blocks are made of whole sectors in
+ * both layouts.
+ */
+static const uint32_t native_flash_blocks[] = {
+    256 * 1024,
+    64 * 1024,
+    0
+};
+
 const struct hal_flash native_flash_dev = {
     .hf_itf = &native_flash_funcs,
     .hf_base_addr = 0,
@@ -83,6 +113,7 @@ const struct hal_flash native_flash_dev = {
     .hf_sector_cnt = FLASH_NUM_AREAS,
     .hf_align = MYNEWT_VAL(MCU_FLASH_MIN_WRITE_SIZE),
     .hf_erased_val = 0xff,
+    .hf_erase_blocks = native_flash_blocks,
 };
 
 static void
@@ -217,6 +248,16 @@ native_flash_read(const struct hal_flash *dev, uint32_t address, void *dst,
     return 0;
 }
 
+static int
+native_flash_mmap(const struct hal_flash *dev, uint32_t address,
+        const void **out_ptr)
+{
+    flash_native_ensure_file_open();
+    *out_ptr = (const char *)file_loc + address;
+
+    return 0;
+}
+
 static int
 find_area(uint32_t address)
 {
@@ -261,6 +302,122 @@ native_flash_erase_sector(const struct hal_flash *dev, uint32_t sector_address)
     return 0;
 }
 
+static int
+native_flash_erase_block(const struct hal_flash *dev, uint32_t address,
+        uint32_t size)
+{
+    flash_native_ensure_file_open();
+
+    if (address % size || address + size > dev->hf_size ||
+        find_area(address) == -1 ||
+        (address + size < dev->hf_size && find_area(address + size) == -1)) {
+        return -1;
+    }
+    flash_native_erase(address, size);
+    return 0;
+}
+
+#if MYNEWT_VAL(HAL_FLASH_ASYNC)
+/*
+ * The async API gets a device that stays busy for a while after each
+ * command, like a real one.  Time is counted in OS ticks, so tests can
+ * step through it with os_time_advance().  A block erase takes as long as
+ * a sector erase.
+ */
+#define NATIVE_FLASH_PAGE_SZ        256
+#define NATIVE_FLASH_ERASE_US       20000
+#define NATIVE_FLASH_WRITE_US       1000
+
+static os_time_t native_flash_busy_until;
+
+static void
+native_flash_busy_set(uint32_t usecs)
+{
+    native_flash_busy_until = os_time_get() +
+                              os_time_ms_to_ticks32(usecs / 1000);
+}
+
+static int
+native_flash_busy(const struct hal_flash *dev)
+{
+    return OS_TIME_TICK_LT(os_time_get(), native_flash_busy_until);
+}
+
+static int
+native_flash_erase_start(const struct hal_flash *dev, uint32_t address,
+        uint32_t num_bytes, uint32_t *done, uint32_t *wait_us)
+{
+    uint32_t start;
+    uint32_t size;
+    uint32_t len;
+    int i;
+
+    *done = 0;
+    *wait_us = 0;
+    if (native_flash_busy(dev)) {
+        return 0;
+    }
+
+    for (i = 0; i < FLASH_NUM_AREAS; i++) {
+        start = native_flash_sectors[i];
+        len = flash_sector_len(i);
+        if (address < start + len) {
+            break;
+        }
+    }
+    if (i == FLASH_NUM_AREAS) {
+        return -1;
+    }
+    /* Erase a whole block in one command if the range covers it. */
+    size = len;
+    if (start == address) {
+        size = hal_flash_erase_unit(dev, start, address + num_bytes, len);
+    }
+    if (size > len) {
+        native_flash_erase_block(dev, start, size);
+        len = size;
+    } else {
+        native_flash_erase_sector(dev, start);
+    }
+
+    *done = start + len - address;
+    *wait_us = NATIVE_FLASH_ERASE_US;
+    native_flash_busy_set(*wait_us);
+
+    return 0;
+}
+
+static int
+native_flash_write_start(const struct hal_flash *dev, uint32_t address,
+        const void *src, uint32_t num_bytes, uint32_t *done,
+        uint32_t *wait_us)
+{
+    uint32_t len;
+    int rc;
+
+    *done = 0;
+    *wait_us = 0;
+    if (native_flash_busy(dev)) {
+        return 0;
+    }
+
+    len = NATIVE_FLASH_PAGE_SZ - address % NATIVE_FLASH_PAGE_SZ;
+    if (len > num_bytes) {
+        len = num_bytes;
+    }
+    rc = native_flash_write(dev, address, src, len);
+    if (rc) {
+        return rc;
+    }
+
+    *done = len;
+    *wait_us = NATIVE_FLASH_WRITE_US;
+    native_flash_busy_set(*wait_us);
+
+    return 0;
+}
+#endif
+
 static int
 native_flash_sector_info(const struct hal_flash *dev, int idx,
         uint32_t *address, uint32_t *size)
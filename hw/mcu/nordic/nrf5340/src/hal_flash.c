@@ -48,6 +48,14 @@ nrf5340_flash_read(const struct hal_flash *dev, uint32_t address, void *dst,
     return 0;
 }
 
+static int
+nrf5340_flash_mmap(const struct hal_flash *dev, uint32_t address,
+                   const void **out_ptr)
+{
+    *out_ptr = (const void *)address;
+    return 0;
+}
+
 /*
  * Flash write is done by writing 4 bytes at a time at a word boundary.
  */
@@ -147,7 +155,8 @@ static const struct hal_flash_funcs nrf5340_flash_funcs = {
     .hff_write = nrf5340_flash_write,
     .hff_erase_sector = nrf5340_flash_erase_sector,
     .hff_sector_info = nrf5340_flash_sector_info,
-    .hff_init = nrf5340_flash_init
+    .hff_init = nrf5340_flash_init,
+    .hff_mmap = nrf5340_flash_mmap,
 };
 
 const struct hal_flash nrf5340_flash_dev = {
@@ -47,6 +47,15 @@ typedef void os_event_fn(struct os_event *ev);
 struct os_event {
     /** Whether this OS event is queued on an event queue. */
     uint8_t ev_queued;
+#if MYNEWT_VAL(OS_EVENTQ_COALESCE)
+    /** Flags, see OS_EVENT_F_* definitions. */
+    uint8_t ev_flags;
+    /**
+     * Number of posts that found the event already queued since it was last
+     * queued.  Only counted if OS_EVENT_F_COALESCE is set.
+     */
+    uint16_t ev_coalesced;
+#endif
     /**
      * Callback to call when the event is taken off of an event queue.
      * APIs, except for os_eventq_run(), assume this callback will be called by
@@ -62,6 +71,14 @@ struct os_event {
 /** Return whether or not the given event is queued. */
 #define OS_EVENT_QUEUED(__ev) ((__ev)->ev_queued)
 
+#if MYNEWT_VAL(OS_EVENTQ_COALESCE)
+/**
+ * Count duplicate posts of this event while it is queued in ev_coalesced.
+ * The event callback can read the count to learn how many posts it serves.
+ */
+#define OS_EVENT_F_COALESCE     (0x01)
+#endif
+
 #if MYNEWT_VAL(OS_EVENTQ_MONITOR)
 /**
  * Structure keeping track of time spent inside event callback. This is
@@ -97,6 +114,10 @@ struct os_eventq {
     struct os_eventq_mon *evq_mon;
     int evq_mon_elems;
 #endif
+#if MYNEWT_VAL(OS_EVENTQ_COALESCE)
+    /** Total number of posts coalesced into events queued here. */
+    uint32_t evq_coalesced;
+#endif
 };
 
 /**
@@ -147,6 +168,35 @@ struct os_event *os_eventq_get(struct os_eventq *);
  */
 void os_eventq_run(struct os_eventq *evq);
 
+/**
+ * Pull up to max items from an event queue.  This function blocks until
+ * there is at least one item on the event queue, and then takes as many
+ * queued items as allowed inside a single critical section.  The events are
+ * returned in queue order and are no longer queued.
+ *
+ * @param evq The event queue to pull events from
+ * @param evs Array that receives the events
+ * @param max Size of the evs array; must be at least 1
+ *
+ * @return The number of events stored in evs
+ */
+int os_eventq_get_batch(struct os_eventq *evq, struct os_event **evs, int max);
+
+/**
+ * Pull up to max items off the event queue at once, blocking until there is
+ * at least one, and call their event callbacks in queue order.  An event that
+ * is removed from the queue with os_eventq_remove() before its callback runs
+ * is skipped; posting one of the pulled events before its callback runs has
+ * no further effect.
+ *
+ * @param evq The event queue to pull the items off
+ * @param max Largest number of events to process; limited to
+ *            OS_EVENTQ_BATCH_MAX
+ *
+ * @return The number of event callbacks called
+ */
+int os_eventq_run_batch(struct os_eventq *evq, int max);
+
 
 /**
  * Poll the list of event queues specified by the evq parameter
@@ -30,6 +30,7 @@
 #define H_OS_HEAP_
 
 #include <stddef.h>
+#include <inttypes.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -70,6 +71,38 @@ void os_free(void *mem);
  */
 void *os_realloc(void *ptr, size_t size);
 
+/**
+ * Information about an os_malloc() size class.
+ */
+struct os_malloc_slab_info {
+    /** Size of a block in this class */
+    uint32_t osi_block_size;
+    /** Number of blocks in this class */
+    uint16_t osi_num_blocks;
+    /** Number of free blocks */
+    uint16_t osi_num_free;
+    /** Largest number of blocks that were in use at once */
+    uint16_t osi_high_water;
+    /** Number of allocations served by this class */
+    uint32_t osi_allocs;
+    /**
+     * Number of requests that fit this class but were passed on to a larger
+     * class or the libc heap because this class was exhausted
+     */
+    uint32_t osi_overflows;
+};
+
+/**
+ * Get information about an os_malloc() size class.  Only available if
+ * OS_MALLOC_SLAB is enabled.
+ *
+ * @param idx The index of the size class, starting at 0 for the smallest
+ * @param osi The structure to fill in
+ *
+ * @return 0 on success, OS_ENOENT if there is no such size class
+ */
+int os_malloc_slab_info_get(int idx, struct os_malloc_slab_info *osi);
+
 #ifdef __cplusplus
 }
 #endif
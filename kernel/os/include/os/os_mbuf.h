@@ -74,6 +74,36 @@ struct os_mbuf_pkthdr {
     STAILQ_ENTRY(os_mbuf_pkthdr) omp_next;
 };
 
+struct os_mbuf_ext;
+
+/**
+ * Function called when the last mbuf referencing an external buffer is freed.
+ *
+ * @param ext                   The external buffer that was released.
+ */
+typedef void os_mbuf_ext_free_fn(struct os_mbuf_ext *ext);
+
+/**
+ * A caller-owned buffer (e.g., DMA or flash read memory) that mbufs can
+ * reference instead of holding a copy of the data.  The buffer is reference
+ * counted; every mbuf pointing into it holds one reference.  The mbuf
+ * functions never grow data into an external buffer, so several mbufs can
+ * share it safely.  os_mbuf_copyinto() does overwrite existing data in
+ * place.
+ */
+struct os_mbuf_ext {
+    /** Start of the external memory */
+    uint8_t *ome_buf;
+    /** Size of the external memory */
+    uint16_t ome_len;
+    /** Number of mbufs referencing the buffer */
+    uint16_t ome_refcnt;
+    /** Called when the reference count drops to 0; may be NULL */
+    os_mbuf_ext_free_fn *ome_free_cb;
+    /** Argument for use by the free callback */
+    void *ome_arg;
+};
+
 /**
  * Chained memory buffer.
  */
@@ -124,6 +154,20 @@ struct os_mqueue {
  */
 #define OS_MBUF_F_MASK(__n) (1 << (__n))
 
+/**
+ * Flag number reserved by the OS: the mbuf data lives in an external buffer
+ * rather than in the mbuf itself.
+ */
+#define OS_MBUF_F_EXT       (7)
+
+/*
+ * Checks whether a given mbuf references an external buffer
+ *
+ * @param __om The mbuf to check
+ */
+#define OS_MBUF_IS_EXT(__om) \
+    (((__om)->om_flags & OS_MBUF_F_MASK(OS_MBUF_F_EXT)) != 0)
+
 /*
  * Checks whether a given mbuf is a packet header mbuf
  *
@@ -184,6 +228,10 @@ _os_mbuf_leadingspace(struct os_mbuf *om)
     uint16_t startoff;
     uint16_t leadingspace;
 
+    if (OS_MBUF_IS_EXT(om)) {
+        return 0;
+    }
+
     startoff = 0;
     if (OS_MBUF_IS_PKTHDR(om)) {
         startoff = om->om_pkthdr_len;
@@ -200,7 +248,8 @@ _os_mbuf_leadingspace(struct os_mbuf *om)
 /**
  * Returns the leading space (space at the beginning) of the mbuf.
  * Works on both packet header, and regular mbufs, as it accounts
- * for the additional space allocated to the packet header.
+ * for the additional space allocated to the packet header.  An mbuf that
+ * references an external buffer has no leading space.
  *
  * @param __omp Is the mbuf pool (which contains packet header length.)
  * @param __om  Is the mbuf in that pool to get the leadingspace for
@@ -218,6 +267,10 @@ _os_mbuf_trailingspace(struct os_mbuf *om)
 {
     struct os_mbuf_pool *omp;
 
+    if (OS_MBUF_IS_EXT(om)) {
+        return 0;
+    }
+
     omp = om->om_omp;
 
     return (&om->om_databuf[0] + omp->omp_databuf_len) -
@@ -228,7 +281,8 @@ _os_mbuf_trailingspace(struct os_mbuf *om)
 
 /**
  * Returns the trailing space (space at the end) of the mbuf.
- * Works on both packet header and regular mbufs.
+ * Works on both packet header and regular mbufs.  An mbuf that references
+ * an external buffer has no trailing space.
  *
  * @param __omp The mbuf pool for this mbuf
  * @param __om  Is the mbuf in that pool to get trailing space for
@@ -373,8 +427,57 @@ struct os_mbuf *os_mbuf_get(struct os_mbuf_pool *omp, uint16_t);
 struct os_mbuf *os_mbuf_get_pkthdr(struct os_mbuf_pool *omp,
         uint8_t pkthdr_len);
 
+/**
+ * Initializes an external buffer descriptor.  The descriptor and the memory
+ * it describes must stay valid until the free callback is called.
+ *
+ * @param ext                   The descriptor to initialize.
+ * @param buf                   The external memory.
+ * @param len                   The size of the external memory.
+ * @param free_cb               Called when the last mbuf referencing the
+ *                                  buffer is freed; may be NULL.
+ * @param arg                   Argument for use by the free callback.
+ */
+void os_mbuf_ext_init(struct os_mbuf_ext *ext, void *buf, uint16_t len,
+                      os_mbuf_ext_free_fn *free_cb, void *arg);
+
+/**
+ * Get an mbuf from the mbuf pool that references a region of an external
+ * buffer instead of holding its own data.  The region is the mbuf's data;
+ * no bytes are copied.  The mbuf takes a reference to the buffer.
+ *
+ * @param omp                   The mbuf pool to allocate the mbuf header
+ *                                  from.
+ * @param ext                   The external buffer to reference.
+ * @param off                   Offset of the region within the buffer.
+ * @param len                   Length of the region.
+ *
+ * @return An initialized mbuf on success, and NULL on failure.
+ */
+struct os_mbuf *os_mbuf_get_ext(struct os_mbuf_pool *omp,
+                                struct os_mbuf_ext *ext,
+                                uint16_t off, uint16_t len);
+
+/**
+ * Appends a region of an external buffer to an mbuf chain without copying
+ * it.  The new mbuf is allocated from the pool of the chain's head.
+ *
+ * @param om                    The mbuf chain to append to.
+ * @param ext                   The external buffer to reference.
+ * @param off                   Offset of the region within the buffer.
+ * @param len                   Length of the region.
+ *
+ * @return                      0 on success;
+ *                              OS_EINVAL if the region is outside the buffer;
+ *                              OS_ENOMEM if no mbuf could be allocated.
+ */
+int os_mbuf_append_ext(struct os_mbuf *om, struct os_mbuf_ext *ext,
+                       uint16_t off, uint16_t len);
+
 /**
  * Duplicate a chain of mbufs.  Return the start of the duplicated chain.
+ * Mbufs that reference an external buffer are duplicated by taking another
+ * reference to the buffer; the data is shared rather than copied.
  *
  * @param omp The mbuf pool to duplicate out of
  * @param om  The mbuf chain to duplicate
@@ -46,6 +46,35 @@ struct os_memblock {
     SLIST_ENTRY(os_memblock) mb_next;
 };
 
+#if MYNEWT_VAL(OS_MEMPOOL_CACHE)
+/**
+ * A small stack of free blocks owned by one priority band of a cached pool.
+ * Only the context that set mm_busy may touch the other fields, so a block
+ * can be handed out or taken back without disabling interrupts.
+ */
+struct os_mempool_mag {
+    /** Set while a context is operating on this magazine */
+    volatile uint8_t mm_busy;
+    /** Number of blocks in the magazine */
+    uint8_t mm_cnt;
+    /** Number of gets and puts served from the magazine */
+    uint32_t mm_hits;
+    /** Cached free blocks */
+    void *mm_blocks[MYNEWT_VAL(OS_MEMPOOL_CACHE_SIZE)];
+};
+
+/**
+ * Magazine layer in front of a memory pool's free list.  Attach with
+ * os_mempool_cache_enable().
+ */
+struct os_mempool_cache {
+    /** One magazine per task priority band */
+    struct os_mempool_mag mpc_mags[MYNEWT_VAL(OS_MEMPOOL_CACHE_BANDS)];
+    /** Number of gets and puts that went to the shared free list */
+    uint32_t mpc_misses;
+};
+#endif
+
 /* XXX: Change this structure so that we keep the first address in the pool? */
 /* XXX: add memory debug structure and associated code */
 /* XXX: Change how I coded the SLIST_HEAD here. It should be named:
@@ -71,6 +100,10 @@ struct os_mempool {
     SLIST_HEAD(,os_memblock);
     /** Name for memory block */
     char *name;
+#if MYNEWT_VAL(OS_MEMPOOL_CACHE)
+    /** Magazine cache; NULL if the pool is not cached */
+    struct os_mempool_cache *mp_cache;
+#endif
 };
 
 /**
@@ -125,6 +158,10 @@ struct os_mempool_info {
     int omi_num_free;
     /** Minimum number of free memory blocks ever */
     int omi_min_free;
+    /** Number of gets and puts served by the magazine cache */
+    uint32_t omi_cache_hits;
+    /** Number of gets and puts that missed the magazine cache */
+    uint32_t omi_cache_misses;
     /** Name of the memory pool */
     char omi_name[OS_MEMPOOL_INFO_NAME_LEN];
 };
@@ -274,6 +311,37 @@ os_error_t os_memblock_put_from_cb(struct os_mempool *mp, void *block_addr);
  */
 os_error_t os_memblock_put(struct os_mempool *mp, void *block_addr);
 
+/**
+ * Returns the number of free blocks in a memory pool.  For a cached pool
+ * this includes the blocks held in magazines, which mp_num_free does not
+ * count.
+ *
+ * @param mp                    The mempool to query.
+ *
+ * @return                      The number of free blocks.
+ */
+int os_mempool_num_free(const struct os_mempool *mp);
+
+#if MYNEWT_VAL(OS_MEMPOOL_CACHE)
+/**
+ * Puts a magazine cache in front of a memory pool.  Each task priority band
+ * then gets and puts blocks through its own small stack of free blocks, and
+ * only goes to the shared free list, with interrupts disabled, to move half a
+ * magazine at a time.  Once enabled, mp_num_free only counts the shared free
+ * list (use os_mempool_num_free() for the total) and mp_min_free is only
+ * updated when the shared free list is accessed.
+ *
+ * @param mp                    The mempool to cache.
+ * @param cache                 Storage for the magazines.  Must stay valid
+ *                                  for the lifetime of the pool.
+ *
+ * @return                      0 on success;
+ *                              OS_INVALID_PARM on bad arguments.
+ */
+os_error_t os_mempool_cache_enable(struct os_mempool *mp,
+                                   struct os_mempool_cache *cache);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
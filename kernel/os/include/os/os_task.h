@@ -132,6 +132,11 @@ struct os_task {
     STAILQ_ENTRY(os_task) t_os_task_list;
     TAILQ_ENTRY(os_task) t_os_list;
     SLIST_ENTRY(os_task) t_obj_list;
+
+#if MYNEWT_VAL(OS_SCHED_PRIO_BITMAP)
+    /** Priority the task was queued with in the run list */
+    uint8_t t_run_prio;
+#endif
 };
 
 /** @cond INTERNAL_HIDDEN */
@@ -24,6 +24,7 @@
 #include <signal.h>
 #include <string.h>
 #include <sys/time.h>
+#include <time.h>
 
 #include "os/mynewt.h"
 #include "os_test/os_test.h"
@@ -60,6 +61,20 @@ os_test_restart(void)
    tu_restart();
 }
 
+/**
+ * Returns host monotonic time.  The OS tick and the sim cputime are too
+ * coarse for the benchmark test cases.
+ */
+uint64_t
+os_test_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
 int
 os_test_all(void)
 {
@@ -70,13 +85,8 @@ os_test_all(void)
     os_eventq_test_suite();
     os_callout_test_suite();
     os_time_test_suite();
+    os_sched_test_suite();
+    os_heap_test_suite();
 
     return tu_case_failed;
 }
-
-int
-main(int argc, char **argv)
-{
-    os_test_all();
-    return tu_any_failed;
-}
@@ -31,6 +31,7 @@
 #include "mbuf_test.h"
 #include "mempool_test.h"
 #include "mutex_test.h"
+#include "sched_test.h"
 #include "sem_test.h"
 
 #ifdef __cplusplus
@@ -49,6 +50,7 @@ extern "C" {
 #define TASK4_PRIO (TASK3_PRIO + 1)
 
 void os_test_restart(void);
+uint64_t os_test_now_ns(void);
 
 #ifdef __cplusplus
 }
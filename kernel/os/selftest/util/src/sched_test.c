@@ -0,0 +1,88 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "os/mynewt.h"
+#include "testutil/testutil.h"
+#include "os_test_priv.h"
+
+struct os_task sched_test_tasks[SCHED_TEST_MAX_TASKS];
+
+/**
+ * Puts a fake task on the run list.  The task is never switched to as long
+ * as a real task of higher priority is ready.
+ */
+void
+sched_test_ready(struct os_task *t, uint8_t prio)
+{
+    os_error_t err;
+
+    memset(t, 0, sizeof *t);
+    t->t_prio = prio;
+    t->t_state = OS_TASK_READY;
+
+    err = os_sched_insert(t);
+    TEST_ASSERT_FATAL(err == OS_OK);
+}
+
+/**
+ * Takes a fake task added with sched_test_ready() off the run list.
+ */
+void
+sched_test_unready(struct os_task *t)
+{
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    os_sched_sleep(t, OS_TIMEOUT_NEVER);
+    TAILQ_REMOVE(&g_os_sleep_list, t, t_os_list);
+    OS_EXIT_CRITICAL(sr);
+}
+
+/**
+ * Checks that the run list is sorted by priority.
+ */
+int
+sched_test_run_list_sorted(void)
+{
+    struct os_task *prev;
+    struct os_task *t;
+
+    prev = NULL;
+    TAILQ_FOREACH(t, &g_os_run_list, t_os_list) {
+        if (prev && prev->t_prio > t->t_prio) {
+            return 0;
+        }
+        prev = t;
+    }
+
+    return 1;
+}
+
+TEST_CASE_DECL(os_sched_test_order)
+TEST_CASE_DECL(os_sched_test_wakeup_bench)
+TEST_CASE_DECL(os_sched_test_ctx_sw)
+
+TEST_SUITE(os_sched_test_suite)
+{
+    os_sched_test_order();
+    os_sched_test_wakeup_bench();
+    os_sched_test_ctx_sw();
+}
@@ -0,0 +1,53 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#ifndef _SCHED_TEST_H
+#define _SCHED_TEST_H
+
+#include <stdio.h>
+#include <string.h>
+#include "os/mynewt.h"
+#include "testutil/testutil.h"
+#include "os_test_priv.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Number of fake tasks used to populate the run list */
+#define SCHED_TEST_MAX_TASKS        (64)
+
+/* Number of real tasks used by the context switch test */
+#define SCHED_TEST_NUM_WORKERS      (8)
+#define SCHED_TEST_WORKER_PRIO      (MYNEWT_VAL(OS_MAIN_TASK_PRIO) - 32)
+#define SCHED_TEST_STACK_SIZE       OS_STACK_ALIGN(1024)
+
+/* Iterations per measurement */
+#define SCHED_TEST_ITERS            (10000)
+
+extern struct os_task sched_test_tasks[SCHED_TEST_MAX_TASKS];
+
+void sched_test_ready(struct os_task *t, uint8_t prio);
+void sched_test_unready(struct os_task *t);
+int sched_test_run_list_sorted(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _SCHED_TEST_H */
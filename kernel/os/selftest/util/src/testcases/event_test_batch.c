@@ -0,0 +1,179 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "os_test_priv.h"
+
+#define ETB_NUM_EVENTS      (16)
+#define ETB_ITERS           (20000)
+
+static struct os_event etb_events[ETB_NUM_EVENTS];
+static int etb_order[ETB_NUM_EVENTS];
+static int etb_runs;
+
+static void
+etb_cb(struct os_event *ev)
+{
+    etb_order[etb_runs++] = (intptr_t)ev->ev_arg;
+}
+
+/* Removes the next event and requeues itself. */
+static void
+etb_remove_cb(struct os_event *ev)
+{
+    etb_cb(ev);
+    os_eventq_remove(&my_eventq, &etb_events[1]);
+    os_eventq_put(&my_eventq, ev);
+}
+
+static void
+etb_init(void)
+{
+    int i;
+
+    os_eventq_init(&my_eventq);
+    memset(etb_events, 0, sizeof etb_events);
+    for (i = 0; i < ETB_NUM_EVENTS; i++) {
+        etb_events[i].ev_cb = etb_cb;
+        etb_events[i].ev_arg = (void *)(intptr_t)i;
+    }
+    etb_runs = 0;
+}
+
+static void
+etb_put_all(void)
+{
+    int i;
+
+    for (i = 0; i < ETB_NUM_EVENTS; i++) {
+        os_eventq_put(&my_eventq, &etb_events[i]);
+    }
+}
+
+/**
+ * Runs ETB_ITERS bursts of ETB_NUM_EVENTS events, either one at a time or
+ * in batches.
+ *
+ * @return Nanoseconds per event.
+ */
+static uint64_t
+etb_measure(int batch)
+{
+    uint64_t start;
+    int left;
+    int i;
+
+    start = os_test_now_ns();
+    for (i = 0; i < ETB_ITERS; i++) {
+        etb_runs = 0;
+        etb_put_all();
+        for (left = ETB_NUM_EVENTS; left > 0; ) {
+            if (batch) {
+                left -= os_eventq_run_batch(&my_eventq, batch);
+            } else {
+                os_eventq_run(&my_eventq);
+                left--;
+            }
+        }
+    }
+
+    return (os_test_now_ns() - start) / ((uint64_t)ETB_ITERS * ETB_NUM_EVENTS);
+}
+
+TEST_CASE_TASK(event_test_batch)
+{
+    struct os_event *evs[ETB_NUM_EVENTS];
+    uint64_t single_ns;
+    uint64_t batch_ns;
+    int cnt;
+    int i;
+
+    etb_init();
+
+    /* Events come out in queue order, at most max at a time. */
+    etb_put_all();
+    cnt = os_eventq_get_batch(&my_eventq, evs, 5);
+    TEST_ASSERT_FATAL(cnt == 5);
+    for (i = 0; i < cnt; i++) {
+        TEST_ASSERT(evs[i] == &etb_events[i]);
+        TEST_ASSERT(!OS_EVENT_QUEUED(evs[i]));
+    }
+    cnt = os_eventq_get_batch(&my_eventq, evs, ETB_NUM_EVENTS);
+    TEST_ASSERT_FATAL(cnt == ETB_NUM_EVENTS - 5);
+    TEST_ASSERT(evs[0] == &etb_events[5]);
+    TEST_ASSERT(STAILQ_EMPTY(&my_eventq.evq_list));
+
+    /* Batches are limited to OS_EVENTQ_BATCH_MAX. */
+    etb_put_all();
+    cnt = os_eventq_run_batch(&my_eventq, ETB_NUM_EVENTS);
+    TEST_ASSERT(cnt == min(ETB_NUM_EVENTS, MYNEWT_VAL(OS_EVENTQ_BATCH_MAX)));
+    while (etb_runs < ETB_NUM_EVENTS) {
+        os_eventq_run_batch(&my_eventq, ETB_NUM_EVENTS);
+    }
+    for (i = 0; i < ETB_NUM_EVENTS; i++) {
+        TEST_ASSERT(etb_order[i] == i);
+    }
+
+    /* An event removed before its turn in the batch is skipped; the event
+     * that is requeued runs again in the next batch.
+     */
+    etb_init();
+    etb_events[0].ev_cb = etb_remove_cb;
+    os_eventq_put(&my_eventq, &etb_events[0]);
+    os_eventq_put(&my_eventq, &etb_events[1]);
+    os_eventq_put(&my_eventq, &etb_events[2]);
+    cnt = os_eventq_run_batch(&my_eventq, 3);
+    TEST_ASSERT(cnt == 2);
+    TEST_ASSERT(etb_runs == 2);
+    TEST_ASSERT(etb_order[0] == 0 && etb_order[1] == 2);
+    TEST_ASSERT(!OS_EVENT_QUEUED(&etb_events[1]));
+    TEST_ASSERT(OS_EVENT_QUEUED(&etb_events[0]));
+    etb_events[0].ev_cb = etb_cb;
+    cnt = os_eventq_run_batch(&my_eventq, 3);
+    TEST_ASSERT(cnt == 1);
+    TEST_ASSERT(etb_order[2] == 0);
+
+#if MYNEWT_VAL(OS_EVENTQ_COALESCE)
+    /* Duplicate posts are counted only for events that opt in. */
+    etb_init();
+    etb_events[0].ev_flags = OS_EVENT_F_COALESCE;
+    for (i = 0; i < 3; i++) {
+        os_eventq_put(&my_eventq, &etb_events[0]);
+        os_eventq_put(&my_eventq, &etb_events[1]);
+    }
+    TEST_ASSERT(etb_events[0].ev_coalesced == 2);
+    TEST_ASSERT(etb_events[1].ev_coalesced == 0);
+    TEST_ASSERT(my_eventq.evq_coalesced == 2);
+    cnt = os_eventq_run_batch(&my_eventq, 2);
+    TEST_ASSERT(cnt == 2);
+    TEST_ASSERT(etb_runs == 2);
+
+    /* The count restarts when the event is queued again. */
+    os_eventq_put(&my_eventq, &etb_events[0]);
+    TEST_ASSERT(etb_events[0].ev_coalesced == 0);
+    os_eventq_run(&my_eventq);
+#endif
+
+    /* Throughput of bursts drained one event at a time vs in batches. */
+    etb_init();
+    single_ns = etb_measure(0);
+    batch_ns = etb_measure(MYNEWT_VAL(OS_EVENTQ_BATCH_MAX));
+    printf("eventq: %llu ns per event with os_eventq_run(), "
+           "%llu ns with os_eventq_run_batch(%d)\n",
+           (unsigned long long)single_ns, (unsigned long long)batch_ns,
+           MYNEWT_VAL(OS_EVENTQ_BATCH_MAX));
+}
@@ -0,0 +1,132 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os_test_priv.h"
+
+#define OSCTC_NUM_CALLOUTS  (256)
+#define OSCTC_ITERS         (20000)
+#define OSCTC_MAX_TICKS     (10000)
+
+static struct os_callout osctc_callouts[OSCTC_NUM_CALLOUTS];
+static struct os_eventq osctc_evq;
+static uint32_t osctc_seed;
+
+static uint32_t
+osctc_rand(void)
+{
+    osctc_seed = osctc_seed * 1103515245 + 12345;
+    return osctc_seed >> 8;
+}
+
+static void
+osctc_verify_wakeup(void)
+{
+    os_time_t remaining;
+    os_time_t expected;
+    os_time_t ticks;
+    os_time_t now;
+    os_sr_t sr;
+    int i;
+
+    OS_ENTER_CRITICAL(sr);
+    now = os_time_get();
+    ticks = os_callout_wakeup_ticks(now);
+    OS_EXIT_CRITICAL(sr);
+
+    expected = OS_TIMEOUT_NEVER;
+    for (i = 0; i < OSCTC_NUM_CALLOUTS; i++) {
+        if (os_callout_queued(&osctc_callouts[i])) {
+            remaining = os_callout_remaining_ticks(&osctc_callouts[i], now);
+            if (remaining < expected) {
+                expected = remaining;
+            }
+        }
+    }
+
+    TEST_ASSERT(ticks == expected);
+}
+
+/**
+ * Re-arms and stops a large set of callouts at random, then lets time run
+ * until all of them have expired.  Verifies that callouts expire exactly on
+ * their tick and reports the cost of reset and of tick processing.
+ */
+TEST_CASE_SELF(os_callout_test_churn)
+{
+    struct os_callout *c;
+    uint64_t reset_ns;
+    uint64_t tick_ns;
+    uint64_t start;
+    os_time_t now;
+    int pending;
+    int rc;
+    int i;
+
+    osctc_seed = 1;
+    os_eventq_init(&osctc_evq);
+    for (i = 0; i < OSCTC_NUM_CALLOUTS; i++) {
+        os_callout_init(&osctc_callouts[i], &osctc_evq, NULL, NULL);
+    }
+
+    start = os_test_now_ns();
+    for (i = 0; i < OSCTC_ITERS; i++) {
+        c = &osctc_callouts[osctc_rand() % OSCTC_NUM_CALLOUTS];
+        rc = os_callout_reset(c, 1 + osctc_rand() % OSCTC_MAX_TICKS);
+        TEST_ASSERT_FATAL(rc == 0);
+
+        if (osctc_rand() % 4 == 0) {
+            c = &osctc_callouts[osctc_rand() % OSCTC_NUM_CALLOUTS];
+            os_callout_stop(c);
+        }
+    }
+    reset_ns = os_test_now_ns() - start;
+
+    osctc_verify_wakeup();
+
+    /* Jump ahead by varying amounts, as tickless idle would. */
+    tick_ns = 0;
+    do {
+        os_time_advance(1 + osctc_rand() % 300);
+        now = os_time_get();
+
+        start = os_test_now_ns();
+        os_callout_tick();
+        tick_ns += os_test_now_ns() - start;
+
+        pending = 0;
+        for (i = 0; i < OSCTC_NUM_CALLOUTS; i++) {
+            c = &osctc_callouts[i];
+            if (os_callout_queued(c)) {
+                TEST_ASSERT_FATAL(OS_TIME_TICK_GT(c->c_ticks, now));
+                pending++;
+            } else if (c->c_ev.ev_queued) {
+                TEST_ASSERT_FATAL(OS_TIME_TICK_GEQ(now, c->c_ticks));
+                os_eventq_remove(&osctc_evq, &c->c_ev);
+            }
+        }
+
+        osctc_verify_wakeup();
+    } while (pending > 0);
+
+    printf("callout churn: %d callouts, %llu ns per reset, %llu us total "
+           "tick processing (wheel=%d)\n", OSCTC_NUM_CALLOUTS,
+           (unsigned long long)(reset_ns / OSCTC_ITERS),
+           (unsigned long long)(tick_ns / 1000),
+           MYNEWT_VAL(OS_CALLOUT_WHEEL));
+}
@@ -0,0 +1,190 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <stdlib.h>
+#include "os_test_priv.h"
+
+#define OHTB_SLOTS      (48)
+#define OHTB_ITERS      (200000)
+
+#if MYNEWT_VAL(OS_MALLOC_SLAB)
+struct ohtb_result {
+    uint64_t avg_ns;
+    uint64_t max_ns;
+    uint32_t failures;
+    uint64_t req_bytes;
+    uint64_t block_bytes;
+};
+
+static void *ohtb_ptrs[OHTB_SLOTS];
+static uint16_t ohtb_sizes[OHTB_SLOTS];
+static uint32_t ohtb_seed;
+
+static uint32_t
+ohtb_rand(void)
+{
+    ohtb_seed = ohtb_seed * 1103515245 + 12345;
+    return ohtb_seed >> 8;
+}
+
+/**
+ * Mostly small, short lived allocations with an occasional large one; the
+ * kind of mix that fragments a first-fit heap over time.
+ */
+static uint16_t
+ohtb_size(void)
+{
+    uint32_t r;
+
+    r = ohtb_rand() % 100;
+    if (r < 60) {
+        return 1 + ohtb_rand() % 16;
+    } else if (r < 85) {
+        return 17 + ohtb_rand() % 48;
+    } else if (r < 97) {
+        return 65 + ohtb_rand() % 64;
+    } else {
+        return 129 + ohtb_rand() % 128;
+    }
+}
+
+static void
+ohtb_run(int slab, struct ohtb_result *res)
+{
+    struct os_malloc_slab_info osi;
+    uint64_t total;
+    uint64_t start;
+    uint64_t ns;
+    int slot;
+    int i;
+    int j;
+
+    memset(res, 0, sizeof *res);
+    memset(ohtb_ptrs, 0, sizeof ohtb_ptrs);
+    ohtb_seed = 1;
+    total = 0;
+
+    for (i = 0; i < OHTB_ITERS; i++) {
+        slot = ohtb_rand() % OHTB_SLOTS;
+        if (ohtb_ptrs[slot] == NULL) {
+            ohtb_sizes[slot] = ohtb_size();
+            start = os_test_now_ns();
+            if (slab) {
+                ohtb_ptrs[slot] = os_malloc(ohtb_sizes[slot]);
+            } else {
+                ohtb_ptrs[slot] = malloc(ohtb_sizes[slot]);
+            }
+            ns = os_test_now_ns() - start;
+            if (ohtb_ptrs[slot] == NULL) {
+                res->failures++;
+            }
+        } else {
+            start = os_test_now_ns();
+            if (slab) {
+                os_free(ohtb_ptrs[slot]);
+            } else {
+                free(ohtb_ptrs[slot]);
+            }
+            ns = os_test_now_ns() - start;
+            ohtb_ptrs[slot] = NULL;
+        }
+
+        total += ns;
+        if (ns > res->max_ns) {
+            res->max_ns = ns;
+        }
+
+        /* Sample internal fragmentation of the size classes. */
+        if (slab && i % 1024 == 0) {
+            for (slot = 0; slot < OHTB_SLOTS; slot++) {
+                if (ohtb_ptrs[slot] == NULL) {
+                    continue;
+                }
+                res->req_bytes += ohtb_sizes[slot];
+                for (j = 0; os_malloc_slab_info_get(j, &osi) == 0; j++) {
+                    if (ohtb_sizes[slot] <= osi.osi_block_size) {
+                        res->block_bytes += osi.osi_block_size;
+                        break;
+                    }
+                }
+                if (os_malloc_slab_info_get(j, &osi) != 0) {
+                    res->block_bytes += ohtb_sizes[slot];
+                }
+            }
+        }
+    }
+    res->avg_ns = total / OHTB_ITERS;
+
+    for (slot = 0; slot < OHTB_SLOTS; slot++) {
+        if (slab) {
+            os_free(ohtb_ptrs[slot]);
+        } else {
+            free(ohtb_ptrs[slot]);
+        }
+    }
+}
+#endif
+
+TEST_CASE_SELF(os_heap_test_bench)
+{
+#if MYNEWT_VAL(OS_MALLOC_SLAB)
+    struct os_malloc_slab_info osi;
+    struct ohtb_result slab;
+    struct ohtb_result heap;
+    void *ptrs[64];
+    int i;
+    int j;
+
+    ohtb_run(1, &slab);
+    ohtb_run(0, &heap);
+
+    TEST_ASSERT(slab.failures == 0);
+    TEST_ASSERT(heap.failures == 0);
+
+    /* After the churn, every class can still be allocated in full. */
+    for (i = 0; os_malloc_slab_info_get(i, &osi) == 0; i++) {
+        TEST_ASSERT_FATAL(osi.osi_num_free == osi.osi_num_blocks);
+        TEST_ASSERT_FATAL(osi.osi_num_blocks <= sizeof ptrs / sizeof ptrs[0]);
+        for (j = 0; j < osi.osi_num_blocks; j++) {
+            ptrs[j] = os_malloc(osi.osi_block_size);
+            TEST_ASSERT_FATAL(ptrs[j] != NULL);
+        }
+        os_malloc_slab_info_get(i, &osi);
+        TEST_ASSERT(osi.osi_num_free == 0);
+        for (j = 0; j < osi.osi_num_blocks; j++) {
+            os_free(ptrs[j]);
+        }
+
+        printf("os_malloc class %d: %u byte blocks, %u/%u high water, "
+               "%u allocs, %u overflows\n",
+               i, (unsigned)osi.osi_block_size,
+               (unsigned)osi.osi_high_water, (unsigned)osi.osi_num_blocks,
+               (unsigned)osi.osi_allocs, (unsigned)osi.osi_overflows);
+    }
+
+    printf("os_malloc slab: %llu ns avg, %llu ns max per op, "
+           "%llu%% internal fragmentation\n",
+           (unsigned long long)slab.avg_ns, (unsigned long long)slab.max_ns,
+           slab.block_bytes ?
+           (unsigned long long)(100 - slab.req_bytes * 100 /
+                                slab.block_bytes) : 0ULL);
+    printf("libc malloc: %llu ns avg, %llu ns max per op\n",
+           (unsigned long long)heap.avg_ns, (unsigned long long)heap.max_ns);
+#endif
+}
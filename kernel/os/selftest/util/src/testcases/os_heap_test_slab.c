@@ -0,0 +1,127 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os_test_priv.h"
+
+#if MYNEWT_VAL(OS_MALLOC_SLAB)
+static void *ohts_ptrs[64];
+
+static int
+ohts_class_cnt(void)
+{
+    struct os_malloc_slab_info osi;
+    int i;
+
+    for (i = 0; os_malloc_slab_info_get(i, &osi) == 0; i++);
+
+    return i;
+}
+#endif
+
+TEST_CASE_SELF(os_heap_test_slab)
+{
+#if MYNEWT_VAL(OS_MALLOC_SLAB)
+    struct os_malloc_slab_info before;
+    struct os_malloc_slab_info after;
+    struct os_malloc_slab_info osi;
+    uint8_t *p;
+    int num_classes;
+    int i;
+    int j;
+
+    num_classes = ohts_class_cnt();
+    TEST_ASSERT_FATAL(num_classes > 0);
+    TEST_ASSERT(os_malloc_slab_info_get(-1, &osi) == OS_ENOENT);
+
+    /* Requests are served by the smallest class that fits. */
+    for (i = 0; i < num_classes; i++) {
+        os_malloc_slab_info_get(i, &before);
+        p = os_malloc(before.osi_block_size);
+        TEST_ASSERT_FATAL(p != NULL);
+        memset(p, 0xa5, before.osi_block_size);
+        os_malloc_slab_info_get(i, &after);
+        TEST_ASSERT(after.osi_allocs == before.osi_allocs + 1);
+        TEST_ASSERT(after.osi_num_free == before.osi_num_free - 1);
+        TEST_ASSERT(after.osi_high_water >=
+                    before.osi_num_blocks - after.osi_num_free);
+
+        /* Growing within the block keeps the pointer. */
+        TEST_ASSERT(os_realloc(p, before.osi_block_size) == p);
+
+        os_free(p);
+        os_malloc_slab_info_get(i, &after);
+        TEST_ASSERT(after.osi_num_free == before.osi_num_free);
+    }
+
+    /* An exhausted class passes requests on to the next larger one. */
+    os_malloc_slab_info_get(0, &before);
+    TEST_ASSERT_FATAL(before.osi_num_blocks <
+                      sizeof ohts_ptrs / sizeof ohts_ptrs[0]);
+    for (i = 0; i <= before.osi_num_blocks; i++) {
+        ohts_ptrs[i] = os_malloc(1);
+        TEST_ASSERT_FATAL(ohts_ptrs[i] != NULL);
+        for (j = 0; j < i; j++) {
+            TEST_ASSERT_FATAL(ohts_ptrs[i] != ohts_ptrs[j]);
+        }
+    }
+    os_malloc_slab_info_get(0, &after);
+    TEST_ASSERT(after.osi_num_free == 0);
+    TEST_ASSERT(after.osi_high_water == after.osi_num_blocks);
+    TEST_ASSERT(after.osi_overflows == before.osi_overflows + 1);
+
+    /* Reallocating past the block size moves the data to a larger class. */
+    p = ohts_ptrs[0];
+    memset(p, 0x3c, before.osi_block_size);
+    ohts_ptrs[0] = os_realloc(p, before.osi_block_size + 1);
+    TEST_ASSERT_FATAL(ohts_ptrs[0] != NULL);
+    TEST_ASSERT(ohts_ptrs[0] != p);
+    for (j = 0; j < before.osi_block_size; j++) {
+        TEST_ASSERT_FATAL(((uint8_t *)ohts_ptrs[0])[j] == 0x3c);
+    }
+
+    for (i = 0; i <= before.osi_num_blocks; i++) {
+        os_free(ohts_ptrs[i]);
+    }
+    for (i = 0; i < num_classes; i++) {
+        os_malloc_slab_info_get(i, &osi);
+        TEST_ASSERT(osi.osi_num_free == osi.osi_num_blocks);
+    }
+
+    /* Reallocating to 0 bytes frees the block. */
+    os_malloc_slab_info_get(0, &before);
+    p = os_malloc(1);
+    TEST_ASSERT_FATAL(p != NULL);
+    TEST_ASSERT(os_realloc(p, 0) == NULL);
+    os_malloc_slab_info_get(0, &after);
+    TEST_ASSERT(after.osi_num_free == before.osi_num_free);
+
+    /* Requests larger than every class come from the libc heap. */
+    os_malloc_slab_info_get(num_classes - 1, &osi);
+    p = os_malloc(osi.osi_block_size + 1);
+#if MYNEWT_VAL(OS_MALLOC_SLAB_FALLBACK)
+    TEST_ASSERT_FATAL(p != NULL);
+    memset(p, 0, osi.osi_block_size + 1);
+    os_free(p);
+#else
+    TEST_ASSERT(p == NULL);
+#endif
+
+    os_free(NULL);
+#endif
+}
@@ -0,0 +1,121 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "os_test_priv.h"
+
+static int os_mbuf_test_ext_freed;
+
+static void
+os_mbuf_test_ext_free(struct os_mbuf_ext *ext)
+{
+    TEST_ASSERT(ext->ome_arg == &os_mbuf_test_ext_freed);
+    os_mbuf_test_ext_freed++;
+}
+
+TEST_CASE_SELF(os_mbuf_test_ext)
+{
+    struct os_mbuf_ext ext;
+    struct os_mbuf *ext_om;
+    struct os_mbuf *dup;
+    struct os_mbuf *om;
+    uint8_t buf[600];
+    int rc;
+
+    os_mbuf_test_setup();
+    os_mbuf_test_ext_freed = 0;
+
+    os_mbuf_ext_init(&ext, os_mbuf_test_data, sizeof os_mbuf_test_data,
+                     os_mbuf_test_ext_free, &os_mbuf_test_ext_freed);
+
+    om = os_mbuf_get_pkthdr(&os_mbuf_pool, 0);
+    TEST_ASSERT_FATAL(om != NULL);
+    rc = os_mbuf_append(om, os_mbuf_test_data, 10);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /* Regions outside the buffer are rejected. */
+    rc = os_mbuf_append_ext(om, &ext, 1000, 100);
+    TEST_ASSERT(rc == OS_EINVAL);
+    TEST_ASSERT(ext.ome_refcnt == 0);
+
+    /* Appending an external region references it without copying. */
+    rc = os_mbuf_append_ext(om, &ext, 10, 500);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(ext.ome_refcnt == 1);
+    ext_om = SLIST_NEXT(om, om_next);
+    TEST_ASSERT_FATAL(ext_om != NULL);
+    TEST_ASSERT(OS_MBUF_IS_EXT(ext_om));
+    TEST_ASSERT(ext_om->om_data == os_mbuf_test_data + 10);
+    TEST_ASSERT(OS_MBUF_LEADINGSPACE(ext_om) == 0);
+    TEST_ASSERT(OS_MBUF_TRAILINGSPACE(ext_om) == 0);
+    os_mbuf_test_misc_assert_sane(om, os_mbuf_test_data, 10, 510,
+                                  sizeof (struct os_mbuf_pkthdr));
+
+    /* Later appends go to a new mbuf rather than into the external data. */
+    rc = os_mbuf_append(om, os_mbuf_test_data + 510, 20);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(ext_om->om_len == 500);
+    TEST_ASSERT(!OS_MBUF_IS_EXT(SLIST_NEXT(ext_om, om_next)));
+    os_mbuf_test_misc_assert_sane(om, os_mbuf_test_data, 10, 530,
+                                  sizeof (struct os_mbuf_pkthdr));
+
+    rc = os_mbuf_copydata(om, 5, 520, buf);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(memcmp(buf, os_mbuf_test_data + 5, 520) == 0);
+
+    /* A duplicate shares the external data. */
+    dup = os_mbuf_dup(om);
+    TEST_ASSERT_FATAL(dup != NULL);
+    TEST_ASSERT(ext.ome_refcnt == 2);
+    TEST_ASSERT(SLIST_NEXT(dup, om_next)->om_data == ext_om->om_data);
+    os_mbuf_test_misc_assert_sane(dup, os_mbuf_test_data, 10, 530,
+                                  sizeof (struct os_mbuf_pkthdr));
+
+    /* Pulling up copies out of the external region of the duplicate only. */
+    dup = os_mbuf_pullup(dup, 100);
+    TEST_ASSERT_FATAL(dup != NULL);
+    TEST_ASSERT(ext.ome_refcnt == 2);
+    os_mbuf_test_misc_assert_sane(dup, os_mbuf_test_data, 100, 530,
+                                  sizeof (struct os_mbuf_pkthdr));
+    TEST_ASSERT(ext_om->om_data == os_mbuf_test_data + 10);
+    TEST_ASSERT(ext_om->om_len == 500);
+
+    /* Trimming moves within the external region. */
+    os_mbuf_adj(om, 200);
+    TEST_ASSERT(ext_om->om_data == os_mbuf_test_data + 200);
+    TEST_ASSERT(OS_MBUF_PKTLEN(om) == 330);
+    os_mbuf_adj(om, -25);
+    TEST_ASSERT(OS_MBUF_PKTLEN(om) == 305);
+    TEST_ASSERT(ext_om->om_len == 305);
+    TEST_ASSERT(SLIST_NEXT(ext_om, om_next) == NULL);
+    rc = os_mbuf_copydata(om, 0, 305, buf);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(memcmp(buf, os_mbuf_test_data + 200, 305) == 0);
+
+    /* The buffer is released once the last reference is freed. */
+    rc = os_mbuf_free_chain(om);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(ext.ome_refcnt == 1);
+    TEST_ASSERT(os_mbuf_test_ext_freed == 0);
+
+    rc = os_mbuf_free_chain(dup);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(ext.ome_refcnt == 0);
+    TEST_ASSERT(os_mbuf_test_ext_freed == 1);
+
+    TEST_ASSERT(os_mbuf_mempool.mp_num_free == MBUF_TEST_POOL_BUF_COUNT);
+}
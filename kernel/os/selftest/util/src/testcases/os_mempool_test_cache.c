@@ -0,0 +1,140 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os_test_priv.h"
+
+#define OMTC_NUM_BLOCKS     (32)
+#define OMTC_BLOCK_SIZE     (32)
+#define OMTC_ITERS          (100000)
+
+static os_membuf_t omtc_buf[OS_MEMPOOL_SIZE(OMTC_NUM_BLOCKS, OMTC_BLOCK_SIZE)];
+static os_membuf_t omtc_plain_buf[OS_MEMPOOL_SIZE(OMTC_NUM_BLOCKS,
+                                                  OMTC_BLOCK_SIZE)];
+static struct os_mempool omtc_pool;
+static struct os_mempool omtc_plain_pool;
+
+#if MYNEWT_VAL(OS_MEMPOOL_CACHE)
+static struct os_mempool_cache omtc_cache;
+
+static struct os_mempool_info *
+omtc_info(struct os_mempool *mp, struct os_mempool_info *omi)
+{
+    struct os_mempool *cur;
+
+    cur = NULL;
+    do {
+        cur = os_mempool_info_get_next(cur, omi);
+    } while (cur != NULL && cur != mp);
+    TEST_ASSERT_FATAL(cur == mp);
+
+    return omi;
+}
+
+/**
+ * Times get/put pairs of a single block.  With a cache these stay within
+ * the magazine of the calling task.
+ */
+static uint64_t
+omtc_measure(struct os_mempool *mp)
+{
+    uint64_t start;
+    void *block;
+    int i;
+
+    start = os_test_now_ns();
+    for (i = 0; i < OMTC_ITERS; i++) {
+        block = os_memblock_get(mp);
+        os_memblock_put(mp, block);
+    }
+
+    return (os_test_now_ns() - start) / OMTC_ITERS;
+}
+#endif
+
+TEST_CASE_SELF(os_mempool_test_cache)
+{
+#if MYNEWT_VAL(OS_MEMPOOL_CACHE)
+    void *blocks[OMTC_NUM_BLOCKS];
+    struct os_mempool_info omi;
+    uint64_t plain_ns;
+    uint64_t cache_ns;
+    int rc;
+    int i;
+    int j;
+
+    os_mempool_unregister(&omtc_pool);
+    os_mempool_unregister(&omtc_plain_pool);
+
+    rc = os_mempool_init(&omtc_pool, OMTC_NUM_BLOCKS, OMTC_BLOCK_SIZE,
+                         omtc_buf, "test_cache");
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = os_mempool_init(&omtc_plain_pool, OMTC_NUM_BLOCKS, OMTC_BLOCK_SIZE,
+                         omtc_plain_buf, "test_cache_plain");
+    TEST_ASSERT_FATAL(rc == 0);
+
+    TEST_ASSERT(os_mempool_cache_enable(NULL, &omtc_cache) != 0);
+    rc = os_mempool_cache_enable(&omtc_pool, &omtc_cache);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /* Every block can be allocated, exactly once, through the cache. */
+    for (i = 0; i < OMTC_NUM_BLOCKS; i++) {
+        blocks[i] = os_memblock_get(&omtc_pool);
+        TEST_ASSERT_FATAL(blocks[i] != NULL);
+        TEST_ASSERT(os_memblock_from(&omtc_pool, blocks[i]));
+        for (j = 0; j < i; j++) {
+            TEST_ASSERT_FATAL(blocks[i] != blocks[j]);
+        }
+    }
+    TEST_ASSERT(os_memblock_get(&omtc_pool) == NULL);
+    TEST_ASSERT(os_mempool_num_free(&omtc_pool) == 0);
+    TEST_ASSERT(omtc_info(&omtc_pool, &omi)->omi_num_free == 0);
+    TEST_ASSERT(omi.omi_min_free == 0);
+
+    /* Freed blocks fill the magazine first, the rest go to the free list. */
+    for (i = 0; i < OMTC_NUM_BLOCKS; i++) {
+        rc = os_memblock_put(&omtc_pool, blocks[i]);
+        TEST_ASSERT_FATAL(rc == 0);
+        TEST_ASSERT(os_mempool_num_free(&omtc_pool) == i + 1);
+    }
+    TEST_ASSERT(omtc_pool.mp_num_free < OMTC_NUM_BLOCKS);
+    TEST_ASSERT(os_mempool_is_sane(&omtc_pool));
+
+    /* Repeated get/put stays in the magazine. */
+    omtc_info(&omtc_pool, &omi);
+    cache_ns = omtc_measure(&omtc_pool);
+    plain_ns = omtc_measure(&omtc_plain_pool);
+    TEST_ASSERT(os_mempool_num_free(&omtc_pool) == OMTC_NUM_BLOCKS);
+
+    i = omi.omi_cache_misses;
+    j = omi.omi_cache_hits;
+    omtc_info(&omtc_pool, &omi);
+    TEST_ASSERT(omi.omi_cache_misses == i);
+    TEST_ASSERT(omi.omi_cache_hits == j + 2 * OMTC_ITERS);
+    TEST_ASSERT(omi.omi_num_free == OMTC_NUM_BLOCKS);
+
+    /* Clearing the pool empties the magazines. */
+    rc = os_mempool_clear(&omtc_pool);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(omtc_pool.mp_num_free == OMTC_NUM_BLOCKS);
+    TEST_ASSERT(os_mempool_num_free(&omtc_pool) == OMTC_NUM_BLOCKS);
+
+    printf("mempool cache: %llu ns per get/put cached, %llu ns uncached\n",
+           (unsigned long long)cache_ns, (unsigned long long)plain_ns);
+#endif
+}
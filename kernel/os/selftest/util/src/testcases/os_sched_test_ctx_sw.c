@@ -0,0 +1,106 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os_test_priv.h"
+
+struct ostscs_worker {
+    struct os_task task;
+    struct os_sem sem;
+    uint64_t woke_ns;
+    uint32_t runs;
+    os_stack_t stack[SCHED_TEST_STACK_SIZE];
+};
+
+static struct ostscs_worker ostscs_workers[SCHED_TEST_NUM_WORKERS];
+
+static void
+ostscs_worker_handler(void *arg)
+{
+    struct ostscs_worker *w;
+
+    w = arg;
+    while (1) {
+        os_sem_pend(&w->sem, OS_TIMEOUT_NEVER);
+        w->woke_ns = os_test_now_ns();
+        w->runs++;
+    }
+}
+
+/**
+ * Wakes higher priority tasks blocked on semaphores, one at a time.  Each
+ * release causes a switch to the woken task, which then blocks again and
+ * switches back.  The wakeup latency is the time from the release until the
+ * woken task runs; the round trip covers both context switches.
+ */
+TEST_CASE_TASK(os_sched_test_ctx_sw)
+{
+    struct ostscs_worker *w;
+    uint64_t wake_total;
+    uint64_t wake_max;
+    uint64_t rt_total;
+    uint64_t start;
+    uint64_t end;
+    uint32_t runs;
+    int rc;
+    int i;
+
+    for (i = 0; i < SCHED_TEST_NUM_WORKERS; i++) {
+        w = &ostscs_workers[i];
+        memset(w, 0, sizeof *w);
+
+        rc = os_sem_init(&w->sem, 0);
+        TEST_ASSERT_FATAL(rc == 0);
+
+        rc = os_task_init(&w->task, "sched_worker", ostscs_worker_handler, w,
+                          SCHED_TEST_WORKER_PRIO + i, OS_WAIT_FOREVER,
+                          w->stack, SCHED_TEST_STACK_SIZE);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+
+    wake_total = 0;
+    wake_max = 0;
+    rt_total = 0;
+    for (i = 0; i < SCHED_TEST_ITERS; i++) {
+        w = &ostscs_workers[i % SCHED_TEST_NUM_WORKERS];
+
+        start = os_test_now_ns();
+        os_sem_release(&w->sem);
+        end = os_test_now_ns();
+
+        TEST_ASSERT_FATAL(w->woke_ns >= start && w->woke_ns <= end);
+        wake_total += w->woke_ns - start;
+        if (w->woke_ns - start > wake_max) {
+            wake_max = w->woke_ns - start;
+        }
+        rt_total += end - start;
+    }
+
+    runs = 0;
+    for (i = 0; i < SCHED_TEST_NUM_WORKERS; i++) {
+        runs += ostscs_workers[i].runs;
+    }
+    TEST_ASSERT(runs == SCHED_TEST_ITERS);
+
+    printf("sched ctx sw: %d tasks, wakeup avg %llu ns max %llu ns, "
+           "switch %llu ns (prio bitmap=%d)\n", SCHED_TEST_NUM_WORKERS,
+           (unsigned long long)(wake_total / SCHED_TEST_ITERS),
+           (unsigned long long)wake_max,
+           (unsigned long long)(rt_total / SCHED_TEST_ITERS / 2),
+           MYNEWT_VAL(OS_SCHED_PRIO_BITMAP));
+}
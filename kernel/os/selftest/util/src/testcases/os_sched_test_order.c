@@ -0,0 +1,108 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os_test_priv.h"
+
+/**
+ * Fills 'out' with the indices of the fake tasks on the run list, in run
+ * list order.  Returns the number of indices written.
+ */
+static int
+ostso_collect(int *out, int max)
+{
+    struct os_task *t;
+    int cnt;
+
+    cnt = 0;
+    TAILQ_FOREACH(t, &g_os_run_list, t_os_list) {
+        if (t >= sched_test_tasks &&
+            t < sched_test_tasks + SCHED_TEST_MAX_TASKS) {
+
+            TEST_ASSERT_FATAL(cnt < max);
+            out[cnt++] = t - sched_test_tasks;
+        }
+    }
+
+    return cnt;
+}
+
+static void
+ostso_verify(const int *exp, int exp_cnt)
+{
+    int idx[SCHED_TEST_MAX_TASKS];
+    int cnt;
+
+    TEST_ASSERT(sched_test_run_list_sorted());
+
+    cnt = ostso_collect(idx, SCHED_TEST_MAX_TASKS);
+    TEST_ASSERT_FATAL(cnt == exp_cnt);
+    TEST_ASSERT(memcmp(idx, exp, cnt * sizeof exp[0]) == 0);
+}
+
+TEST_CASE_SELF(os_sched_test_order)
+{
+    struct os_task *t;
+    int i;
+
+    t = sched_test_tasks;
+
+    /* Equal priorities are kept in FIFO order. */
+    sched_test_ready(&t[0], 50);
+    sched_test_ready(&t[1], 40);
+    sched_test_ready(&t[2], 50);
+    sched_test_ready(&t[3], 60);
+    sched_test_ready(&t[4], 40);
+    ostso_verify((int[]){ 1, 4, 0, 2, 3 }, 5);
+    TEST_ASSERT(os_sched_next_task() == &t[1]);
+
+    /* A resorted task goes to the back of its new priority. */
+    t[1].t_prio = 50;
+    os_sched_resort(&t[1]);
+    ostso_verify((int[]){ 4, 0, 2, 1, 3 }, 5);
+    TEST_ASSERT(os_sched_next_task() == &t[4]);
+
+    t[3].t_prio = 30;
+    os_sched_resort(&t[3]);
+    ostso_verify((int[]){ 3, 4, 0, 2, 1 }, 5);
+    TEST_ASSERT(os_sched_next_task() == &t[3]);
+
+    /* Removing the last task of a priority keeps the rest linked. */
+    sched_test_unready(&t[1]);
+    ostso_verify((int[]){ 3, 4, 0, 2 }, 4);
+    sched_test_unready(&t[3]);
+    ostso_verify((int[]){ 4, 0, 2 }, 3);
+    TEST_ASSERT(os_sched_next_task() == &t[4]);
+
+    /* Re-inserted tasks land behind the remaining ones. */
+    sched_test_ready(&t[1], 50);
+    sched_test_ready(&t[3], 40);
+    ostso_verify((int[]){ 4, 3, 0, 2, 1 }, 5);
+
+    /* Spread tasks over every bitmap word. */
+    for (i = 5; i < SCHED_TEST_MAX_TASKS; i++) {
+        sched_test_ready(&t[i], (i * 37) % 250);
+    }
+    TEST_ASSERT(sched_test_run_list_sorted());
+
+    for (i = 0; i < SCHED_TEST_MAX_TASKS; i++) {
+        sched_test_unready(&t[i]);
+        TEST_ASSERT(sched_test_run_list_sorted());
+    }
+    ostso_verify((int[]){ 0 }, 0);
+}
@@ -0,0 +1,76 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os_test_priv.h"
+
+#define OSTSWB_PROBE_PRIO   (250)
+
+/**
+ * Times a sleep/wakeup cycle of a task queued behind 'num_ready' other ready
+ * tasks.  This is the worst case for a sorted run list insert.
+ */
+static uint64_t
+ostswb_measure(int num_ready)
+{
+    struct os_task *probe;
+    uint64_t start;
+    uint64_t end;
+    os_sr_t sr;
+    int i;
+
+    probe = &sched_test_tasks[SCHED_TEST_MAX_TASKS - 1];
+    TEST_ASSERT_FATAL(num_ready < SCHED_TEST_MAX_TASKS);
+
+    for (i = 0; i < num_ready; i++) {
+        sched_test_ready(&sched_test_tasks[i], OSTSWB_PROBE_PRIO - 1 - i);
+    }
+    sched_test_ready(probe, OSTSWB_PROBE_PRIO);
+
+    start = os_test_now_ns();
+    for (i = 0; i < SCHED_TEST_ITERS; i++) {
+        OS_ENTER_CRITICAL(sr);
+        os_sched_sleep(probe, OS_TIMEOUT_NEVER);
+        os_sched_wakeup(probe);
+        OS_EXIT_CRITICAL(sr);
+    }
+    end = os_test_now_ns();
+
+    TEST_ASSERT(sched_test_run_list_sorted());
+
+    sched_test_unready(probe);
+    for (i = 0; i < num_ready; i++) {
+        sched_test_unready(&sched_test_tasks[i]);
+    }
+
+    return (end - start) / SCHED_TEST_ITERS;
+}
+
+TEST_CASE_SELF(os_sched_test_wakeup_bench)
+{
+    static const int num_ready[] = { 1, 8, 16, 32, 48 };
+    uint64_t ns;
+    int i;
+
+    for (i = 0; i < sizeof num_ready / sizeof num_ready[0]; i++) {
+        ns = ostswb_measure(num_ready[i]);
+        printf("sched wakeup: %2d ready tasks, %llu ns per sleep/wakeup "
+               "(prio bitmap=%d)\n", num_ready[i], (unsigned long long)ns,
+               MYNEWT_VAL(OS_SCHED_PRIO_BITMAP));
+    }
+}
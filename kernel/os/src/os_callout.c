@@ -26,7 +26,244 @@
 #include "os/mynewt.h"
 #include "os_priv.h"
 
+#if MYNEWT_VAL(OS_CALLOUT_WHEEL)
+
+#if MYNEWT_VAL(OS_CALLOUT_WHEEL_BITS) < 1 || MYNEWT_VAL(OS_CALLOUT_WHEEL_BITS) > 5
+#error "OS_CALLOUT_WHEEL_BITS must be between 1 and 5"
+#endif
+
+/*
+ * Hierarchical timing wheel.  Level n has OS_CALLOUT_WHEEL_SLOTS slots, each
+ * covering 2^(n * OS_CALLOUT_WHEEL_BITS) ticks of absolute time.  A callout
+ * goes to the lowest level whose range covers its distance from the wheel
+ * time; whenever the wheel time crosses a slot boundary of level n, that
+ * level's current slot is cascaded down.  Every entry of a level 0 slot
+ * expires on the same tick.
+ *
+ * os_callout_wheel_time is the last tick processed by os_callout_tick().
+ * A bitmap per level tracks non-empty slots so idle slots are skipped when
+ * the OS time jumps forward (e.g. after tickless idle).
+ */
+#define OS_CALLOUT_WHEEL_BITS   MYNEWT_VAL(OS_CALLOUT_WHEEL_BITS)
+#define OS_CALLOUT_WHEEL_SLOTS  (1 << OS_CALLOUT_WHEEL_BITS)
+#define OS_CALLOUT_WHEEL_MASK   (OS_CALLOUT_WHEEL_SLOTS - 1)
+#define OS_CALLOUT_WHEEL_LEVELS \
+    ((32 + OS_CALLOUT_WHEEL_BITS - 1) / OS_CALLOUT_WHEEL_BITS)
+
+static struct os_callout_list
+    os_callout_wheel[OS_CALLOUT_WHEEL_LEVELS][OS_CALLOUT_WHEEL_SLOTS];
+static uint32_t os_callout_wheel_map[OS_CALLOUT_WHEEL_LEVELS];
+static os_time_t os_callout_wheel_time;
+
+/*
+ * Returns the distance, in slots, from slot 'cur' to the next non-empty slot
+ * of a level, or 0 if the level is empty.  Slot 'cur' itself counts as the
+ * farthest one.
+ */
+static int
+os_callout_wheel_next_slot(uint32_t map, int cur)
+{
+    uint32_t above;
+
+    above = map & ~((2UL << cur) - 1);
+    if (above) {
+        return __builtin_ctz(above) - cur;
+    }
+    if (map) {
+        return __builtin_ctz(map) + OS_CALLOUT_WHEEL_SLOTS - cur;
+    }
+
+    return 0;
+}
+
+static void
+os_callout_wheel_insert(struct os_callout *c)
+{
+    os_time_t delta;
+    int level;
+    int slot;
+
+    delta = c->c_ticks - os_callout_wheel_time;
+    level = 0;
+    while (level < OS_CALLOUT_WHEEL_LEVELS - 1 &&
+           (delta >> (OS_CALLOUT_WHEEL_BITS * (level + 1))) != 0) {
+        level++;
+    }
+    slot = (c->c_ticks >> (OS_CALLOUT_WHEEL_BITS * level)) &
+           OS_CALLOUT_WHEEL_MASK;
+
+    TAILQ_INSERT_TAIL(&os_callout_wheel[level][slot], c, c_next);
+    os_callout_wheel_map[level] |= 1UL << slot;
+    c->c_wheel_idx = level * OS_CALLOUT_WHEEL_SLOTS + slot;
+}
+
+static void
+os_callout_wheel_remove(struct os_callout *c)
+{
+    struct os_callout_list *head;
+    int level;
+    int slot;
+
+    level = c->c_wheel_idx / OS_CALLOUT_WHEEL_SLOTS;
+    slot = c->c_wheel_idx % OS_CALLOUT_WHEEL_SLOTS;
+    head = &os_callout_wheel[level][slot];
+
+    TAILQ_REMOVE(head, c, c_next);
+    c->c_next.tqe_prev = NULL;
+    if (TAILQ_EMPTY(head)) {
+        os_callout_wheel_map[level] &= ~(1UL << slot);
+    }
+}
+
+/*
+ * Moves the wheel time forward by one step, but not past 'now'.  A step ends
+ * at the next non-empty level 0 slot or at the next slot boundary of the
+ * lowest non-empty upper level, whichever comes first.  Upper level slots
+ * whose boundary is reached are cascaded down.
+ */
+static void
+os_callout_wheel_advance(os_time_t now)
+{
+    struct os_callout_list *head;
+    struct os_callout *c;
+    os_time_t step;
+    os_time_t span;
+    int level;
+    int slot;
+
+    step = now - os_callout_wheel_time;
+
+    span = os_callout_wheel_next_slot(os_callout_wheel_map[0],
+                                      os_callout_wheel_time &
+                                      OS_CALLOUT_WHEEL_MASK);
+    if (span != 0 && span < step) {
+        step = span;
+    }
+    for (level = 1; level < OS_CALLOUT_WHEEL_LEVELS; level++) {
+        if (os_callout_wheel_map[level]) {
+            span = (1UL << (OS_CALLOUT_WHEEL_BITS * level)) -
+                   (os_callout_wheel_time &
+                    ((1UL << (OS_CALLOUT_WHEEL_BITS * level)) - 1));
+            if (span < step) {
+                step = span;
+            }
+            break;
+        }
+    }
+
+    os_callout_wheel_time += step;
+
+    for (level = 1; level < OS_CALLOUT_WHEEL_LEVELS; level++) {
+        if (os_callout_wheel_time &
+            ((1UL << (OS_CALLOUT_WHEEL_BITS * level)) - 1)) {
+            break;
+        }
+
+        slot = (os_callout_wheel_time >> (OS_CALLOUT_WHEEL_BITS * level)) &
+               OS_CALLOUT_WHEEL_MASK;
+        if (!(os_callout_wheel_map[level] & (1UL << slot))) {
+            continue;
+        }
+
+        /* Callouts of this slot always move to a lower level. */
+        head = &os_callout_wheel[level][slot];
+        os_callout_wheel_map[level] &= ~(1UL << slot);
+        while ((c = TAILQ_FIRST(head)) != NULL) {
+            TAILQ_REMOVE(head, c, c_next);
+            os_callout_wheel_insert(c);
+        }
+    }
+}
+
+/*
+ * Removes and returns the next callout that has expired by 'now', or NULL
+ * if there is none left.
+ */
+static struct os_callout *
+os_callout_wheel_expired(os_time_t now)
+{
+    struct os_callout *c;
+
+    while (1) {
+        c = TAILQ_FIRST(&os_callout_wheel[0][os_callout_wheel_time &
+                                             OS_CALLOUT_WHEEL_MASK]);
+        if (c) {
+            os_callout_wheel_remove(c);
+            return c;
+        }
+        if (os_callout_wheel_time == now) {
+            return NULL;
+        }
+        os_callout_wheel_advance(now);
+    }
+}
+
+/*
+ * Returns the earliest callout in the wheel.  Only the first non-empty slot
+ * of each level needs to be looked at; a level 0 slot holds callouts of a
+ * single expiry time.
+ */
+static struct os_callout *
+os_callout_wheel_first(void)
+{
+    struct os_callout *first;
+    struct os_callout *c;
+    int level;
+    int span;
+    int slot;
+
+    /* Callouts due at the wheel time which os_callout_tick() has not
+     * dequeued yet.
+     */
+    first = TAILQ_FIRST(&os_callout_wheel[0][os_callout_wheel_time &
+                                             OS_CALLOUT_WHEEL_MASK]);
+    if (first) {
+        return first;
+    }
+
+    for (level = 0; level < OS_CALLOUT_WHEEL_LEVELS; level++) {
+        slot = (os_callout_wheel_time >> (OS_CALLOUT_WHEEL_BITS * level)) &
+               OS_CALLOUT_WHEEL_MASK;
+        span = os_callout_wheel_next_slot(os_callout_wheel_map[level], slot);
+        if (span == 0) {
+            continue;
+        }
+        slot = (slot + span) & OS_CALLOUT_WHEEL_MASK;
+
+        TAILQ_FOREACH(c, &os_callout_wheel[level][slot], c_next) {
+            if (!first || OS_TIME_TICK_LT(c->c_ticks, first->c_ticks)) {
+                first = c;
+            }
+            if (level == 0) {
+                break;
+            }
+        }
+    }
+
+    return first;
+}
+#else
 struct os_callout_list g_callout_list;
+#endif
+
+void
+os_callout_module_init(void)
+{
+#if MYNEWT_VAL(OS_CALLOUT_WHEEL)
+    int level;
+    int slot;
+
+    for (level = 0; level < OS_CALLOUT_WHEEL_LEVELS; level++) {
+        for (slot = 0; slot < OS_CALLOUT_WHEEL_SLOTS; slot++) {
+            TAILQ_INIT(&os_callout_wheel[level][slot]);
+        }
+        os_callout_wheel_map[level] = 0;
+    }
+    os_callout_wheel_time = os_time_get();
+#else
+    TAILQ_INIT(&g_callout_list);
+#endif
+}
 
 void os_callout_init(struct os_callout *c, struct os_eventq *evq,
                      os_event_fn *ev_cb, void *ev_arg)
@@ -51,8 +288,12 @@ os_callout_stop(struct os_callout *c)
     OS_ENTER_CRITICAL(sr);
 
     if (os_callout_queued(c)) {
+#if MYNEWT_VAL(OS_CALLOUT_WHEEL)
+        os_callout_wheel_remove(c);
+#else
         TAILQ_REMOVE(&g_callout_list, c, c_next);
         c->c_next.tqe_prev = NULL;
+#endif
     }
 
     if (c->c_evq) {
@@ -67,7 +308,9 @@ os_callout_stop(struct os_callout *c)
 int
 os_callout_reset(struct os_callout *c, os_time_t ticks)
 {
+#if !MYNEWT_VAL(OS_CALLOUT_WHEEL)
     struct os_callout *entry;
+#endif
     os_sr_t sr;
     int ret;
 
@@ -91,6 +334,9 @@ os_callout_reset(struct os_callout *c, os_time_t ticks)
 
     c->c_ticks = os_time_get() + ticks;
 
+#if MYNEWT_VAL(OS_CALLOUT_WHEEL)
+    os_callout_wheel_insert(c);
+#else
     entry = NULL;
     TAILQ_FOREACH(entry, &g_callout_list, c_next) {
         if (OS_TIME_TICK_LT(c->c_ticks, entry->c_ticks)) {
@@ -103,6 +349,7 @@ os_callout_reset(struct os_callout *c, os_time_t ticks)
     } else {
         TAILQ_INSERT_TAIL(&g_callout_list, c, c_next);
     }
+#endif
 
     OS_EXIT_CRITICAL(sr);
 
@@ -133,6 +380,9 @@ os_callout_tick(void)
 
     while (1) {
         OS_ENTER_CRITICAL(sr);
+#if MYNEWT_VAL(OS_CALLOUT_WHEEL)
+        c = os_callout_wheel_expired(now);
+#else
         c = TAILQ_FIRST(&g_callout_list);
         if (c) {
             if (OS_TIME_TICK_GEQ(now, c->c_ticks)) {
@@ -142,6 +392,7 @@ os_callout_tick(void)
                 c = NULL;
             }
         }
+#endif
         OS_EXIT_CRITICAL(sr);
 
         if (c) {
@@ -174,7 +425,11 @@ os_callout_wakeup_ticks(os_time_t now)
 
     OS_ASSERT_CRITICAL();
 
+#if MYNEWT_VAL(OS_CALLOUT_WHEEL)
+    c = os_callout_wheel_first();
+#else
     c = TAILQ_FIRST(&g_callout_list);
+#endif
     if (c != NULL) {
         if (OS_TIME_TICK_GEQ(c->c_ticks, now)) {
             rt = c->c_ticks - now;
@@ -25,6 +25,13 @@
 #endif
 #include "os/mynewt.h"
 
+/*
+ * ev_queued value of an event that os_eventq_run_batch() took off its queue
+ * but has not run yet.  The event counts as queued, so posting it again has
+ * no effect, but it is not on any list.
+ */
+#define OS_EVENT_BATCHED    (2)
+
 static struct os_eventq os_eventq_main;
 
 void
@@ -54,6 +61,14 @@ os_eventq_put(struct os_eventq *evq, struct os_event *ev)
 
     /* Do not queue if already queued */
     if (OS_EVENT_QUEUED(ev)) {
+#if MYNEWT_VAL(OS_EVENTQ_COALESCE)
+        if (ev->ev_flags & OS_EVENT_F_COALESCE) {
+            if (ev->ev_coalesced < UINT16_MAX) {
+                ev->ev_coalesced++;
+            }
+            evq->evq_coalesced++;
+        }
+#endif
         OS_EXIT_CRITICAL(sr);
         os_trace_api_ret(OS_TRACE_ID_EVENTQ_PUT);
         return;
@@ -61,6 +76,9 @@ os_eventq_put(struct os_eventq *evq, struct os_event *ev)
 
     /* Queue the event */
     ev->ev_queued = 1;
+#if MYNEWT_VAL(OS_EVENTQ_COALESCE)
+    ev->ev_coalesced = 0;
+#endif
     STAILQ_INSERT_TAIL(&evq->evq_list, ev, ev_next);
 
     resched = 0;
@@ -157,6 +175,70 @@ pull_one:
     return (ev);
 }
 
+/*
+ * Blocks until the queue has an event, then takes up to max events off it in
+ * one critical section.  The events are marked with the given ev_queued
+ * value.
+ */
+static int
+os_eventq_pull_batch(struct os_eventq *evq, struct os_event **evs, int max,
+                     uint8_t queued)
+{
+    struct os_event *ev;
+    struct os_task *t;
+    os_sr_t sr;
+    int cnt;
+
+    assert(max > 0);
+
+    t = os_sched_get_current_task();
+    if (evq->evq_owner != t) {
+        if (evq->evq_owner == NULL) {
+            evq->evq_owner = t;
+        } else {
+            /*
+             * A task is trying to read from event queue which is handled
+             * by another.
+             */
+            assert(0);
+        }
+    }
+
+    OS_ENTER_CRITICAL(sr);
+    while (STAILQ_EMPTY(&evq->evq_list)) {
+        evq->evq_task = t;
+        os_sched_sleep(evq->evq_task, OS_TIMEOUT_NEVER);
+        t->t_flags |= OS_TASK_FLAG_EVQ_WAIT;
+        OS_EXIT_CRITICAL(sr);
+
+        os_sched(NULL);
+
+        OS_ENTER_CRITICAL(sr);
+        evq->evq_task = NULL;
+    }
+
+    cnt = 0;
+    while (cnt < max && (ev = STAILQ_FIRST(&evq->evq_list)) != NULL) {
+        STAILQ_REMOVE_HEAD(&evq->evq_list, ev_next);
+        ev->ev_queued = queued;
+        evs[cnt++] = ev;
+    }
+    t->t_flags &= ~OS_TASK_FLAG_EVQ_WAIT;
+    OS_EXIT_CRITICAL(sr);
+
+#if MYNEWT_VAL(OS_EVENTQ_DEBUG)
+    evq->evq_prev = evs[cnt - 1];
+#endif
+
+    return cnt;
+}
+
+int
+os_eventq_get_batch(struct os_eventq *evq, struct os_event **evs, int max)
+{
+    return os_eventq_pull_batch(evq, evs, max, 0);
+}
+
 #if MYNEWT_VAL(OS_EVENTQ_MONITOR)
 static struct os_eventq_mon *
 os_eventq_mon_find(struct os_eventq *evq, struct os_event *ev)
@@ -179,16 +261,14 @@ os_eventq_mon_find(struct os_eventq *evq, struct os_event *ev)
 }
 #endif
 
-void
-os_eventq_run(struct os_eventq *evq)
+static void
+os_eventq_run_ev(struct os_eventq *evq, struct os_event *ev)
 {
-    struct os_event *ev;
 #if MYNEWT_VAL(OS_EVENTQ_MONITOR)
     struct os_eventq_mon *mon;
     uint32_t ticks;
 #endif
 
-    ev = os_eventq_get(evq);
     assert(ev->ev_cb != NULL);
 #if MYNEWT_VAL(OS_EVENTQ_MONITOR)
     ticks = os_cputime_get32();
@@ -215,6 +295,53 @@ os_eventq_run(struct os_eventq *evq)
 #endif
 }
 
+void
+os_eventq_run(struct os_eventq *evq)
+{
+    struct os_event *ev;
+
+    ev = os_eventq_get(evq);
+    os_eventq_run_ev(evq, ev);
+}
+
+int
+os_eventq_run_batch(struct os_eventq *evq, int max)
+{
+    struct os_event *evs[MYNEWT_VAL(OS_EVENTQ_BATCH_MAX)];
+    struct os_event *ev;
+    os_sr_t sr;
+    int run;
+    int cnt;
+    int i;
+
+    if (max > MYNEWT_VAL(OS_EVENTQ_BATCH_MAX)) {
+        max = MYNEWT_VAL(OS_EVENTQ_BATCH_MAX);
+    }
+
+    cnt = os_eventq_pull_batch(evq, evs, max, OS_EVENT_BATCHED);
+
+    run = 0;
+    for (i = 0; i < cnt; i++) {
+        ev = evs[i];
+
+        /* Skip events that were removed, and possibly queued again, since
+         * they were pulled.
+         */
+        OS_ENTER_CRITICAL(sr);
+        if (ev->ev_queued != OS_EVENT_BATCHED) {
+            OS_EXIT_CRITICAL(sr);
+            continue;
+        }
+        ev->ev_queued = 0;
+        OS_EXIT_CRITICAL(sr);
+
+        os_eventq_run_ev(evq, ev);
+        run++;
+    }
+
+    return run;
+}
+
 static struct os_event *
 os_eventq_poll_0timo(struct os_eventq **evq, int nevqs)
 {
@@ -322,7 +449,7 @@ os_eventq_remove(struct os_eventq *evq, struct os_event *ev)
     os_trace_api_u32x2(OS_TRACE_ID_EVENTQ_REMOVE, (uint32_t)evq, (uint32_t)ev);
 
     OS_ENTER_CRITICAL(sr);
-    if (OS_EVENT_QUEUED(ev)) {
+    if (OS_EVENT_QUEUED(ev) && ev->ev_queued != OS_EVENT_BATCHED) {
         STAILQ_REMOVE(&evq->evq_list, ev, os_event, ev_next);
     }
     ev->ev_queued = 0;
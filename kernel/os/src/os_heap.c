@@ -18,7 +18,9 @@
  */
 
 #include <assert.h>
+#include <string.h>
 #include "os/mynewt.h"
+#include "os_priv.h"
 
 #if MYNEWT_VAL(OS_SCHEDULING)
 static struct os_mutex os_malloc_mutex;
@@ -50,11 +52,237 @@ os_malloc_unlock(void)
 #endif
 }
 
+#if MYNEWT_VAL(OS_MALLOC_SLAB)
+
+#if MYNEWT_VAL(OS_MALLOC_SLAB_1_BLOCK_COUNT) +  \
+    MYNEWT_VAL(OS_MALLOC_SLAB_2_BLOCK_COUNT) +  \
+    MYNEWT_VAL(OS_MALLOC_SLAB_3_BLOCK_COUNT) +  \
+    MYNEWT_VAL(OS_MALLOC_SLAB_4_BLOCK_COUNT) +  \
+    MYNEWT_VAL(OS_MALLOC_SLAB_5_BLOCK_COUNT) == 0
+#error "OS_MALLOC_SLAB requires at least one size class"
+#endif
+
+#define OS_MALLOC_SLAB_BLOCK_SIZE(n)                                \
+    OS_ALIGN(MYNEWT_VAL(OS_MALLOC_SLAB_ ## n ## _BLOCK_SIZE), OS_ALIGNMENT)
+#define OS_MALLOC_SLAB_MEMPOOL_SIZE(n)                              \
+    OS_MEMPOOL_SIZE(MYNEWT_VAL(OS_MALLOC_SLAB_ ## n ## _BLOCK_COUNT), \
+                    OS_MALLOC_SLAB_BLOCK_SIZE(n))
+#define OS_MALLOC_SLAB_ENTRY(n, data) {                             \
+    .oms_data = (data),                                             \
+    .oms_block_size = OS_MALLOC_SLAB_BLOCK_SIZE(n),                 \
+    .oms_num_blocks = MYNEWT_VAL(OS_MALLOC_SLAB_ ## n ## _BLOCK_COUNT), \
+    .oms_name = "os_malloc_" #n,                                    \
+}
+
+struct os_malloc_slab {
+    struct os_mempool oms_pool;
+    os_membuf_t *oms_data;
+    uint32_t oms_block_size;
+    uint16_t oms_num_blocks;
+    uint32_t oms_allocs;
+    uint32_t oms_overflows;
+    char *oms_name;
+};
+
+#if MYNEWT_VAL(OS_MALLOC_SLAB_1_BLOCK_COUNT) > 0
+static os_membuf_t os_malloc_slab_1_data[OS_MALLOC_SLAB_MEMPOOL_SIZE(1)];
+#endif
+#if MYNEWT_VAL(OS_MALLOC_SLAB_2_BLOCK_COUNT) > 0
+static os_membuf_t os_malloc_slab_2_data[OS_MALLOC_SLAB_MEMPOOL_SIZE(2)];
+#endif
+#if MYNEWT_VAL(OS_MALLOC_SLAB_3_BLOCK_COUNT) > 0
+static os_membuf_t os_malloc_slab_3_data[OS_MALLOC_SLAB_MEMPOOL_SIZE(3)];
+#endif
+#if MYNEWT_VAL(OS_MALLOC_SLAB_4_BLOCK_COUNT) > 0
+static os_membuf_t os_malloc_slab_4_data[OS_MALLOC_SLAB_MEMPOOL_SIZE(4)];
+#endif
+#if MYNEWT_VAL(OS_MALLOC_SLAB_5_BLOCK_COUNT) > 0
+static os_membuf_t os_malloc_slab_5_data[OS_MALLOC_SLAB_MEMPOOL_SIZE(5)];
+#endif
+
+/* Size classes, smallest first. */
+static struct os_malloc_slab os_malloc_slabs[] = {
+#if MYNEWT_VAL(OS_MALLOC_SLAB_1_BLOCK_COUNT) > 0
+    OS_MALLOC_SLAB_ENTRY(1, os_malloc_slab_1_data),
+#endif
+#if MYNEWT_VAL(OS_MALLOC_SLAB_2_BLOCK_COUNT) > 0
+    OS_MALLOC_SLAB_ENTRY(2, os_malloc_slab_2_data),
+#endif
+#if MYNEWT_VAL(OS_MALLOC_SLAB_3_BLOCK_COUNT) > 0
+    OS_MALLOC_SLAB_ENTRY(3, os_malloc_slab_3_data),
+#endif
+#if MYNEWT_VAL(OS_MALLOC_SLAB_4_BLOCK_COUNT) > 0
+    OS_MALLOC_SLAB_ENTRY(4, os_malloc_slab_4_data),
+#endif
+#if MYNEWT_VAL(OS_MALLOC_SLAB_5_BLOCK_COUNT) > 0
+    OS_MALLOC_SLAB_ENTRY(5, os_malloc_slab_5_data),
+#endif
+};
+
+#define OS_MALLOC_SLAB_CNT \
+    (int)(sizeof(os_malloc_slabs) / sizeof(os_malloc_slabs[0]))
+
+static uint8_t os_malloc_slab_ready;
+
+/*
+ * Creates the pools of the size classes.  Must be called with interrupts
+ * disabled.
+ */
+static void
+os_malloc_slab_init(void)
+{
+    struct os_malloc_slab *oms;
+    os_error_t err;
+    int i;
+
+    for (i = 0; i < OS_MALLOC_SLAB_CNT; i++) {
+        oms = &os_malloc_slabs[i];
+        assert(i == 0 || oms->oms_block_size > oms[-1].oms_block_size);
+
+        err = os_mempool_init(&oms->oms_pool, oms->oms_num_blocks,
+                              oms->oms_block_size, oms->oms_data,
+                              oms->oms_name);
+        assert(err == OS_OK);
+    }
+
+    os_malloc_slab_ready = 1;
+}
+
+/**
+ * Allocates a block from the smallest size class that fits, or from the next
+ * larger class if that one is exhausted.
+ *
+ * @return The block, or NULL if no class can satisfy the request.
+ */
+static void *
+os_malloc_slab_alloc(size_t size)
+{
+    struct os_malloc_slab *oms;
+    void *ptr;
+    os_sr_t sr;
+    int i;
+
+    if (!os_malloc_slab_ready) {
+        OS_ENTER_CRITICAL(sr);
+        if (!os_malloc_slab_ready) {
+            os_malloc_slab_init();
+        }
+        OS_EXIT_CRITICAL(sr);
+    }
+
+    for (i = 0; i < OS_MALLOC_SLAB_CNT; i++) {
+        if (size <= os_malloc_slabs[i].oms_block_size) {
+            break;
+        }
+    }
+
+    ptr = NULL;
+    oms = NULL;
+    for (; i < OS_MALLOC_SLAB_CNT; i++) {
+        if (oms) {
+            oms->oms_overflows++;
+        }
+        oms = &os_malloc_slabs[i];
+        ptr = os_memblock_get(&oms->oms_pool);
+        if (ptr) {
+            oms->oms_allocs++;
+            return ptr;
+        }
+    }
+
+    if (oms) {
+        oms->oms_overflows++;
+    }
+
+    return NULL;
+}
+
+/**
+ * @return The size class the memory belongs to, or NULL if it was not
+ *         allocated from a size class.
+ */
+static struct os_malloc_slab *
+os_malloc_slab_find(const void *mem)
+{
+    int i;
+
+    if (mem && os_malloc_slab_ready) {
+        for (i = 0; i < OS_MALLOC_SLAB_CNT; i++) {
+            if (os_memblock_from(&os_malloc_slabs[i].oms_pool, mem)) {
+                return &os_malloc_slabs[i];
+            }
+        }
+    }
+
+    return NULL;
+}
+
+int
+os_malloc_slab_info_get(int idx, struct os_malloc_slab_info *osi)
+{
+    struct os_malloc_slab *oms;
+    os_sr_t sr;
+
+    if (idx < 0 || idx >= OS_MALLOC_SLAB_CNT) {
+        return OS_ENOENT;
+    }
+    oms = &os_malloc_slabs[idx];
+
+    OS_ENTER_CRITICAL(sr);
+    osi->osi_block_size = oms->oms_block_size;
+    osi->osi_num_blocks = oms->oms_num_blocks;
+    if (os_malloc_slab_ready) {
+        osi->osi_num_free = oms->oms_pool.mp_num_free;
+        osi->osi_high_water = oms->oms_num_blocks -
+                              oms->oms_pool.mp_min_free;
+    } else {
+        osi->osi_num_free = oms->oms_num_blocks;
+        osi->osi_high_water = 0;
+    }
+    osi->osi_allocs = oms->oms_allocs;
+    osi->osi_overflows = oms->oms_overflows;
+    OS_EXIT_CRITICAL(sr);
+
+    return 0;
+}
+#endif
+
+void
+os_malloc_module_init(void)
+{
+#if MYNEWT_VAL(OS_MALLOC_SLAB)
+    os_sr_t sr;
+    int i;
+
+    OS_ENTER_CRITICAL(sr);
+    if (!os_malloc_slab_ready) {
+        os_malloc_slab_init();
+    } else {
+        /* The mempool list was reset; relink the pools without discarding
+         * the blocks that are still allocated.
+         */
+        for (i = 0; i < OS_MALLOC_SLAB_CNT; i++) {
+            os_mempool_unregister(&os_malloc_slabs[i].oms_pool);
+            STAILQ_INSERT_TAIL(&g_os_mempool_list,
+                               &os_malloc_slabs[i].oms_pool, mp_list);
+        }
+    }
+    OS_EXIT_CRITICAL(sr);
+#endif
+}
+
 void *
 os_malloc(size_t size)
 {
     void *ptr;
 
+#if MYNEWT_VAL(OS_MALLOC_SLAB)
+    ptr = os_malloc_slab_alloc(size);
+    if (ptr != NULL || !MYNEWT_VAL(OS_MALLOC_SLAB_FALLBACK)) {
+        return ptr;
+    }
+#endif
+
     os_malloc_lock();
     ptr = malloc(size);
     os_malloc_unlock();
@@ -65,6 +293,18 @@ os_malloc(size_t size)
 void
 os_free(void *mem)
 {
+#if MYNEWT_VAL(OS_MALLOC_SLAB)
+    struct os_malloc_slab *oms;
+    os_error_t err;
+
+    oms = os_malloc_slab_find(mem);
+    if (oms) {
+        err = os_memblock_put(&oms->oms_pool, mem);
+        assert(err == OS_OK);
+        return;
+    }
+#endif
+
     os_malloc_lock();
     free(mem);
     os_malloc_unlock();
@@ -74,6 +314,32 @@ void *
 os_realloc(void *ptr, size_t size)
 {
     void *new_ptr;
+#if MYNEWT_VAL(OS_MALLOC_SLAB)
+    struct os_malloc_slab *oms;
+
+    if (ptr == NULL) {
+        return os_malloc(size);
+    }
+
+    oms = os_malloc_slab_find(ptr);
+    if (oms) {
+        /* Same as realloc(ptr, 0): the block is freed. */
+        if (size == 0) {
+            os_free(ptr);
+            return NULL;
+        }
+        if (size <= oms->oms_block_size) {
+            return ptr;
+        }
+
+        new_ptr = os_malloc(size);
+        if (new_ptr) {
+            memcpy(new_ptr, ptr, oms->oms_block_size);
+            os_free(ptr);
+        }
+        return new_ptr;
+    }
+#endif
 
     os_malloc_lock();
     new_ptr = realloc(ptr, size);
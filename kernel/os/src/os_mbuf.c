@@ -119,6 +119,64 @@ os_mbuf_pool_init(struct os_mbuf_pool *omp, struct os_mempool *mp,
     return (0);
 }
 
+/*
+ * An mbuf that references an external buffer keeps the buffer descriptor in
+ * the last pointer-sized slot of its own, otherwise unused, data area.
+ */
+static struct os_mbuf_ext **
+os_mbuf_ext_slot(const struct os_mbuf *om)
+{
+    uint16_t off;
+
+    off = (om->om_omp->omp_databuf_len - sizeof(struct os_mbuf_ext *)) &
+          ~(sizeof(struct os_mbuf_ext *) - 1);
+
+    return (struct os_mbuf_ext **)(&om->om_databuf[0] + off);
+}
+
+static void
+os_mbuf_ext_ref(struct os_mbuf *om, struct os_mbuf_ext *ext)
+{
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    ext->ome_refcnt++;
+    OS_EXIT_CRITICAL(sr);
+
+    *os_mbuf_ext_slot(om) = ext;
+    om->om_flags |= OS_MBUF_F_MASK(OS_MBUF_F_EXT);
+}
+
+static void
+os_mbuf_ext_release(struct os_mbuf *om)
+{
+    struct os_mbuf_ext *ext;
+    uint16_t refcnt;
+    os_sr_t sr;
+
+    ext = *os_mbuf_ext_slot(om);
+
+    OS_ENTER_CRITICAL(sr);
+    assert(ext->ome_refcnt > 0);
+    refcnt = --ext->ome_refcnt;
+    OS_EXIT_CRITICAL(sr);
+
+    if (refcnt == 0 && ext->ome_free_cb != NULL) {
+        ext->ome_free_cb(ext);
+    }
+}
+
+void
+os_mbuf_ext_init(struct os_mbuf_ext *ext, void *buf, uint16_t len,
+                 os_mbuf_ext_free_fn *free_cb, void *arg)
+{
+    ext->ome_buf = buf;
+    ext->ome_len = len;
+    ext->ome_refcnt = 0;
+    ext->ome_free_cb = free_cb;
+    ext->ome_arg = arg;
+}
+
 struct os_mbuf *
 os_mbuf_get(struct os_mbuf_pool *omp, uint16_t leadingspace)
 {
@@ -149,6 +207,29 @@ done:
     return om;
 }
 
+struct os_mbuf *
+os_mbuf_get_ext(struct os_mbuf_pool *omp, struct os_mbuf_ext *ext,
+                uint16_t off, uint16_t len)
+{
+    struct os_mbuf *om;
+
+    if (off + len > ext->ome_len ||
+        omp->omp_databuf_len < sizeof(struct os_mbuf_ext *)) {
+        return NULL;
+    }
+
+    om = os_mbuf_get(omp, 0);
+    if (om == NULL) {
+        return NULL;
+    }
+
+    os_mbuf_ext_ref(om, ext);
+    om->om_data = ext->ome_buf + off;
+    om->om_len = len;
+
+    return om;
+}
+
 struct os_mbuf *
 os_mbuf_get_pkthdr(struct os_mbuf_pool *omp, uint8_t user_pkthdr_len)
 {
@@ -190,6 +271,10 @@ os_mbuf_free(struct os_mbuf *om)
     os_trace_api_u32(OS_TRACE_ID_MBUF_FREE, (uint32_t)om);
 
     if (om->om_omp != NULL) {
+        if (OS_MBUF_IS_EXT(om)) {
+            os_mbuf_ext_release(om);
+        }
+
         rc = os_memblock_put(om->om_omp->omp_pool, om);
         if (rc != 0) {
             goto done;
@@ -335,6 +420,36 @@ err:
     return (rc);
 }
 
+int
+os_mbuf_append_ext(struct os_mbuf *om, struct os_mbuf_ext *ext,
+                   uint16_t off, uint16_t len)
+{
+    struct os_mbuf *last;
+    struct os_mbuf *new;
+
+    if (om == NULL || ext == NULL || off + len > ext->ome_len) {
+        return OS_EINVAL;
+    }
+
+    new = os_mbuf_get_ext(om->om_omp, ext, off, len);
+    if (new == NULL) {
+        return OS_ENOMEM;
+    }
+
+    /* Scroll to last mbuf in the chain */
+    last = om;
+    while (SLIST_NEXT(last, om_next) != NULL) {
+        last = SLIST_NEXT(last, om_next);
+    }
+    SLIST_NEXT(last, om_next) = new;
+
+    if (OS_MBUF_IS_PKTHDR(om)) {
+        OS_MBUF_PKTHDR(om)->omp_len += len;
+    }
+
+    return 0;
+}
+
 int
 os_mbuf_appendfrom(struct os_mbuf *dst, const struct os_mbuf *src,
                    uint16_t src_off, uint16_t len)
@@ -399,8 +514,14 @@ os_mbuf_dup(struct os_mbuf *om)
         }
         copy->om_flags = om->om_flags;
         copy->om_len = om->om_len;
-        memcpy(OS_MBUF_DATA(copy, uint8_t *), OS_MBUF_DATA(om, uint8_t *),
-                om->om_len);
+        if (OS_MBUF_IS_EXT(om)) {
+            /* Share the external data instead of copying it. */
+            os_mbuf_ext_ref(copy, *os_mbuf_ext_slot(om));
+            copy->om_data = om->om_data;
+        } else {
+            memcpy(OS_MBUF_DATA(copy, uint8_t *), OS_MBUF_DATA(om, uint8_t *),
+                    om->om_len);
+        }
     }
 
     return (head);
@@ -25,6 +25,7 @@
 #define OS_TRACE_DISABLE_FILE_API
 #endif
 #include "os/mynewt.h"
+#include "os_priv.h"
 
 #define OS_MEM_TRUE_BLOCK_SIZE(bsize)   OS_ALIGN(bsize, OS_ALIGNMENT)
 #if MYNEWT_VAL(OS_MEMPOOL_GUARD)
@@ -36,7 +37,8 @@
 #define OS_MEMPOOL_TRUE_BLOCK_SIZE(mp) OS_MEM_TRUE_BLOCK_SIZE(mp->mp_block_size)
 #endif
 
-STAILQ_HEAD(, os_mempool) g_os_mempool_list;
+struct os_mempool_list g_os_mempool_list =
+    STAILQ_HEAD_INITIALIZER(g_os_mempool_list);
 
 #if MYNEWT_VAL(OS_MEMPOOL_POISON)
 static uint32_t os_mem_poison = 0xde7ec7ed;
@@ -114,6 +116,203 @@ os_mempool_guard_check(const struct os_mempool *mp, void *start)
 #define os_mempool_guard_check(mp, start)
 #endif
 
+#if MYNEWT_VAL(OS_MEMPOOL_CACHE)
+#define OS_MEMPOOL_CACHE_SIZE       MYNEWT_VAL(OS_MEMPOOL_CACHE_SIZE)
+#define OS_MEMPOOL_CACHE_BANDS      MYNEWT_VAL(OS_MEMPOOL_CACHE_BANDS)
+
+/* Keeps the compiler from moving magazine accesses across mm_busy updates. */
+#define OS_MEMPOOL_CACHE_BARRIER()  __asm__ volatile ("" ::: "memory")
+
+/*
+ * Claims the magazine of the current priority band.  An interrupt or a
+ * higher priority task of the same band that preempts the owner finds the
+ * magazine busy and falls back to the shared free list; since a preempting
+ * context always finishes before the preempted one resumes, the flag needs
+ * no atomic instructions.
+ *
+ * Returns NULL if the magazine is busy.
+ */
+static struct os_mempool_mag *
+os_mempool_mag_claim(struct os_mempool *mp)
+{
+    struct os_mempool_mag *mag;
+    struct os_task *t;
+    int band;
+
+    t = os_sched_get_current_task();
+    if (t) {
+        band = t->t_prio * OS_MEMPOOL_CACHE_BANDS / (UINT8_MAX + 1);
+    } else {
+        band = 0;
+    }
+
+    mag = &mp->mp_cache->mpc_mags[band];
+    if (mag->mm_busy) {
+        return NULL;
+    }
+    mag->mm_busy = 1;
+    OS_MEMPOOL_CACHE_BARRIER();
+
+    return mag;
+}
+
+static void
+os_mempool_mag_release(struct os_mempool_mag *mag)
+{
+    OS_MEMPOOL_CACHE_BARRIER();
+    mag->mm_busy = 0;
+}
+
+static int
+os_mempool_cache_cnt(const struct os_mempool *mp)
+{
+    int cnt;
+    int i;
+
+    cnt = 0;
+    for (i = 0; i < OS_MEMPOOL_CACHE_BANDS; i++) {
+        cnt += mp->mp_cache->mpc_mags[i].mm_cnt;
+    }
+
+    return cnt;
+}
+
+static void
+os_mempool_shared_push(struct os_mempool *mp, struct os_memblock *block)
+{
+    SLIST_NEXT(block, mb_next) = SLIST_FIRST(mp);
+    SLIST_FIRST(mp) = block;
+    mp->mp_num_free++;
+}
+
+static struct os_memblock *
+os_mempool_shared_pop(struct os_mempool *mp)
+{
+    struct os_memblock *block;
+
+    block = SLIST_FIRST(mp);
+    SLIST_FIRST(mp) = SLIST_NEXT(block, mb_next);
+    mp->mp_num_free--;
+
+    return block;
+}
+
+/*
+ * Moves the blocks of all idle magazines back to the shared free list.
+ * Must be called with interrupts disabled.
+ */
+static void
+os_mempool_cache_reclaim(struct os_mempool *mp)
+{
+    struct os_mempool_mag *mag;
+    int i;
+
+    for (i = 0; i < OS_MEMPOOL_CACHE_BANDS; i++) {
+        mag = &mp->mp_cache->mpc_mags[i];
+        if (mag->mm_busy) {
+            continue;
+        }
+        while (mag->mm_cnt > 0) {
+            os_mempool_shared_push(mp, mag->mm_blocks[--mag->mm_cnt]);
+        }
+    }
+}
+
+static struct os_memblock *
+os_mempool_cache_get(struct os_mempool *mp)
+{
+    struct os_mempool_mag *mag;
+    struct os_memblock *block;
+    uint16_t num_free;
+    os_sr_t sr;
+
+    mag = os_mempool_mag_claim(mp);
+    if (mag && mag->mm_cnt > 0) {
+        block = mag->mm_blocks[--mag->mm_cnt];
+        mag->mm_hits++;
+        os_mempool_mag_release(mag);
+        return block;
+    }
+
+    /* Miss; take a block and refill half of the magazine in one go. */
+    block = NULL;
+    OS_ENTER_CRITICAL(sr);
+    mp->mp_cache->mpc_misses++;
+    if (!mp->mp_num_free) {
+        os_mempool_cache_reclaim(mp);
+    }
+    if (mp->mp_num_free) {
+        block = os_mempool_shared_pop(mp);
+        while (mag && mp->mp_num_free &&
+               mag->mm_cnt < OS_MEMPOOL_CACHE_SIZE / 2) {
+            mag->mm_blocks[mag->mm_cnt++] = os_mempool_shared_pop(mp);
+        }
+
+        num_free = mp->mp_num_free + os_mempool_cache_cnt(mp);
+        if (mp->mp_min_free > num_free) {
+            mp->mp_min_free = num_free;
+        }
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    if (mag) {
+        os_mempool_mag_release(mag);
+    }
+
+    return block;
+}
+
+static void
+os_mempool_cache_put(struct os_mempool *mp, struct os_memblock *block)
+{
+    struct os_mempool_mag *mag;
+    os_sr_t sr;
+
+    mag = os_mempool_mag_claim(mp);
+    if (mag && mag->mm_cnt < OS_MEMPOOL_CACHE_SIZE) {
+        mag->mm_blocks[mag->mm_cnt++] = block;
+        mag->mm_hits++;
+        os_mempool_mag_release(mag);
+        return;
+    }
+
+    /* Miss; return half of the magazine to the shared free list. */
+    OS_ENTER_CRITICAL(sr);
+    mp->mp_cache->mpc_misses++;
+    if (mag) {
+        while (mag->mm_cnt > OS_MEMPOOL_CACHE_SIZE / 2) {
+            os_mempool_shared_push(mp, mag->mm_blocks[--mag->mm_cnt]);
+        }
+        mag->mm_blocks[mag->mm_cnt++] = block;
+    } else {
+        os_mempool_shared_push(mp, block);
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    if (mag) {
+        os_mempool_mag_release(mag);
+    }
+}
+
+os_error_t
+os_mempool_cache_enable(struct os_mempool *mp, struct os_mempool_cache *cache)
+{
+    os_sr_t sr;
+
+    if (!mp || !cache) {
+        return OS_INVALID_PARM;
+    }
+
+    memset(cache, 0, sizeof(*cache));
+
+    OS_ENTER_CRITICAL(sr);
+    mp->mp_cache = cache;
+    OS_EXIT_CRITICAL(sr);
+
+    return OS_OK;
+}
+#endif
+
 static os_error_t
 os_mempool_init_internal(struct os_mempool *mp, uint16_t blocks,
                          uint32_t block_size, void *membuf, char *name,
@@ -150,6 +349,9 @@ os_mempool_init_internal(struct os_mempool *mp, uint16_t blocks,
     mp->mp_num_blocks = blocks;
     mp->mp_membuf_addr = (uint32_t)membuf;
     mp->name = name;
+#if MYNEWT_VAL(OS_MEMPOOL_CACHE)
+    mp->mp_cache = NULL;
+#endif
     SLIST_FIRST(mp) = membuf;
 
     if (blocks > 0) {
@@ -247,6 +449,9 @@ os_mempool_clear(struct os_mempool *mp)
     int true_block_size;
     uint8_t *block_addr;
     uint16_t blocks;
+#if MYNEWT_VAL(OS_MEMPOOL_CACHE)
+    int i;
+#endif
 
     if (!mp) {
         return OS_INVALID_PARM;
@@ -254,6 +459,14 @@ os_mempool_clear(struct os_mempool *mp)
 
     true_block_size = OS_MEMPOOL_TRUE_BLOCK_SIZE(mp);
 
+#if MYNEWT_VAL(OS_MEMPOOL_CACHE)
+    if (mp->mp_cache) {
+        for (i = 0; i < OS_MEMPOOL_CACHE_BANDS; i++) {
+            mp->mp_cache->mpc_mags[i].mm_cnt = 0;
+        }
+    }
+#endif
+
     /* cleanup the memory pool structure */
     mp->mp_num_free = mp->mp_num_blocks;
     mp->mp_min_free = mp->mp_num_blocks;
@@ -285,6 +498,11 @@ bool
 os_mempool_is_sane(const struct os_mempool *mp)
 {
     struct os_memblock *block;
+#if MYNEWT_VAL(OS_MEMPOOL_CACHE)
+    const struct os_mempool_mag *mag;
+    int i;
+    int j;
+#endif
 
     /* Verify that each block in the free list belongs to the mempool. */
     SLIST_FOREACH(block, mp, mb_next) {
@@ -295,6 +513,21 @@ os_mempool_is_sane(const struct os_mempool *mp)
         os_mempool_guard_check(mp, block);
     }
 
+#if MYNEWT_VAL(OS_MEMPOOL_CACHE)
+    if (mp->mp_cache) {
+        for (i = 0; i < OS_MEMPOOL_CACHE_BANDS; i++) {
+            mag = &mp->mp_cache->mpc_mags[i];
+            for (j = 0; j < mag->mm_cnt; j++) {
+                if (!os_memblock_from(mp, mag->mm_blocks[j])) {
+                    return false;
+                }
+                os_mempool_poison_check(mp, mag->mm_blocks[j]);
+                os_mempool_guard_check(mp, mag->mm_blocks[j]);
+            }
+        }
+    }
+#endif
+
     return true;
 }
 
@@ -342,6 +575,12 @@ os_memblock_get(struct os_mempool *mp)
     /* Check to make sure they passed in a memory pool (or something) */
     block = NULL;
     if (mp) {
+#if MYNEWT_VAL(OS_MEMPOOL_CACHE)
+        if (mp->mp_cache) {
+            block = os_mempool_cache_get(mp);
+            goto check;
+        }
+#endif
         OS_ENTER_CRITICAL(sr);
         /* Check for any free */
         if (mp->mp_num_free) {
@@ -359,6 +598,9 @@ os_memblock_get(struct os_mempool *mp)
         }
         OS_EXIT_CRITICAL(sr);
 
+#if MYNEWT_VAL(OS_MEMPOOL_CACHE)
+check:
+#endif
         if (block) {
             os_mempool_poison_check(mp, block);
             os_mempool_guard_check(mp, block);
@@ -383,6 +625,14 @@ os_memblock_put_from_cb(struct os_mempool *mp, void *block_addr)
     os_mempool_poison(mp, block_addr);
 
     block = (struct os_memblock *)block_addr;
+
+#if MYNEWT_VAL(OS_MEMPOOL_CACHE)
+    if (mp->mp_cache) {
+        os_mempool_cache_put(mp, block);
+        goto done;
+    }
+#endif
+
     OS_ENTER_CRITICAL(sr);
 
     /* Chain current free list pointer to this block; make this block head */
@@ -395,6 +645,9 @@ os_memblock_put_from_cb(struct os_mempool *mp, void *block_addr)
 
     OS_EXIT_CRITICAL(sr);
 
+#if MYNEWT_VAL(OS_MEMPOOL_CACHE)
+done:
+#endif
     os_trace_api_ret_u32(OS_TRACE_ID_MEMBLOCK_PUT_FROM_CB, (uint32_t)OS_OK);
 
     return OS_OK;
@@ -407,6 +660,10 @@ os_memblock_put(struct os_mempool *mp, void *block_addr)
     os_error_t ret;
 #if MYNEWT_VAL(OS_MEMPOOL_CHECK)
     struct os_memblock *block;
+#if MYNEWT_VAL(OS_MEMPOOL_CACHE)
+    int i;
+    int j;
+#endif
 #endif
 
     os_trace_api_u32x2(OS_TRACE_ID_MEMBLOCK_PUT, (uint32_t)mp,
@@ -428,6 +685,15 @@ os_memblock_put(struct os_mempool *mp, void *block_addr)
     SLIST_FOREACH(block, mp, mb_next) {
         assert(block != (struct os_memblock *)block_addr);
     }
+#if MYNEWT_VAL(OS_MEMPOOL_CACHE)
+    if (mp->mp_cache) {
+        for (i = 0; i < OS_MEMPOOL_CACHE_BANDS; i++) {
+            for (j = 0; j < mp->mp_cache->mpc_mags[i].mm_cnt; j++) {
+                assert(mp->mp_cache->mpc_mags[i].mm_blocks[j] != block_addr);
+            }
+        }
+    }
+#endif
 #endif
     /* If this is an extended mempool with a put callback, call the callback
      * instead of freeing the block directly.
@@ -448,10 +714,25 @@ done:
     return ret;
 }
 
+int
+os_mempool_num_free(const struct os_mempool *mp)
+{
+#if MYNEWT_VAL(OS_MEMPOOL_CACHE)
+    if (mp->mp_cache) {
+        return mp->mp_num_free + os_mempool_cache_cnt(mp);
+    }
+#endif
+
+    return mp->mp_num_free;
+}
+
 struct os_mempool *
 os_mempool_info_get_next(struct os_mempool *mp, struct os_mempool_info *omi)
 {
     struct os_mempool *cur;
+#if MYNEWT_VAL(OS_MEMPOOL_CACHE)
+    int i;
+#endif
 
     if (mp == NULL) {
         cur = STAILQ_FIRST(&g_os_mempool_list);
@@ -465,8 +746,18 @@ os_mempool_info_get_next(struct os_mempool *mp, struct os_mempool_info *omi)
 
     omi->omi_block_size = cur->mp_block_size;
     omi->omi_num_blocks = cur->mp_num_blocks;
-    omi->omi_num_free = cur->mp_num_free;
+    omi->omi_num_free = os_mempool_num_free(cur);
     omi->omi_min_free = cur->mp_min_free;
+    omi->omi_cache_hits = 0;
+    omi->omi_cache_misses = 0;
+#if MYNEWT_VAL(OS_MEMPOOL_CACHE)
+    if (cur->mp_cache) {
+        for (i = 0; i < OS_MEMPOOL_CACHE_BANDS; i++) {
+            omi->omi_cache_hits += cur->mp_cache->mpc_mags[i].mm_hits;
+        }
+        omi->omi_cache_misses = cur->mp_cache->mpc_misses;
+    }
+#endif
     omi->omi_name[0] = '\0';
     strncat(omi->omi_name, cur->name, sizeof(omi->omi_name) - 1);
 
@@ -34,6 +34,9 @@ static STAILQ_HEAD(, os_mbuf_pool) g_msys_pool_list =
 static os_membuf_t os_msys_1_data[SYSINIT_MSYS_1_MEMPOOL_SIZE];
 static struct os_mbuf_pool os_msys_1_mbuf_pool;
 static struct os_mempool os_msys_1_mempool;
+#if MYNEWT_VAL(MSYS_MEMPOOL_CACHE)
+static struct os_mempool_cache os_msys_1_cache;
+#endif
 #endif
 
 #if MYNEWT_VAL(MSYS_2_BLOCK_COUNT) > 0
@@ -45,6 +48,9 @@ static struct os_mempool os_msys_1_mempool;
 static os_membuf_t os_msys_2_data[SYSINIT_MSYS_2_MEMPOOL_SIZE];
 static struct os_mbuf_pool os_msys_2_mbuf_pool;
 static struct os_mempool os_msys_2_mempool;
+#if MYNEWT_VAL(MSYS_MEMPOOL_CACHE)
+static struct os_mempool_cache os_msys_2_cache;
+#endif
 #endif
 
 #define OS_MSYS_SANITY_ENABLED                  \
@@ -188,7 +194,7 @@ os_msys_num_free(void)
 
     total = 0;
     STAILQ_FOREACH(omp, &g_msys_pool_list, omp_next) {
-        total += omp->omp_pool->mp_num_free;
+        total += os_mempool_num_free(omp->omp_pool);
     }
 
     return total;
@@ -231,7 +237,7 @@ os_msys_sanity(struct os_sanity_check *sc, void *arg)
     idx = 0;
     STAILQ_FOREACH(omp, &g_msys_pool_list, omp_next) {
         min_count = os_msys_sanity_min_count(idx);
-        if (omp->omp_pool->mp_num_free < min_count) {
+        if (os_mempool_num_free(omp->omp_pool) < min_count) {
             return OS_ENOMEM;
         }
 
@@ -274,6 +280,10 @@ os_msys_init(void)
                       MYNEWT_VAL(MSYS_1_BLOCK_COUNT),
                       SYSINIT_MSYS_1_MEMBLOCK_SIZE,
                       "msys_1");
+#if MYNEWT_VAL(MSYS_MEMPOOL_CACHE)
+    rc = os_mempool_cache_enable(&os_msys_1_mempool, &os_msys_1_cache);
+    SYSINIT_PANIC_ASSERT(rc == 0);
+#endif
 #endif
 
 #if MYNEWT_VAL(MSYS_2_BLOCK_COUNT) > 0
@@ -283,6 +293,10 @@ os_msys_init(void)
                       MYNEWT_VAL(MSYS_2_BLOCK_COUNT),
                       SYSINIT_MSYS_2_MEMBLOCK_SIZE,
                       "msys_2");
+#if MYNEWT_VAL(MSYS_MEMPOOL_CACHE)
+    rc = os_mempool_cache_enable(&os_msys_2_mempool, &os_msys_2_cache);
+    SYSINIT_PANIC_ASSERT(rc == 0);
+#endif
 #endif
 
 #if OS_MSYS_SANITY_ENABLED
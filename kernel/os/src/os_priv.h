@@ -37,7 +37,12 @@ extern struct os_task_list g_os_sleep_list;
 extern struct os_task_stailq g_os_task_list;
 extern struct os_callout_list g_callout_list;
 
+STAILQ_HEAD(os_mempool_list, os_mempool);
+extern struct os_mempool_list g_os_mempool_list;
+
+void os_callout_module_init(void);
 void os_mempool_module_init(void);
+void os_malloc_module_init(void);
 void os_msys_init(void);
 
 /**
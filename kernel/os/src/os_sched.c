@@ -18,6 +18,7 @@
  */
 
 #include <assert.h>
+#include <string.h>
 #include "os/mynewt.h"
 #include "os_priv.h"
 
@@ -29,6 +30,138 @@ struct os_task *g_current_task;
 extern os_time_t g_os_time;
 os_time_t g_os_last_ctx_sw_time;
 
+#if MYNEWT_VAL(OS_SCHED_PRIO_BITMAP)
+#define OS_SCHED_NUM_PRIOS      (UINT8_MAX + 1)
+#define OS_SCHED_PRIO_WORDS     (OS_SCHED_NUM_PRIOS / 32)
+
+/*
+ * Bit (p % 32) of word (p / 32) in os_sched_prio_map is set when the run list
+ * holds at least one task of priority p.  Bit n of os_sched_prio_grp is set
+ * when word n of the map is non-zero.  os_sched_prio_tail[p] is the last task
+ * of priority p in the run list, so tasks of equal priority stay in FIFO
+ * order and a new task is linked right after it.
+ */
+static uint32_t os_sched_prio_grp;
+static uint32_t os_sched_prio_map[OS_SCHED_PRIO_WORDS];
+static struct os_task *os_sched_prio_tail[OS_SCHED_NUM_PRIOS];
+
+/*
+ * Returns the numerically largest priority lower than 'prio' that has a task
+ * in the run list, or -1 if there is none.
+ */
+static int
+os_sched_prio_prev(uint8_t prio)
+{
+    uint32_t word;
+    uint32_t grp;
+    int idx;
+
+    idx = prio / 32;
+    word = os_sched_prio_map[idx] & ((1UL << (prio % 32)) - 1);
+    if (word) {
+        return idx * 32 + 31 - __builtin_clz(word);
+    }
+
+    grp = os_sched_prio_grp & ((1UL << idx) - 1);
+    if (!grp) {
+        return -1;
+    }
+    idx = 31 - __builtin_clz(grp);
+
+    return idx * 32 + 31 - __builtin_clz(os_sched_prio_map[idx]);
+}
+
+static void
+os_sched_run_list_insert(struct os_task *t)
+{
+    struct os_task *prev;
+    int prio;
+
+    prev = os_sched_prio_tail[t->t_prio];
+    if (!prev) {
+        prio = os_sched_prio_prev(t->t_prio);
+        if (prio >= 0) {
+            prev = os_sched_prio_tail[prio];
+        }
+        os_sched_prio_map[t->t_prio / 32] |= 1UL << (t->t_prio % 32);
+        os_sched_prio_grp |= 1UL << (t->t_prio / 32);
+    }
+    if (prev) {
+        TAILQ_INSERT_AFTER(&g_os_run_list, prev, t, t_os_list);
+    } else {
+        TAILQ_INSERT_HEAD(&g_os_run_list, t, t_os_list);
+    }
+    os_sched_prio_tail[t->t_prio] = t;
+    t->t_run_prio = t->t_prio;
+}
+
+/*
+ * Unlinks a task from the run list.  Uses the priority the task was queued
+ * with, as os_sched_resort() is called after t_prio has been changed.
+ */
+static void
+os_sched_run_list_remove(struct os_task *t)
+{
+    struct os_task *prev;
+    uint8_t prio;
+
+    prio = t->t_run_prio;
+    if (os_sched_prio_tail[prio] == t) {
+        prev = TAILQ_PREV(t, os_task_list, t_os_list);
+        if (prev && prev->t_run_prio == prio) {
+            os_sched_prio_tail[prio] = prev;
+        } else {
+            os_sched_prio_tail[prio] = NULL;
+            os_sched_prio_map[prio / 32] &= ~(1UL << (prio % 32));
+            if (!os_sched_prio_map[prio / 32]) {
+                os_sched_prio_grp &= ~(1UL << (prio / 32));
+            }
+        }
+    }
+    TAILQ_REMOVE(&g_os_run_list, t, t_os_list);
+}
+#else
+static void
+os_sched_run_list_insert(struct os_task *t)
+{
+    struct os_task *entry;
+
+    TAILQ_FOREACH(entry, &g_os_run_list, t_os_list) {
+        if (t->t_prio < entry->t_prio) {
+            break;
+        }
+    }
+    if (entry) {
+        TAILQ_INSERT_BEFORE(entry, t, t_os_list);
+    } else {
+        TAILQ_INSERT_TAIL(&g_os_run_list, t, t_os_list);
+    }
+}
+
+static void
+os_sched_run_list_remove(struct os_task *t)
+{
+    TAILQ_REMOVE(&g_os_run_list, t, t_os_list);
+}
+#endif
+
+/**
+ * os sched run list init
+ *
+ * Empties the run list.  Only needed when the OS is re-initialized, as
+ * happens on sim between test cases.
+ */
+void
+os_sched_run_list_init(void)
+{
+    TAILQ_INIT(&g_os_run_list);
+#if MYNEWT_VAL(OS_SCHED_PRIO_BITMAP)
+    os_sched_prio_grp = 0;
+    memset(os_sched_prio_map, 0, sizeof(os_sched_prio_map));
+    memset(os_sched_prio_tail, 0, sizeof(os_sched_prio_tail));
+#endif
+}
+
 /**
  * os sched insert
  *
@@ -43,7 +176,6 @@ os_time_t g_os_last_ctx_sw_time;
 os_error_t
 os_sched_insert(struct os_task *t)
 {
-    struct os_task *entry;
     os_sr_t sr;
     os_error_t rc;
 
@@ -52,18 +184,8 @@ os_sched_insert(struct os_task *t)
         goto err;
     }
 
-    entry = NULL;
     OS_ENTER_CRITICAL(sr);
-    TAILQ_FOREACH(entry, &g_os_run_list, t_os_list) {
-        if (t->t_prio < entry->t_prio) {
-            break;
-        }
-    }
-    if (entry) {
-        TAILQ_INSERT_BEFORE(entry, (struct os_task *) t, t_os_list);
-    } else {
-        TAILQ_INSERT_TAIL(&g_os_run_list, (struct os_task *) t, t_os_list);
-    }
+    os_sched_run_list_insert(t);
     OS_EXIT_CRITICAL(sr);
 
     return (0);
@@ -152,7 +274,7 @@ os_sched_sleep(struct os_task *t, os_time_t nticks)
 
     entry = NULL;
 
-    TAILQ_REMOVE(&g_os_run_list, t, t_os_list);
+    os_sched_run_list_remove(t);
     t->t_state = OS_TASK_SLEEP;
     t->t_next_wakeup = os_time_get() + nticks;
     if (nticks == OS_TIMEOUT_NEVER) {
@@ -196,7 +318,7 @@ os_sched_remove(struct os_task *t)
     if (t->t_state == OS_TASK_SLEEP) {
         TAILQ_REMOVE(&g_os_sleep_list, t, t_os_list);
     } else if (t->t_state == OS_TASK_READY) {
-        TAILQ_REMOVE(&g_os_run_list, t, t_os_list);
+        os_sched_run_list_remove(t);
     }
     t->t_next_wakeup = 0;
     t->t_flags |= OS_TASK_FLAG_NO_TIMEOUT;
@@ -346,7 +468,7 @@ void
 os_sched_resort(struct os_task *t)
 {
     if (t->t_state == OS_TASK_READY) {
-        TAILQ_REMOVE(&g_os_run_list, t, t_os_list);
+        os_sched_run_list_remove(t);
         os_sched_insert(t);
     }
 }
@@ -48,6 +48,19 @@ void sim_restore_sr(os_sr_t osr);
 int sim_in_critical(void);
 void sim_tick_idle(os_time_t ticks);
 
+/*
+ * Profiling: calls fn with the interrupted PC (and LR, where the host CPU
+ * has one) freq_hz times per second of CPU time, from a SIGPROF handler
+ * which runs like an interrupt handler.  Only supported with
+ * MCU_NATIVE_USE_SIGNALS.  Many host kernels limit the rate to their own
+ * tick rate.  sim_prof_start() returns SYS_EINVAL for a rate of 0 or above
+ * 1 MHz, SYS_ENOTSUP without signals and SYS_EUNKNOWN if the host refuses
+ * the timer.
+ */
+typedef void sim_prof_fn(uintptr_t pc, uintptr_t lr);
+int sim_prof_start(uint32_t freq_hz, sim_prof_fn *fn);
+void sim_prof_stop(void);
+
 /**
  * Prints information about a crash to stdout.  This functionality is defined
  * as a macro rather than a function to ensure that it gets inlined, enforcing
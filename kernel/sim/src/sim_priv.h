@@ -33,6 +33,7 @@ void sim_switch_tasks(void);
 void sim_tick(void);
 void sim_signals_init(void);
 void sim_signals_cleanup(void);
+uintptr_t sim_prof_pc(const void *ucontext, uintptr_t *lr);
 
 extern pid_t sim_pid;
 
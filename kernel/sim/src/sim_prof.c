@@ -0,0 +1,71 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/* Needed for the register names in ucontext_t */
+#ifdef __APPLE__
+#define _XOPEN_SOURCE
+#else
+#define _GNU_SOURCE
+#endif
+
+#include <stdint.h>
+#include <signal.h>
+#include <ucontext.h>
+
+#include "os/mynewt.h"
+
+#if MYNEWT_VAL(MCU_NATIVE_USE_SIGNALS)
+
+#include "sim_priv.h"
+
+/**
+ * Extracts the interrupted program counter, and link register if the host
+ * CPU has one, from the context passed to a SA_SIGINFO signal handler.
+ * Returns 0 on hosts this doesn't know about.
+ */
+uintptr_t
+sim_prof_pc(const void *ucontext, uintptr_t *lr)
+{
+    const ucontext_t *uc;
+
+    uc = ucontext;
+    *lr = 0;
+
+#if defined(__linux__) && defined(__x86_64__)
+    return uc->uc_mcontext.gregs[REG_RIP];
+#elif defined(__linux__) && defined(__i386__)
+    return uc->uc_mcontext.gregs[REG_EIP];
+#elif defined(__linux__) && defined(__arm__)
+    *lr = uc->uc_mcontext.arm_lr;
+    return uc->uc_mcontext.arm_pc;
+#elif defined(__linux__) && defined(__aarch64__)
+    *lr = uc->uc_mcontext.regs[30];
+    return uc->uc_mcontext.pc;
+#elif defined(__APPLE__) && defined(__x86_64__)
+    return uc->uc_mcontext->__ss.__rip;
+#elif defined(__APPLE__) && defined(__aarch64__)
+    *lr = uc->uc_mcontext->__ss.__lr;
+    return uc->uc_mcontext->__ss.__pc;
+#else
+    (void)uc;
+    return 0;
+#endif
+}
+
+#endif /* MYNEWT_VAL(MCU_NATIVE_USE_SIGNALS) */
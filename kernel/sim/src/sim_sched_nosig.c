@@ -48,6 +48,7 @@
 #include <sys/time.h>
 #include <assert.h>
 #include "sim_priv.h"
+#include "sim/sim.h"
 
 static sigset_t nosigs;
 static sigset_t suspsigs;   /* signals delivered in sigsuspend() */
@@ -201,6 +202,21 @@ sim_tick_idle(os_time_t ticks)
     }
 }
 
+int
+sim_prof_start(uint32_t freq_hz, sim_prof_fn *fn)
+{
+    /*
+     * Critical sections don't block signals in this version of sim, so a
+     * SIGPROF handler could not safely call into the OS.
+     */
+    return SYS_ENOTSUP;
+}
+
+void
+sim_prof_stop(void)
+{
+}
+
 void
 sim_signals_init(void)
 {
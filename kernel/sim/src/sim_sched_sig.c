@@ -34,6 +34,7 @@
 #if MYNEWT_VAL(MCU_NATIVE_USE_SIGNALS)
 
 #include "sim_priv.h"
+#include "sim/sim.h"
 
 #include <hal/hal_bsp.h>
 
@@ -53,6 +54,7 @@ static bool suspended;      /* process is blocked in sigsuspend() */
 static sigset_t suspsigs;   /* signals delivered in sigsuspend() */
 static sigset_t allsigs;
 static sigset_t nosigs;
+static sim_prof_fn *prof_fn;
 
 void
 sim_ctx_sw(struct os_task *next_t)
@@ -152,6 +154,86 @@ timer_handler(int sig)
     }
 }
 
+static void
+prof_handler(int sig, siginfo_t *si, void *uc)
+{
+    sim_prof_fn *fn;
+    uintptr_t pc;
+    uintptr_t lr;
+
+    OS_ASSERT_CRITICAL();
+
+    /*
+     * A sample delivered in sigsuspend() was pending while the idle task
+     * was in its critical section; there is nothing useful to attribute it
+     * to.
+     */
+    fn = prof_fn;
+    if (suspended || fn == NULL) {
+        return;
+    }
+
+    pc = sim_prof_pc(uc, &lr);
+    fn(pc, lr);
+}
+
+int
+sim_prof_start(uint32_t freq_hz, sim_prof_fn *fn)
+{
+    struct itimerval it;
+    struct sigaction sa;
+    struct sigaction old_sa;
+    uint32_t period_us;
+    int rc;
+
+    if (freq_hz == 0 || freq_hz > 1000000) {
+        return SYS_EINVAL;
+    }
+
+    prof_fn = fn;
+
+    /*
+     * SIGPROF is part of 'allsigs', so like the other signals it is held
+     * off while in a critical section.
+     */
+    memset(&sa, 0, sizeof sa);
+    sa.sa_sigaction = prof_handler;
+    sa.sa_mask = allsigs;
+    sa.sa_flags = SA_RESTART | SA_SIGINFO;
+    rc = sigaction(SIGPROF, &sa, &old_sa);
+    if (rc != 0) {
+        prof_fn = NULL;
+        return SYS_EUNKNOWN;
+    }
+
+    /* tv_usec must stay below a second, e.g. for freq_hz == 1 */
+    period_us = 1000000 / freq_hz;
+    it.it_value.tv_sec = period_us / 1000000;
+    it.it_value.tv_usec = period_us % 1000000;
+    it.it_interval = it.it_value;
+    rc = setitimer(ITIMER_PROF, &it, NULL);
+    if (rc != 0) {
+        sigaction(SIGPROF, &old_sa, NULL);
+        prof_fn = NULL;
+        return SYS_EUNKNOWN;
+    }
+
+    return 0;
+}
+
+void
+sim_prof_stop(void)
+{
+    struct itimerval it;
+    int rc;
+
+    memset(&it, 0, sizeof it);
+    rc = setitimer(ITIMER_PROF, &it, NULL);
+    assert(rc == 0);
+
+    prof_fn = NULL;
+}
+
 static struct {
     int num;
     void (*handler)(int sig);
@@ -229,6 +311,8 @@ sim_signals_init(void)
     for (i = 0; i < NUMSIGS; i++) {
         sigaddset(&allsigs, signals[i].num);
     }
+    /* The handler is only installed by sim_prof_start() */
+    sigaddset(&allsigs, SIGPROF);
 
     for (i = 0; i < NUMSIGS; i++) {
         memset(&sa, 0, sizeof sa);
@@ -253,6 +337,14 @@ sim_signals_cleanup(void)
     int i, error;
     struct sigaction sa;
 
+    if (prof_fn != NULL) {
+        sim_prof_stop();
+        memset(&sa, 0, sizeof sa);
+        sa.sa_handler = SIG_DFL;
+        error = sigaction(SIGPROF, &sa, NULL);
+        assert(error == 0);
+    }
+
     for (i = 0; i < NUMSIGS; i++) {
         memset(&sa, 0, sizeof sa);
         sa.sa_handler = SIG_DFL;
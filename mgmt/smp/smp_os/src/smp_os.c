@@ -125,6 +125,12 @@ smp_def_mpstat_read(struct mgmt_ctxt *cb)
         g_err |= cbor_encode_uint(&pool, omi.omi_num_free);
         g_err |= cbor_encode_text_stringz(&pool, "min");
         g_err |= cbor_encode_uint(&pool, omi.omi_min_free);
+#if MYNEWT_VAL(OS_MEMPOOL_CACHE)
+        g_err |= cbor_encode_text_stringz(&pool, "chits");
+        g_err |= cbor_encode_uint(&pool, omi.omi_cache_hits);
+        g_err |= cbor_encode_text_stringz(&pool, "cmiss");
+        g_err |= cbor_encode_uint(&pool, omi.omi_cache_misses);
+#endif
         g_err |= cbor_encoder_close_container(&pools, &pool);
     }
 
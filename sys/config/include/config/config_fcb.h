@@ -20,6 +20,7 @@
 #define __SYS_CONFIG_FCB_H_
 
 #include <fcb/fcb.h>
+#include <os/os_eventq.h>
 
 #include "config/config.h"
 #include "config/config_store.h"
@@ -28,9 +29,37 @@
 extern "C" {
 #endif
 
+#if MYNEWT_VAL(CONFIG_FCB_INDEX)
+/*
+ * Location of the latest record for one config name.
+ */
+struct conf_fcb_idx_ent {
+    uint32_t cie_hash;          /* hash of the name */
+    uint32_t cie_data_off;      /* start of record data within area */
+    uint16_t cie_data_len;      /* length of record data */
+    uint8_t cie_area;           /* index into f_sectors, 0xff if unused */
+};
+
+/*
+ * Open addressed hash table from config name to its latest record in
+ * the FCB.  Built on first use, kept up to date by saves and compression.
+ */
+struct conf_fcb_idx {
+    struct conf_fcb_idx_ent ci_ents[MYNEWT_VAL(CONFIG_FCB_INDEX_SIZE)];
+    uint16_t ci_cnt;            /* number of used entries */
+    uint8_t ci_state;           /* not built, valid or overflowed */
+};
+#endif
+
 struct conf_fcb {
     struct conf_store cf_store;
     struct fcb cf_fcb;
+#if MYNEWT_VAL(CONFIG_FCB_INDEX)
+    struct conf_fcb_idx cf_idx;
+#endif
+#if MYNEWT_VAL(CONFIG_FCB_COMPACT_BG)
+    struct os_event cf_compact_ev;
+#endif
 };
 
 /**
@@ -67,6 +96,19 @@ void conf_fcb_compress(struct conf_fcb *cf,
                                           void *con_arg),
                        void *con_arg);
 
+/**
+ * Compress the oldest sector if the FCB is about to run out of space and,
+ * when the index is enabled, enough of that sector is stale.
+ * Only the latest value of each name is copied forward.  This is what
+ * saves do when they find no room; calling it ahead of time keeps that
+ * work off the save path.
+ *
+ * @param cf FCB source to compact.
+ *
+ * @return 1 if a sector was compressed, 0 if there was no need.
+ */
+int conf_fcb_compact(struct conf_fcb *cf);
+
 #ifdef __cplusplus
 }
 #endif
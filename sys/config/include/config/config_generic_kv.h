@@ -44,6 +44,9 @@ extern "C" {
  *
  * The returned value is always null-terminated.
  *
+ * If the FCB backs a registered config FCB store, its index is used when
+ * CONFIG_FCB_INDEX is enabled.
+ *
  * @param fcb    FCB with kv store
  * @param name   Key name to load
  * @param value  Buffer to store value
@@ -62,7 +65,8 @@ int conf_fcb2_kv_load(struct fcb2 *, const char *name, char *value, size_t len);
  * Store value for given key to FCB key-value storage area
  *
  * This stores new value for given key to FCB key-value storage area.
- * The FCB kv store can be any FCB provided by application.
+ * The FCB kv store can be any FCB provided by application.  If it backs a
+ * registered config FCB store, that store's index is kept up to date.
  *
  * @param fcb    FCB with kv store
  * @param name   Key name to store
@@ -42,6 +42,13 @@ struct conf_store_itf {
     int (*csi_save_start)(struct conf_store *cs);
     int (*csi_save)(struct conf_store *cs, const char *name, const char *value);
     int (*csi_save_end)(struct conf_store *cs);
+    /*
+     * Optional.  Calls cb for the latest stored value of the given name
+     * only.  Stores which can look up a single name without reading
+     * everything provide this; otherwise csi_load is used.
+     */
+    int (*csi_load_one)(struct conf_store *cs, const char *name,
+                        conf_store_load_cb cb, void *cb_arg);
 };
 
 struct conf_store {
@@ -0,0 +1,189 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "conf_test_fcb/conf_test_fcb.h"
+
+#if MYNEWT_VAL(CONFIG_FCB_INDEX)
+
+#define CONF_TEST_IDX_NAMES     12
+
+static void
+config_test_idx_name(int i, char *name)
+{
+    sprintf(name, "cfidx/key%d", i);
+}
+
+static void
+config_test_idx_val(int i, int iter, char *val)
+{
+    /* Vary the length so that records move around within sectors. */
+    sprintf(val, "%d-%.*s", iter, (i * 7 + iter) % 40,
+            "0123456789012345678901234567890123456789");
+}
+
+static void
+config_test_idx_init(struct conf_fcb *cf, int wipe)
+{
+    int rc;
+
+    config_wipe_srcs();
+    if (wipe) {
+        config_wipe_fcb(fcb_areas, sizeof(fcb_areas) / sizeof(fcb_areas[0]));
+    }
+    memset(cf, 0, sizeof(*cf));
+    cf->cf_fcb.f_magic = MYNEWT_VAL(CONFIG_FCB_MAGIC);
+    cf->cf_fcb.f_sectors = fcb_areas;
+    cf->cf_fcb.f_sector_cnt = sizeof(fcb_areas) / sizeof(fcb_areas[0]);
+
+    rc = conf_fcb_src(cf);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    rc = conf_fcb_dst(cf);
+    TEST_ASSERT_FATAL(rc == 0);
+}
+
+/*
+ * Both the config store and the kv helper must return the latest value.
+ */
+static void
+config_test_idx_check(struct conf_fcb *cf, int iter)
+{
+    char name[32];
+    char exp[CONF_MAX_VAL_LEN];
+    char val[CONF_MAX_VAL_LEN];
+    char kv_val[CONF_MAX_VAL_LEN];
+    int rc;
+    int i;
+
+    for (i = 0; i < CONF_TEST_IDX_NAMES; i++) {
+        config_test_idx_name(i, name);
+        config_test_idx_val(i, iter, exp);
+
+        rc = conf_get_stored_value(name, val, sizeof(val));
+        TEST_ASSERT_FATAL(rc == 0);
+        TEST_ASSERT(!strcmp(val, exp));
+
+        kv_val[0] = '\0';
+        rc = conf_fcb_kv_load(&cf->cf_fcb, name, kv_val, sizeof(kv_val));
+        TEST_ASSERT(rc == 0);
+        TEST_ASSERT(!strcmp(kv_val, exp));
+    }
+}
+
+TEST_CASE_SELF(config_test_fcb_index)
+{
+    struct conf_fcb cf;
+    char name[32];
+    char val[CONF_MAX_VAL_LEN];
+    int rc;
+    int iter;
+    int i;
+
+    config_test_idx_init(&cf, 1);
+
+    rc = conf_get_stored_value("cfidx/key0", val, sizeof(val));
+    TEST_ASSERT(rc == OS_ENOENT);
+
+    /*
+     * Overwrite the same names until the FCB has been compressed several
+     * times.
+     */
+    for (iter = 0; iter < 400; iter++) {
+        for (i = 0; i < CONF_TEST_IDX_NAMES; i++) {
+            config_test_idx_name(i, name);
+            config_test_idx_val(i, iter, val);
+            rc = conf_save_one(name, val);
+            TEST_ASSERT_FATAL(rc == 0);
+        }
+        if (iter % 50 == 0) {
+            config_test_idx_check(&cf, iter);
+        }
+    }
+    iter--;
+    config_test_idx_check(&cf, iter);
+    TEST_ASSERT(cf.cf_idx.ci_cnt == CONF_TEST_IDX_NAMES);
+
+    /*
+     * Saving the same value again is not written.
+     */
+    config_test_idx_name(3, name);
+    config_test_idx_val(3, iter, val);
+    i = cf.cf_fcb.f_active.fe_elem_off;
+    rc = conf_save_one(name, val);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(cf.cf_fcb.f_active.fe_elem_off == i);
+
+    /*
+     * Deleted value.
+     */
+    rc = conf_save_one("cfidx/key5", NULL);
+    TEST_ASSERT(rc == 0);
+    rc = conf_get_stored_value("cfidx/key5", val, sizeof(val));
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(val[0] == '\0');
+
+    /*
+     * Index is rebuilt from flash after restart.
+     */
+    config_test_idx_init(&cf, 0);
+    rc = conf_get_stored_value("cfidx/key5", val, sizeof(val));
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(val[0] == '\0');
+    config_test_idx_name(5, name);
+    config_test_idx_val(5, iter, val);
+    rc = conf_save_one(name, val);
+    TEST_ASSERT(rc == 0);
+    config_test_idx_check(&cf, iter);
+
+    /*
+     * Compact ahead of time; values survive.
+     */
+    for (i = 0; i < 1000 && !conf_fcb_compact(&cf); i++) {
+        config_test_idx_name(0, name);
+        config_test_idx_val(0, i, val);
+        rc = conf_save_one(name, val);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+    TEST_ASSERT(i < 1000);
+    TEST_ASSERT(fcb_free_sector_cnt(&cf.cf_fcb) == 1);
+    config_test_idx_name(0, name);
+    config_test_idx_val(0, iter, val);
+    rc = conf_save_one(name, val);
+    TEST_ASSERT(rc == 0);
+    config_test_idx_check(&cf, iter);
+
+    /*
+     * Saves through the kv helper keep the index current, including across
+     * the compressions they trigger.
+     */
+    for (iter = 0; iter < 100; iter++) {
+        for (i = 0; i < CONF_TEST_IDX_NAMES; i++) {
+            config_test_idx_name(i, name);
+            config_test_idx_val(i, iter, val);
+            rc = conf_fcb_kv_save(&cf.cf_fcb, name, val);
+            TEST_ASSERT_FATAL(rc == 0);
+        }
+        if (iter % 25 == 0) {
+            config_test_idx_check(&cf, iter);
+        }
+    }
+    iter--;
+    config_test_idx_check(&cf, iter);
+}
+
+#endif
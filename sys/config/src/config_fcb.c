@@ -32,6 +32,18 @@
 
 #define CONF_FCB_VERS		1
 
+#define CONF_FCB_BUF_LEN        (CONF_MAX_NAME_LEN + CONF_MAX_VAL_LEN + 32)
+
+#if MYNEWT_VAL(CONFIG_FCB_INDEX)
+#define CONF_FCB_IDX_SIZE       MYNEWT_VAL(CONFIG_FCB_INDEX_SIZE)
+
+#define CONF_FCB_IDX_NONE       0   /* not built yet */
+#define CONF_FCB_IDX_VALID      1
+#define CONF_FCB_IDX_OVERFLOW   2   /* more names than entries */
+
+#define CONF_FCB_IDX_FREE       0xff
+#endif
+
 struct conf_fcb_load_cb_arg {
     conf_store_load_cb cb;
     void *cb_arg;
@@ -47,12 +59,331 @@ static int conf_fcb_load(struct conf_store *, conf_store_load_cb cb,
                          void *cb_arg);
 static int conf_fcb_save(struct conf_store *, const char *name,
                          const char *value);
+#if MYNEWT_VAL(CONFIG_FCB_INDEX)
+static int conf_fcb_load_one(struct conf_store *, const char *name,
+                             conf_store_load_cb cb, void *cb_arg);
+#endif
 
 static struct conf_store_itf conf_fcb_itf = {
     .csi_load = conf_fcb_load,
     .csi_save = conf_fcb_save,
+#if MYNEWT_VAL(CONFIG_FCB_INDEX)
+    .csi_load_one = conf_fcb_load_one,
+#endif
 };
 
+#if MYNEWT_VAL(CONFIG_FCB_INDEX)
+#define CONF_FCB_IDX(cf)        (&(cf)->cf_idx)
+#else
+#define CONF_FCB_IDX(cf)        NULL
+struct conf_fcb_idx;
+#endif
+
+static int conf_fcb_var_read(struct fcb_entry *loc, char *buf, char **name,
+                             char **val);
+
+static int conf_fcb_compact_needed(struct conf_fcb *cf);
+#if MYNEWT_VAL(CONFIG_FCB_COMPACT_BG)
+static void conf_fcb_compact_ev(struct os_event *ev);
+#endif
+
+#if MYNEWT_VAL(CONFIG_FCB_INDEX)
+
+/*
+ * FNV-1a.
+ */
+static uint32_t
+conf_fcb_idx_hash(const char *name)
+{
+    uint32_t hash;
+
+    hash = 2166136261;
+    while (*name) {
+        hash ^= (uint8_t)*name++;
+        hash *= 16777619;
+    }
+    return hash;
+}
+
+static void
+conf_fcb_idx_loc(struct fcb *fcb, const struct conf_fcb_idx_ent *ent,
+                 struct fcb_entry *loc)
+{
+    loc->fe_area = &fcb->f_sectors[ent->cie_area];
+    loc->fe_elem_off = 0;
+    loc->fe_data_off = ent->cie_data_off;
+    loc->fe_data_len = ent->cie_data_len;
+}
+
+/*
+ * Does the record behind an entry belong to name?  Records are written by
+ * conf_line_make(), so it is enough to check for "<name>=" at the start.
+ */
+static int
+conf_fcb_idx_match(struct fcb *fcb, const struct conf_fcb_idx_ent *ent,
+                   const char *name, int nlen)
+{
+    struct flash_area *fa;
+    char buf[16];
+    uint32_t off;
+    int blen;
+    int rc;
+
+    if (nlen >= ent->cie_data_len) {
+        return 0;
+    }
+    fa = &fcb->f_sectors[ent->cie_area];
+    off = ent->cie_data_off;
+    while (nlen >= 0) {
+        blen = min(nlen + 1, (int)sizeof(buf));
+        rc = flash_area_read(fa, off, buf, blen);
+        if (rc) {
+            return 0;
+        }
+        if (blen > nlen) {
+            if (memcmp(buf, name, nlen) || buf[nlen] != '=') {
+                return 0;
+            }
+            return 1;
+        }
+        if (memcmp(buf, name, blen)) {
+            return 0;
+        }
+        name += blen;
+        nlen -= blen;
+        off += blen;
+    }
+    return 0;
+}
+
+/*
+ * Find the entry for name.  If it's not there and freep is given, return
+ * the free slot where it would go.
+ */
+static struct conf_fcb_idx_ent *
+conf_fcb_idx_lookup(struct fcb *fcb, struct conf_fcb_idx *ci,
+                    const char *name, uint32_t hash,
+                    struct conf_fcb_idx_ent **freep)
+{
+    struct conf_fcb_idx_ent *ent;
+    int nlen;
+    int i;
+    int j;
+
+    nlen = strlen(name);
+    i = hash % CONF_FCB_IDX_SIZE;
+    for (j = 0; j < CONF_FCB_IDX_SIZE; j++) {
+        ent = &ci->ci_ents[i];
+        if (ent->cie_area == CONF_FCB_IDX_FREE) {
+            if (freep) {
+                *freep = ent;
+            }
+            return NULL;
+        }
+        if (ent->cie_hash == hash && conf_fcb_idx_match(fcb, ent, name, nlen)) {
+            return ent;
+        }
+        i = (i + 1) % CONF_FCB_IDX_SIZE;
+    }
+    return NULL;
+}
+
+/*
+ * Find the entry pointing to a given record, without reading flash.
+ */
+static struct conf_fcb_idx_ent *
+conf_fcb_idx_find_loc(struct fcb *fcb, struct conf_fcb_idx *ci, uint32_t hash,
+                      struct fcb_entry *loc)
+{
+    struct conf_fcb_idx_ent *ent;
+    int area;
+    int i;
+    int j;
+
+    area = loc->fe_area - fcb->f_sectors;
+    i = hash % CONF_FCB_IDX_SIZE;
+    for (j = 0; j < CONF_FCB_IDX_SIZE; j++) {
+        ent = &ci->ci_ents[i];
+        if (ent->cie_area == CONF_FCB_IDX_FREE) {
+            break;
+        }
+        if (ent->cie_area == area && ent->cie_data_off == loc->fe_data_off) {
+            return ent;
+        }
+        i = (i + 1) % CONF_FCB_IDX_SIZE;
+    }
+    return NULL;
+}
+
+static void
+conf_fcb_idx_ent_set(struct fcb *fcb, struct conf_fcb_idx_ent *ent,
+                     struct fcb_entry *loc)
+{
+    ent->cie_area = loc->fe_area - fcb->f_sectors;
+    ent->cie_data_off = loc->fe_data_off;
+    ent->cie_data_len = loc->fe_data_len;
+}
+
+/*
+ * Record loc as the latest value of name.
+ */
+static void
+conf_fcb_idx_set(struct fcb *fcb, struct conf_fcb_idx *ci, const char *name,
+                 struct fcb_entry *loc)
+{
+    struct conf_fcb_idx_ent *ent;
+    struct conf_fcb_idx_ent *free;
+    uint32_t hash;
+
+    if (!ci || ci->ci_state != CONF_FCB_IDX_VALID) {
+        return;
+    }
+    hash = conf_fcb_idx_hash(name);
+    free = NULL;
+    ent = conf_fcb_idx_lookup(fcb, ci, name, hash, &free);
+    if (!ent) {
+        /*
+         * Keep one slot free so that lookups always terminate.
+         */
+        if (!free || ci->ci_cnt >= CONF_FCB_IDX_SIZE - 1) {
+            ci->ci_state = CONF_FCB_IDX_OVERFLOW;
+            return;
+        }
+        ent = free;
+        ent->cie_hash = hash;
+        ci->ci_cnt++;
+    }
+    conf_fcb_idx_ent_set(fcb, ent, loc);
+}
+
+static int
+conf_fcb_idx_build_cb(struct fcb_entry *loc, void *arg)
+{
+    struct conf_fcb *cf = (struct conf_fcb *)arg;
+    char buf[CONF_FCB_BUF_LEN];
+    char *name_str;
+    char *val_str;
+
+    if (loc->fe_data_len >= sizeof(buf)) {
+        return 0;
+    }
+    if (conf_fcb_var_read(loc, buf, &name_str, &val_str)) {
+        return 0;
+    }
+    conf_fcb_idx_set(&cf->cf_fcb, &cf->cf_idx, name_str, loc);
+    if (cf->cf_idx.ci_state != CONF_FCB_IDX_VALID) {
+        return 1;
+    }
+    return 0;
+}
+
+/*
+ * Build the index if it has not been done yet.  Returns 1 if the index
+ * can be used.
+ */
+static int
+conf_fcb_idx_ready(struct conf_fcb *cf)
+{
+    struct conf_fcb_idx *ci;
+    int i;
+
+    ci = &cf->cf_idx;
+    if (ci->ci_state == CONF_FCB_IDX_NONE) {
+        for (i = 0; i < CONF_FCB_IDX_SIZE; i++) {
+            ci->ci_ents[i].cie_area = CONF_FCB_IDX_FREE;
+        }
+        ci->ci_cnt = 0;
+        ci->ci_state = CONF_FCB_IDX_VALID;
+        fcb_walk(&cf->cf_fcb, 0, conf_fcb_idx_build_cb, cf);
+    }
+    return ci->ci_state == CONF_FCB_IDX_VALID;
+}
+
+static int
+conf_fcb_load_one(struct conf_store *cs, const char *name,
+                  conf_store_load_cb cb, void *cb_arg)
+{
+    struct conf_fcb *cf = (struct conf_fcb *)cs;
+    struct conf_fcb_idx_ent *ent;
+    struct fcb_entry loc;
+    char buf[CONF_FCB_BUF_LEN];
+    char *name_str;
+    char *val_str;
+
+    if (!conf_fcb_idx_ready(cf)) {
+        return conf_fcb_load(cs, cb, cb_arg);
+    }
+    ent = conf_fcb_idx_lookup(&cf->cf_fcb, &cf->cf_idx, name,
+                              conf_fcb_idx_hash(name), NULL);
+    if (!ent) {
+        return OS_OK;
+    }
+    conf_fcb_idx_loc(&cf->cf_fcb, ent, &loc);
+    if (conf_fcb_var_read(&loc, buf, &name_str, &val_str)) {
+        return OS_EINVAL;
+    }
+    cb(name_str, val_str, cb_arg);
+    return OS_OK;
+}
+
+/*
+ * Find the config store built on this FCB, if any, so that the kv helpers
+ * can use and maintain its index.
+ */
+static struct conf_fcb *
+conf_fcb_kv_find(struct fcb *fcb)
+{
+    struct conf_store *cs;
+    struct conf_fcb *cf;
+
+    cs = conf_save_dst;
+    if (cs && cs->cs_itf == &conf_fcb_itf) {
+        cf = (struct conf_fcb *)cs;
+        if (&cf->cf_fcb == fcb) {
+            return cf;
+        }
+    }
+    SLIST_FOREACH(cs, &conf_load_srcs, cs_next) {
+        if (cs->cs_itf == &conf_fcb_itf) {
+            cf = (struct conf_fcb *)cs;
+            if (&cf->cf_fcb == fcb) {
+                return cf;
+            }
+        }
+    }
+    return NULL;
+}
+
+static int
+conf_fcb_kv_load_idx(struct conf_fcb *cf, const char *name, char *value,
+                     size_t len)
+{
+    struct conf_fcb_idx_ent *ent;
+    struct fcb_entry loc;
+    char buf[CONF_FCB_BUF_LEN];
+    char *name_str;
+    char *val_str;
+
+    ent = conf_fcb_idx_lookup(&cf->cf_fcb, &cf->cf_idx, name,
+                              conf_fcb_idx_hash(name), NULL);
+    if (!ent) {
+        return OS_OK;
+    }
+    conf_fcb_idx_loc(&cf->cf_fcb, ent, &loc);
+    if (conf_fcb_var_read(&loc, buf, &name_str, &val_str)) {
+        return OS_EINVAL;
+    }
+    if (!val_str) {
+        value[0] = '\0';
+        return OS_OK;
+    }
+    strncpy(value, val_str, len);
+    value[len - 1] = '\0';
+    return OS_OK;
+}
+
+#endif
+
 int
 conf_fcb_src(struct conf_fcb *cf)
 {
@@ -83,6 +414,9 @@ conf_fcb_src(struct conf_fcb *cf)
         }
     }
 
+#if MYNEWT_VAL(CONFIG_FCB_INDEX)
+    cf->cf_idx.ci_state = CONF_FCB_IDX_NONE;
+#endif
     cf->cf_store.cs_itf = &conf_fcb_itf;
     conf_src_register(&cf->cf_store);
 
@@ -92,6 +426,14 @@ conf_fcb_src(struct conf_fcb *cf)
 int
 conf_fcb_dst(struct conf_fcb *cf)
 {
+#if MYNEWT_VAL(CONFIG_FCB_INDEX)
+    cf->cf_idx.ci_state = CONF_FCB_IDX_NONE;
+#endif
+#if MYNEWT_VAL(CONFIG_FCB_COMPACT_BG)
+    memset(&cf->cf_compact_ev, 0, sizeof(cf->cf_compact_ev));
+    cf->cf_compact_ev.ev_cb = conf_fcb_compact_ev;
+    cf->cf_compact_ev.ev_arg = cf;
+#endif
     cf->cf_store.cs_itf = &conf_fcb_itf;
     conf_dst_register(&cf->cf_store);
 
@@ -159,20 +501,56 @@ conf_fcb_var_read(struct fcb_entry *loc, char *buf, char **name, char **val)
     return rc;
 }
 
+/*
+ * Is there a newer record for the same name after loc?
+ */
+static int
+conf_fcb_var_superseded(struct fcb *fcb, struct fcb_entry *loc,
+                        const char *name)
+{
+    char buf[CONF_MAX_NAME_LEN + CONF_MAX_VAL_LEN + 32];
+    struct fcb_entry loc2;
+    char *name2, *val2;
+    int rc;
+
+    loc2 = *loc;
+    while (fcb_getnext(fcb, &loc2) == 0) {
+        rc = conf_fcb_var_read(&loc2, buf, &name2, &val2);
+        if (rc) {
+            continue;
+        }
+        if (!strcmp(name, name2)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
 static void
-conf_fcb_compress_internal(struct fcb *fcb,
+conf_fcb_compress_internal(struct fcb *fcb, struct conf_fcb_idx *ci,
                            int (*copy_or_not)(const char *name, const char *val,
                                               void *cn_arg),
                            void *cn_arg)
 {
     int rc;
     char buf1[CONF_MAX_NAME_LEN + CONF_MAX_VAL_LEN + 32];
-    char buf2[CONF_MAX_NAME_LEN + CONF_MAX_VAL_LEN + 32];
     struct fcb_entry loc1;
     struct fcb_entry loc2;
     char *name1, *val1;
-    char *name2, *val2;
-    int copy;
+#if MYNEWT_VAL(CONFIG_FCB_INDEX)
+    struct conf_fcb_idx_ent *ent;
+    int use_idx;
+    int idx_lost;
+
+    /*
+     * With a valid index, a record is live if the index points to it; no
+     * need to scan the rest of the FCB for a newer one.  If a live name is
+     * not carried over, the index is rebuilt on next use.
+     */
+    use_idx = ci && ci->ci_state == CONF_FCB_IDX_VALID;
+    idx_lost = 0;
+    ent = NULL;
+#endif
 
     rc = fcb_append_to_scratch(fcb);
     if (rc) {
@@ -182,6 +560,13 @@ conf_fcb_compress_internal(struct fcb *fcb,
     loc1.fe_area = NULL;
     loc1.fe_elem_off = 0;
     while (fcb_getnext(fcb, &loc1) == 0) {
+#if MYNEWT_VAL(CONFIG_FCB_INDEX)
+        if (ent) {
+            /* Previous live record was dropped. */
+            idx_lost = 1;
+            ent = NULL;
+        }
+#endif
         if (loc1.fe_area != fcb->f_oldest) {
             break;
         }
@@ -189,24 +574,27 @@ conf_fcb_compress_internal(struct fcb *fcb,
         if (rc) {
             continue;
         }
+#if MYNEWT_VAL(CONFIG_FCB_INDEX)
+        if (use_idx) {
+            ent = conf_fcb_idx_find_loc(fcb, ci, conf_fcb_idx_hash(name1),
+                                        &loc1);
+            if (!ent) {
+                continue;
+            }
+        }
+#endif
         if (!val1) {
             continue;
         }
-        loc2 = loc1;
-        copy = 1;
-        while (fcb_getnext(fcb, &loc2) == 0) {
-            rc = conf_fcb_var_read(&loc2, buf2, &name2, &val2);
-            if (rc) {
-                continue;
-            }
-            if (!strcmp(name1, name2)) {
-                copy = 0;
-                break;
-            }
+#if MYNEWT_VAL(CONFIG_FCB_INDEX)
+        if (!use_idx && conf_fcb_var_superseded(fcb, &loc1, name1)) {
+            continue;
         }
-        if (!copy) {
+#else
+        if (conf_fcb_var_superseded(fcb, &loc1, name1)) {
             continue;
         }
+#endif
 
         if (copy_or_not) {
             if (copy_or_not(name1, val1, cn_arg)) {
@@ -232,16 +620,32 @@ conf_fcb_compress_internal(struct fcb *fcb,
             continue;
         }
         fcb_append_finish(fcb, &loc2);
+#if MYNEWT_VAL(CONFIG_FCB_INDEX)
+        if (use_idx) {
+            loc2.fe_data_len = loc1.fe_data_len;
+            conf_fcb_idx_ent_set(fcb, ent, &loc2);
+            ent = NULL;
+        }
+#endif
     }
     rc = fcb_rotate(fcb);
     if (rc) {
         /* XXXX */
         ;
     }
+#if MYNEWT_VAL(CONFIG_FCB_INDEX)
+    if (ent) {
+        idx_lost = 1;
+    }
+    if (ci && (!use_idx || idx_lost)) {
+        ci->ci_state = CONF_FCB_IDX_NONE;
+    }
+#endif
 }
 
 static int
-conf_fcb_append(struct fcb *fcb, char *buf, int len)
+conf_fcb_append(struct fcb *fcb, struct conf_fcb_idx *ci, const char *name,
+                char *buf, int len)
 {
     int rc;
     int i;
@@ -255,7 +659,7 @@ conf_fcb_append(struct fcb *fcb, char *buf, int len)
         if (fcb->f_scratch_cnt == 0) {
             return OS_ENOMEM;
         }
-        conf_fcb_compress_internal(fcb, NULL, NULL);
+        conf_fcb_compress_internal(fcb, ci, NULL, NULL);
     }
     if (rc) {
         return OS_EINVAL;
@@ -265,15 +669,44 @@ conf_fcb_append(struct fcb *fcb, char *buf, int len)
         return OS_EINVAL;
     }
     fcb_append_finish(fcb, &loc);
+#if MYNEWT_VAL(CONFIG_FCB_INDEX)
+    loc.fe_data_len = len;
+    conf_fcb_idx_set(fcb, ci, name, &loc);
+#endif
     return OS_OK;
 }
 
+static int
+conf_fcb_save_internal(struct fcb *fcb, struct conf_fcb_idx *ci,
+                       const char *name, const char *value)
+{
+    char buf[CONF_MAX_NAME_LEN + CONF_MAX_VAL_LEN + 32];
+    int len;
+
+    if (!name) {
+        return OS_INVALID_PARM;
+    }
+
+    len = conf_line_make(buf, sizeof(buf), name, value);
+    if (len < 0 || len + 2 > sizeof(buf)) {
+        return OS_INVALID_PARM;
+    }
+    return conf_fcb_append(fcb, ci, name, buf, len);
+}
+
 static int
 conf_fcb_save(struct conf_store *cs, const char *name, const char *value)
 {
     struct conf_fcb *cf = (struct conf_fcb *)cs;
+    int rc;
 
-    return conf_fcb_kv_save(&cf->cf_fcb, name, value);
+    rc = conf_fcb_save_internal(&cf->cf_fcb, CONF_FCB_IDX(cf), name, value);
+#if MYNEWT_VAL(CONFIG_FCB_COMPACT_BG)
+    if (rc == 0 && conf_fcb_compact_needed(cf)) {
+        os_eventq_put(os_eventq_dflt_get(), &cf->cf_compact_ev);
+    }
+#endif
+    return rc;
 }
 
 void
@@ -282,9 +715,75 @@ conf_fcb_compress(struct conf_fcb *cf,
                                      void *cn_arg),
                   void *cn_arg)
 {
-    conf_fcb_compress_internal(&cf->cf_fcb, copy_or_not, cn_arg);
+    conf_fcb_compress_internal(&cf->cf_fcb, CONF_FCB_IDX(cf), copy_or_not,
+                               cn_arg);
 }
 
+/*
+ * Compact when the active sector is the last one before scratch and is
+ * mostly used.  With the index, also require that at least half of the
+ * oldest sector is stale, so that compaction does not repeat on every save
+ * when most of the data is live.
+ */
+static int
+conf_fcb_compact_needed(struct conf_fcb *cf)
+{
+    struct fcb *fcb;
+    struct fcb_entry *active;
+#if MYNEWT_VAL(CONFIG_FCB_INDEX)
+    struct conf_fcb_idx_ent *ent;
+    uint32_t live;
+    int oldest;
+    int i;
+#endif
+
+    fcb = &cf->cf_fcb;
+    if (fcb->f_scratch_cnt == 0 ||
+        fcb_free_sector_cnt(fcb) > fcb->f_scratch_cnt) {
+        return 0;
+    }
+    active = &fcb->f_active;
+    if (active->fe_elem_off < active->fe_area->fa_size / 4 * 3) {
+        return 0;
+    }
+#if MYNEWT_VAL(CONFIG_FCB_INDEX)
+    if (conf_fcb_idx_ready(cf)) {
+        oldest = fcb->f_oldest - fcb->f_sectors;
+        live = 0;
+        for (i = 0; i < CONF_FCB_IDX_SIZE; i++) {
+            ent = &cf->cf_idx.ci_ents[i];
+            if (ent->cie_area == oldest) {
+                live += ent->cie_data_len;
+            }
+        }
+        if (live >= fcb->f_oldest->fa_size / 2) {
+            return 0;
+        }
+    }
+#endif
+    return 1;
+}
+
+int
+conf_fcb_compact(struct conf_fcb *cf)
+{
+    if (!conf_fcb_compact_needed(cf)) {
+        return 0;
+    }
+    conf_fcb_compress_internal(&cf->cf_fcb, CONF_FCB_IDX(cf), NULL, NULL);
+    return 1;
+}
+
+#if MYNEWT_VAL(CONFIG_FCB_COMPACT_BG)
+static void
+conf_fcb_compact_ev(struct os_event *ev)
+{
+    conf_lock();
+    conf_fcb_compact(ev->ev_arg);
+    conf_unlock();
+}
+#endif
+
 static int
 conf_kv_load_cb(struct fcb_entry *loc, void *arg)
 {
@@ -315,6 +814,10 @@ conf_kv_load_cb(struct fcb_entry *loc, void *arg)
         return 0;
     }
 
+    if (!val_str) {
+        cb_arg->value[0] = '\0';
+        return 0;
+    }
     strncpy(cb_arg->value, val_str, cb_arg->len);
     cb_arg->value[cb_arg->len - 1] = '\0';
 
@@ -326,6 +829,18 @@ conf_fcb_kv_load(struct fcb *fcb, const char *name, char *value, size_t len)
 {
     struct conf_kv_load_cb_arg arg;
     int rc;
+#if MYNEWT_VAL(CONFIG_FCB_INDEX)
+    struct conf_fcb *cf;
+
+    conf_lock();
+    cf = conf_fcb_kv_find(fcb);
+    if (cf && conf_fcb_idx_ready(cf)) {
+        rc = conf_fcb_kv_load_idx(cf, name, value, len);
+        conf_unlock();
+        return rc;
+    }
+    conf_unlock();
+#endif
 
     arg.name = name;
     arg.value = value;
@@ -342,18 +857,18 @@ conf_fcb_kv_load(struct fcb *fcb, const char *name, char *value, size_t len)
 int
 conf_fcb_kv_save(struct fcb *fcb, const char *name, const char *value)
 {
-    char buf[CONF_MAX_NAME_LEN + CONF_MAX_VAL_LEN + 32];
-    int len;
-
-    if (!name) {
-        return OS_INVALID_PARM;
-    }
+#if MYNEWT_VAL(CONFIG_FCB_INDEX)
+    struct conf_fcb *cf;
+    int rc;
 
-    len = conf_line_make(buf, sizeof(buf), name, value);
-    if (len < 0 || len + 2 > sizeof(buf)) {
-        return OS_INVALID_PARM;
-    }
-    return conf_fcb_append(fcb, buf, len);
+    conf_lock();
+    cf = conf_fcb_kv_find(fcb);
+    rc = conf_fcb_save_internal(fcb, cf ? &cf->cf_idx : NULL, name, value);
+    conf_unlock();
+    return rc;
+#else
+    return conf_fcb_save_internal(fcb, NULL, name, value);
+#endif
 }
 
 #endif
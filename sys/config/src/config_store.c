@@ -64,6 +64,19 @@ conf_dst_register(struct conf_store *cs)
     conf_save_dst = cs;
 }
 
+/*
+ * Report stored value(s) of one name from a store.
+ */
+static int
+conf_store_load_one(struct conf_store *cs, const char *name,
+                    conf_store_load_cb cb, void *cb_arg)
+{
+    if (cs->cs_itf->csi_load_one) {
+        return cs->cs_itf->csi_load_one(cs, name, cb, cb_arg);
+    }
+    return cs->cs_itf->csi_load(cs, cb, cb_arg);
+}
+
 static void
 conf_load_cb(char *name, char *val, void *cb_arg)
 {
@@ -90,7 +103,7 @@ conf_load_one(char *name)
     conf_lock();
     conf_loading = true;
     SLIST_FOREACH(cs, &conf_load_srcs, cs_next) {
-        cs->cs_itf->csi_load(cs, conf_load_cb, name);
+        conf_store_load_one(cs, name, conf_load_cb, name);
     }
     conf_loading = false;
     conf_unlock();
@@ -171,7 +184,7 @@ conf_get_stored_value(char *name, char *buf, int buf_len)
      */
     conf_lock();
     SLIST_FOREACH(cs, &conf_load_srcs, cs_next) {
-        cs->cs_itf->csi_load(cs, conf_get_value_cb, &cgva);
+        conf_store_load_one(cs, name, conf_get_value_cb, &cgva);
     }
     conf_unlock();
 
@@ -232,7 +245,7 @@ conf_save_one(const char *name, char *value)
     cdca.val = value;
     cdca.is_dup = 0;
     SLIST_FOREACH(cs, &conf_load_srcs, cs_next) {
-        cs->cs_itf->csi_load(cs, conf_dup_check_cb, &cdca);
+        conf_store_load_one(cs, name, conf_dup_check_cb, &cdca);
     }
     if (cdca.is_dup == 1) {
         rc = 0;
@@ -0,0 +1,151 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef H_CPUPROF_
+#define H_CPUPROF_
+
+#include <inttypes.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Statistical CPU profiler.
+ *
+ * While running, the profiler periodically interrupts the CPU and records
+ * the interrupted program counter (PC) and link register (LR).  Samples are
+ * pushed into a lock-free ring from interrupt context and aggregated into a
+ * histogram of (PC, LR) pairs from task context.  The histogram holds raw
+ * addresses only; symbolize them offline against the image's ELF file, e.g.:
+ *
+ *     arm-none-eabi-addr2line -f -e bin/targets/<target>/app/.../<app>.elf \
+ *         <pc> ...
+ *
+ * Samples are taken from a CPU time timer callback on Cortex-M, and from a
+ * SIGPROF handler on the native (sim) target.  Neither fires inside a
+ * critical section, so time spent with interrupts disabled is attributed to
+ * the code which re-enables them.  Samples whose PC can't be determined, e.g.
+ * when the timer preempts another interrupt handler, are recorded with a PC
+ * of 0.
+ */
+
+/** A histogram entry. */
+struct cpuprof_entry {
+    /** The sampled program counter. */
+    uintptr_t pc;
+    /** The sampled link register; 0 if not recorded. */
+    uintptr_t lr;
+    /** The number of samples with this PC and LR. */
+    uint32_t count;
+};
+
+/** Profiler status, see cpuprof_info_get(). */
+struct cpuprof_info {
+    /** The sampling frequency in Hz; 0 if stopped. */
+    uint32_t freq;
+    /** The number of samples in the histogram. */
+    uint32_t samples;
+    /** The number of samples dropped because the ring was full. */
+    uint32_t ring_drops;
+    /** The number of samples dropped because the histogram was full. */
+    uint32_t hist_drops;
+    /** The number of histogram entries in use. */
+    uint16_t entries;
+};
+
+typedef int cpuprof_walk_fn(const struct cpuprof_entry *entry, void *arg);
+
+/**
+ * @brief Starts sampling.
+ *
+ * Samples are added to those already in the histogram; call
+ * `cpuprof_reset()` first to start over.
+ *
+ * @param freq_hz               The sampling frequency, in Hz.
+ *
+ * @return                      0 on success;
+ *                              SYS_EINVAL if freq_hz is 0;
+ *                              SYS_EALREADY if the profiler is running;
+ *                              SYS_ENOTSUP if the platform can't sample.
+ */
+int cpuprof_start(uint32_t freq_hz);
+
+/**
+ * @brief Stops sampling.
+ *
+ * Samples still in the ring are added to the histogram.
+ *
+ * @return                      0 on success;
+ *                              SYS_EALREADY if the profiler isn't running.
+ */
+int cpuprof_stop(void);
+
+/**
+ * @brief Clears the histogram, pending samples and drop counters.
+ */
+void cpuprof_reset(void);
+
+/**
+ * @brief Records a sample.
+ *
+ * Called by the sampling source from interrupt context.  Can also be used
+ * to feed samples from a custom source.  Must not be called concurrently
+ * with itself.
+ *
+ * @param pc                    The interrupted program counter.
+ * @param lr                    The interrupted link register.
+ */
+void cpuprof_sample(uintptr_t pc, uintptr_t lr);
+
+/**
+ * @brief Moves pending samples from the ring into the histogram.
+ *
+ * This happens automatically from the default event queue when the ring
+ * fills up; call this to get an up to date histogram.
+ */
+void cpuprof_flush(void);
+
+/**
+ * @brief Applies a function to each histogram entry.
+ *
+ * Entries are visited in no particular order.  The histogram is locked
+ * while the walk is in progress; new samples stay in the ring.
+ *
+ * @param walk_func             The function to apply.  A nonzero return
+ *                                  value stops the walk.
+ * @param arg                   Passed to walk_func.
+ *
+ * @return                      0 if all entries were visited; the nonzero
+ *                                  value returned by walk_func otherwise.
+ */
+int cpuprof_walk(cpuprof_walk_fn *walk_func, void *arg);
+
+/**
+ * @brief Retrieves the profiler status.
+ *
+ * @param info                  On return, the profiler status.
+ */
+void cpuprof_info_get(struct cpuprof_info *info);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* H_CPUPROF_ */
@@ -0,0 +1,132 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "cpuprof_test.h"
+
+struct ctch_expect {
+    uintptr_t pc;
+    uintptr_t lr;
+    uint32_t count;
+    int seen;
+};
+
+static struct ctch_expect ctch_expect[] = {
+    { 0x1000, 0x2000, 3 },
+    { 0x1004, 0x2000, 2 },
+    { 0x1000, 0x3000, 1 },
+};
+
+#define CTCH_NUM_EXPECT (sizeof ctch_expect / sizeof ctch_expect[0])
+
+static int
+ctch_walk(const struct cpuprof_entry *entry, void *arg)
+{
+    int i;
+
+    for (i = 0; i < CTCH_NUM_EXPECT; i++) {
+        if (entry->pc == ctch_expect[i].pc &&
+            entry->lr == ctch_expect[i].lr) {
+
+            TEST_ASSERT(entry->count == ctch_expect[i].count);
+            TEST_ASSERT(!ctch_expect[i].seen);
+            ctch_expect[i].seen = 1;
+            return 0;
+        }
+    }
+
+    TEST_ASSERT(0);
+    return 0;
+}
+
+static void
+ctch_sample_n(uintptr_t pc, uintptr_t lr, int n)
+{
+    int i;
+
+    for (i = 0; i < n; i++) {
+        cpuprof_sample(pc, lr);
+    }
+}
+
+TEST_CASE_SELF(cpuprof_test_case_hist)
+{
+    struct cpuprof_info info;
+    int rc;
+    int i;
+
+    /* Identical (PC, LR) pairs are aggregated. */
+    cpuprof_reset();
+    for (i = 0; i < CTCH_NUM_EXPECT; i++) {
+        ctch_sample_n(ctch_expect[i].pc, ctch_expect[i].lr,
+                      ctch_expect[i].count);
+    }
+    cpuprof_flush();
+
+    rc = cpuprof_walk(ctch_walk, NULL);
+    TEST_ASSERT(rc == 0);
+    for (i = 0; i < CTCH_NUM_EXPECT; i++) {
+        TEST_ASSERT(ctch_expect[i].seen);
+    }
+
+    cpuprof_info_get(&info);
+    TEST_ASSERT(info.freq == 0);
+    TEST_ASSERT(info.samples == 6);
+    TEST_ASSERT(info.entries == CTCH_NUM_EXPECT);
+    TEST_ASSERT(info.ring_drops == 0);
+    TEST_ASSERT(info.hist_drops == 0);
+
+    /* Samples which don't fit in the ring are dropped and counted. */
+    cpuprof_reset();
+    ctch_sample_n(0x1000, 0x2000, MYNEWT_VAL(CPUPROF_RING_SIZE) + 4);
+    cpuprof_flush();
+
+    cpuprof_info_get(&info);
+    TEST_ASSERT(info.samples == MYNEWT_VAL(CPUPROF_RING_SIZE));
+    TEST_ASSERT(info.entries == 1);
+    TEST_ASSERT(info.ring_drops == 4);
+
+    /* Space is reclaimed once the ring is flushed. */
+    ctch_sample_n(0x1000, 0x2000, 1);
+    cpuprof_flush();
+
+    cpuprof_info_get(&info);
+    TEST_ASSERT(info.samples == MYNEWT_VAL(CPUPROF_RING_SIZE) + 1);
+    TEST_ASSERT(info.ring_drops == 4);
+
+    /* New pairs are dropped and counted once the histogram is full. */
+    cpuprof_reset();
+    for (i = 0; i < MYNEWT_VAL(CPUPROF_HIST_SIZE) + 2; i++) {
+        ctch_sample_n(0x1000 + i * 4, 0, 1);
+    }
+    cpuprof_flush();
+
+    cpuprof_info_get(&info);
+    TEST_ASSERT(info.samples == MYNEWT_VAL(CPUPROF_HIST_SIZE));
+    TEST_ASSERT(info.entries == MYNEWT_VAL(CPUPROF_HIST_SIZE));
+    TEST_ASSERT(info.ring_drops == 0);
+    TEST_ASSERT(info.hist_drops == 2);
+
+    /* Reset clears everything. */
+    cpuprof_reset();
+    cpuprof_info_get(&info);
+    TEST_ASSERT(info.samples == 0);
+    TEST_ASSERT(info.entries == 0);
+    TEST_ASSERT(info.ring_drops == 0);
+    TEST_ASSERT(info.hist_drops == 0);
+}
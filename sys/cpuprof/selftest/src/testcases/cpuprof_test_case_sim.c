@@ -0,0 +1,86 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "cpuprof_test.h"
+
+#if MYNEWT_VAL(MCU_NATIVE_USE_SIGNALS)
+
+static volatile uint32_t ctcs_sink;
+
+static void
+ctcs_profile(void)
+{
+    struct cpuprof_info info;
+    os_time_t deadline;
+    int rc;
+    int i;
+
+    cpuprof_reset();
+
+    rc = cpuprof_start(100);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = cpuprof_start(100);
+    TEST_ASSERT(rc == SYS_EALREADY);
+
+    /* SIGPROF counts CPU time, so keep the CPU busy until a sample lands. */
+    deadline = os_time_get() + 5 * OS_TICKS_PER_SEC;
+    do {
+        for (i = 0; i < 100000; i++) {
+            ctcs_sink += i;
+        }
+        cpuprof_flush();
+        cpuprof_info_get(&info);
+    } while (info.samples == 0 && OS_TIME_TICK_LT(os_time_get(), deadline));
+
+    TEST_ASSERT(info.freq == 100);
+    TEST_ASSERT(info.samples > 0);
+
+    rc = cpuprof_stop();
+    TEST_ASSERT(rc == 0);
+
+    /* A period of a whole second doesn't fit in tv_usec. */
+    rc = cpuprof_start(1);
+    TEST_ASSERT(rc == 0);
+    rc = cpuprof_stop();
+    TEST_ASSERT(rc == 0);
+}
+
+#endif
+
+TEST_CASE_TASK(cpuprof_test_case_sim)
+{
+    struct cpuprof_info info;
+    int rc;
+
+    rc = cpuprof_start(0);
+    TEST_ASSERT(rc == SYS_EINVAL);
+
+#if MYNEWT_VAL(MCU_NATIVE_USE_SIGNALS)
+    ctcs_profile();
+#else
+    rc = cpuprof_start(100);
+    TEST_ASSERT(rc == SYS_ENOTSUP);
+#endif
+
+    rc = cpuprof_stop();
+    TEST_ASSERT(rc == SYS_EALREADY);
+
+    cpuprof_info_get(&info);
+    TEST_ASSERT(info.freq == 0);
+}
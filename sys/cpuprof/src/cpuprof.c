@@ -0,0 +1,292 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+
+#include "os/mynewt.h"
+#include "cpuprof/cpuprof.h"
+#include "cpuprof_priv.h"
+
+#define CPUPROF_RING_SIZE       MYNEWT_VAL(CPUPROF_RING_SIZE)
+#define CPUPROF_HIST_SIZE       MYNEWT_VAL(CPUPROF_HIST_SIZE)
+
+/* Number of histogram slots tried before a sample is dropped */
+#define CPUPROF_HIST_PROBES     min(16, CPUPROF_HIST_SIZE)
+
+#if (CPUPROF_RING_SIZE & (CPUPROF_RING_SIZE - 1)) != 0
+#error "CPUPROF_RING_SIZE must be a power of two"
+#endif
+
+struct cpuprof_sample {
+    uintptr_t pc;
+    uintptr_t lr;
+};
+
+/*
+ * Single producer, single consumer ring.  Only the sampling interrupt writes
+ * the head and the drop counter; only the consumer, with cpuprof_mtx held,
+ * writes the tail.  Indices are free running.
+ */
+static struct cpuprof_sample cpuprof_ring[CPUPROF_RING_SIZE];
+static volatile uint32_t cpuprof_ring_head;
+static volatile uint32_t cpuprof_ring_tail;
+static volatile uint32_t cpuprof_ring_drops;
+static uint32_t cpuprof_ring_drops_base;
+
+/* Open addressing hash table of (PC, LR) pairs; protected by cpuprof_mtx */
+static struct cpuprof_entry cpuprof_hist[CPUPROF_HIST_SIZE];
+static uint16_t cpuprof_hist_used;
+static uint32_t cpuprof_hist_drops;
+static uint32_t cpuprof_samples;
+
+static uint32_t cpuprof_freq;
+static struct os_mutex cpuprof_mtx;
+
+static void cpuprof_flush_event(struct os_event *ev);
+
+static struct os_event cpuprof_flush_ev = {
+    .ev_cb = cpuprof_flush_event,
+};
+
+void
+cpuprof_sample(uintptr_t pc, uintptr_t lr)
+{
+    struct cpuprof_sample *sample;
+    uint32_t head;
+
+    head = cpuprof_ring_head;
+    if (head - cpuprof_ring_tail >= CPUPROF_RING_SIZE) {
+        cpuprof_ring_drops++;
+        return;
+    }
+
+    sample = &cpuprof_ring[head % CPUPROF_RING_SIZE];
+    sample->pc = pc;
+#if MYNEWT_VAL(CPUPROF_LR)
+    sample->lr = lr;
+#else
+    sample->lr = 0;
+#endif
+
+    /* The sample must be written before the consumer can see it */
+    __atomic_signal_fence(__ATOMIC_RELEASE);
+    head++;
+    cpuprof_ring_head = head;
+
+    if (head - cpuprof_ring_tail >= CPUPROF_RING_SIZE / 2) {
+        os_eventq_put(os_eventq_dflt_get(), &cpuprof_flush_ev);
+    }
+}
+
+static uint32_t
+cpuprof_hash(uintptr_t pc, uintptr_t lr)
+{
+    uint32_t h;
+
+    /* Code addresses are at least 2-byte aligned */
+    h = ((uint32_t)pc >> 1) * 2654435761u;
+    h ^= ((uint32_t)lr >> 1) * 40503u;
+    h ^= h >> 16;
+
+    return h % CPUPROF_HIST_SIZE;
+}
+
+static void
+cpuprof_hist_add(uintptr_t pc, uintptr_t lr)
+{
+    struct cpuprof_entry *entry;
+    uint32_t idx;
+    int i;
+
+    idx = cpuprof_hash(pc, lr);
+
+    for (i = 0; i < CPUPROF_HIST_PROBES; i++) {
+        entry = &cpuprof_hist[idx];
+
+        if (entry->count == 0) {
+            entry->pc = pc;
+            entry->lr = lr;
+            entry->count = 1;
+            cpuprof_hist_used++;
+            cpuprof_samples++;
+            return;
+        }
+
+        if (entry->pc == pc && entry->lr == lr) {
+            entry->count++;
+            cpuprof_samples++;
+            return;
+        }
+
+        idx = (idx + 1) % CPUPROF_HIST_SIZE;
+    }
+
+    cpuprof_hist_drops++;
+}
+
+/* Must be called with cpuprof_mtx held */
+static void
+cpuprof_drain(void)
+{
+    struct cpuprof_sample *sample;
+    uint32_t tail;
+
+    tail = cpuprof_ring_tail;
+    while (tail != cpuprof_ring_head) {
+        __atomic_signal_fence(__ATOMIC_ACQUIRE);
+
+        sample = &cpuprof_ring[tail % CPUPROF_RING_SIZE];
+        cpuprof_hist_add(sample->pc, sample->lr);
+
+        /* Done with the slot; hand it back to the producer */
+        __atomic_signal_fence(__ATOMIC_RELEASE);
+        tail++;
+        cpuprof_ring_tail = tail;
+    }
+}
+
+void
+cpuprof_flush(void)
+{
+    os_mutex_pend(&cpuprof_mtx, OS_TIMEOUT_NEVER);
+    cpuprof_drain();
+    os_mutex_release(&cpuprof_mtx);
+}
+
+static void
+cpuprof_flush_event(struct os_event *ev)
+{
+    cpuprof_flush();
+}
+
+int
+cpuprof_start(uint32_t freq_hz)
+{
+    int rc;
+
+    if (freq_hz == 0) {
+        return SYS_EINVAL;
+    }
+
+    if (cpuprof_freq != 0) {
+        return SYS_EALREADY;
+    }
+
+    rc = cpuprof_arch_start(freq_hz);
+    if (rc != 0) {
+        return rc;
+    }
+
+    cpuprof_freq = freq_hz;
+
+    return 0;
+}
+
+int
+cpuprof_stop(void)
+{
+    if (cpuprof_freq == 0) {
+        return SYS_EALREADY;
+    }
+
+    cpuprof_arch_stop();
+    cpuprof_freq = 0;
+
+    cpuprof_flush();
+
+    return 0;
+}
+
+void
+cpuprof_reset(void)
+{
+    os_mutex_pend(&cpuprof_mtx, OS_TIMEOUT_NEVER);
+
+    cpuprof_ring_tail = cpuprof_ring_head;
+    cpuprof_ring_drops_base = cpuprof_ring_drops;
+
+    memset(cpuprof_hist, 0, sizeof cpuprof_hist);
+    cpuprof_hist_used = 0;
+    cpuprof_hist_drops = 0;
+    cpuprof_samples = 0;
+
+    os_mutex_release(&cpuprof_mtx);
+}
+
+int
+cpuprof_walk(cpuprof_walk_fn *walk_func, void *arg)
+{
+    int rc;
+    int i;
+
+    rc = 0;
+
+    os_mutex_pend(&cpuprof_mtx, OS_TIMEOUT_NEVER);
+
+    for (i = 0; i < CPUPROF_HIST_SIZE; i++) {
+        if (cpuprof_hist[i].count == 0) {
+            continue;
+        }
+
+        rc = walk_func(&cpuprof_hist[i], arg);
+        if (rc != 0) {
+            break;
+        }
+    }
+
+    os_mutex_release(&cpuprof_mtx);
+
+    return rc;
+}
+
+void
+cpuprof_info_get(struct cpuprof_info *info)
+{
+    os_mutex_pend(&cpuprof_mtx, OS_TIMEOUT_NEVER);
+
+    info->freq = cpuprof_freq;
+    info->samples = cpuprof_samples;
+    info->ring_drops = cpuprof_ring_drops - cpuprof_ring_drops_base;
+    info->hist_drops = cpuprof_hist_drops;
+    info->entries = cpuprof_hist_used;
+
+    os_mutex_release(&cpuprof_mtx);
+}
+
+void
+cpuprof_init(void)
+{
+    int rc;
+
+    /* Ensure this function only gets called by sysinit. */
+    SYSINIT_ASSERT_ACTIVE();
+
+    rc = os_mutex_init(&cpuprof_mtx);
+    SYSINIT_PANIC_ASSERT(rc == 0);
+
+#if MYNEWT_VAL(CPUPROF_CLI)
+    rc = cpuprof_shell_register();
+    SYSINIT_PANIC_ASSERT(rc == 0);
+#endif
+
+#if MYNEWT_VAL(CPUPROF_MGMT)
+    rc = cpuprof_mgmt_register();
+    SYSINIT_PANIC_ASSERT(rc == 0);
+#endif
+}
@@ -0,0 +1,123 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+#include "cpuprof/cpuprof.h"
+#include "cpuprof_priv.h"
+
+#if defined(ARCH_sim)
+
+#include "sim/sim.h"
+
+int
+cpuprof_arch_start(uint32_t freq_hz)
+{
+    return sim_prof_start(freq_hz, cpuprof_sample);
+}
+
+void
+cpuprof_arch_stop(void)
+{
+    sim_prof_stop();
+}
+
+#elif defined(ARCH_cortex_m0) || defined(ARCH_cortex_m3) || \
+      defined(ARCH_cortex_m4) || defined(ARCH_cortex_m7) || \
+      defined(ARCH_cortex_m33)
+
+static struct hal_timer cpuprof_timer;
+static uint32_t cpuprof_period;
+
+static void
+cpuprof_timer_cb(void *arg)
+{
+    const uint32_t *frame;
+    uintptr_t pc;
+    uintptr_t lr;
+    uint32_t next;
+
+    pc = 0;
+    lr = 0;
+
+    /*
+     * When the timer interrupt preempted a task, the exception frame stacked
+     * on entry (r0-r3, r12, lr, pc, xpsr) is at the task's PSP; interrupt
+     * handlers run on the main stack.  RETTOBASE tells if there is no other
+     * active exception, i.e. if thread mode was interrupted.  Cortex-M0
+     * can't tell, so there samples taken in interrupt handlers get
+     * attributed to the task they preempted.
+     */
+#ifdef SCB_ICSR_RETTOBASE_Msk
+    if (g_os_started && (SCB->ICSR & SCB_ICSR_RETTOBASE_Msk)) {
+#else
+    if (g_os_started) {
+#endif
+        frame = (const uint32_t *)__get_PSP();
+        lr = frame[5];
+        pc = frame[6];
+    }
+
+    cpuprof_sample(pc, lr);
+
+    /*
+     * Keep a fixed period, but if the timer was held off for longer than
+     * that (e.g. by a critical section) don't catch up with a burst of
+     * samples.
+     */
+    next = cpuprof_timer.expiry + cpuprof_period;
+    if ((int32_t)(next - os_cputime_get32()) <= 0) {
+        next = os_cputime_get32() + cpuprof_period;
+    }
+    os_cputime_timer_start(&cpuprof_timer, next);
+}
+
+int
+cpuprof_arch_start(uint32_t freq_hz)
+{
+    cpuprof_period = os_cputime_usecs_to_ticks(1000000 / freq_hz);
+    if (cpuprof_period == 0) {
+        return SYS_EINVAL;
+    }
+
+    os_cputime_timer_init(&cpuprof_timer, cpuprof_timer_cb, NULL);
+
+    return os_cputime_timer_start(&cpuprof_timer,
+                                  os_cputime_get32() + cpuprof_period);
+}
+
+void
+cpuprof_arch_stop(void)
+{
+    os_cputime_timer_stop(&cpuprof_timer);
+}
+
+#else
+
+int
+cpuprof_arch_start(uint32_t freq_hz)
+{
+    return SYS_ENOTSUP;
+}
+
+void
+cpuprof_arch_stop(void)
+{
+}
+
+#endif
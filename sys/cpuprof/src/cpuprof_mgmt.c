@@ -0,0 +1,237 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+
+#if MYNEWT_VAL(CPUPROF_MGMT)
+
+#include <limits.h>
+
+#include "mgmt/mgmt.h"
+#include "cborattr/cborattr.h"
+#include "cpuprof/cpuprof.h"
+#include "cpuprof_priv.h"
+
+#define CPUPROF_MGMT_ID_READ    0
+#define CPUPROF_MGMT_ID_CTRL    1
+
+static int cpuprof_mgmt_read(struct mgmt_ctxt *);
+static int cpuprof_mgmt_ctrl(struct mgmt_ctxt *);
+
+static const struct mgmt_handler cpuprof_mgmt_handlers[] = {
+    [CPUPROF_MGMT_ID_READ] = { cpuprof_mgmt_read, NULL },
+    [CPUPROF_MGMT_ID_CTRL] = { NULL, cpuprof_mgmt_ctrl },
+};
+
+static struct mgmt_group cpuprof_mgmt_group = {
+    .mg_handlers = (struct mgmt_handler *)cpuprof_mgmt_handlers,
+    .mg_handlers_count = sizeof cpuprof_mgmt_handlers /
+                         sizeof cpuprof_mgmt_handlers[0],
+    .mg_group_id = MYNEWT_VAL(CPUPROF_MGMT_GROUP),
+};
+
+struct cpuprof_mgmt_walk_arg {
+    CborEncoder *enc;
+    uint32_t off;
+    uint32_t idx;
+    CborError err;
+};
+
+static int
+cpuprof_mgmt_encode_entry(const struct cpuprof_entry *entry, void *arg)
+{
+    struct cpuprof_mgmt_walk_arg *wa;
+    CborEncoder triple;
+
+    wa = arg;
+
+    if (wa->idx < wa->off) {
+        wa->idx++;
+        return 0;
+    }
+    if (wa->idx - wa->off >= MYNEWT_VAL(CPUPROF_MGMT_MAX_ENTRIES)) {
+        return 1;
+    }
+    wa->idx++;
+
+    wa->err |= cbor_encoder_create_array(wa->enc, &triple, 3);
+    wa->err |= cbor_encode_uint(&triple, entry->pc);
+    wa->err |= cbor_encode_uint(&triple, entry->lr);
+    wa->err |= cbor_encode_uint(&triple, entry->count);
+    wa->err |= cbor_encoder_close_container(wa->enc, &triple);
+
+    return wa->err != CborNoError;
+}
+
+/**
+ * Command handler: prof read
+ *
+ * Request:
+ *     o off (optional): index of the first histogram entry to return.
+ *
+ * Response:
+ *     o freq, samples, rdrops, hdrops: see struct cpuprof_info.
+ *     o hist: array of [pc, lr, count] arrays; at most
+ *       CPUPROF_MGMT_MAX_ENTRIES of them.
+ *     o next: the offset to request the next entries at; absent once all
+ *       entries have been returned.
+ *
+ * Stop the profiler before paging through the histogram; new entries may
+ * otherwise shift the ones already read.
+ */
+static int
+cpuprof_mgmt_read(struct mgmt_ctxt *cb)
+{
+    struct cpuprof_mgmt_walk_arg wa;
+    struct cpuprof_info info;
+    unsigned long long off;
+    CborError g_err = CborNoError;
+    CborEncoder hist;
+    int more;
+    int rc;
+
+    const struct cbor_attr_t attrs[] = {
+        [0] = {
+            .attribute = "off",
+            .type = CborAttrUnsignedIntegerType,
+            .addr.uinteger = &off
+        },
+        [1] = {
+            .attribute = NULL
+        }
+    };
+
+    off = 0;
+
+    rc = cbor_read_object(&cb->it, attrs);
+    if (rc != 0 || off > UINT16_MAX) {
+        return MGMT_ERR_EINVAL;
+    }
+
+    cpuprof_flush();
+    cpuprof_info_get(&info);
+
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "rc");
+    g_err |= cbor_encode_int(&cb->encoder, MGMT_ERR_EOK);
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "freq");
+    g_err |= cbor_encode_uint(&cb->encoder, info.freq);
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "samples");
+    g_err |= cbor_encode_uint(&cb->encoder, info.samples);
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "rdrops");
+    g_err |= cbor_encode_uint(&cb->encoder, info.ring_drops);
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "hdrops");
+    g_err |= cbor_encode_uint(&cb->encoder, info.hist_drops);
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "hist");
+    g_err |= cbor_encoder_create_array(&cb->encoder, &hist,
+                                       CborIndefiniteLength);
+    if (g_err) {
+        return MGMT_ERR_ENOMEM;
+    }
+
+    wa.enc = &hist;
+    wa.off = off;
+    wa.idx = 0;
+    wa.err = CborNoError;
+    more = cpuprof_walk(cpuprof_mgmt_encode_entry, &wa);
+    if (wa.err != CborNoError) {
+        return MGMT_ERR_ENOMEM;
+    }
+
+    g_err |= cbor_encoder_close_container(&cb->encoder, &hist);
+    if (more) {
+        g_err |= cbor_encode_text_stringz(&cb->encoder, "next");
+        g_err |= cbor_encode_uint(&cb->encoder, wa.idx);
+    }
+    if (g_err) {
+        return MGMT_ERR_ENOMEM;
+    }
+
+    return 0;
+}
+
+/**
+ * Command handler: prof ctrl
+ *
+ * Request:
+ *     o reset (optional): clear the histogram first.
+ *     o freq (optional): start, or restart, sampling at this frequency in
+ *       Hz; 0 stops sampling.
+ *
+ * Response:
+ *     o rc
+ */
+static int
+cpuprof_mgmt_ctrl(struct mgmt_ctxt *cb)
+{
+    unsigned long long freq;
+    bool reset;
+    int rc;
+
+    const struct cbor_attr_t attrs[] = {
+        [0] = {
+            .attribute = "reset",
+            .type = CborAttrBooleanType,
+            .addr.boolean = &reset
+        },
+        [1] = {
+            .attribute = "freq",
+            .type = CborAttrUnsignedIntegerType,
+            .addr.uinteger = &freq
+        },
+        [2] = {
+            .attribute = NULL
+        }
+    };
+
+    reset = false;
+    freq = ULLONG_MAX;
+
+    rc = cbor_read_object(&cb->it, attrs);
+    if (rc != 0 || (freq != ULLONG_MAX && freq > UINT32_MAX)) {
+        return MGMT_ERR_EINVAL;
+    }
+
+    if (freq != ULLONG_MAX) {
+        cpuprof_stop();
+    }
+
+    if (reset) {
+        cpuprof_reset();
+    }
+
+    if (freq != ULLONG_MAX && freq != 0) {
+        rc = cpuprof_start(freq);
+        if (rc == SYS_ENOTSUP) {
+            return MGMT_ERR_ENOTSUP;
+        } else if (rc != 0) {
+            return MGMT_ERR_EINVAL;
+        }
+    }
+
+    return mgmt_write_rsp_status(cb, 0);
+}
+
+int
+cpuprof_mgmt_register(void)
+{
+    mgmt_register_group(&cpuprof_mgmt_group);
+    return 0;
+}
+
+#endif /* MYNEWT_VAL(CPUPROF_MGMT) */
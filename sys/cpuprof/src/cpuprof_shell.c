@@ -0,0 +1,116 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+
+#if MYNEWT_VAL(CPUPROF_CLI)
+
+#include <stdlib.h>
+#include <string.h>
+#include "shell/shell.h"
+#include "streamer/streamer.h"
+#include "cpuprof/cpuprof.h"
+#include "cpuprof_priv.h"
+
+static int cpuprof_shell_cmd(const struct shell_cmd *cmd, int argc,
+                             char **argv, struct streamer *streamer);
+
+static struct shell_cmd cpuprof_shell_cmd_struct =
+    SHELL_CMD_EXT("prof", cpuprof_shell_cmd, NULL);
+
+static int
+cpuprof_shell_show_entry(const struct cpuprof_entry *entry, void *arg)
+{
+    struct streamer *streamer;
+
+    streamer = arg;
+    streamer_printf(streamer, "0x%08lx 0x%08lx %lu\n",
+                    (unsigned long)entry->pc, (unsigned long)entry->lr,
+                    (unsigned long)entry->count);
+
+    return 0;
+}
+
+static void
+cpuprof_shell_show(struct streamer *streamer)
+{
+    struct cpuprof_info info;
+
+    cpuprof_flush();
+    cpuprof_info_get(&info);
+
+    streamer_printf(streamer, "freq=%lu samples=%lu entries=%u "
+                    "ring_drops=%lu hist_drops=%lu\n",
+                    (unsigned long)info.freq, (unsigned long)info.samples,
+                    info.entries, (unsigned long)info.ring_drops,
+                    (unsigned long)info.hist_drops);
+    streamer_printf(streamer, "pc         lr         count\n");
+
+    cpuprof_walk(cpuprof_shell_show_entry, streamer);
+}
+
+static int
+cpuprof_shell_cmd(const struct shell_cmd *cmd, int argc, char **argv,
+                  struct streamer *streamer)
+{
+    unsigned long freq;
+    char *eptr;
+    int rc;
+
+    if (argc < 2 || strcmp(argv[1], "show") == 0) {
+        cpuprof_shell_show(streamer);
+        return 0;
+    }
+
+    if (strcmp(argv[1], "start") == 0) {
+        freq = MYNEWT_VAL(CPUPROF_FREQ);
+        if (argc > 2) {
+            freq = strtoul(argv[2], &eptr, 0);
+            if (*eptr != '\0') {
+                streamer_printf(streamer, "invalid frequency: %s\n", argv[2]);
+                return 0;
+            }
+        }
+
+        rc = cpuprof_start(freq);
+    } else if (strcmp(argv[1], "stop") == 0) {
+        rc = cpuprof_stop();
+    } else if (strcmp(argv[1], "reset") == 0) {
+        cpuprof_reset();
+        rc = 0;
+    } else {
+        streamer_printf(streamer,
+                        "usage: prof [start [<hz>]|stop|reset|show]\n");
+        return 0;
+    }
+
+    if (rc != 0) {
+        streamer_printf(streamer, "error: %d\n", rc);
+    }
+
+    return 0;
+}
+
+int
+cpuprof_shell_register(void)
+{
+    return shell_cmd_register(&cpuprof_shell_cmd_struct);
+}
+
+#endif /* MYNEWT_VAL(CPUPROF_CLI) */
@@ -89,6 +89,26 @@ int flash_area_write(const struct flash_area *, uint32_t off, const void *src,
   uint32_t len);
 int flash_area_erase(const struct flash_area *, uint32_t off, uint32_t len);
 
+/*
+ * Pointer through which len bytes at off can be read in place.  Fails with
+ * SYS_ENOTSUP unless the underlying flash is memory mapped.
+ */
+int flash_area_mmap(const struct flash_area *, uint32_t off, uint32_t len,
+  const void **out_ptr);
+
+#if MYNEWT_VAL(HAL_FLASH_ASYNC)
+struct hal_flash_op;
+
+/*
+ * Queued write/erase; op->hfo_ev is posted when done.  See
+ * hal_flash_write_async() and hal_flash_erase_async().
+ */
+int flash_area_write_async(const struct flash_area *, uint32_t off,
+  const void *src, uint32_t len, struct hal_flash_op *op);
+int flash_area_erase_async(const struct flash_area *, uint32_t off,
+  uint32_t len, struct hal_flash_op *op);
+#endif
+
 /*
  * Whether the whole area is empty.
  */
@@ -32,7 +32,7 @@
 extern "C" {
 #endif
 
-/* This space intentionally left blank */
+void flash_map_test_all(void);
 
 #ifdef __cplusplus
 }
@@ -26,6 +26,7 @@
 #include "hal/hal_bsp.h"
 #include "hal/hal_flash.h"
 #include "hal/hal_flash_int.h"
+#include "flash_map_test/flash_map_test.h"
 
 struct flash_area *fa_sectors;
 
@@ -38,6 +39,8 @@ TEST_CASE_DECL(flash_map_test_case_1)
 TEST_CASE_DECL(flash_map_test_case_2)
 TEST_CASE_DECL(flash_map_test_case_3)
 TEST_CASE_DECL(flash_map_test_case_new_areas)
+TEST_CASE_DECL(flash_map_test_case_async)
+TEST_CASE_DECL(flash_map_test_case_erase_plan)
 
 TEST_SUITE(flash_map_test_suite)
 {
@@ -45,16 +48,16 @@ TEST_SUITE(flash_map_test_suite)
     flash_map_test_case_2();
     flash_map_test_case_3();
     flash_map_test_case_new_areas();
+    flash_map_test_case_async();
+    flash_map_test_case_erase_plan();
 }
 
-int
-main(int argc, char **argv)
+void
+flash_map_test_all(void)
 {
     fa_sectors = (struct flash_area *)
                 malloc(sizeof(struct flash_area) * SELFTEST_FA_SECTOR_COUNT);
     TEST_ASSERT_FATAL(fa_sectors);
 
     flash_map_test_suite();
-
-    return tu_any_failed;
 }
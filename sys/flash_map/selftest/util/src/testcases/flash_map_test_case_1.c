@@ -16,7 +16,7 @@
  * specific language governing permissions and limitations
  * under the License.
  */
-#include "flash_map_test.h"
+#include "flash_map_test/flash_map_test.h"
 
 extern int flash_map_entries;
 extern struct flash_area *fa_sectors;
@@ -0,0 +1,166 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "flash_map_test/flash_map_test.h"
+
+static struct os_eventq fmta_evq;
+static int fmta_done;
+
+/*
+ * Runs queued events, then moves time on by a tick so the callout polling
+ * the device fires.  Returns the number of ticks it took to finish cnt
+ * operations.
+ */
+static int
+fmta_run(int cnt)
+{
+    struct os_event *ev;
+    int ticks;
+
+    ticks = 0;
+    while (1) {
+        while ((ev = os_eventq_get_no_wait(&fmta_evq)) != NULL) {
+            ev->ev_cb(ev);
+        }
+        if (fmta_done >= cnt || ticks > 1000) {
+            break;
+        }
+        os_time_advance(1);
+        os_callout_tick();
+        ticks++;
+    }
+    return ticks;
+}
+
+static void
+fmta_op_done(struct os_event *ev)
+{
+    struct hal_flash_op *op;
+
+    op = ev->ev_arg;
+    TEST_ASSERT(op->hfo_rc == 0);
+    fmta_done++;
+}
+
+/*
+ * Test queued erase and write
+ */
+TEST_CASE_SELF(flash_map_test_case_async)
+{
+#if MYNEWT_VAL(HAL_FLASH_ASYNC)
+    struct hal_flash_op ops[3];
+    const struct hal_flash *hf;
+    const struct flash_area *fa;
+    uint32_t wait_us;
+    uint32_t done;
+    uint8_t wd[256];
+    uint8_t rd[256];
+    int rc;
+    int i;
+
+    rc = flash_area_open(FLASH_AREA_IMAGE_0, &fa);
+    TEST_ASSERT_FATAL(rc == 0, "flash_area_open() fail");
+
+    os_eventq_init(&fmta_evq);
+    hal_flash_async_evq_set(&fmta_evq);
+    fmta_done = 0;
+
+    for (i = 0; i < 3; i++) {
+        memset(&ops[i], 0, sizeof(ops[i]));
+        ops[i].hfo_ev.ev_cb = fmta_op_done;
+        ops[i].hfo_ev.ev_arg = &ops[i];
+        ops[i].hfo_evq = &fmta_evq;
+    }
+    memset(wd, 0x5a, sizeof(wd));
+
+    /* Out of bounds */
+    rc = flash_area_erase_async(fa, 0, fa->fa_size + 1, &ops[0]);
+    TEST_ASSERT(rc != 0);
+
+    /* Write protected */
+    rc = hal_flash_write_protect(fa->fa_device_id, 1);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = flash_area_erase_async(fa, 0, fa->fa_size, &ops[0]);
+    TEST_ASSERT(rc == SYS_EACCES);
+    rc = hal_flash_write_protect(fa->fa_device_id, 0);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /* Operations are done in order, and only when the queue runs. */
+    rc = flash_area_erase_async(fa, 0, fa->fa_size, &ops[0]);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = flash_area_write_async(fa, 0, wd, sizeof(wd), &ops[1]);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = flash_area_write_async(fa, fa->fa_size - sizeof(wd), wd, sizeof(wd),
+                                &ops[2]);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(fmta_done == 0);
+
+    fmta_run(3);
+    TEST_ASSERT_FATAL(fmta_done == 3);
+
+    rc = flash_area_read(fa, 0, rd, sizeof(rd));
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(!memcmp(wd, rd, sizeof(rd)));
+
+    rc = flash_area_read(fa, fa->fa_size - sizeof(rd), rd, sizeof(rd));
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(!memcmp(wd, rd, sizeof(rd)));
+
+    rc = flash_area_read_is_empty(fa, sizeof(rd), rd, sizeof(rd));
+    TEST_ASSERT(rc == 1);
+
+    /*
+     * The native flash stays busy after every command; the queue must
+     * wait for it through the callout instead of blocking here.  Three
+     * 128kB sector erases take at least two ticks each.
+     */
+    fmta_done = 0;
+    rc = flash_area_erase_async(fa, 0, fa->fa_size, &ops[0]);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = flash_area_write_async(fa, 0, wd, sizeof(wd), &ops[1]);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = fmta_run(1);
+    TEST_ASSERT(fmta_done == 1);
+    TEST_ASSERT(rc >= 6);
+    rc = fmta_run(2);
+    TEST_ASSERT(fmta_done == 2);
+    TEST_ASSERT(rc >= 1);
+
+    /*
+     * Device busy with a command the queue did not issue: the write is
+     * held back until the device is idle.
+     */
+    hf = hal_bsp_flash_dev(fa->fa_device_id);
+    TEST_ASSERT_FATAL(hf->hf_itf->hff_erase_start != NULL);
+    fmta_done = 0;
+    rc = hf->hf_itf->hff_erase_start(hf, fa->fa_off, fa->fa_size, &done,
+                                     &wait_us);
+    TEST_ASSERT_FATAL(rc == 0 && done > 0);
+    rc = flash_area_write_async(fa, 0, wd, sizeof(wd), &ops[0]);
+    TEST_ASSERT_FATAL(rc == 0);
+    fmta_run(0);
+    TEST_ASSERT(fmta_done == 0);
+    rc = flash_area_read_is_empty(fa, 0, rd, sizeof(rd));
+    TEST_ASSERT(rc == 1);
+    fmta_run(1);
+    TEST_ASSERT(fmta_done == 1);
+    rc = flash_area_read(fa, 0, rd, sizeof(rd));
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(!memcmp(wd, rd, sizeof(rd)));
+#endif
+}
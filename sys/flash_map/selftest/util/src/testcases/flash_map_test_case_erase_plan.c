@@ -0,0 +1,272 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "flash_map_test/flash_map_test.h"
+
+/*
+ * Geometry of a 16MB SPI NOR flash with 4KB sectors, 32KB/64KB block erase
+ * and chip erase.
+ */
+#define FMTEP_SECTOR_SZ     0x1000
+#define FMTEP_SIZE          (16 * 1024 * 1024)
+
+static const uint32_t fmtep_blocks[] = { FMTEP_SIZE, 0x10000, 0x8000, 0 };
+
+static const struct hal_flash fmtep_dev = {
+    .hf_base_addr = 0,
+    .hf_size = FMTEP_SIZE,
+    .hf_sector_cnt = 4096,
+    .hf_align = 1,
+    .hf_erased_val = 0xff,
+    .hf_erase_blocks = fmtep_blocks,
+};
+
+extern struct flash_area *fa_sectors;
+
+/*
+ * Native flash advertises erase blocks and has no hff_erase, so
+ * hal_flash_erase() plans the erase and uses hff_erase_block where a block
+ * fits.  The area must end up erased, and nothing next to it.
+ */
+static void
+fmtep_erase_sync(const struct flash_area *fa)
+{
+    const struct hal_flash *hf;
+    uint8_t wd[16];
+    uint8_t rd[16];
+    uint32_t len;
+    int blocks;
+    int cnt;
+    int rc;
+    int i;
+
+    hf = hal_bsp_flash_dev(fa->fa_device_id);
+    rc = flash_area_to_sectors(fa->fa_id, &cnt, fa_sectors);
+    TEST_ASSERT_FATAL(rc == 0);
+    blocks = 0;
+    for (i = 0; i < cnt; i++) {
+        len = hal_flash_erase_unit(hf, fa_sectors[i].fa_off,
+                                   fa->fa_off + fa->fa_size,
+                                   fa_sectors[i].fa_size);
+        if (len > fa_sectors[i].fa_size) {
+            blocks++;
+        }
+    }
+    TEST_ASSERT_FATAL(blocks > 0, "no erase block fits in the area");
+
+    memset(wd, 0xa5, sizeof(wd));
+    rc = hal_flash_erase(fa->fa_device_id, fa->fa_off - sizeof(wd),
+                         fa->fa_size + 2 * sizeof(wd));
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = hal_flash_write(fa->fa_device_id, fa->fa_off - sizeof(wd), wd,
+                         sizeof(wd));
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = hal_flash_write(fa->fa_device_id, fa->fa_off + fa->fa_size, wd,
+                         sizeof(wd));
+    TEST_ASSERT_FATAL(rc == 0);
+    for (i = 0; i < cnt; i++) {
+        rc = hal_flash_write(fa->fa_device_id,
+                             fa_sectors[i].fa_off + fa_sectors[i].fa_size -
+                             sizeof(wd), wd, sizeof(wd));
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+
+    rc = hal_flash_erase(fa->fa_device_id, fa->fa_off, fa->fa_size);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    for (i = 0; i < cnt; i++) {
+        rc = flash_area_read_is_empty(fa, fa_sectors[i].fa_off - fa->fa_off +
+                                      fa_sectors[i].fa_size - sizeof(rd),
+                                      rd, sizeof(rd));
+        TEST_ASSERT(rc == 1);
+    }
+    rc = hal_flash_read(fa->fa_device_id, fa->fa_off - sizeof(rd), rd,
+                        sizeof(rd));
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(!memcmp(wd, rd, sizeof(rd)));
+    rc = hal_flash_read(fa->fa_device_id, fa->fa_off + fa->fa_size, rd,
+                        sizeof(rd));
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(!memcmp(wd, rd, sizeof(rd)));
+}
+
+#if MYNEWT_VAL(HAL_FLASH_ASYNC)
+static struct os_eventq fmtep_evq;
+static int fmtep_done;
+
+static void
+fmtep_op_done(struct os_event *ev)
+{
+    struct hal_flash_op *op;
+
+    op = ev->ev_arg;
+    TEST_ASSERT(op->hfo_rc == 0);
+    fmtep_done = 1;
+}
+
+/*
+ * Erases part of the area through the async API, stepping time on until
+ * the device is done.  Returns the number of ticks it took.
+ */
+static int
+fmtep_erase_async(const struct flash_area *fa, uint32_t off, uint32_t len)
+{
+    struct hal_flash_op op;
+    struct os_event *ev;
+    int ticks;
+    int rc;
+
+    memset(&op, 0, sizeof(op));
+    op.hfo_ev.ev_cb = fmtep_op_done;
+    op.hfo_ev.ev_arg = &op;
+    op.hfo_evq = &fmtep_evq;
+    fmtep_done = 0;
+
+    rc = flash_area_erase_async(fa, off, len, &op);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    ticks = 0;
+    while (1) {
+        while ((ev = os_eventq_get_no_wait(&fmtep_evq)) != NULL) {
+            ev->ev_cb(ev);
+        }
+        if (fmtep_done) {
+            break;
+        }
+        TEST_ASSERT_FATAL(ticks < 100000, "erase did not finish");
+        os_time_advance(1);
+        os_callout_tick();
+        ticks++;
+    }
+    return ticks;
+}
+
+/*
+ * Native flash is busy for a while after each erase command, sector or
+ * block.  Time erasing the area in one request, where the driver plans
+ * block erases, against erasing it one sector per request.
+ */
+static void
+fmtep_erase_bench(const struct flash_area *fa)
+{
+    int planned;
+    int by_sector;
+    int cnt;
+    int rc;
+    int i;
+
+    os_eventq_init(&fmtep_evq);
+    hal_flash_async_evq_set(&fmtep_evq);
+
+    rc = flash_area_to_sectors(fa->fa_id, &cnt, fa_sectors);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    planned = fmtep_erase_async(fa, 0, fa->fa_size);
+
+    by_sector = 0;
+    for (i = 0; i < cnt; i++) {
+        by_sector += fmtep_erase_async(fa, fa_sectors[i].fa_off - fa->fa_off,
+                                       fa_sectors[i].fa_size);
+    }
+
+    printf("erase plan: %u kB area, %d sectors, %d ms planned, "
+           "%d ms by sector\n", (unsigned)(fa->fa_size / 1024), cnt,
+           planned * 1000 / OS_TICKS_PER_SEC,
+           by_sector * 1000 / OS_TICKS_PER_SEC);
+
+    TEST_ASSERT(planned < by_sector);
+}
+#endif
+
+/*
+ * Erase planner: an image slot sized area at a 64KB boundary and 4KB off
+ * of it is covered exactly, with aligned units, using the largest blocks
+ * that fit.  Then the planner is used on native flash, synchronously and,
+ * with HAL_FLASH_ASYNC, timed against erasing sector by sector.
+ */
+TEST_CASE_SELF(flash_map_test_case_erase_plan)
+{
+    const struct flash_area *fa;
+    uint32_t offs[2] = { 0x20000, 0x21000 };
+    /* Units used, by size: 4KB, 32KB, 64KB */
+    int expect[2][3];
+    int cnt[3];
+    uint32_t addr;
+    uint32_t end;
+    uint32_t len;
+    int rc;
+    int i;
+
+    rc = flash_area_open(FLASH_AREA_IMAGE_0, &fa);
+    TEST_ASSERT_FATAL(rc == 0, "flash_area_open() fail");
+
+    /* No block fits, only a sector. */
+    len = hal_flash_erase_unit(&fmtep_dev, 0x20000, 0x20000 + 0x7000,
+                               FMTEP_SECTOR_SZ);
+    TEST_ASSERT(len == FMTEP_SECTOR_SZ);
+
+    /* Aligned: 64KB blocks only. */
+    expect[0][0] = 0;
+    expect[0][1] = 0;
+    expect[0][2] = fa->fa_size / 0x10000;
+
+    /*
+     * 4KB off: sectors up to the next 32KB boundary, one 32KB block up to
+     * the 64KB boundary, 64KB blocks, then the same in reverse at the end.
+     */
+    expect[1][0] = 7 + 1;
+    expect[1][1] = 1;
+    expect[1][2] = fa->fa_size / 0x10000 - 1;
+
+    for (i = 0; i < 2; i++) {
+        memset(cnt, 0, sizeof(cnt));
+        end = offs[i] + fa->fa_size;
+        for (addr = offs[i]; addr < end; addr += len) {
+            len = hal_flash_erase_unit(&fmtep_dev, addr, end, FMTEP_SECTOR_SZ);
+            TEST_ASSERT_FATAL(addr % len == 0);
+            TEST_ASSERT_FATAL(addr + len <= end);
+            switch (len) {
+            case FMTEP_SECTOR_SZ:
+                cnt[0]++;
+                break;
+            case 0x8000:
+                cnt[1]++;
+                break;
+            case 0x10000:
+                cnt[2]++;
+                break;
+            default:
+                TEST_ASSERT_FATAL(0, "unexpected erase unit");
+            }
+        }
+        TEST_ASSERT(addr == end);
+        TEST_ASSERT(!memcmp(cnt, expect[i], sizeof(cnt)));
+    }
+
+    /* The whole device goes in one chip erase, anything less does not. */
+    len = hal_flash_erase_unit(&fmtep_dev, 0, FMTEP_SIZE, FMTEP_SECTOR_SZ);
+    TEST_ASSERT(len == FMTEP_SIZE);
+    len = hal_flash_erase_unit(&fmtep_dev, 0, FMTEP_SIZE - FMTEP_SECTOR_SZ,
+                               FMTEP_SECTOR_SZ);
+    TEST_ASSERT(len == 0x10000);
+
+    fmtep_erase_sync(fa);
+#if MYNEWT_VAL(HAL_FLASH_ASYNC)
+    fmtep_erase_bench(fa);
+#endif
+}
@@ -17,7 +17,7 @@
  * under the License.
  */
 
-#include "flash_map_test.h"
+#include "flash_map_test/flash_map_test.h"
 
 static struct flash_area scratch_flash_map[100];
 
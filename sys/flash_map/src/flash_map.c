@@ -238,6 +238,16 @@ flash_area_read(const struct flash_area *fa, uint32_t off, void *dst,
     return hal_flash_read(fa->fa_device_id, fa->fa_off + off, dst, len);
 }
 
+int
+flash_area_mmap(const struct flash_area *fa, uint32_t off, uint32_t len,
+    const void **out_ptr)
+{
+    if (off > fa->fa_size || off + len > fa->fa_size) {
+        return -1;
+    }
+    return hal_flash_mmap(fa->fa_device_id, fa->fa_off + off, len, out_ptr);
+}
+
 int
 flash_area_write(const struct flash_area *fa, uint32_t off, const void *src,
     uint32_t len)
@@ -258,6 +268,29 @@ flash_area_erase(const struct flash_area *fa, uint32_t off, uint32_t len)
     return hal_flash_erase(fa->fa_device_id, fa->fa_off + off, len);
 }
 
+#if MYNEWT_VAL(HAL_FLASH_ASYNC)
+int
+flash_area_write_async(const struct flash_area *fa, uint32_t off,
+    const void *src, uint32_t len, struct hal_flash_op *op)
+{
+    if (off > fa->fa_size || off + len > fa->fa_size) {
+        return -1;
+    }
+    return hal_flash_write_async(fa->fa_device_id, fa->fa_off + off, src, len,
+                                 op);
+}
+
+int
+flash_area_erase_async(const struct flash_area *fa, uint32_t off,
+    uint32_t len, struct hal_flash_op *op)
+{
+    if (off > fa->fa_size || off + len > fa->fa_size) {
+        return -1;
+    }
+    return hal_flash_erase_async(fa->fa_device_id, fa->fa_off + off, len, op);
+}
+#endif
+
 uint8_t
 flash_area_align(const struct flash_area *fa)
 {
@@ -0,0 +1,46 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef H_LOG_CBOR_SERIES_
+#define H_LOG_CBOR_SERIES_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * CBOR tag of a packed integer series.
+ *
+ * The tagged item is a byte string (possibly chunked) holding a header byte
+ * with the value size in bytes (1, 2 or 4) and LOG_CBOR_SERIES_SIGNED for
+ * signed values, followed by one varint per value. Each varint is the
+ * zigzag encoded difference to the previous value, modulo 2^(8 * size); the
+ * first value is relative to 0.
+ *
+ * Writers only need this header; log_cbor_reader decodes the series.
+ */
+#define LOG_CBOR_TAG_PACKED_SERIES      0x6d73
+#define LOG_CBOR_SERIES_SIGNED          0x40
+#define LOG_CBOR_SERIES_SIZE_MASK       0x0f
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
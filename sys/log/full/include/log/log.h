@@ -192,6 +192,9 @@ STATS_SECT_START(logs)
     STATS_SECT_ENTRY(errs)
     STATS_SECT_ENTRY(lost)
     STATS_SECT_ENTRY(too_long)
+#if MYNEWT_VAL(LOG_DEFERRED)
+    STATS_SECT_ENTRY(deferred_drops)
+#endif
 STATS_SECT_END
 
 #define LOG_STATS_INC(log, name)        STATS_INC(log->l_stats, name)
@@ -201,6 +204,30 @@ STATS_SECT_END
 #define LOG_STATS_INCN(log, name, cnt)
 #endif
 
+#if MYNEWT_VAL(LOG_DEFERRED)
+/**
+ * Staging ring of a log in deferred mode (see log_set_deferred()).  Writers
+ * reserve space for an entry, copy the entry in and mark it ready; the log
+ * task writes ready entries to the log handler in ring order.
+ */
+struct log_deferred {
+    struct log *ld_log;
+    uint8_t *ld_buf;
+    uint32_t ld_size;
+    /* Ring offsets of the next reservation and of the oldest entry. */
+    uint32_t ld_head;
+    uint32_t ld_tail;
+    /* Free running byte counts reserved by writers and released by the
+     * log task; their difference is the number of bytes in use. */
+    uint32_t ld_in;
+    uint32_t ld_out;
+    /* Entries dropped because the ring was full. */
+    uint32_t ld_drops;
+    struct os_event ld_ev;
+    struct os_mutex ld_mtx;
+};
+#endif
+
 struct log {
     const char *l_name;
     const struct log_handler *l_log;
@@ -216,6 +243,9 @@ struct log {
 #if MYNEWT_VAL(LOG_STATS)
     STATS_SECT_DECL(logs) l_stats;
 #endif
+#if MYNEWT_VAL(LOG_DEFERRED)
+    struct log_deferred *l_deferred;
+#endif
 };
 
 /* Log system level functions (for all logs.) */
@@ -262,6 +292,46 @@ int log_register(const char *name, struct log *log, const struct log_handler *,
  */
 void log_set_append_cb(struct log *log, log_append_cb *cb);
 
+#if MYNEWT_VAL(LOG_DEFERRED)
+/**
+ * @brief Puts the given log in deferred mode, or takes it out of it.
+ *
+ * In deferred mode, appending an entry only copies it into a staging ring;
+ * the log task writes staged entries to the log handler later.  Callers are
+ * thus not held up by slow backends, e.g., a flash erase in an FCB log.
+ * Entries that do not fit in the ring are dropped and counted in
+ * `ld_drops`.  The append callback is executed by the log task once the
+ * entry has been written.
+ *
+ * @param log                   The log to configure.
+ * @param ld                    The staging ring state, or NULL to make the
+ *                                  log synchronous again.  Staged entries
+ *                                  are written out before this returns.
+ * @param buf                   Ring storage; must be 4-byte aligned.  Both
+ *                                  ld and buf must stay valid while the log
+ *                                  is in deferred mode.
+ * @param buf_size              Size of buf, in bytes.
+ *
+ * @return                      0 on success; SYS_EINVAL if the buffer is
+ *                                  unusable.
+ */
+int log_set_deferred(struct log *log, struct log_deferred *ld, void *buf,
+                     uint32_t buf_size);
+
+/**
+ * @brief Blocks until all entries staged in a deferred log at the time of
+ * the call have been written to the log handler.
+ *
+ * Must not be called from interrupt context.  Does nothing for a
+ * synchronous log.
+ *
+ * @param log                   The log to flush.
+ *
+ * @return                      0 on success; nonzero on failure.
+ */
+int log_deferred_flush(struct log *log);
+#endif
+
 /**
  * @brief Searches the list of registered logs for one with the specified name.
  *
@@ -56,6 +56,30 @@ struct log_fcb_bset {
     int lfs_next;
 };
 
+/** Summary of the log entries in one FCB/FCB2 area. */
+struct log_fcb_area_idx {
+    /* Location of the first entry in the area. */
+#if MYNEWT_VAL(LOG_FCB)
+    struct fcb_entry lfa_first;
+#elif MYNEWT_VAL(LOG_FCB2)
+    struct fcb2_entry lfa_first;
+#endif
+    /* Timestamp and index of the first entry in the area. */
+    int64_t lfa_first_ts;
+    uint32_t lfa_first_index;
+    /* Number of entries in the area; 0 if the area is empty. */
+    uint16_t lfa_count;
+};
+
+/** Per-area index of an fcb log. */
+struct log_fcb_index {
+    /** Array of area summaries, indexed by area number. */
+    struct log_fcb_area_idx *lfi_areas;
+
+    /** The number of elements in lfi_areas. */
+    int lfi_cap;
+};
+
 /**
  * fcb_log is needed as the number of entries in a log
  */
@@ -72,6 +96,9 @@ struct fcb_log {
 #if MYNEWT_VAL(LOG_FCB_BOOKMARKS)
     struct log_fcb_bset fl_bset;
 #endif
+#if MYNEWT_VAL(LOG_FCB_INDEX)
+    struct log_fcb_index fl_index;
+#endif
 };
 
 #elif MYNEWT_VAL(LOG_FCB2)
@@ -87,6 +114,9 @@ struct fcb_log {
 #if MYNEWT_VAL(LOG_FCB_BOOKMARKS)
     struct log_fcb_bset fl_bset;
 #endif
+#if MYNEWT_VAL(LOG_FCB_INDEX)
+    struct log_fcb_index fl_index;
+#endif
 };
 #endif
 
@@ -161,6 +191,91 @@ void log_fcb_add_bmark(struct fcb_log *fcb_log, const struct fcb2_entry *entry,
 #endif
 #endif
 
+#if MYNEWT_VAL(LOG_FCB_INDEX)
+
+/**
+ * The area index keeps, for each flash area of an FCB-backed log, the index
+ * and timestamp of the first entry in the area and the number of entries.
+ * Since both entry indices and timestamps only grow, the area holding the
+ * start of a walk can be found by binary search; only the entries of that
+ * one area are then read.
+ *
+ * The index lives in RAM.  It is rebuilt from flash when the log is
+ * registered and kept current as entries are appended and areas rotated.
+ */
+
+struct log;
+struct log_entry_hdr;
+
+/**
+ * @brief Configures an fcb_log to use the specified buffer for its area
+ * index.  Must be called before the log is registered.
+ *
+ * @param fcb_log               The log to configure.
+ * @param buf                   The buffer to use for the index.
+ * @param area_count            The number of elements in buf.  If this is
+ *                                  less than the number of areas in the
+ *                                  FCB, the index is not used.
+ */
+void log_fcb_init_index(struct fcb_log *fcb_log,
+                        struct log_fcb_area_idx *buf, int area_count);
+
+/**
+ * @brief Rebuilds the area index of an fcb log from the contents of flash.
+ *
+ * @param log                   The log to index.
+ *
+ * @return                      0 on success; nonzero on failure.
+ */
+int log_fcb_build_index(struct log *log);
+
+/**
+ * @brief Erases the area index of the supplied fcb_log.
+ *
+ * @param fcb_log               The fcb_log to clear.
+ */
+void log_fcb_clear_index(struct fcb_log *fcb_log);
+
+/**
+ * @brief Forgets the oldest FCB/FCB2 area.  This is meant to get called
+ * just before the area is rotated out.
+ *
+ * @param fcb_log               The fcb_log to operate on.
+ */
+void log_fcb_rotate_index(struct fcb_log *fcb_log);
+
+/**
+ * @brief Records a newly appended entry in the area index.
+ *
+ * @param fcb_log               The log the entry was appended to.
+ * @param entry                 The location of the entry.
+ * @param hdr                   The header of the entry.
+ */
+#if MYNEWT_VAL(LOG_FCB)
+void log_fcb_add_index(struct fcb_log *fcb_log, const struct fcb_entry *entry,
+                       const struct log_entry_hdr *hdr);
+#elif MYNEWT_VAL(LOG_FCB2)
+void log_fcb_add_index(struct fcb_log *fcb_log, const struct fcb2_entry *entry,
+                       const struct log_entry_hdr *hdr);
+#endif
+
+/**
+ * @brief Searches the area index for the newest area whose first entry
+ * precedes the first entry with an index >= `index` and a timestamp >= `ts`.
+ *
+ * @param fcb_log               The log to search.
+ * @param index                 The minimum entry index.
+ * @param ts                    The minimum timestamp; 0 for any.
+ *
+ * @return                      The area to start looking in;
+ *                              NULL if the log is empty or has no usable
+ *                                  index.
+ */
+const struct log_fcb_area_idx *
+log_fcb_closest_area(const struct fcb_log *fcb_log, uint32_t index,
+                     int64_t ts);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -73,6 +73,8 @@ TEST_CASE_DECL(log_test_case_level);
 TEST_CASE_DECL(log_test_case_append_cb);
 
 TEST_CASE_DECL(log_test_case_2logs);
+TEST_CASE_DECL(log_test_case_deferred);
+TEST_CASE_DECL(log_test_case_fcb_index);
 
 #ifdef __cplusplus
 }
@@ -53,4 +53,10 @@ TEST_SUITE(log_test_suite_misc)
 #if MYNEWT_VAL(LOG_FCB)
     log_test_case_2logs();
 #endif
+#if MYNEWT_VAL(LOG_DEFERRED)
+    log_test_case_deferred();
+#endif
+#if MYNEWT_VAL(LOG_FCB_INDEX)
+    log_test_case_fcb_index();
+#endif
 }
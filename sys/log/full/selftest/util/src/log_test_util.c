@@ -186,6 +186,9 @@ ltu_walk_verify(struct log *log, struct log_offset *log_offset,
 {
     int rc;
     struct log_entry_hdr ueh;
+#if MYNEWT_VAL(LOG_FLAGS_IMAGE_HASH)
+    struct log_entry_hdr cur;
+#endif
     struct os_mbuf *om;
     char data[128];
     int dlen;
@@ -215,6 +218,13 @@ ltu_walk_verify(struct log *log, struct log_offset *log_offset,
     rc = log_read_hdr(log, dptr, &ueh);
     TEST_ASSERT(rc == 0);
 
+#if MYNEWT_VAL(LOG_FLAGS_IMAGE_HASH)
+    memset(&cur, 0, sizeof cur);
+    log_fill_current_img_hash(&cur);
+    TEST_ASSERT(ueh.ue_flags & LOG_FLAGS_IMG_HASH);
+    TEST_ASSERT(!memcmp(ueh.ue_imghash, cur.ue_imghash, LOG_IMG_HASHLEN));
+#endif
+
     rc = log_read_body(log, dptr, data, 0, dlen);
     TEST_ASSERT(rc == dlen);
 
@@ -21,10 +21,13 @@
 
 TEST_CASE_SELF(log_test_case_cbmem_append_mbuf)
 {
+    uint8_t buf[LOG_HDR_SIZE + 128];
     struct cbmem cbmem;
     struct os_mbuf *om;
     struct log log;
+    uint32_t idx;
     char *str;
+    int len;
     int rc;
     int i;
 
@@ -36,16 +39,39 @@ TEST_CASE_SELF(log_test_case_cbmem_append_mbuf)
             break;
         }
 
-        /* Split chain into several mbufs. */
-        om = ltu_flat_to_fragged_mbuf(str, strlen(str), 2);
+        if (i % 2 == 0) {
+            /* Split chain into several mbufs. */
+            om = ltu_flat_to_fragged_mbuf(str, strlen(str), 2);
 
-        /* Prepend space for the entry header. */
-        om = os_mbuf_prepend(om, LOG_HDR_SIZE);
-        TEST_ASSERT(om != NULL);
+            /* Prepend space for the entry header. */
+            om = os_mbuf_prepend(om, LOG_HDR_SIZE);
+            TEST_ASSERT(om != NULL);
+        } else {
+            /* Split the header space across mbufs as well. */
+            len = strlen(str);
+            TEST_ASSERT_FATAL(len <= sizeof buf - LOG_HDR_SIZE);
+            memset(buf, 0xff, LOG_HDR_SIZE);
+            memcpy(buf + LOG_HDR_SIZE, str, len);
+            om = ltu_flat_to_fragged_mbuf(buf, LOG_HDR_SIZE + len, 2);
+        }
 
         rc = log_append_mbuf_typed(&log, 0, 0, LOG_ETYPE_STRING, om);
         TEST_ASSERT_FATAL(rc == 0);
     }
 
     ltu_verify_contents(&log);
+
+    /* An entry that is too long is dropped without using up an index. */
+    idx = log_get_last_index(&log);
+    log_set_max_entry_len(&log, 4);
+
+    om = ltu_flat_to_fragged_mbuf("too long", 8, 2);
+    om = os_mbuf_prepend(om, LOG_HDR_SIZE);
+    TEST_ASSERT_FATAL(om != NULL);
+
+    rc = log_append_mbuf_typed(&log, 0, 0, LOG_ETYPE_STRING, om);
+    TEST_ASSERT(rc != 0);
+    TEST_ASSERT(log_get_last_index(&log) == idx);
+
+    log_set_max_entry_len(&log, 0);
 }
@@ -0,0 +1,182 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "log_test_util/log_test_util.h"
+
+#if MYNEWT_VAL(LOG_DEFERRED)
+
+static uint32_t ltcd_buf[64];
+static int ltcd_num_cbs;
+static uint32_t ltcd_last_idx;
+
+static void
+ltcd_append_cb(struct log *log, uint32_t idx)
+{
+    if (ltcd_num_cbs > 0) {
+        TEST_ASSERT(idx == ltcd_last_idx + 1);
+    }
+    ltcd_last_idx = idx;
+    ltcd_num_cbs++;
+}
+
+static int
+ltcd_walk_count(struct log *log, struct log_offset *log_offset,
+                const void *dptr, uint16_t len)
+{
+    (*(int *)log_offset->lo_arg)++;
+    return 0;
+}
+
+static int
+ltcd_count(struct log *log)
+{
+    struct log_offset log_offset = { 0 };
+    int cnt;
+    int rc;
+
+    cnt = 0;
+    log_offset.lo_arg = &cnt;
+    rc = log_walk(log, ltcd_walk_count, &log_offset);
+    TEST_ASSERT(rc == 0);
+
+    return cnt;
+}
+
+TEST_CASE_SELF(log_test_case_deferred)
+{
+    struct log_deferred ld;
+    struct fcb_log fcb_log;
+    struct os_mbuf *om;
+    struct log log;
+    char *str;
+    int num_strs;
+    int rc;
+    int i;
+#if MYNEWT_VAL(LOG_STATS)
+    uint32_t deferred_drops;
+    uint32_t errs;
+#endif
+
+    ltu_setup_fcb(&fcb_log, &log);
+    log_set_append_cb(&log, ltcd_append_cb);
+
+    rc = log_set_deferred(&log, &ld, ltcd_buf, sizeof ltcd_buf);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /*** Entries are only staged until the log is flushed. */
+
+    ltcd_num_cbs = 0;
+    for (i = 0; ; i++) {
+        str = ltu_str_logs[i];
+        if (!str) {
+            break;
+        }
+        rc = log_append_body(&log, 0, 0, LOG_ETYPE_STRING, str, strlen(str));
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+    num_strs = i;
+
+    TEST_ASSERT(ltcd_count(&log) == 0);
+    TEST_ASSERT(ltcd_num_cbs == 0);
+
+    rc = log_deferred_flush(&log);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(ltcd_num_cbs == num_strs);
+    TEST_ASSERT(ld.ld_drops == 0);
+
+    ltu_verify_contents(&log);
+
+    /*** Mbuf entries are staged with the header length set by prepare. */
+
+    rc = log_flush(&log);
+    TEST_ASSERT(rc == 0);
+
+    ltcd_num_cbs = 0;
+    for (i = 0; i < num_strs; i++) {
+        str = ltu_str_logs[i];
+        om = ltu_flat_to_fragged_mbuf(str, strlen(str), 2);
+
+        /* Stale flags in the header space must not change its length. */
+        om = os_mbuf_prepend(om, LOG_HDR_SIZE);
+        TEST_ASSERT_FATAL(om != NULL);
+        memset(om->om_data, 0xff, LOG_HDR_SIZE);
+
+        rc = log_append_mbuf_typed(&log, 0, 0, LOG_ETYPE_STRING, om);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+
+    rc = log_deferred_flush(&log);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(ltcd_num_cbs == num_strs);
+
+    ltu_verify_contents(&log);
+
+    /*** Entries that do not fit are dropped and counted. */
+
+#if MYNEWT_VAL(LOG_STATS)
+    deferred_drops = STATS_GET(log.l_stats, deferred_drops);
+    errs = STATS_GET(log.l_stats, errs);
+#endif
+
+    ltcd_num_cbs = 0;
+    for (i = 0; ; i++) {
+        rc = log_append_body(&log, 0, 0, LOG_ETYPE_STRING, "0123456789", 10);
+        if (rc != 0) {
+            break;
+        }
+    }
+    TEST_ASSERT(i > 0);
+    TEST_ASSERT(ld.ld_drops == 1);
+#if MYNEWT_VAL(LOG_STATS)
+    TEST_ASSERT(STATS_GET(log.l_stats, errs) == errs + 1);
+    TEST_ASSERT(STATS_GET(log.l_stats, deferred_drops) == deferred_drops + 1);
+#endif
+
+    /* log_flush() writes the staged entries out before erasing the log. */
+    rc = log_flush(&log);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(ltcd_num_cbs == i);
+    TEST_ASSERT(ltcd_count(&log) == 0);
+
+    /*** The ring wraps; all entries come out in order. */
+
+    ltcd_num_cbs = 0;
+    for (i = 0; i < 100; i++) {
+        rc = log_append_body(&log, 0, 0, LOG_ETYPE_STRING, "0123456789",
+                             i % 11);
+        TEST_ASSERT_FATAL(rc == 0);
+        if (i % 3 == 2) {
+            rc = log_deferred_flush(&log);
+            TEST_ASSERT(rc == 0);
+        }
+    }
+
+    /*** Back to synchronous mode; staged entries are written first. */
+
+    rc = log_set_deferred(&log, NULL, NULL, 0);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(ltcd_num_cbs == 100);
+    TEST_ASSERT(ltcd_count(&log) == 100);
+
+    rc = log_append_body(&log, 0, 0, LOG_ETYPE_STRING, "sync", 4);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(ltcd_num_cbs == 101);
+}
+
+#endif
@@ -0,0 +1,133 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "log_test_util/log_test_util.h"
+
+#if MYNEWT_VAL(LOG_FCB_INDEX)
+
+#define LTCFI_NUM_ENTRIES   2000
+
+static struct log_fcb_area_idx ltcfi_areas[2];
+
+struct ltcfi_walk_arg {
+    uint32_t first;
+    int count;
+};
+
+static int
+ltcfi_walk_cb(struct log *log, struct log_offset *log_offset,
+              const void *dptr, uint16_t len)
+{
+    struct ltcfi_walk_arg *arg;
+    struct log_entry_hdr hdr;
+    int rc;
+
+    arg = log_offset->lo_arg;
+
+    rc = log_read_hdr(log, dptr, &hdr);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    if (arg->count == 0) {
+        arg->first = hdr.ue_index;
+    }
+    arg->count++;
+
+    return 0;
+}
+
+static struct ltcfi_walk_arg
+ltcfi_walk(struct log *log, uint32_t index)
+{
+    struct ltcfi_walk_arg arg = { 0 };
+    struct log_offset log_offset = {
+        .lo_arg = &arg,
+        .lo_index = index,
+    };
+    int rc;
+
+    rc = log_walk(log, ltcfi_walk_cb, &log_offset);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    return arg;
+}
+
+TEST_CASE_SELF(log_test_case_fcb_index)
+{
+    struct ltcfi_walk_arg all;
+    struct ltcfi_walk_arg arg;
+    struct fcb_log fcb_log;
+    struct log log;
+    uint32_t last;
+    uint32_t idx;
+    int rc;
+    int i;
+
+    ltu_setup_fcb(&fcb_log, &log);
+    log_fcb_init_index(&fcb_log, ltcfi_areas,
+                       sizeof ltcfi_areas / sizeof ltcfi_areas[0]);
+    rc = log_fcb_build_index(&log);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /*** Empty log. */
+    TEST_ASSERT(log_fcb_closest_area(&fcb_log, 0, 0) == NULL);
+    arg = ltcfi_walk(&log, 0);
+    TEST_ASSERT(arg.count == 0);
+
+    /*** Fill the log enough that it wraps several times. */
+    for (i = 0; i < LTCFI_NUM_ENTRIES; i++) {
+        rc = log_append_body(&log, 0, 0, LOG_ETYPE_STRING,
+                             "0123456789abcdef", 16);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+
+    all = ltcfi_walk(&log, 0);
+    TEST_ASSERT_FATAL(all.count > 0 && all.count < LTCFI_NUM_ENTRIES);
+    last = all.first + all.count - 1;
+
+    /*** Every walk starts at the first entry with a matching index. */
+    for (idx = 0; idx <= last + 1; idx += 7) {
+        arg = ltcfi_walk(&log, idx);
+        if (idx <= all.first) {
+            TEST_ASSERT(arg.first == all.first);
+            TEST_ASSERT(arg.count == all.count);
+        } else if (idx <= last) {
+            TEST_ASSERT(arg.first == idx);
+            TEST_ASSERT(arg.count == last - idx + 1);
+        } else {
+            TEST_ASSERT(arg.count == 0);
+        }
+    }
+
+    /*** A rebuilt index gives the same answers as the maintained one. */
+    rc = log_fcb_build_index(&log);
+    TEST_ASSERT_FATAL(rc == 0);
+    arg = ltcfi_walk(&log, last);
+    TEST_ASSERT(arg.first == last);
+    TEST_ASSERT(arg.count == 1);
+    arg = ltcfi_walk(&log, 0);
+    TEST_ASSERT(arg.first == all.first);
+    TEST_ASSERT(arg.count == all.count);
+
+    /*** Flushing empties the index. */
+    rc = log_flush(&log);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(log_fcb_closest_area(&fcb_log, 0, 0) == NULL);
+}
+
+#endif
@@ -25,6 +25,7 @@
 #include "os/mynewt.h"
 #include "cbmem/cbmem.h"
 #include "log/log.h"
+#include "log_priv.h"
 #if MYNEWT_VAL(LOG_STORAGE_WATERMARK)
 #include "config/config.h"
 #endif
@@ -81,6 +82,9 @@ STATS_NAME_START(logs)
   STATS_NAME(logs, errs)
   STATS_NAME(logs, lost)
   STATS_NAME(logs, too_long)
+#if MYNEWT_VAL(LOG_DEFERRED)
+  STATS_NAME(logs, deferred_drops)
+#endif
 STATS_NAME_END(logs)
 #endif
 
@@ -162,6 +166,10 @@ log_init(void)
     log_console_init();
 #endif
 
+#if MYNEWT_VAL(LOG_DEFERRED)
+    log_deferred_init();
+#endif
+
 #if MYNEWT_VAL(LOG_STORAGE_WATERMARK)
 #if MYNEWT_VAL(LOG_PERSIST_WATERMARK)
     rc = conf_register(&log_conf);
@@ -393,6 +401,9 @@ log_register(const char *name, struct log *log, const struct log_handler *lh,
 #if !MYNEWT_VAL(LOG_GLOBAL_IDX)
     log->l_idx = 0;
 #endif
+#if MYNEWT_VAL(LOG_DEFERRED)
+    log->l_deferred = NULL;
+#endif
 
     if (!log_registered(log)) {
         STAILQ_INSERT_TAIL(&g_log_list, log, l_next);
@@ -495,6 +506,16 @@ log_chk_max_entry_len(struct log *log, uint16_t len)
     return rc;
 }
 
+static inline int
+log_is_deferred(const struct log *log)
+{
+#if MYNEWT_VAL(LOG_DEFERRED)
+    return log->l_deferred != NULL;
+#else
+    return 0;
+#endif
+}
+
 static int
 log_append_prepare(struct log *log, uint8_t module, uint8_t level,
                    uint8_t etype, struct log_entry_hdr *ue)
@@ -502,7 +523,6 @@ log_append_prepare(struct log *log, uint8_t module, uint8_t level,
     int rc;
     int sr;
     struct os_timeval tv;
-    uint32_t idx;
 
     rc = 0;
 
@@ -538,13 +558,12 @@ log_append_prepare(struct log *log, uint8_t module, uint8_t level,
         goto err;
     }
 
-    OS_ENTER_CRITICAL(sr);
-#if MYNEWT_VAL(LOG_GLOBAL_IDX)
-    idx = g_log_info.li_next_index++;
-#else
-    idx = log->l_idx++;
-#endif
-    OS_EXIT_CRITICAL(sr);
+    /* Deferred logs assign the index when the entry is staged. */
+    if (!log_is_deferred(log)) {
+        OS_ENTER_CRITICAL(sr);
+        ue->ue_index = log_next_index(log);
+        OS_EXIT_CRITICAL(sr);
+    }
 
     /* Try to get UTC Time */
     rc = os_gettimeofday(&tv, NULL);
@@ -556,7 +575,6 @@ log_append_prepare(struct log *log, uint8_t module, uint8_t level,
 
     ue->ue_level = level;
     ue->ue_module = module;
-    ue->ue_index = idx;
     ue->ue_etype = etype;
     /* Clear flags before assigning */
     ue->ue_flags = 0;
@@ -571,10 +589,20 @@ err:
     return (rc);
 }
 
+uint32_t
+log_next_index(struct log *log)
+{
+#if MYNEWT_VAL(LOG_GLOBAL_IDX)
+    return g_log_info.li_next_index++;
+#else
+    return log->l_idx++;
+#endif
+}
+
 /**
  * Calls the given log's append callback, if it has one.
  */
-static void
+void
 log_call_append_cb(struct log *log, uint32_t idx)
 {
     /* Qualify this as `volatile` to prevent a race condition.  This prevents
@@ -613,6 +641,17 @@ log_append_typed(struct log *log, uint8_t module, uint8_t level, uint8_t etype,
         goto err;
     }
 
+#if MYNEWT_VAL(LOG_DEFERRED)
+    if (log_is_deferred(log)) {
+        rc = log_deferred_append(log, hdr,
+                                 (uint8_t *)data + log_hdr_len(hdr), len);
+        if (rc != 0) {
+            LOG_STATS_INC(log, errs);
+        }
+        return rc;
+    }
+#endif
+
     rc = log->l_log->log_append(log, data, len + log_hdr_len(hdr));
     if (rc != 0) {
         LOG_STATS_INC(log, errs);
@@ -646,6 +685,16 @@ log_append_body(struct log *log, uint8_t module, uint8_t level, uint8_t etype,
         return rc;
     }
 
+#if MYNEWT_VAL(LOG_DEFERRED)
+    if (log_is_deferred(log)) {
+        rc = log_deferred_append(log, &hdr, body, body_len);
+        if (rc != 0) {
+            LOG_STATS_INC(log, errs);
+        }
+        return rc;
+    }
+#endif
+
     rc = log->l_log->log_append_body(log, &hdr, body, body_len);
     if (rc != 0) {
         LOG_STATS_INC(log, errs);
@@ -676,21 +725,14 @@ log_append_mbuf_typed_no_free(struct log *log, uint8_t module, uint8_t level,
         goto err;
     }
 
-    hdr = (struct log_entry_hdr *)om->om_data;
-
     /*
-     * We do a pull up twice, once so that the base header is
-     * contiguous, so that we read the flags correctly, second
-     * time is so that we account for the image hash as well.
+     * The caller reserved LOG_HDR_SIZE bytes for the header: the base header
+     * plus the image hash if LOG_FLAGS_IMAGE_HASH is on.  Make all of it
+     * contiguous before preparing the header in place, so the hash is
+     * written inside the first mbuf and no later pullup moves body bytes
+     * over it.
      */
-    om = os_mbuf_pullup(om, LOG_BASE_ENTRY_HDR_SIZE);
-    if (!om) {
-        rc = -1;
-        goto err;
-    }
-
-    hdr_len = log_hdr_len(hdr);
-
+    hdr_len = LOG_HDR_SIZE;
     om = os_mbuf_pullup(om, hdr_len);
     if (!om) {
         rc = -1;
@@ -702,7 +744,8 @@ log_append_mbuf_typed_no_free(struct log *log, uint8_t module, uint8_t level,
      * may appear a bit odd in that it checks that the length is greater than
      * a log entry header length. The reason for this check is to ensure any
      * error handling of this case to be the same as it was before the
-     * maximum entry length was checked.
+     * maximum entry length was checked.  It comes before preparing the
+     * header so a dropped entry doesn't use up an index.
      */
     len = os_mbuf_len(om);
     if (len > hdr_len) {
@@ -712,11 +755,25 @@ log_append_mbuf_typed_no_free(struct log *log, uint8_t module, uint8_t level,
         }
     }
 
+    hdr = (struct log_entry_hdr *)om->om_data;
+
     rc = log_append_prepare(log, module, level, etype, hdr);
     if (rc != 0) {
         LOG_STATS_INC(log, drops);
         goto drop;
     }
+    assert(log_hdr_len(hdr) == hdr_len);
+
+#if MYNEWT_VAL(LOG_DEFERRED)
+    if (log_is_deferred(log)) {
+        rc = log_deferred_append_mbuf(log, hdr, om, hdr_len, len - hdr_len);
+        if (rc != 0) {
+            goto err;
+        }
+        *om_ptr = om;
+        return 0;
+    }
+#endif
 
     rc = log->l_log->log_append_mbuf(log, om);
     if (rc != 0) {
@@ -781,6 +838,16 @@ log_append_mbuf_body_no_free(struct log *log, uint8_t module, uint8_t level,
         goto drop;
     }
 
+#if MYNEWT_VAL(LOG_DEFERRED)
+    if (log_is_deferred(log)) {
+        rc = log_deferred_append_mbuf(log, &hdr, om, 0, len);
+        if (rc != 0) {
+            goto err;
+        }
+        return 0;
+    }
+#endif
+
     rc = log->l_log->log_append_mbuf_body(log, &hdr, om);
     if (rc != 0) {
         goto err;
@@ -1021,6 +1088,14 @@ log_flush(struct log *log)
 {
     int rc;
 
+#if MYNEWT_VAL(LOG_DEFERRED)
+    /* Entries staged before the flush must not show up after it. */
+    rc = log_deferred_flush(log);
+    if (rc != 0) {
+        goto err;
+    }
+#endif
+
     rc = log->l_log->log_flush(log);
     if (rc != 0) {
         goto err;
@@ -0,0 +1,357 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include <string.h>
+
+#include "os/mynewt.h"
+
+#if MYNEWT_VAL(LOG_DEFERRED)
+
+#include "log/log.h"
+#include "log_priv.h"
+
+/**
+ * Header of a record in a staging ring.  Entries never wrap around the end
+ * of the ring; a record with a length of 0 pads the space up to the end.
+ */
+struct log_deferred_rec {
+    uint16_t ldr_len;
+    volatile uint8_t ldr_ready;
+    uint8_t ldr_pad;
+};
+
+#define LOG_DEFERRED_REC_SIZE(len) \
+    OS_ALIGN(sizeof(struct log_deferred_rec) + (len), 4)
+
+static struct os_eventq log_deferred_evq;
+static struct os_task log_deferred_task;
+OS_TASK_STACK_DEFINE(log_deferred_stack, MYNEWT_VAL(LOG_DEFERRED_STACK_SIZE));
+
+/**
+ * Reserves ring space for an entry of the given length and assigns the
+ * entry its index.  The index is taken together with the ring space so that
+ * entries reach the log handler in index order.
+ *
+ * @return                      The reserved record; NULL if the ring is full.
+ */
+static struct log_deferred_rec *
+log_deferred_reserve(struct log *log, struct log_deferred *ld,
+                     struct log_entry_hdr *hdr, uint32_t len)
+{
+    struct log_deferred_rec *pad;
+    struct log_deferred_rec *rec;
+    uint32_t need;
+    uint32_t skip;
+    os_sr_t sr;
+
+    need = LOG_DEFERRED_REC_SIZE(len);
+
+    OS_ENTER_CRITICAL(sr);
+
+    if (len > UINT16_MAX) {
+        ld->ld_drops++;
+        OS_EXIT_CRITICAL(sr);
+        return NULL;
+    }
+
+    skip = 0;
+    if (ld->ld_head + need > ld->ld_size) {
+        skip = ld->ld_size - ld->ld_head;
+    }
+
+    if (need + skip > ld->ld_size - (ld->ld_in - ld->ld_out)) {
+        ld->ld_drops++;
+        OS_EXIT_CRITICAL(sr);
+        return NULL;
+    }
+
+    if (skip != 0) {
+        pad = (struct log_deferred_rec *)(ld->ld_buf + ld->ld_head);
+        pad->ldr_len = 0;
+        pad->ldr_ready = 1;
+        ld->ld_head = 0;
+    }
+
+    rec = (struct log_deferred_rec *)(ld->ld_buf + ld->ld_head);
+    rec->ldr_len = len;
+    rec->ldr_ready = 0;
+
+    ld->ld_head += need;
+    if (ld->ld_head == ld->ld_size) {
+        ld->ld_head = 0;
+    }
+    ld->ld_in += need + skip;
+
+    hdr->ue_index = log_next_index(log);
+
+    OS_EXIT_CRITICAL(sr);
+
+    return rec;
+}
+
+/**
+ * Marks a filled in record as ready and wakes the log task.  Both happen
+ * with interrupts disabled so that the log task cannot go idle in between.
+ */
+static void
+log_deferred_commit(struct log_deferred *ld, struct log_deferred_rec *rec)
+{
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    rec->ldr_ready = 1;
+    os_eventq_put(&log_deferred_evq, &ld->ld_ev);
+    OS_EXIT_CRITICAL(sr);
+}
+
+int
+log_deferred_append(struct log *log, struct log_entry_hdr *hdr,
+                    const void *body, uint16_t body_len)
+{
+    struct log_deferred_rec *rec;
+    struct log_deferred *ld;
+    uint16_t hdr_len;
+    uint8_t *dst;
+
+    ld = log->l_deferred;
+    hdr_len = log_hdr_len(hdr);
+
+    rec = log_deferred_reserve(log, ld, hdr, hdr_len + body_len);
+    if (rec == NULL) {
+        LOG_STATS_INC(log, deferred_drops);
+        return OS_ENOMEM;
+    }
+
+    dst = (uint8_t *)(rec + 1);
+    memcpy(dst, hdr, hdr_len);
+    memcpy(dst + hdr_len, body, body_len);
+
+    log_deferred_commit(ld, rec);
+
+    return 0;
+}
+
+int
+log_deferred_append_mbuf(struct log *log, struct log_entry_hdr *hdr,
+                         const struct os_mbuf *om, uint16_t off,
+                         uint16_t body_len)
+{
+    struct log_deferred_rec *rec;
+    struct log_deferred *ld;
+    uint16_t hdr_len;
+    uint8_t *dst;
+    int rc;
+
+    ld = log->l_deferred;
+    hdr_len = log_hdr_len(hdr);
+
+    rec = log_deferred_reserve(log, ld, hdr, hdr_len + body_len);
+    if (rec == NULL) {
+        LOG_STATS_INC(log, deferred_drops);
+        return OS_ENOMEM;
+    }
+
+    dst = (uint8_t *)(rec + 1);
+    memcpy(dst, hdr, hdr_len);
+    rc = os_mbuf_copydata(om, off, body_len, dst + hdr_len);
+    assert(rc == 0);
+
+    log_deferred_commit(ld, rec);
+
+    return 0;
+}
+
+/**
+ * Writes ready entries to the log handler, oldest first, until the ring is
+ * empty or the oldest entry is still being filled in.  The caller must hold
+ * the ring mutex.
+ */
+static void
+log_deferred_drain(struct log_deferred *ld)
+{
+    struct log_deferred_rec *rec;
+    struct log_entry_hdr *hdr;
+    struct log *log;
+    uint32_t tail;
+    uint32_t step;
+    os_sr_t sr;
+    int rc;
+
+    log = ld->ld_log;
+
+    while (ld->ld_in != ld->ld_out) {
+        rec = (struct log_deferred_rec *)(ld->ld_buf + ld->ld_tail);
+        if (!rec->ldr_ready) {
+            break;
+        }
+
+        if (rec->ldr_len == 0) {
+            step = ld->ld_size - ld->ld_tail;
+        } else {
+            hdr = (struct log_entry_hdr *)(rec + 1);
+            rc = log->l_log->log_append(log, hdr, rec->ldr_len);
+            if (rc != 0) {
+                LOG_STATS_INC(log, errs);
+            } else {
+                log_call_append_cb(log, hdr->ue_index);
+            }
+            step = LOG_DEFERRED_REC_SIZE(rec->ldr_len);
+        }
+
+        tail = ld->ld_tail + step;
+        if (tail == ld->ld_size) {
+            tail = 0;
+        }
+
+        OS_ENTER_CRITICAL(sr);
+        ld->ld_tail = tail;
+        ld->ld_out += step;
+        OS_EXIT_CRITICAL(sr);
+    }
+}
+
+/**
+ * Drains the ring until everything reserved before the call has been
+ * written.  A writer that was preempted while filling in its entry holds up
+ * the entries behind it; give it a chance to run.
+ */
+static int
+log_deferred_flush_ring(struct log_deferred *ld)
+{
+    uint32_t target;
+    int rc;
+
+    rc = os_mutex_pend(&ld->ld_mtx, OS_TIMEOUT_NEVER);
+    if (rc != 0 && rc != OS_NOT_STARTED) {
+        return rc;
+    }
+
+    target = ld->ld_in;
+    while (1) {
+        log_deferred_drain(ld);
+        if ((int32_t)(ld->ld_out - target) >= 0 || !os_started()) {
+            break;
+        }
+        os_time_delay(1);
+    }
+
+    os_mutex_release(&ld->ld_mtx);
+
+    return 0;
+}
+
+int
+log_deferred_flush(struct log *log)
+{
+    struct log_deferred *ld;
+
+    ld = log->l_deferred;
+    if (ld == NULL) {
+        return 0;
+    }
+
+    return log_deferred_flush_ring(ld);
+}
+
+static void
+log_deferred_event_cb(struct os_event *ev)
+{
+    struct log_deferred *ld;
+
+    ld = ev->ev_arg;
+
+    os_mutex_pend(&ld->ld_mtx, OS_TIMEOUT_NEVER);
+    log_deferred_drain(ld);
+    os_mutex_release(&ld->ld_mtx);
+}
+
+int
+log_set_deferred(struct log *log, struct log_deferred *ld, void *buf,
+                 uint32_t buf_size)
+{
+    struct log_deferred *old;
+    os_sr_t sr;
+    int rc;
+
+    if (ld != NULL) {
+        buf_size &= ~3;
+        if (((uintptr_t)buf & 3) != 0 ||
+            buf_size < LOG_DEFERRED_REC_SIZE(LOG_BASE_ENTRY_HDR_SIZE)) {
+            return SYS_EINVAL;
+        }
+    }
+
+    /* New entries go to the handler directly from here on; write out what
+     * the old ring still holds.
+     */
+    OS_ENTER_CRITICAL(sr);
+    old = log->l_deferred;
+    log->l_deferred = NULL;
+    OS_EXIT_CRITICAL(sr);
+
+    if (old != NULL) {
+        rc = log_deferred_flush_ring(old);
+        if (rc != 0) {
+            log->l_deferred = old;
+            return rc;
+        }
+        os_eventq_remove(&log_deferred_evq, &old->ld_ev);
+    }
+
+    if (ld == NULL) {
+        return 0;
+    }
+
+    memset(ld, 0, sizeof(*ld));
+    ld->ld_log = log;
+    ld->ld_buf = buf;
+    ld->ld_size = buf_size;
+    ld->ld_ev.ev_cb = log_deferred_event_cb;
+    ld->ld_ev.ev_arg = ld;
+    os_mutex_init(&ld->ld_mtx);
+
+    log->l_deferred = ld;
+
+    return 0;
+}
+
+static void
+log_deferred_task_handler(void *arg)
+{
+    while (1) {
+        os_eventq_run(&log_deferred_evq);
+    }
+}
+
+void
+log_deferred_init(void)
+{
+    int rc;
+
+    os_eventq_init(&log_deferred_evq);
+
+    rc = os_task_init(&log_deferred_task, "log", log_deferred_task_handler,
+                      NULL, MYNEWT_VAL(LOG_DEFERRED_TASK_PRIO),
+                      OS_WAIT_FOREVER, log_deferred_stack,
+                      OS_STACK_ALIGN(MYNEWT_VAL(LOG_DEFERRED_STACK_SIZE)));
+    SYSINIT_PANIC_ASSERT(rc == 0);
+}
+
+#endif
@@ -111,7 +111,8 @@ found_ent:
  *
  * The "index" field corresponds to a log entry index.
  *
- * If bookmarks are enabled, this function uses them in the search.
+ * If bookmarks or the area index are enabled, this function uses them in the
+ * search.
  *
  * @return                      0 if an entry was found
  *                              SYS_ENOENT if there are no suitable entries.
@@ -123,12 +124,15 @@ log_fcb_find_gte(struct log *log, struct log_offset *log_offset,
 {
 #if MYNEWT_VAL(LOG_FCB_BOOKMARKS)
     const struct log_fcb_bmark *bmark;
+#endif
+#if MYNEWT_VAL(LOG_FCB_INDEX)
+    const struct log_fcb_area_idx *area;
 #endif
     struct log_entry_hdr hdr;
     struct fcb_log *fcb_log;
     struct fcb *fcb;
     int rc;
-    bool bmark_found = false;
+    bool start_found = false;
 
     fcb_log = log->l_arg;
     fcb = &fcb_log->fl_fcb;
@@ -161,11 +165,27 @@ log_fcb_find_gte(struct log *log, struct log_offset *log_offset,
         return SYS_ENOENT;
     }
 
+#if MYNEWT_VAL(LOG_FCB_INDEX)
+    area = log_fcb_closest_area(fcb_log, log_offset->lo_index,
+                                log_offset->lo_ts);
+    if (area != NULL) {
+        *out_entry = area->lfa_first;
+        start_found = true;
+    }
+#endif
+
 #if MYNEWT_VAL(LOG_FCB_BOOKMARKS)
     bmark = log_fcb_closest_bmark(fcb_log, log_offset->lo_index);
+#if MYNEWT_VAL(LOG_FCB_INDEX)
+    /* Only use the bookmark if it is closer than the indexed area. */
+    if (bmark != NULL && area != NULL &&
+        bmark->lfb_index <= area->lfa_first_index) {
+        bmark = NULL;
+    }
+#endif
     if (bmark != NULL) {
         *out_entry = bmark->lfb_entry;
-        bmark_found = true;
+        start_found = true;
     }
 #endif
 
@@ -174,10 +194,10 @@ log_fcb_find_gte(struct log *log, struct log_offset *log_offset,
      * compare the ue_index with lo_index for the first entry of each
      * of these areas. If we find one that is less than the lo_index,
      * use that. This covers a case if we are looking for a an entry
-     * GTE to any random non-zero value. If bookmark is set, it is expected
-     * that the log is walked from there.
+     * GTE to any random non-zero value. If a bookmark or indexed area is
+     * found, it is expected that the log is walked from there.
      */
-    if ((bmark_found == false) && (log_offset->lo_index != 0)) {
+    if ((start_found == false) && (log_offset->lo_index != 0)) {
         rc = fcb_walk_back_find_start(fcb, log, log_offset, out_entry);
         if (rc != 0) {
             return rc;
@@ -250,6 +270,9 @@ log_fcb_start_append(struct log *log, int len, struct fcb_entry *loc)
         /* The FCB needs to be rotated. */
         log_fcb_rotate_bmarks(fcb_log);
 #endif
+#if MYNEWT_VAL(LOG_FCB_INDEX)
+        log_fcb_rotate_index(fcb_log);
+#endif
 
         rc = fcb_rotate(fcb);
         if (rc) {
@@ -294,35 +317,24 @@ log_fcb_hdr_body_bytes(uint8_t align, uint8_t hdr_len)
     return align - mod;
 }
 
+/**
+ * Writes an entry to space reserved in the FCB and finishes the append.
+ */
 static int
-log_fcb_append_body(struct log *log, const struct log_entry_hdr *hdr,
+log_fcb_write_entry(struct fcb *fcb, struct fcb_entry *loc,
+                    const struct log_entry_hdr *hdr,
                     const void *body, int body_len)
 {
     uint8_t buf[LOG_BASE_ENTRY_HDR_SIZE + LOG_IMG_HASHLEN +
                 LOG_FCB_MAX_ALIGN - 1];
-    struct fcb *fcb;
-    struct fcb_entry loc;
-    struct fcb_log *fcb_log;
     const uint8_t *u8p;
     int hdr_alignment;
     int chunk_sz;
     int rc;
     uint16_t hdr_len;
 
-    fcb_log = (struct fcb_log *)log->l_arg;
-    fcb = &fcb_log->fl_fcb;
-
-    if (fcb->f_align > LOG_FCB_MAX_ALIGN) {
-        return SYS_ENOTSUP;
-    }
-
     hdr_len = log_hdr_len(hdr);
 
-    rc = log_fcb_start_append(log, hdr_len + body_len, &loc);
-    if (rc != 0) {
-        return rc;
-    }
-
     /* Append the first chunk (header + x-bytes of body, where x is however
      * many bytes are required to increase the chunk size up to a multiple of
      * the flash alignment). If the hash flag is set, we have to account for
@@ -348,7 +360,7 @@ log_fcb_append_body(struct log *log, const struct log_entry_hdr *hdr,
     }
     memcpy(buf + hdr_len, u8p, hdr_alignment);
 
-    rc = flash_area_write(loc.fe_area, loc.fe_data_off, buf, chunk_sz);
+    rc = flash_area_write(loc->fe_area, loc->fe_data_off, buf, chunk_sz);
     if (rc != 0) {
         return rc;
     }
@@ -359,18 +371,46 @@ log_fcb_append_body(struct log *log, const struct log_entry_hdr *hdr,
     body_len -= hdr_alignment;
 
     if (body_len > 0) {
-        rc = flash_area_write(loc.fe_area, loc.fe_data_off + chunk_sz, u8p,
+        rc = flash_area_write(loc->fe_area, loc->fe_data_off + chunk_sz, u8p,
                               body_len);
         if (rc != 0) {
             return rc;
         }
     }
 
-    rc = fcb_append_finish(fcb, &loc);
+    return fcb_append_finish(fcb, loc);
+}
+
+static int
+log_fcb_append_body(struct log *log, const struct log_entry_hdr *hdr,
+                    const void *body, int body_len)
+{
+    struct fcb *fcb;
+    struct fcb_entry loc;
+    struct fcb_log *fcb_log;
+    int rc;
+
+    fcb_log = (struct fcb_log *)log->l_arg;
+    fcb = &fcb_log->fl_fcb;
+
+    if (fcb->f_align > LOG_FCB_MAX_ALIGN) {
+        return SYS_ENOTSUP;
+    }
+
+    rc = log_fcb_start_append(log, log_hdr_len(hdr) + body_len, &loc);
+    if (rc != 0) {
+        return rc;
+    }
+
+    rc = log_fcb_write_entry(fcb, &loc, hdr, body, body_len);
     if (rc != 0) {
         return rc;
     }
 
+#if MYNEWT_VAL(LOG_FCB_INDEX)
+    log_fcb_add_index(fcb_log, &loc, hdr);
+#endif
+
     return 0;
 }
 
@@ -456,6 +496,10 @@ log_fcb_append_mbuf_body(struct log *log, const struct log_entry_hdr *hdr,
         return rc;
     }
 
+#if MYNEWT_VAL(LOG_FCB_INDEX)
+    log_fcb_add_index(fcb_log, &loc, hdr);
+#endif
+
     return 0;
 }
 
@@ -651,6 +695,9 @@ log_fcb_flush(struct log *log)
 #if MYNEWT_VAL(LOG_FCB_BOOKMARKS)
     log_fcb_clear_bmarks(fcb_log);
 #endif
+#if MYNEWT_VAL(LOG_FCB_INDEX)
+    log_fcb_clear_index(fcb_log);
+#endif
 
     return fcb_clear(fcb);
 }
@@ -683,7 +730,11 @@ log_fcb_registered(struct log *log)
     fl->fl_watermark_off = 0xffffffff;
 #endif
 #endif
+#if MYNEWT_VAL(LOG_FCB_INDEX)
+    return log_fcb_build_index(log);
+#else
     return 0;
+#endif
 }
 
 #if MYNEWT_VAL(LOG_STORAGE_INFO)
@@ -834,10 +885,11 @@ log_fcb_copy_entry(struct log *log, struct fcb_entry *entry,
     struct log_entry_hdr ueh;
     char data[MYNEWT_VAL(LOG_FCB_COPY_MAX_ENTRY_LEN) + LOG_BASE_ENTRY_HDR_SIZE +
               LOG_IMG_HASHLEN];
+    struct fcb_log *fcb_log;
+    struct fcb_entry loc;
     uint16_t hdr_len;
     int dlen;
     int rc;
-    struct fcb *fcb_tmp;
 
     rc = log_fcb_read(log, entry, &ueh, 0, LOG_BASE_ENTRY_HDR_SIZE);
 
@@ -855,12 +907,20 @@ log_fcb_copy_entry(struct log *log, struct fcb_entry *entry,
         goto err;
     }
 
-    /* Changing the fcb to be logged to be dst fcb */
-    fcb_tmp = &((struct fcb_log *)log->l_arg)->fl_fcb;
-
-    log->l_arg = dst_fcb;
-    rc = log_fcb_append(log, data, dlen);
-    log->l_arg = fcb_tmp;
+    /* Entries going back into the log take the regular append path; the
+     * scratch FCB is written directly.
+     */
+    fcb_log = log->l_arg;
+    if (dst_fcb == &fcb_log->fl_fcb) {
+        rc = log_fcb_append(log, data, dlen);
+    } else {
+        rc = fcb_append(dst_fcb, dlen, &loc);
+        if (rc == 0) {
+            rc = log_fcb_write_entry(dst_fcb, &loc,
+                                     (struct log_entry_hdr *)data,
+                                     data + hdr_len, dlen - hdr_len);
+        }
+    }
     if (rc) {
         goto err;
     }
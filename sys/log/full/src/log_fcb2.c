@@ -46,7 +46,8 @@ static int log_fcb2_rtr_erase(struct log *log);
  *
  * The "index" field corresponds to a log entry index.
  *
- * If bookmarks are enabled, this function uses them in the search.
+ * If bookmarks or the area index are enabled, this function uses them in the
+ * search.
  *
  * @return                      0 if an entry was found
  *                              SYS_ENOENT if there are no suitable entries.
@@ -58,6 +59,9 @@ log_fcb2_find_gte(struct log *log, struct log_offset *log_offset,
 {
 #if MYNEWT_VAL(LOG_FCB_BOOKMARKS)
     const struct log_fcb_bmark *bmark;
+#endif
+#if MYNEWT_VAL(LOG_FCB_INDEX)
+    const struct log_fcb_area_idx *area;
 #endif
     struct log_entry_hdr hdr;
     struct fcb_log *fcb_log;
@@ -102,8 +106,22 @@ log_fcb2_find_gte(struct log *log, struct log_offset *log_offset,
     if (rc != 0) {
         return SYS_EUNKNOWN;
     }
+#if MYNEWT_VAL(LOG_FCB_INDEX)
+    area = log_fcb_closest_area(fcb_log, log_offset->lo_index,
+                                log_offset->lo_ts);
+    if (area != NULL) {
+        *out_entry = area->lfa_first;
+    }
+#endif
 #if MYNEWT_VAL(LOG_FCB_BOOKMARKS)
     bmark = log_fcb_closest_bmark(fcb_log, log_offset->lo_index);
+#if MYNEWT_VAL(LOG_FCB_INDEX)
+    /* Only use the bookmark if it is closer than the indexed area. */
+    if (bmark != NULL && area != NULL &&
+        bmark->lfb_index <= area->lfa_first_index) {
+        bmark = NULL;
+    }
+#endif
     if (bmark != NULL) {
         *out_entry = bmark->lfb_entry;
     }
@@ -173,6 +191,9 @@ log_fcb2_start_append(struct log *log, int len, struct fcb2_entry *loc)
         /* The FCB needs to be rotated. */
         log_fcb_rotate_bmarks(fcb_log);
 #endif
+#if MYNEWT_VAL(LOG_FCB_INDEX)
+        log_fcb_rotate_index(fcb_log);
+#endif
 
         rc = fcb2_rotate(fcb);
         if (rc) {
@@ -217,13 +238,15 @@ log_fcb2_hdr_body_bytes(uint8_t align, uint8_t hdr_len)
     return align - mod;
 }
 
+/**
+ * Writes an entry to space reserved in the FCB2 and finishes the append.
+ */
 static int
-log_fcb2_append_body(struct log *log, const struct log_entry_hdr *hdr,
+log_fcb2_write_entry(struct fcb2_entry *loc, const struct log_entry_hdr *hdr,
                      const void *body, int body_len)
 {
     uint8_t buf[LOG_BASE_ENTRY_HDR_SIZE + LOG_IMG_HASHLEN +
                 LOG_FCB2_MAX_ALIGN - 1];
-    struct fcb2_entry loc;
     const uint8_t *u8p;
     int hdr_alignment;
     int chunk_sz;
@@ -232,17 +255,12 @@ log_fcb2_append_body(struct log *log, const struct log_entry_hdr *hdr,
 
     hdr_len = log_hdr_len(hdr);
 
-    rc = log_fcb2_start_append(log, hdr_len + body_len, &loc);
-    if (rc != 0) {
-        return rc;
-    }
-
     /* Append the first chunk (header + x-bytes of body, where x is however
      * many bytes are required to increase the chunk size up to a multiple of
      * the flash alignment). If the hash flag is set, we have to account for
      * appending the hash right after the header.
      */
-    hdr_alignment = log_fcb2_hdr_body_bytes(loc.fe_range->fsr_align, hdr_len);
+    hdr_alignment = log_fcb2_hdr_body_bytes(loc->fe_range->fsr_align, hdr_len);
     if (hdr_alignment > body_len) {
         chunk_sz = hdr_len + body_len;
     } else {
@@ -262,7 +280,7 @@ log_fcb2_append_body(struct log *log, const struct log_entry_hdr *hdr,
     }
     memcpy(buf + hdr_len, u8p, hdr_alignment);
 
-    rc = fcb2_write(&loc, 0, buf, chunk_sz);
+    rc = fcb2_write(loc, 0, buf, chunk_sz);
     if (rc != 0) {
         return rc;
     }
@@ -273,17 +291,36 @@ log_fcb2_append_body(struct log *log, const struct log_entry_hdr *hdr,
     body_len -= hdr_alignment;
 
     if (body_len > 0) {
-        rc = fcb2_write(&loc, chunk_sz, u8p, body_len);
+        rc = fcb2_write(loc, chunk_sz, u8p, body_len);
         if (rc != 0) {
             return rc;
         }
     }
 
-    rc = fcb2_append_finish(&loc);
+    return fcb2_append_finish(loc);
+}
+
+static int
+log_fcb2_append_body(struct log *log, const struct log_entry_hdr *hdr,
+                     const void *body, int body_len)
+{
+    struct fcb2_entry loc;
+    int rc;
+
+    rc = log_fcb2_start_append(log, log_hdr_len(hdr) + body_len, &loc);
     if (rc != 0) {
         return rc;
     }
 
+    rc = log_fcb2_write_entry(&loc, hdr, body, body_len);
+    if (rc != 0) {
+        return rc;
+    }
+
+#if MYNEWT_VAL(LOG_FCB_INDEX)
+    log_fcb_add_index(log->l_arg, &loc, hdr);
+#endif
+
     return 0;
 }
 
@@ -366,6 +403,10 @@ log_fcb2_append_mbuf_body(struct log *log, const struct log_entry_hdr *hdr,
         return rc;
     }
 
+#if MYNEWT_VAL(LOG_FCB_INDEX)
+    log_fcb_add_index(log->l_arg, &loc, hdr);
+#endif
+
     return 0;
 }
 
@@ -468,13 +509,18 @@ done:
     return len - rem_len;
 }
 
+/**
+ * Walks either the full log or only the area holding the first entry that
+ * matches the offset.
+ */
 static int
-log_fcb2_walk(struct log *log, log_walk_func_t walk_func,
-              struct log_offset *log_off)
+log_fcb2_walk_impl(struct log *log, log_walk_func_t walk_func,
+                   struct log_offset *log_off, bool area)
 {
     struct fcb2 *fcb;
     struct fcb_log *fcb_log;
     struct fcb2_entry loc;
+    uint16_t sector;
     int rc;
 
     fcb_log = log->l_arg;
@@ -492,6 +538,7 @@ log_fcb2_walk(struct log *log, log_walk_func_t walk_func,
     default:
         return rc;
     }
+    sector = loc.fe_sector;
 
 #if MYNEWT_VAL(LOG_FCB_BOOKMARKS)
     /* If a minimum index was specified (i.e., we are not just retrieving the
@@ -503,6 +550,10 @@ log_fcb2_walk(struct log *log, log_walk_func_t walk_func,
 #endif
 
     do {
+        if (area && loc.fe_sector != sector) {
+            return 0;
+        }
+
         rc = walk_func(log, log_off, &loc, loc.fe_data_len);
         if (rc != 0) {
             if (rc < 0) {
@@ -516,6 +567,20 @@ log_fcb2_walk(struct log *log, log_walk_func_t walk_func,
     return 0;
 }
 
+static int
+log_fcb2_walk(struct log *log, log_walk_func_t walk_func,
+              struct log_offset *log_off)
+{
+    return log_fcb2_walk_impl(log, walk_func, log_off, false);
+}
+
+static int
+log_fcb2_walk_area(struct log *log, log_walk_func_t walk_func,
+                   struct log_offset *log_off)
+{
+    return log_fcb2_walk_impl(log, walk_func, log_off, true);
+}
+
 static int
 log_fcb2_flush(struct log *log)
 {
@@ -528,6 +593,9 @@ log_fcb2_flush(struct log *log)
 #if MYNEWT_VAL(LOG_FCB_BOOKMARKS)
     log_fcb_clear_bmarks(fcb_log);
 #endif
+#if MYNEWT_VAL(LOG_FCB_INDEX)
+    log_fcb_clear_index(fcb_log);
+#endif
 
     return fcb2_clear(fcb);
 }
@@ -571,7 +639,11 @@ log_fcb2_registered(struct log *log)
     fl->fl_watermark_off = 0xffffffff;
 #endif
 #endif
+#if MYNEWT_VAL(LOG_FCB_INDEX)
+    return log_fcb_build_index(log);
+#else
     return 0;
+#endif
 }
 
 #if MYNEWT_VAL(LOG_STORAGE_INFO)
@@ -739,10 +811,11 @@ log_fcb2_copy_entry(struct log *log, struct fcb2_entry *entry,
     struct log_entry_hdr ueh;
     char data[LOG_PRINTF_MAX_ENTRY_LEN + LOG_BASE_ENTRY_HDR_SIZE +
               LOG_IMG_HASHLEN];
+    struct fcb_log *fcb_log;
+    struct fcb2_entry loc;
     uint16_t hdr_len;
     int dlen;
     int rc;
-    struct fcb2 *fcb_tmp;
 
     rc = log_fcb2_read(log, entry, &ueh, 0, LOG_BASE_ENTRY_HDR_SIZE);
     if (rc != LOG_BASE_ENTRY_HDR_SIZE) {
@@ -759,12 +832,19 @@ log_fcb2_copy_entry(struct log *log, struct fcb2_entry *entry,
     }
 
     /*
-     * Changing the fcb to be logged to be dst fcb.
+     * Entries going back into the log take the regular append path; the
+     * scratch FCB2 is written directly.
      */
-    fcb_tmp = log->l_arg;
-    log->l_arg = dst_fcb;
-    rc = log_fcb2_append(log, data, dlen);
-    log->l_arg = fcb_tmp;
+    fcb_log = log->l_arg;
+    if (dst_fcb == &fcb_log->fl_fcb) {
+        rc = log_fcb2_append(log, data, dlen);
+    } else {
+        rc = fcb2_append(dst_fcb, dlen, &loc);
+        if (rc == 0) {
+            rc = log_fcb2_write_entry(&loc, (struct log_entry_hdr *)data,
+                                      data + hdr_len, dlen - hdr_len);
+        }
+    }
     if (rc) {
         goto err;
     }
@@ -894,6 +974,7 @@ const struct log_handler log_fcb_handler = {
     .log_append_mbuf = log_fcb2_append_mbuf,
     .log_append_mbuf_body = log_fcb2_append_mbuf_body,
     .log_walk = log_fcb2_walk,
+    .log_walk_sector = log_fcb2_walk_area,
     .log_flush = log_fcb2_flush,
 #if MYNEWT_VAL(LOG_STORAGE_INFO)
     .log_storage_info = log_fcb2_storage_info,
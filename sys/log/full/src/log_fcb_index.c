@@ -0,0 +1,269 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+
+#include "os/mynewt.h"
+
+#if MYNEWT_VAL(LOG_FCB_INDEX)
+
+#include "log/log.h"
+#include "log/log_fcb.h"
+
+#if MYNEWT_VAL(LOG_FCB)
+typedef struct fcb log_fcb_t;
+typedef struct fcb_entry log_fcb_entry_t;
+#define log_fcb_getnext fcb_getnext
+#elif MYNEWT_VAL(LOG_FCB2)
+typedef struct fcb2 log_fcb_t;
+typedef struct fcb2_entry log_fcb_entry_t;
+#define log_fcb_getnext fcb2_getnext
+#endif
+
+static int
+log_fcb_index_area_cnt(const log_fcb_t *fcb)
+{
+    return fcb->f_sector_cnt;
+}
+
+static int
+log_fcb_index_slot(const log_fcb_t *fcb, const log_fcb_entry_t *entry)
+{
+#if MYNEWT_VAL(LOG_FCB)
+    return entry->fe_area - fcb->f_sectors;
+#else
+    return entry->fe_sector;
+#endif
+}
+
+static int
+log_fcb_index_oldest(const log_fcb_t *fcb)
+{
+#if MYNEWT_VAL(LOG_FCB)
+    return fcb->f_oldest - fcb->f_sectors;
+#else
+    return fcb->f_oldest_sec;
+#endif
+}
+
+/**
+ * Returns the number of areas from the oldest to the active one, inclusive.
+ */
+static int
+log_fcb_index_span(const log_fcb_t *fcb)
+{
+    int cnt;
+    int span;
+
+    cnt = log_fcb_index_area_cnt(fcb);
+    span = log_fcb_index_slot(fcb, &fcb->f_active) -
+           log_fcb_index_oldest(fcb);
+    if (span < 0) {
+        span += cnt;
+    }
+
+    return span + 1;
+}
+
+void
+log_fcb_init_index(struct fcb_log *fcb_log,
+                   struct log_fcb_area_idx *buf, int area_count)
+{
+    fcb_log->fl_index = (struct log_fcb_index) {
+        .lfi_areas = buf,
+        .lfi_cap = area_count,
+    };
+    log_fcb_clear_index(fcb_log);
+}
+
+void
+log_fcb_clear_index(struct fcb_log *fcb_log)
+{
+    int i;
+
+    for (i = 0; i < fcb_log->fl_index.lfi_cap; i++) {
+        fcb_log->fl_index.lfi_areas[i].lfa_count = 0;
+    }
+}
+
+void
+log_fcb_rotate_index(struct fcb_log *fcb_log)
+{
+    int slot;
+
+    if (fcb_log->fl_index.lfi_cap == 0) {
+        return;
+    }
+
+    slot = log_fcb_index_oldest(&fcb_log->fl_fcb);
+    fcb_log->fl_index.lfi_areas[slot].lfa_count = 0;
+}
+
+void
+log_fcb_add_index(struct fcb_log *fcb_log, const log_fcb_entry_t *entry,
+                  const struct log_entry_hdr *hdr)
+{
+    struct log_fcb_area_idx *area;
+
+    if (fcb_log->fl_index.lfi_cap == 0) {
+        return;
+    }
+
+    area = &fcb_log->fl_index.lfi_areas[
+        log_fcb_index_slot(&fcb_log->fl_fcb, entry)];
+    if (area->lfa_count == 0) {
+        area->lfa_first = *entry;
+        area->lfa_first_ts = hdr->ue_ts;
+        area->lfa_first_index = hdr->ue_index;
+    }
+    if (area->lfa_count < UINT16_MAX) {
+        area->lfa_count++;
+    }
+}
+
+int
+log_fcb_build_index(struct log *log)
+{
+    struct log_fcb_area_idx *area;
+    struct log_entry_hdr hdr;
+    struct fcb_log *fcb_log;
+    log_fcb_entry_t loc;
+    log_fcb_t *fcb;
+    int rc;
+
+    fcb_log = log->l_arg;
+    fcb = &fcb_log->fl_fcb;
+
+    if (fcb_log->fl_index.lfi_cap < log_fcb_index_area_cnt(fcb)) {
+        /* Buffer too small; don't use the index. */
+        fcb_log->fl_index.lfi_cap = 0;
+        return 0;
+    }
+
+    log_fcb_clear_index(fcb_log);
+
+    /* Only the first entry of each area needs to be read. */
+    memset(&loc, 0, sizeof(loc));
+    while (log_fcb_getnext(fcb, &loc) == 0) {
+        area = &fcb_log->fl_index.lfi_areas[log_fcb_index_slot(fcb, &loc)];
+        if (area->lfa_count == 0) {
+            rc = log_read_hdr(log, &loc, &hdr);
+            if (rc != 0) {
+                log_fcb_clear_index(fcb_log);
+                return rc;
+            }
+            log_fcb_add_index(fcb_log, &loc, &hdr);
+        } else if (area->lfa_count < UINT16_MAX) {
+            area->lfa_count++;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Binary searches the areas, in age order, for the newest area whose first
+ * entry has an index <= `index` (by_ts == 0) or a timestamp < `ts`
+ * (by_ts == 1).  Timestamps need not be unique, so an entry with a
+ * timestamp equal to `ts` may still be in the preceding area.
+ *
+ * @return                      The position of the area relative to the
+ *                                  oldest area; -1 if there is none.
+ */
+static int
+log_fcb_index_search(const struct fcb_log *fcb_log, int oldest, int span,
+                     uint32_t index, int64_t ts, int by_ts)
+{
+    const struct log_fcb_area_idx *area;
+    int cnt;
+    int best;
+    int mid;
+    int lo;
+    int hi;
+    int le;
+
+    cnt = log_fcb_index_area_cnt(&fcb_log->fl_fcb);
+    best = -1;
+    lo = 0;
+    hi = span - 1;
+    while (lo <= hi) {
+        mid = (lo + hi) / 2;
+        area = &fcb_log->fl_index.lfi_areas[(oldest + mid) % cnt];
+
+        if (area->lfa_count == 0) {
+            /* Only the active area can be empty. */
+            le = 0;
+        } else if (by_ts) {
+            le = area->lfa_first_ts < ts;
+        } else {
+            le = area->lfa_first_index <= index;
+        }
+
+        if (le) {
+            best = mid;
+            lo = mid + 1;
+        } else {
+            hi = mid - 1;
+        }
+    }
+
+    return best;
+}
+
+const struct log_fcb_area_idx *
+log_fcb_closest_area(const struct fcb_log *fcb_log, uint32_t index,
+                     int64_t ts)
+{
+    const struct log_fcb_area_idx *area;
+    int oldest;
+    int span;
+    int pos;
+    int tpos;
+
+    if (fcb_log->fl_index.lfi_cap == 0) {
+        return NULL;
+    }
+
+    oldest = log_fcb_index_oldest(&fcb_log->fl_fcb);
+    span = log_fcb_index_span(&fcb_log->fl_fcb);
+
+    /* The walk starts at the later of the two positions. */
+    pos = log_fcb_index_search(fcb_log, oldest, span, index, ts, 0);
+    if (ts > 0) {
+        tpos = log_fcb_index_search(fcb_log, oldest, span, index, ts, 1);
+        if (tpos > pos) {
+            pos = tpos;
+        }
+    }
+
+    if (pos < 0) {
+        /* Everything in the log matches; start at the oldest entry. */
+        pos = 0;
+    }
+
+    area = &fcb_log->fl_index.lfi_areas[
+        (oldest + pos) % log_fcb_index_area_cnt(&fcb_log->fl_fcb)];
+    if (area->lfa_count == 0) {
+        return NULL;
+    }
+
+    return area;
+}
+
+#endif /* MYNEWT_VAL(LOG_FCB_INDEX) */
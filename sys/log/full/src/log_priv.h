@@ -0,0 +1,48 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef H_LOG_PRIV_
+#define H_LOG_PRIV_
+
+#include "os/mynewt.h"
+#include "log/log.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void log_call_append_cb(struct log *log, uint32_t idx);
+
+/* Must be called with interrupts disabled. */
+uint32_t log_next_index(struct log *log);
+
+#if MYNEWT_VAL(LOG_DEFERRED)
+void log_deferred_init(void);
+int log_deferred_append(struct log *log, struct log_entry_hdr *hdr,
+                        const void *body, uint16_t body_len);
+int log_deferred_append_mbuf(struct log *log, struct log_entry_hdr *hdr,
+                             const struct os_mbuf *om, uint16_t off,
+                             uint16_t body_len);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
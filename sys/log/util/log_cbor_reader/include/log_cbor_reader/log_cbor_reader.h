@@ -19,6 +19,7 @@
 
 #include "os/mynewt.h"
 #include "log/log.h"
+#include "log_common/log_cbor_series.h"
 #include "tinycbor/cbor.h"
 #include "tinycbor/compilersupport_p.h"
 
@@ -31,3 +32,57 @@ struct log_cbor_reader {
 void
 log_cbor_reader_init(struct log_cbor_reader *cbr, struct log *log,
                      const void *dptr, uint16_t len);
+
+/** Packed series decoder state */
+struct log_cbor_series {
+    const uint8_t *buf;
+    size_t len;
+    size_t off;
+    uint32_t prev;
+    uint8_t flags;
+};
+
+/**
+ * Reads a packed series.
+ *
+ * Expects the tag of a packed series at the current position, copies the
+ * series data to the buffer and advances the iterator past it.
+ *
+ * @param it                    The iterator.
+ * @param buf                   Buffer for the series data.
+ * @param len                   On input, the size of the buffer.  On
+ *                                  success, the size of the series data.
+ *
+ * @return                      0 on success;
+ *                              SYS_EINVAL if there is no packed series at
+ *                                  the iterator;
+ *                              SYS_ENOMEM if the buffer is too small.
+ */
+int log_cbor_reader_series_read(CborValue *it, uint8_t *buf, size_t *len);
+
+/**
+ * Initializes a decoder for packed series data.
+ *
+ * @param ls                    The decoder to initialize.
+ * @param buf                   The series data, e.g. as read by
+ *                                  log_cbor_reader_series_read().
+ * @param len                   The size of the series data.
+ *
+ * @return                      0 on success;
+ *                              SYS_EINVAL if the header is invalid.
+ */
+int log_cbor_series_init(struct log_cbor_series *ls, const uint8_t *buf,
+                         size_t len);
+
+/**
+ * Decodes the next value of a packed series.
+ *
+ * @param ls                    The decoder.
+ * @param val                   On success, the value; sign extended if the
+ *                                  series is signed.
+ *
+ * @return                      0 on success;
+ *                              SYS_ENOENT if there are no more values;
+ *                              SYS_EINVAL on malformed data.
+ */
+int log_cbor_series_next(struct log_cbor_series *ls, int64_t *val);
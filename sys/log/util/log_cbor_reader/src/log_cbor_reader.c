@@ -120,3 +120,93 @@ log_cbor_reader_init(struct log_cbor_reader *cbr, struct log *log,
     cbr->log = log;
     cbr->dptr = dptr;
 }
+
+int
+log_cbor_reader_series_read(CborValue *it, uint8_t *buf, size_t *len)
+{
+    CborTag tag;
+    int rc;
+
+    if (!cbor_value_is_tag(it)) {
+        return SYS_EINVAL;
+    }
+
+    rc = cbor_value_get_tag(it, &tag);
+    if (rc != 0 || tag != LOG_CBOR_TAG_PACKED_SERIES) {
+        return SYS_EINVAL;
+    }
+
+    rc = cbor_value_skip_tag(it);
+    if (rc != 0 || !cbor_value_is_byte_string(it)) {
+        return SYS_EINVAL;
+    }
+
+    rc = cbor_value_copy_byte_string(it, buf, len, it);
+    if (rc == CborErrorOutOfMemory) {
+        return SYS_ENOMEM;
+    } else if (rc != 0) {
+        return SYS_EINVAL;
+    }
+
+    return 0;
+}
+
+int
+log_cbor_series_init(struct log_cbor_series *ls, const uint8_t *buf,
+                     size_t len)
+{
+    uint8_t size;
+
+    if (len < 1) {
+        return SYS_EINVAL;
+    }
+
+    size = buf[0] & LOG_CBOR_SERIES_SIZE_MASK;
+    if (size != 1 && size != 2 && size != 4) {
+        return SYS_EINVAL;
+    }
+
+    ls->buf = buf;
+    ls->len = len;
+    ls->off = 1;
+    ls->prev = 0;
+    ls->flags = buf[0];
+
+    return 0;
+}
+
+int
+log_cbor_series_next(struct log_cbor_series *ls, int64_t *val)
+{
+    uint32_t zz;
+    uint8_t shift;
+    uint8_t ext;
+    uint8_t b;
+
+    if (ls->off >= ls->len) {
+        return SYS_ENOENT;
+    }
+
+    zz = 0;
+    shift = 0;
+    do {
+        if (ls->off >= ls->len || shift > 28) {
+            return SYS_EINVAL;
+        }
+        b = ls->buf[ls->off++];
+        zz |= (uint32_t)(b & 0x7f) << shift;
+        shift += 7;
+    } while (b & 0x80);
+
+    ls->prev += (zz >> 1) ^ -(zz & 1);
+
+    /* Truncate to value size, then sign or zero extend */
+    ext = 32 - (ls->flags & LOG_CBOR_SERIES_SIZE_MASK) * 8;
+    if (ls->flags & LOG_CBOR_SERIES_SIGNED) {
+        *val = (int32_t)(ls->prev << ext) >> ext;
+    } else {
+        *val = (ls->prev << ext) >> ext;
+    }
+
+    return 0;
+}
@@ -142,6 +142,41 @@ extern "C" {
  * As number of values increases in a series it may be necessary to allocate
  * more blocks for the same data series. Once event data is reset, all blocks
  * allocated for an event are freed.
+ *
+ * When only the distribution of a series matters, the metric can be made an
+ * aggregate instead (requires METRICS_AGGR). Values set to an aggregate are
+ * not stored; they are folded into a running summary which takes a single
+ * mempool block regardless of the number of values:
+ *
+ *     static const int32_t rssi_bounds[] = { -90, -80, -70, -60 };
+ *     static const uint16_t rssi_quantiles[] = { 500, 900 };
+ *     static const struct metrics_aggr_def rssi_aggr = {
+ *         .hist_bounds = rssi_bounds,
+ *         .hist_count = 4,
+ *         .quantiles = rssi_quantiles,
+ *         .quantile_count = 2,
+ *     };
+ *
+ *     METRICS_SECT_START(my_conn_metrics)
+ *         METRICS_SECT_ENTRY_AGGR(rssi, METRICS_TYPE_AGGR_S, &rssi_aggr)
+ *         METRICS_SECT_ENTRY(tx_len, METRICS_TYPE_AGGR_U)
+ *     METRICS_SECT_END
+ *
+ * Each aggregate keeps count, min, max, mean and variance; optionally a
+ * histogram over fixed buckets and estimates of selected quantiles. The
+ * summary state, including histogram buckets and quantile estimators, must
+ * fit in METRICS_POOL_SIZE or metrics_event_init() fails.
+ *
+ * Series of slowly changing values (e.g. temperature or accelerometer
+ * samples) can be stored packed instead (requires METRICS_PACKED_SERIES):
+ *
+ *     METRICS_SECT_ENTRY(temp, METRICS_TYPE_PACKED(METRICS_TYPE_SERIES_S16))
+ *
+ * Each value of a packed series is stored as the difference to the previous
+ * value, zigzag and varint encoded, so small changes take a single byte both
+ * in the mempool and in the log. Packed series are written to CBOR as a byte
+ * string tagged with LOG_CBOR_TAG_PACKED_SERIES instead of an array, see
+ * log_cbor_series_next() for decoding.
  */
 
 /* Helper to define metric type - use types defined below instead! */
@@ -160,10 +195,36 @@ extern "C" {
 #define METRICS_TYPE_SINGLE             (METRICS_TYPE_SINGLE_U)
 #define METRICS_TYPE_SERIES             (METRICS_TYPE_SERIES_U32)
 
+/* Aggregated series: values are summarized instead of stored */
+#define METRICS_TYPE_AGGR_FLAG          0x20
+#define METRICS_TYPE_AGGR_U             (METRICS_TYPE_SERIES_U32 | \
+                                         METRICS_TYPE_AGGR_FLAG)
+#define METRICS_TYPE_AGGR_S             (METRICS_TYPE_SERIES_S32 | \
+                                         METRICS_TYPE_AGGR_FLAG)
+
+/* Packed series: values are stored delta/varint encoded */
+#define METRICS_TYPE_PACKED_FLAG        0x10
+#define METRICS_TYPE_PACKED(__type)     ((__type) | METRICS_TYPE_PACKED_FLAG)
+
+/* Optional histogram and quantiles of an aggregate metric */
+struct metrics_aggr_def {
+    /*
+     * Ascending histogram bucket bounds, NULL for no histogram. Bucket i
+     * counts values <= hist_bounds[i] (and above the previous bound); one
+     * extra bucket counts values above the last bound.
+     */
+    const int32_t *hist_bounds;
+    uint8_t hist_count;
+    /* Quantiles to estimate in thousandths, e.g. 990 for p99 */
+    const uint16_t *quantiles;
+    uint8_t quantile_count;
+};
+
 /* Metric definition - use METRICS_SECT_* helpers to create */
 struct metrics_metric_def {
     const char *name;
     uint8_t type;
+    const struct metrics_aggr_def *aggr;
 };
 
 /* Event header - use EVENT_DECLARE() helpers to create */
@@ -189,6 +250,8 @@ struct metrics_event_hdr {
     static const struct metrics_metric_def _metrics[] = {
 #define METRICS_SECT_ENTRY(_name, _type) \
         { .name = #_name, .type = _type },
+#define METRICS_SECT_ENTRY_AGGR(_name, _type, _aggr) \
+        { .name = #_name, .type = _type, .aggr = _aggr },
 #define METRICS_SECT_END \
     }
 
@@ -403,6 +466,16 @@ int metrics_set_series_value(struct metrics_event_hdr *hdr, uint8_t metric,
  * metrics will be included in output. Metrics which do not have data set will
  * have value set to 'undefined'.
  *
+ * Aggregate metrics are written as a map with keys "n" (count), "min", "max",
+ * "mean" and "var" (population variance), plus "h" (array of histogram bucket
+ * counts) and "q" (map of quantile in thousandths to its estimate) when
+ * configured. "mean", "var" and the quantile estimates are floats if
+ * FLOAT_USER is enabled and rounded integers otherwise.
+ *
+ * Packed series are written as a byte string tagged with
+ * LOG_CBOR_TAG_PACKED_SERIES. The byte string is split into chunks if the
+ * series spans multiple mbufs.
+ *
  * Data collected in an event remain unaffected. The only exception is when
  * destination mbuf is allocated using event_metric_get_mbuf() - data are then
  * removed from event during serialization to reduce memory usage and free space
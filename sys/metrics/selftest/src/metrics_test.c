@@ -0,0 +1,67 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "metrics_test.h"
+
+/**
+ * Encodes an event to CBOR and leaves tc->event at the top-level map.
+ */
+void
+metrics_test_encode(struct metrics_event_hdr *hdr,
+                    struct metrics_test_cbor *tc)
+{
+    struct os_mbuf *om;
+    int len;
+    int rc;
+
+    om = metrics_get_mbuf();
+    TEST_ASSERT_FATAL(om != NULL);
+
+    rc = metrics_event_to_cbor(hdr, om);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    len = os_mbuf_len(om);
+    TEST_ASSERT_FATAL(len <= sizeof tc->buf);
+    rc = os_mbuf_copydata(om, 0, len, tc->buf);
+    TEST_ASSERT_FATAL(rc == 0);
+    os_mbuf_free_chain(om);
+
+    cbor_buf_reader_init(&tc->reader, tc->buf, len);
+    rc = cbor_parser_init(&tc->reader.r, 0, &tc->parser, &tc->event);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT_FATAL(cbor_value_is_map(&tc->event));
+}
+
+TEST_SUITE(metrics_test_suite_aggr)
+{
+    metrics_test_case_aggr();
+}
+
+TEST_SUITE(metrics_test_suite_packed)
+{
+    metrics_test_case_packed();
+}
+
+int
+main(int argc, char **argv)
+{
+    metrics_test_suite_aggr();
+    metrics_test_suite_packed();
+    return tu_any_failed;
+}
@@ -0,0 +1,45 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef H_METRICS_TEST_H
+#define H_METRICS_TEST_H
+
+#include "os/mynewt.h"
+#include "testutil/testutil.h"
+#include "metrics/metrics.h"
+#include "tinycbor/cbor.h"
+#include "tinycbor/cbor_buf_reader.h"
+
+/* Flat copy of an event's CBOR encoding */
+struct metrics_test_cbor {
+    uint8_t buf[1024];
+    struct cbor_buf_reader reader;
+    CborParser parser;
+    CborValue event;
+};
+
+void metrics_test_encode(struct metrics_event_hdr *hdr,
+                         struct metrics_test_cbor *tc);
+
+TEST_SUITE_DECL(metrics_test_suite_aggr);
+TEST_CASE_DECL(metrics_test_case_aggr);
+TEST_SUITE_DECL(metrics_test_suite_packed);
+TEST_CASE_DECL(metrics_test_case_packed);
+
+#endif
@@ -0,0 +1,213 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "metrics_test.h"
+
+static const int32_t mtca_bounds[] = { -10, 0, 10 };
+static const uint16_t mtca_quantiles[] = { 500, 900 };
+
+static const struct metrics_aggr_def mtca_hist = {
+    .hist_bounds = mtca_bounds,
+    .hist_count = 3,
+};
+
+static const struct metrics_aggr_def mtca_p2 = {
+    .quantiles = mtca_quantiles,
+    .quantile_count = 2,
+};
+
+METRICS_SECT_START(mtca_metrics)
+    METRICS_SECT_ENTRY(welford, METRICS_TYPE_AGGR_U)
+    METRICS_SECT_ENTRY_AGGR(hist, METRICS_TYPE_AGGR_S, &mtca_hist)
+    METRICS_SECT_ENTRY_AGGR(three, METRICS_TYPE_AGGR_U, &mtca_p2)
+    METRICS_SECT_ENTRY_AGGR(five, METRICS_TYPE_AGGR_U, &mtca_p2)
+    METRICS_SECT_ENTRY_AGGR(many, METRICS_TYPE_AGGR_U, &mtca_p2)
+METRICS_SECT_END;
+
+enum {
+    MTCA_WELFORD,
+    MTCA_HIST,
+    MTCA_THREE,
+    MTCA_FIVE,
+    MTCA_MANY,
+};
+
+METRICS_EVENT_DECLARE(mtca_event, mtca_metrics);
+
+static struct mtca_event mtca_ev;
+
+static void
+mtca_set(uint8_t metric, const int32_t *vals, int count)
+{
+    int rc;
+    int i;
+
+    for (i = 0; i < count; i++) {
+        rc = metrics_set_value(&mtca_ev.hdr, metric, vals[i]);
+        TEST_ASSERT(rc == 0);
+    }
+}
+
+static int64_t
+mtca_int(const CborValue *map, const char *key)
+{
+    CborValue val;
+    int64_t i;
+    int rc;
+
+    rc = cbor_value_map_find_value(map, key, &val);
+    TEST_ASSERT(rc == 0 && cbor_value_is_integer(&val), "%s", key);
+
+    i = INT64_MIN;
+    cbor_value_get_int64(&val, &i);
+
+    return i;
+}
+
+/**
+ * Checks the count, min, max, rounded mean and rounded variance of a summary.
+ */
+static void
+mtca_check_summary(const CborValue *map, int64_t n, int64_t min, int64_t max,
+                   int64_t mean, int64_t var)
+{
+    TEST_ASSERT(mtca_int(map, "n") == n);
+    TEST_ASSERT(mtca_int(map, "min") == min);
+    TEST_ASSERT(mtca_int(map, "max") == max);
+    TEST_ASSERT(mtca_int(map, "mean") == mean);
+    TEST_ASSERT(mtca_int(map, "var") == var);
+}
+
+/**
+ * Checks the p50 and p90 estimates of a summary, within +/- tol.
+ */
+static void
+mtca_check_quantiles(const CborValue *map, int64_t p50, int64_t p90,
+                     int64_t tol)
+{
+    CborValue q;
+    CborValue it;
+    uint64_t key;
+    int64_t est;
+    int rc;
+    int i;
+
+    rc = cbor_value_map_find_value(map, "q", &q);
+    TEST_ASSERT_FATAL(rc == 0 && cbor_value_is_map(&q));
+
+    rc = cbor_value_enter_container(&q, &it);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    for (i = 0; i < 2; i++) {
+        rc = cbor_value_get_uint64(&it, &key);
+        TEST_ASSERT_FATAL(rc == 0 && key == mtca_quantiles[i]);
+        rc = cbor_value_advance(&it);
+        TEST_ASSERT_FATAL(rc == 0);
+
+        rc = cbor_value_get_int64(&it, &est);
+        TEST_ASSERT_FATAL(rc == 0);
+        if (key == 500) {
+            TEST_ASSERT(est >= p50 - tol && est <= p50 + tol,
+                        "p50 %d", (int)est);
+        } else {
+            TEST_ASSERT(est >= p90 - tol && est <= p90 + tol,
+                        "p90 %d", (int)est);
+        }
+        rc = cbor_value_advance(&it);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+    TEST_ASSERT(cbor_value_at_end(&it));
+}
+
+TEST_CASE_SELF(metrics_test_case_aggr)
+{
+    static const int32_t welford[] = { 2, 4, 4, 4, 5, 5, 7, 9 };
+    static const int32_t hist[] = { -20, -10, -5, 0, 5, 10, 15, 20, -3 };
+    static const int32_t three[] = { 30, 10, 20 };
+    static const int32_t five[] = { 50, 10, 40, 20, 30 };
+    struct metrics_test_cbor tc;
+    CborValue map;
+    CborValue h;
+    CborValue it;
+    uint64_t cnt;
+    int rc;
+    int i;
+
+    rc = metrics_event_init(&mtca_ev.hdr, mtca_metrics,
+                            METRICS_SECT_COUNT(mtca_metrics), "mtca");
+    TEST_ASSERT_FATAL(rc == 0);
+
+    rc = metrics_event_start(&mtca_ev.hdr, 0);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    mtca_set(MTCA_WELFORD, welford, ARRAY_SIZE(welford));
+    mtca_set(MTCA_HIST, hist, ARRAY_SIZE(hist));
+    mtca_set(MTCA_THREE, three, ARRAY_SIZE(three));
+    mtca_set(MTCA_FIVE, five, ARRAY_SIZE(five));
+
+    /* 1..1000 in a scrambled but fixed order */
+    for (i = 0; i < 1000; i++) {
+        rc = metrics_set_value(&mtca_ev.hdr, MTCA_MANY, i * 7919 % 1000 + 1);
+        TEST_ASSERT(rc == 0);
+    }
+
+    metrics_test_encode(&mtca_ev.hdr, &tc);
+
+    /* Welford: mean 5 and population variance 4 */
+    rc = cbor_value_map_find_value(&tc.event, "welford", &map);
+    TEST_ASSERT_FATAL(rc == 0 && cbor_value_is_map(&map));
+    mtca_check_summary(&map, 8, 2, 9, 5, 4);
+    rc = cbor_value_map_find_value(&map, "h", &h);
+    TEST_ASSERT(rc == 0 && cbor_value_get_type(&h) == CborInvalidType);
+
+    /* Histogram: values equal to a bound go to the bucket below it */
+    rc = cbor_value_map_find_value(&tc.event, "hist", &map);
+    TEST_ASSERT_FATAL(rc == 0 && cbor_value_is_map(&map));
+    mtca_check_summary(&map, 9, -20, 20, 1, 141);
+    rc = cbor_value_map_find_value(&map, "h", &h);
+    TEST_ASSERT_FATAL(rc == 0 && cbor_value_is_array(&h));
+    rc = cbor_value_enter_container(&h, &it);
+    TEST_ASSERT_FATAL(rc == 0);
+    for (i = 0; i < 4; i++) {
+        rc = cbor_value_get_uint64(&it, &cnt);
+        TEST_ASSERT_FATAL(rc == 0);
+        TEST_ASSERT(cnt == (i == 1 ? 3 : 2), "bucket %d: %d", i, (int)cnt);
+        rc = cbor_value_advance(&it);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+    TEST_ASSERT(cbor_value_at_end(&it));
+
+    /* Up to five values, quantiles are exact */
+    rc = cbor_value_map_find_value(&tc.event, "three", &map);
+    TEST_ASSERT_FATAL(rc == 0 && cbor_value_is_map(&map));
+    mtca_check_quantiles(&map, 20, 30, 0);
+
+    rc = cbor_value_map_find_value(&tc.event, "five", &map);
+    TEST_ASSERT_FATAL(rc == 0 && cbor_value_is_map(&map));
+    mtca_check_quantiles(&map, 30, 50, 0);
+
+    /* Beyond that, P-square estimates */
+    rc = cbor_value_map_find_value(&tc.event, "many", &map);
+    TEST_ASSERT_FATAL(rc == 0 && cbor_value_is_map(&map));
+    mtca_check_summary(&map, 1000, 1, 1000, 501, 83333);
+    mtca_check_quantiles(&map, 500, 900, 10);
+
+    rc = metrics_event_end(&mtca_ev.hdr);
+    TEST_ASSERT(rc == 0);
+}
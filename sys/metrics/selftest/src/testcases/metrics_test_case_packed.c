@@ -0,0 +1,175 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "metrics_test.h"
+#include "log_cbor_reader/log_cbor_reader.h"
+
+#define MTCP_MANY               300
+#define MTCP_MAX                64
+
+METRICS_SECT_START(mtcp_metrics)
+    METRICS_SECT_ENTRY(temp, METRICS_TYPE_PACKED(METRICS_TYPE_SERIES_S16))
+    METRICS_SECT_ENTRY(cnt, METRICS_TYPE_PACKED(METRICS_TYPE_SERIES_U32))
+METRICS_SECT_END;
+
+enum {
+    MTCP_TEMP,
+    MTCP_CNT,
+};
+
+METRICS_EVENT_DECLARE(mtcp_event, mtcp_metrics);
+
+static struct mtcp_event mtcp_ev;
+static struct metrics_test_cbor mtcp_tc;
+static struct os_mbuf *mtcp_hoard[MYNEWT_VAL(METRICS_POOL_COUNT)];
+static int mtcp_hoard_cnt;
+static int64_t mtcp_vals[MTCP_MANY];
+static uint8_t mtcp_series[MTCP_MANY * 5];
+
+/**
+ * Takes every free block from the metrics pool.
+ */
+static void
+mtcp_hoard_all(void)
+{
+    struct os_mbuf *om;
+
+    while ((om = metrics_get_mbuf()) != NULL) {
+        TEST_ASSERT_FATAL(mtcp_hoard_cnt < ARRAY_SIZE(mtcp_hoard));
+        mtcp_hoard[mtcp_hoard_cnt++] = om;
+    }
+}
+
+static void
+mtcp_release_all(void)
+{
+    while (mtcp_hoard_cnt > 0) {
+        os_mbuf_free(mtcp_hoard[--mtcp_hoard_cnt]);
+    }
+}
+
+/**
+ * Encodes the event and checks that a metric decodes to the expected values.
+ */
+static void
+mtcp_check(const char *name, const int64_t *vals, int cnt, bool chunked)
+{
+    struct log_cbor_series ls;
+    CborValue it;
+    int64_t val;
+    size_t len;
+    int rc;
+    int i;
+
+    metrics_test_encode(&mtcp_ev.hdr, &mtcp_tc);
+
+    rc = cbor_value_map_find_value(&mtcp_tc.event, name, &it);
+    TEST_ASSERT_FATAL(rc == 0 && cbor_value_is_tag(&it));
+
+    /* Series spanning more than one mbuf are written in chunks */
+    rc = cbor_value_skip_tag(&it);
+    TEST_ASSERT_FATAL(rc == 0 && cbor_value_is_byte_string(&it));
+    TEST_ASSERT(cbor_value_is_length_known(&it) == !chunked);
+
+    rc = cbor_value_map_find_value(&mtcp_tc.event, name, &it);
+    TEST_ASSERT_FATAL(rc == 0);
+    len = sizeof mtcp_series;
+    rc = log_cbor_reader_series_read(&it, mtcp_series, &len);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    rc = log_cbor_series_init(&ls, mtcp_series, len);
+    TEST_ASSERT_FATAL(rc == 0);
+    for (i = 0; i < cnt; i++) {
+        rc = log_cbor_series_next(&ls, &val);
+        TEST_ASSERT_FATAL(rc == 0, "value %d: rc %d", i, rc);
+        TEST_ASSERT(val == vals[i], "value %d: %lld != %lld", i,
+                    (long long)val, (long long)vals[i]);
+    }
+    rc = log_cbor_series_next(&ls, &val);
+    TEST_ASSERT(rc == SYS_ENOENT);
+}
+
+TEST_CASE_SELF(metrics_test_case_packed)
+{
+    uint32_t val;
+    int cnt;
+    int rc;
+    int i;
+    int k;
+
+    rc = metrics_event_init(&mtcp_ev.hdr, mtcp_metrics,
+                            METRICS_SECT_COUNT(mtcp_metrics), "mtcp");
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /* Two-byte steps up and down: the series spans several mbufs */
+    metrics_event_start(&mtcp_ev.hdr, 0);
+    for (i = 0; i < MTCP_MANY; i++) {
+        mtcp_vals[i] = (i & 1) ? -100 * i : 100 * i;
+        rc = metrics_set_value(&mtcp_ev.hdr, MTCP_TEMP, mtcp_vals[i]);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+    mtcp_check("temp", mtcp_vals, MTCP_MANY, true);
+    metrics_event_end(&mtcp_ev.hdr);
+
+    /*
+     * Run out of mbufs in the middle of a five-byte value. The leading
+     * one-byte values shift where in the mbuf that happens, so all but one
+     * of the runs cut a value in two. The series must still decode to the
+     * values that were accepted, and keep going once there is memory again.
+     */
+    for (k = 0; k < 5; k++) {
+        metrics_event_start(&mtcp_ev.hdr, 0);
+
+        cnt = 0;
+        val = 0;
+        rc = metrics_set_value(&mtcp_ev.hdr, MTCP_CNT, val);
+        TEST_ASSERT_FATAL(rc == 0);
+        mtcp_vals[cnt++] = val;
+
+        mtcp_hoard_all();
+
+        for (i = 0; i < k; i++) {
+            val++;
+            rc = metrics_set_value(&mtcp_ev.hdr, MTCP_CNT, val);
+            TEST_ASSERT_FATAL(rc == 0);
+            mtcp_vals[cnt++] = val;
+        }
+
+        while (1) {
+            TEST_ASSERT_FATAL(cnt < MTCP_MAX);
+            rc = metrics_set_value(&mtcp_ev.hdr, MTCP_CNT, val + 0x80000000);
+            if (rc != 0) {
+                break;
+            }
+            val += 0x80000000;
+            mtcp_vals[cnt++] = val;
+        }
+        TEST_ASSERT(rc == SYS_ENOMEM);
+
+        mtcp_release_all();
+
+        val += 0x80000000;
+        rc = metrics_set_value(&mtcp_ev.hdr, MTCP_CNT, val);
+        TEST_ASSERT_FATAL(rc == 0);
+        mtcp_vals[cnt++] = val;
+
+        mtcp_check("cnt", mtcp_vals, cnt, true);
+        metrics_event_end(&mtcp_ev.hdr);
+    }
+}
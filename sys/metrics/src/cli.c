@@ -81,6 +81,22 @@ metric_type_str(uint8_t type)
         return "unsigned32-series";
     case METRICS_TYPE_SERIES_S32:
         return "signed32-series";
+    case METRICS_TYPE_AGGR_U:
+        return "unsigned-aggregate";
+    case METRICS_TYPE_AGGR_S:
+        return "signed-aggregate";
+    case METRICS_TYPE_PACKED(METRICS_TYPE_SERIES_U8):
+        return "unsigned8-packed-series";
+    case METRICS_TYPE_PACKED(METRICS_TYPE_SERIES_S8):
+        return "signed8-packed-series";
+    case METRICS_TYPE_PACKED(METRICS_TYPE_SERIES_U16):
+        return "unsigned16-packed-series";
+    case METRICS_TYPE_PACKED(METRICS_TYPE_SERIES_S16):
+        return "signed16-packed-series";
+    case METRICS_TYPE_PACKED(METRICS_TYPE_SERIES_U32):
+        return "unsigned32-packed-series";
+    case METRICS_TYPE_PACKED(METRICS_TYPE_SERIES_S32):
+        return "signed32-packed-series";
     }
 
     return "<unknown>";
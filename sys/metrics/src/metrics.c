@@ -28,6 +28,7 @@
 #include "tinycbor/cbor.h"
 #include "tinycbor/cbor_mbuf_writer.h"
 #include "log/log.h"
+#include "log_common/log_cbor_series.h"
 #include "metrics_priv.h"
 
 #define MBUF_MEMBLOCK_OVERHEAD \
@@ -36,14 +37,11 @@
 #define MEMPOOL_COUNT   MYNEWT_VAL(METRICS_POOL_COUNT)
 #define MEMPOOL_SIZE    MYNEWT_VAL(METRICS_POOL_SIZE)
 
-#define METRICS_TYPE_SERIES_MASK    0x80
-#define METRICS_TYPE_SIGNED_MASK    0x40
-#define METRICS_TYPE_SIZE_MASK      0x0f
-
 union metrics_metric_val {
     uintptr_t notused;
     uint32_t val;
     struct os_mbuf *series;
+    void *aggr;
 };
 
 struct metrics_event {
@@ -67,8 +65,35 @@ metrics_event_init(struct metrics_event_hdr *hdr,
                   const struct metrics_metric_def *metrics, uint8_t count,
                   const char *name)
 {
+    int i;
+
     assert((count > 0) && (count <= 32));
 
+    for (i = 0; i < count; i++) {
+        if (metrics[i].type & METRICS_TYPE_PACKED_FLAG) {
+#if MYNEWT_VAL(METRICS_PACKED_SERIES)
+            if ((metrics[i].type & METRICS_TYPE_SERIES_MASK) == 0 ||
+                (metrics[i].type & METRICS_TYPE_AGGR_FLAG)) {
+                return SYS_EINVAL;
+            }
+#else
+            return SYS_ENOTSUP;
+#endif
+        }
+
+        if ((metrics[i].type & METRICS_TYPE_AGGR_FLAG) == 0) {
+            continue;
+        }
+#if MYNEWT_VAL(METRICS_AGGR)
+        /* Summary state is kept in a single mempool block */
+        if (metrics_aggr_size(&metrics[i]) > MEMPOOL_SIZE) {
+            return SYS_EINVAL;
+        }
+#else
+        return SYS_ENOTSUP;
+#endif
+    }
+
     memset(hdr, 0, sizeof(*hdr) + count * sizeof(union metrics_metric_val));
     hdr->name = name;
     hdr->count = count;
@@ -144,7 +169,14 @@ metrics_event_end(struct metrics_event_hdr *hdr)
         def = &hdr->defs[i];
         v = &em->vals[i];
 
-        if (def->type & METRICS_TYPE_SERIES_MASK) {
+        if (def->type & METRICS_TYPE_AGGR_FLAG) {
+#if MYNEWT_VAL(METRICS_AGGR)
+            if (v->aggr) {
+                os_memblock_put(&event_metric_mempool, v->aggr);
+            }
+            v->aggr = NULL;
+#endif
+        } else if (def->type & METRICS_TYPE_SERIES_MASK) {
             if (v->series) {
                 os_mbuf_free_chain(v->series);
             }
@@ -208,6 +240,84 @@ set_single_value(struct metrics_event_hdr *hdr, uint8_t metric,
     return 0;
 }
 
+#if MYNEWT_VAL(METRICS_PACKED_SERIES)
+/*
+ * Packed series start with a header byte holding value size and signedness,
+ * followed by the difference of each value to the previous one (the first
+ * one to 0) as zigzag encoded varint. Differences are taken modulo the value
+ * size so e.g. a wrapping 8-bit counter still takes a single byte per value.
+ * The previous value is kept in the user header of the first mbuf.
+ */
+static int
+set_packed_series_value(union metrics_metric_val *v, uint32_t val,
+                        uint8_t type)
+{
+    uint8_t buf[5];
+    uint32_t *prev;
+    uint32_t zz;
+    int32_t delta;
+    uint16_t pktlen;
+    uint8_t type_len;
+    uint8_t shift;
+    int len;
+    int rc;
+
+    type_len = type & METRICS_TYPE_SIZE_MASK;
+    assert((type_len == 1) || (type_len == 2) || (type_len == 4));
+
+    shift = 32 - type_len * 8;
+
+    if (!v->series) {
+        v->series = os_mbuf_get_pkthdr(&event_metric_mbuf_pool,
+                                       sizeof(uint32_t));
+        if (!v->series) {
+            return SYS_ENOMEM;
+        }
+
+        buf[0] = type_len;
+        if (type & METRICS_TYPE_SIGNED_MASK) {
+            buf[0] |= LOG_CBOR_SERIES_SIGNED;
+        }
+
+        rc = os_mbuf_append(v->series, buf, 1);
+        if (rc != 0) {
+            os_mbuf_free_chain(v->series);
+            v->series = NULL;
+            return SYS_ENOMEM;
+        }
+
+        prev = OS_MBUF_USRHDR(v->series);
+        *prev = 0;
+    }
+
+    prev = OS_MBUF_USRHDR(v->series);
+    delta = (int32_t)((val - *prev) << shift) >> shift;
+    zz = ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31);
+
+    len = 0;
+    do {
+        buf[len] = zz & 0x7f;
+        zz >>= 7;
+        if (zz) {
+            buf[len] |= 0x80;
+        }
+        len++;
+    } while (zz);
+
+    pktlen = OS_MBUF_PKTLEN(v->series);
+    rc = os_mbuf_append(v->series, buf, len);
+    if (rc != 0) {
+        /* Drop partially appended value so the series can still be decoded */
+        os_mbuf_adj(v->series, pktlen - OS_MBUF_PKTLEN(v->series));
+        return SYS_ENOMEM;
+    }
+
+    *prev = val;
+
+    return 0;
+}
+#endif
+
 static int
 set_series_value(struct metrics_event_hdr *hdr, uint8_t metric,
                  uint32_t val, uint8_t type)
@@ -215,9 +325,41 @@ set_series_value(struct metrics_event_hdr *hdr, uint8_t metric,
     struct metrics_event *em = (struct metrics_event *)hdr;
     union metrics_metric_val *v;
     uint16_t type_len;
+#if MYNEWT_VAL(METRICS_PACKED_SERIES)
+    int rc;
+#endif
 
     v = &em->vals[metric];
 
+#if MYNEWT_VAL(METRICS_AGGR)
+    if (type & METRICS_TYPE_AGGR_FLAG) {
+        if (!v->aggr) {
+            v->aggr = os_memblock_get(&event_metric_mempool);
+            if (!v->aggr) {
+                return SYS_ENOMEM;
+            }
+            metrics_aggr_init(v->aggr, &hdr->defs[metric]);
+        }
+
+        metrics_aggr_add(v->aggr, &hdr->defs[metric], val);
+
+        hdr->set |= (1 << metric);
+
+        return 0;
+    }
+#endif
+
+#if MYNEWT_VAL(METRICS_PACKED_SERIES)
+    if (type & METRICS_TYPE_PACKED_FLAG) {
+        rc = set_packed_series_value(v, val, type);
+        if (rc == 0) {
+            hdr->set |= (1 << metric);
+        }
+
+        return rc;
+    }
+#endif
+
     if (!v->series) {
         v->series = os_mbuf_get(&event_metric_mbuf_pool, 0);
     }
@@ -430,6 +572,77 @@ append_series_s32_to_cbor(CborEncoder *encoder, struct os_mbuf *om)
     return 0;
 }
 
+static int
+append_series_to_cbor(CborEncoder *encoder, struct os_mbuf *om, uint8_t type)
+{
+    struct CborEncoder arr;
+    int rc;
+
+    rc = cbor_encoder_create_array(encoder, &arr, CborIndefiniteLength);
+    if (rc != 0) {
+        return SYS_ENOMEM;
+    }
+
+    switch (type) {
+    case METRICS_TYPE_SERIES_U8:
+        append_series_u8_to_cbor(&arr, om);
+        break;
+    case METRICS_TYPE_SERIES_S8:
+        append_series_s8_to_cbor(&arr, om);
+        break;
+    case METRICS_TYPE_SERIES_U16:
+        append_series_u16_to_cbor(&arr, om);
+        break;
+    case METRICS_TYPE_SERIES_S16:
+        append_series_s16_to_cbor(&arr, om);
+        break;
+    case METRICS_TYPE_SERIES_U32:
+        append_series_u32_to_cbor(&arr, om);
+        break;
+    case METRICS_TYPE_SERIES_S32:
+        append_series_s32_to_cbor(&arr, om);
+        break;
+    default:
+        assert(0);
+    }
+
+    rc = cbor_encoder_close_container(encoder, &arr);
+    if (rc != 0) {
+        return SYS_ENOMEM;
+    }
+
+    return 0;
+}
+
+#if MYNEWT_VAL(METRICS_PACKED_SERIES)
+static int
+append_packed_series_to_cbor(CborEncoder *encoder, struct os_mbuf *om)
+{
+    struct CborEncoder str;
+    int rc;
+
+    rc = cbor_encode_tag(encoder, LOG_CBOR_TAG_PACKED_SERIES);
+
+    /* Series which span multiple mbufs are written one chunk per mbuf */
+    if (SLIST_NEXT(om, om_next) == NULL) {
+        rc |= cbor_encode_byte_string(encoder, om->om_data, om->om_len);
+    } else {
+        rc |= cbor_encoder_create_indef_byte_string(encoder, &str);
+        while (om) {
+            rc |= cbor_encode_byte_string(&str, om->om_data, om->om_len);
+            om = SLIST_NEXT(om, om_next);
+        }
+        rc |= cbor_encoder_close_container(encoder, &str);
+    }
+
+    if (rc != 0) {
+        return SYS_ENOMEM;
+    }
+
+    return 0;
+}
+#endif
+
 int
 metrics_event_to_cbor(struct metrics_event_hdr *hdr, struct os_mbuf *om)
 {
@@ -439,7 +652,6 @@ metrics_event_to_cbor(struct metrics_event_hdr *hdr, struct os_mbuf *om)
     struct cbor_mbuf_writer writer;
     struct CborEncoder encoder;
     struct CborEncoder map;
-    struct CborEncoder arr;
     int i;
     int rc;
 
@@ -482,37 +694,26 @@ metrics_event_to_cbor(struct metrics_event_hdr *hdr, struct os_mbuf *om)
             continue;
         }
 
-        rc = cbor_encoder_create_array(&map, &arr, CborIndefiniteLength);
-        if (rc != 0) {
-            return SYS_ENOMEM;
+#if MYNEWT_VAL(METRICS_AGGR)
+        if (def->type & METRICS_TYPE_AGGR_FLAG) {
+            rc = metrics_aggr_to_cbor(&map, v->aggr, def);
+            if (rc != 0) {
+                return rc;
+            }
+            continue;
         }
+#endif
 
-        switch (def->type) {
-        case METRICS_TYPE_SERIES_U8:
-            append_series_u8_to_cbor(&arr, v->series);
-            break;
-        case METRICS_TYPE_SERIES_S8:
-            append_series_s8_to_cbor(&arr, v->series);
-            break;
-        case METRICS_TYPE_SERIES_U16:
-            append_series_u16_to_cbor(&arr, v->series);
-            break;
-        case METRICS_TYPE_SERIES_S16:
-            append_series_s16_to_cbor(&arr, v->series);
-            break;
-        case METRICS_TYPE_SERIES_U32:
-            append_series_u32_to_cbor(&arr, v->series);
-            break;
-        case METRICS_TYPE_SERIES_S32:
-            append_series_s32_to_cbor(&arr, v->series);
-            break;
-        default:
-            assert(0);
+#if MYNEWT_VAL(METRICS_PACKED_SERIES)
+        if (def->type & METRICS_TYPE_PACKED_FLAG) {
+            rc = append_packed_series_to_cbor(&map, v->series);
+        } else
+#endif
+        {
+            rc = append_series_to_cbor(&map, v->series, def->type);
         }
-
-        rc = cbor_encoder_close_container(&map, &arr);
         if (rc != 0) {
-            return SYS_ENOMEM;
+            return rc;
         }
 
         /*
@@ -0,0 +1,294 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+
+#if MYNEWT_VAL(METRICS_AGGR)
+
+#include <string.h>
+
+#include "metrics/metrics.h"
+#include "tinycbor/cbor.h"
+#include "metrics_priv.h"
+
+/*
+ * P-square quantile estimator (Jain & Chlamtac, 1985): five markers whose
+ * heights track the minimum, the target quantile, the maximum and the two
+ * midpoints in between. The first five values are kept as is.
+ */
+struct metrics_aggr_p2 {
+    float q[5];
+    int32_t n[5];
+};
+
+/*
+ * Summary state. Followed by hist_count + 1 histogram buckets (if there is
+ * a histogram) and quantile_count P-square estimators.
+ */
+struct metrics_aggr {
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    float mean;
+    float m2;
+};
+
+static int
+hist_buckets(const struct metrics_metric_def *def)
+{
+    if (!def->aggr || !def->aggr->hist_bounds) {
+        return 0;
+    }
+
+    return def->aggr->hist_count + 1;
+}
+
+static int
+quantile_count(const struct metrics_metric_def *def)
+{
+    if (!def->aggr || !def->aggr->quantiles) {
+        return 0;
+    }
+
+    return def->aggr->quantile_count;
+}
+
+static uint32_t *
+aggr_hist(const struct metrics_aggr *a)
+{
+    return (uint32_t *)(a + 1);
+}
+
+static struct metrics_aggr_p2 *
+aggr_p2(const struct metrics_aggr *a, const struct metrics_metric_def *def)
+{
+    return (struct metrics_aggr_p2 *)(aggr_hist(a) + hist_buckets(def));
+}
+
+static int64_t
+aggr_val(const struct metrics_metric_def *def, uint32_t val)
+{
+    if (def->type & METRICS_TYPE_SIGNED_MASK) {
+        return (int32_t)val;
+    }
+
+    return val;
+}
+
+static void
+p2_add(struct metrics_aggr_p2 *e, float p, float x, uint32_t count)
+{
+    float f[5] = { 0, p / 2, p, (1 + p) / 2, 1 };
+    float qp;
+    float d;
+    int s;
+    int i;
+    int k;
+
+    if (count <= 5) {
+        /* Insertion sort into the first samples */
+        for (i = count - 1; i > 0 && e->q[i - 1] > x; i--) {
+            e->q[i] = e->q[i - 1];
+        }
+        e->q[i] = x;
+        e->n[count - 1] = count;
+        return;
+    }
+
+    if (x < e->q[0]) {
+        e->q[0] = x;
+        k = 0;
+    } else if (x >= e->q[4]) {
+        e->q[4] = x;
+        k = 3;
+    } else {
+        for (k = 0; k < 3 && x >= e->q[k + 1]; k++) {
+        }
+    }
+
+    for (i = k + 1; i < 5; i++) {
+        e->n[i]++;
+    }
+
+    /* Move the middle markers towards their desired positions */
+    for (i = 1; i < 4; i++) {
+        d = 1 + (count - 1) * f[i] - e->n[i];
+        if ((d >= 1 && e->n[i + 1] - e->n[i] > 1) ||
+            (d <= -1 && e->n[i - 1] - e->n[i] < -1)) {
+            s = d >= 0 ? 1 : -1;
+
+            qp = e->q[i] + (float)s / (e->n[i + 1] - e->n[i - 1]) *
+                 ((e->n[i] - e->n[i - 1] + s) * (e->q[i + 1] - e->q[i]) /
+                  (e->n[i + 1] - e->n[i]) +
+                  (e->n[i + 1] - e->n[i] - s) * (e->q[i] - e->q[i - 1]) /
+                  (e->n[i] - e->n[i - 1]));
+            if (e->q[i - 1] < qp && qp < e->q[i + 1]) {
+                e->q[i] = qp;
+            } else {
+                e->q[i] += s * (e->q[i + s] - e->q[i]) /
+                           (e->n[i + s] - e->n[i]);
+            }
+            e->n[i] += s;
+        }
+    }
+}
+
+static float
+p2_get(const struct metrics_aggr_p2 *e, float p, uint32_t count)
+{
+    /* Until a sixth value moves the markers, q[] is just the sorted values */
+    if (count > 5) {
+        return e->q[2];
+    }
+
+    return e->q[(int)(p * (count - 1) + 0.5f)];
+}
+
+int
+metrics_aggr_size(const struct metrics_metric_def *def)
+{
+    return sizeof(struct metrics_aggr) +
+           hist_buckets(def) * sizeof(uint32_t) +
+           quantile_count(def) * sizeof(struct metrics_aggr_p2);
+}
+
+void
+metrics_aggr_init(void *aggr, const struct metrics_metric_def *def)
+{
+    memset(aggr, 0, metrics_aggr_size(def));
+}
+
+void
+metrics_aggr_add(void *aggr, const struct metrics_metric_def *def,
+                 uint32_t val)
+{
+    struct metrics_aggr *a = aggr;
+    struct metrics_aggr_p2 *p2;
+    uint32_t *hist;
+    int64_t x;
+    float delta;
+    int i;
+
+    x = aggr_val(def, val);
+
+    if (a->count == 0 || x < aggr_val(def, a->min)) {
+        a->min = val;
+    }
+    if (a->count == 0 || x > aggr_val(def, a->max)) {
+        a->max = val;
+    }
+
+    /* Welford's online mean and variance */
+    a->count++;
+    delta = x - a->mean;
+    a->mean += delta / a->count;
+    a->m2 += delta * (x - a->mean);
+
+    if (hist_buckets(def)) {
+        hist = aggr_hist(a);
+        for (i = 0; i < def->aggr->hist_count; i++) {
+            if (x <= def->aggr->hist_bounds[i]) {
+                break;
+            }
+        }
+        hist[i]++;
+    }
+
+    p2 = aggr_p2(a, def);
+    for (i = 0; i < quantile_count(def); i++) {
+        p2_add(&p2[i], def->aggr->quantiles[i] / 1000.0f, x, a->count);
+    }
+}
+
+static CborError
+encode_val(CborEncoder *encoder, const struct metrics_metric_def *def,
+           uint32_t val)
+{
+    if (def->type & METRICS_TYPE_SIGNED_MASK) {
+        return cbor_encode_int(encoder, (int32_t)val);
+    }
+
+    return cbor_encode_uint(encoder, val);
+}
+
+static CborError
+encode_float(CborEncoder *encoder, float val)
+{
+#if MYNEWT_VAL(FLOAT_USER)
+    return cbor_encode_float(encoder, val);
+#else
+    return cbor_encode_int(encoder, (int64_t)(val < 0 ? val - 0.5f :
+                                                        val + 0.5f));
+#endif
+}
+
+int
+metrics_aggr_to_cbor(CborEncoder *encoder, const void *aggr,
+                     const struct metrics_metric_def *def)
+{
+    const struct metrics_aggr *a = aggr;
+    const struct metrics_aggr_p2 *p2;
+    const uint32_t *hist;
+    CborEncoder map;
+    CborEncoder sub;
+    CborError err;
+    int i;
+
+    err = cbor_encoder_create_map(encoder, &map, CborIndefiniteLength);
+
+    err |= cbor_encode_text_stringz(&map, "n");
+    err |= cbor_encode_uint(&map, a->count);
+    err |= cbor_encode_text_stringz(&map, "min");
+    err |= encode_val(&map, def, a->min);
+    err |= cbor_encode_text_stringz(&map, "max");
+    err |= encode_val(&map, def, a->max);
+    err |= cbor_encode_text_stringz(&map, "mean");
+    err |= encode_float(&map, a->mean);
+    err |= cbor_encode_text_stringz(&map, "var");
+    err |= encode_float(&map, a->count ? a->m2 / a->count : 0);
+
+    if (hist_buckets(def)) {
+        hist = aggr_hist(a);
+        err |= cbor_encode_text_stringz(&map, "h");
+        err |= cbor_encoder_create_array(&map, &sub, hist_buckets(def));
+        for (i = 0; i < hist_buckets(def); i++) {
+            err |= cbor_encode_uint(&sub, hist[i]);
+        }
+        err |= cbor_encoder_close_container(&map, &sub);
+    }
+
+    if (quantile_count(def)) {
+        p2 = aggr_p2(a, def);
+        err |= cbor_encode_text_stringz(&map, "q");
+        err |= cbor_encoder_create_map(&map, &sub, quantile_count(def));
+        for (i = 0; i < quantile_count(def); i++) {
+            err |= cbor_encode_uint(&sub, def->aggr->quantiles[i]);
+            err |= encode_float(&sub, p2_get(&p2[i],
+                                             def->aggr->quantiles[i] / 1000.0f,
+                                             a->count));
+        }
+        err |= cbor_encoder_close_container(&map, &sub);
+    }
+
+    err |= cbor_encoder_close_container(encoder, &map);
+
+    return err ? SYS_ENOMEM : 0;
+}
+
+#endif /* MYNEWT_VAL(METRICS_AGGR) */
@@ -24,9 +24,25 @@
 extern "C" {
 #endif
 
+#define METRICS_TYPE_SERIES_MASK    0x80
+#define METRICS_TYPE_SIGNED_MASK    0x40
+#define METRICS_TYPE_SIZE_MASK      0x0f
+
 int metrics_cli_init(void);
 int metrics_cli_register_event(struct metrics_event_hdr *hdr);
 
+#if MYNEWT_VAL(METRICS_AGGR)
+struct CborEncoder;
+
+/* Size of the summary state of an aggregate metric */
+int metrics_aggr_size(const struct metrics_metric_def *def);
+void metrics_aggr_init(void *aggr, const struct metrics_metric_def *def);
+void metrics_aggr_add(void *aggr, const struct metrics_metric_def *def,
+                      uint32_t val);
+int metrics_aggr_to_cbor(struct CborEncoder *encoder, const void *aggr,
+                         const struct metrics_metric_def *def);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -109,6 +109,62 @@ STATS_SECT_DECL(__name) {                   \
     STATS_PERSIST_SCHED((struct stats_hdr *)&__sectvarname);    \
 } while (0)
 
+#if MYNEWT_VAL(STATS_ATOMIC)
+
+/* Private */
+void stats_add_locked(void *stat, uint8_t size, uint64_t n);
+
+/**
+ * @brief (private) Adds to a stat without losing concurrent updates.
+ *
+ * Widths the CPU can update atomically (e.g., with LDREX/STREX on
+ * Cortex-M3 and up) are incremented lock-free; the rest fall back to a
+ * critical section.  The size switch folds away at compile time.
+ */
+static inline void
+stats_atomic_add(void *stat, uint8_t size, uint64_t n)
+{
+    switch (size) {
+#if __GCC_ATOMIC_SHORT_LOCK_FREE == 2
+    case sizeof (uint16_t):
+        __atomic_fetch_add((uint16_t *)stat, n, __ATOMIC_RELAXED);
+        break;
+#endif
+#if __GCC_ATOMIC_INT_LOCK_FREE == 2
+    case sizeof (uint32_t):
+        __atomic_fetch_add((uint32_t *)stat, n, __ATOMIC_RELAXED);
+        break;
+#endif
+#if __GCC_ATOMIC_LLONG_LOCK_FREE == 2
+    case sizeof (uint64_t):
+        __atomic_fetch_add((uint64_t *)stat, n, __ATOMIC_RELAXED);
+        break;
+#endif
+    default:
+        stats_add_locked(stat, size, n);
+        break;
+    }
+}
+
+/**
+ * @brief Adjusts a stat's in-RAM value by the specified delta.
+ *
+ * With STATS_ATOMIC, the update is atomic with respect to other tasks and
+ * interrupts, so callers don't need a critical section.  This must only be
+ * used with non-persistent stats; for persistent stats the behavior is
+ * undefined.
+ *
+ * @param __sectvarname         The name of the stat group containing the stat
+ *                                  to modify.
+ * @param __var                 The name of the individual stat to modify.
+ * @param __n                   The amount to add to the specified stat.
+ */
+#define STATS_INCN_RAW(__sectvarname, __var, __n)                   \
+    stats_atomic_add(&STATS_GET(__sectvarname, __var),              \
+                     sizeof STATS_GET(__sectvarname, __var), (__n))
+
+#else /* MYNEWT_VAL(STATS_ATOMIC) */
+
 /**
  * @brief Adjusts a stat's in-RAM value by the specified delta.
  *
@@ -125,6 +181,8 @@ STATS_SECT_DECL(__name) {                   \
     (STATS_SET_RAW(__sectvarname, __var,            \
                    STATS_GET(__sectvarname, __var) + (__n))
 
+#endif /* MYNEWT_VAL(STATS_ATOMIC) */
+
 /**
  * @brief Increments a stat's in-RAM value.
  *
@@ -150,8 +208,15 @@ STATS_SECT_DECL(__name) {                   \
  * @param __var                 The name of the individual stat to modify.
  * @param __n                   The amount to add to the specified stat.
  */
+#if MYNEWT_VAL(STATS_ATOMIC)
+#define STATS_INCN(__sectvarname, __var, __n) do {                  \
+    STATS_INCN_RAW(__sectvarname, __var, __n);                      \
+    STATS_PERSIST_SCHED((struct stats_hdr *)&__sectvarname);        \
+} while (0)
+#else
 #define STATS_INCN(__sectvarname, __var, __n)       \
     STATS_SET(__sectvarname, __var, STATS_GET(__sectvarname, __var) + (__n))
+#endif
 
 /**
  * @brief Increments a stat's value.
@@ -213,10 +278,110 @@ int stats_group_walk(stats_group_walk_func_t, void *);
 
 struct stats_hdr *stats_group_find(const char *name);
 
+#if MYNEWT_VAL(STATS_SNAP)
+
+/** Snapshot holds counter deltas since the previous delta snapshot. */
+#define STATS_SNAP_F_DELTA              0x01
+
+/** Format version written at the start of each snapshot record. */
+#define STATS_SNAP_VERSION              1
+
+/** Size of the fixed part of a snapshot record. */
+#define STATS_SNAP_HDR_SZ               10
+
+/**
+ * @brief Computes a hash identifying the layout of a stat group.
+ *
+ * The hash covers the group name, the entry size and count and, if
+ * STATS_NAMES is enabled, the name of each entry.  A collector can cache
+ * a group's field names under this hash and fetch them again only when it
+ * changes.
+ *
+ * @param hdr                   The stat group to hash.
+ *
+ * @return                      The 32-bit FNV-1a hash of the group layout.
+ */
+uint32_t stats_schema_hash(const struct stats_hdr *hdr);
+
+/**
+ * @brief Retrieves the position of a stat group in the registry.
+ *
+ * @param hdr                   The stat group to look up.
+ *
+ * @return                      The group's id; -1 if it isn't registered.
+ */
+int stats_group_id(const struct stats_hdr *hdr);
+
+/**
+ * @brief Calculates the largest snapshot record a stat group can produce.
+ *
+ * @param hdr                   The stat group to examine.
+ * @param flags                 The STATS_SNAP_F_[...] flags to encode with.
+ *
+ * @return                      The maximum record size, in bytes.
+ */
+int stats_snap_max_len(const struct stats_hdr *hdr, uint8_t flags);
+
+/**
+ * @brief Encodes a binary snapshot of a stat group.
+ *
+ * All multi-byte fields are little endian.  A record consists of:
+ *     o version (1 byte, STATS_SNAP_VERSION)
+ *     o flags (1 byte, STATS_SNAP_F_[...])
+ *     o group id (2 bytes, see `stats_group_id()`)
+ *     o schema hash (4 bytes, see `stats_schema_hash()`)
+ *     o entry size (1 byte)
+ *     o entry count (1 byte)
+ *     o the entries, in declaration order.  Without STATS_SNAP_F_DELTA,
+ *       each entry's raw value is written in `entry size` bytes.  With it,
+ *       each entry is written as an unsigned LEB128 varint holding the
+ *       change since the previous delta snapshot of the group committed by
+ *       the same client, modulo the entry width.  A client's first delta
+ *       snapshot of a group holds the full values.
+ *
+ * Delta snapshots keep a baseline per client and group in a buffer of
+ * STATS_SNAP_DELTA_BUF_SIZE bytes.  The values a delta snapshot reports
+ * only become the client's baseline once `stats_snap_delta_done()` is
+ * called with commit set, so a reply that never made it out can be
+ * dropped without losing counts.
+ *
+ * @param hdr                   The stat group to encode.
+ * @param flags                 The STATS_SNAP_F_[...] flags to encode with.
+ * @param client                Identifies the reader whose baseline delta
+ *                                  snapshots use; ignored otherwise.
+ * @param buf                   The buffer to write the record to.
+ * @param buf_len               The size of buf.  It must be at least
+ *                                  `stats_snap_max_len()` bytes.
+ *
+ * @return                      The size of the record on success;
+ *                              SYS_ENOMEM if buf is too small or the
+ *                                  delta buffer is full;
+ *                              SYS_ENOTSUP if delta snapshots are disabled.
+ */
+int stats_snap_encode(struct stats_hdr *hdr, uint8_t flags, uint32_t client,
+                      void *buf, int buf_len);
+
+/**
+ * @brief Ends a round of delta snapshots for a client.
+ *
+ * Either makes the values reported by the client's delta snapshots since
+ * the previous call its new baselines, or drops them so the next delta
+ * snapshots report the same changes again.
+ *
+ * @param client                The client passed to `stats_snap_encode()`.
+ * @param commit                Whether the snapshots were delivered.
+ */
+void stats_snap_delta_done(uint32_t client, bool commit);
+
+#endif /* MYNEWT_VAL(STATS_SNAP) */
+
 /* Private */
 #if MYNEWT_VAL(STATS_MGMT)
 int stats_mgmt_register_group(void);
 #endif
+#if MYNEWT_VAL(STATS_SNAP_MGMT)
+int stats_snap_mgmt_register(void);
+#endif
 #if MYNEWT_VAL(STATS_CLI)
 int stats_shell_register(void);
 #endif
@@ -0,0 +1,166 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "stats_test.h"
+
+#define STCA_CONTENDER_PRIO     10
+#define STCA_STACK_SIZE         OS_STACK_ALIGN(1024)
+
+#define STCA_ITERS              200000
+#define STCA_BURST              1000
+
+STATS_SECT_START(stca)
+    STATS_SECT_ENTRY(plain)
+    STATS_SECT_ENTRY(crit)
+    STATS_SECT_ENTRY(atomic)
+STATS_SECT_END
+
+static STATS_SECT_DECL(stca) stca_stats;
+
+static struct os_task stca_task;
+static os_stack_t stca_stack[STCA_STACK_SIZE];
+static struct os_sem stca_sem;
+
+static volatile int stca_done;
+static uint32_t stca_bursts;
+
+static void
+stca_inc_plain(void)
+{
+    /* What STATS_INC() does without STATS_ATOMIC. */
+    STATS_SET_RAW(stca_stats, plain, STATS_GET(stca_stats, plain) + 1);
+}
+
+static void
+stca_inc_crit(void)
+{
+    os_sr_t sr;
+
+    /* What callers of hot counters have to do today. */
+    OS_ENTER_CRITICAL(sr);
+    STATS_SET_RAW(stca_stats, crit, STATS_GET(stca_stats, crit) + 1);
+    OS_EXIT_CRITICAL(sr);
+}
+
+static void
+stca_inc_atomic(void)
+{
+    STATS_INC_RAW(stca_stats, atomic);
+}
+
+static void
+stca_inc_all(void)
+{
+    stca_inc_plain();
+    stca_inc_crit();
+    stca_inc_atomic();
+}
+
+/**
+ * Preempts the test task once per tick and hammers the same counters.
+ */
+static void
+stca_contender(void *arg)
+{
+    int i;
+
+    while (!stca_done) {
+        for (i = 0; i < STCA_BURST; i++) {
+            stca_inc_all();
+        }
+        stca_bursts++;
+
+        os_time_delay(1);
+    }
+
+    os_sem_release(&stca_sem);
+    while (1) {
+        os_time_delay(OS_TICKS_PER_SEC);
+    }
+}
+
+static uint32_t
+stca_time(void (*inc)(void))
+{
+    uint32_t start;
+    int i;
+
+    start = os_cputime_get32();
+    for (i = 0; i < STCA_ITERS; i++) {
+        inc();
+    }
+
+    return os_cputime_ticks_to_usecs(os_cputime_get32() - start);
+}
+
+TEST_CASE_TASK(stats_test_case_atomic)
+{
+    uint32_t expected;
+    uint32_t plain_us;
+    uint32_t crit_us;
+    uint32_t atomic_us;
+    int rc;
+    int i;
+
+    rc = stats_init(STATS_HDR(stca_stats),
+                    STATS_SIZE_INIT_PARMS(stca_stats, STATS_SIZE_32),
+                    NULL, 0);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /* Time each path on its own, before there is anything to contend with. */
+    plain_us = stca_time(stca_inc_plain);
+    crit_us = stca_time(stca_inc_crit);
+    atomic_us = stca_time(stca_inc_atomic);
+
+    TEST_ASSERT_FATAL(STATS_GET(stca_stats, plain) == STCA_ITERS);
+    TEST_ASSERT_FATAL(STATS_GET(stca_stats, crit) == STCA_ITERS);
+    TEST_ASSERT_FATAL(STATS_GET(stca_stats, atomic) == STCA_ITERS);
+
+    /* Then have the contender preempt a loop hitting all three counters. */
+    rc = os_sem_init(&stca_sem, 0);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    stca_done = 0;
+    stca_bursts = 0;
+    rc = os_task_init(&stca_task, "stca", stca_contender, NULL,
+                      STCA_CONTENDER_PRIO, OS_WAIT_FOREVER, stca_stack,
+                      STCA_STACK_SIZE);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    for (i = 0; i < STCA_ITERS; i++) {
+        stca_inc_all();
+    }
+
+    stca_done = 1;
+    os_sem_pend(&stca_sem, OS_TIMEOUT_NEVER);
+
+    /* Only the plain counter may have lost updates. */
+    expected = 2 * STCA_ITERS + stca_bursts * STCA_BURST;
+    TEST_ASSERT(STATS_GET(stca_stats, crit) == expected);
+    TEST_ASSERT(STATS_GET(stca_stats, atomic) == expected);
+    TEST_ASSERT(STATS_GET(stca_stats, plain) <= expected);
+
+    printf("stats inc: plain %lu ns, critical %lu ns, atomic %lu ns; "
+           "%d bursts, %lu plain updates lost\n",
+           (unsigned long)((uint64_t)plain_us * 1000 / STCA_ITERS),
+           (unsigned long)((uint64_t)crit_us * 1000 / STCA_ITERS),
+           (unsigned long)((uint64_t)atomic_us * 1000 / STCA_ITERS),
+           (int)stca_bursts,
+           (unsigned long)(expected - STATS_GET(stca_stats, plain)));
+}
@@ -0,0 +1,120 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "stats_test.h"
+
+STATS_SECT_START(stcs)
+    STATS_SECT_ENTRY(a)
+    STATS_SECT_ENTRY(b)
+STATS_SECT_END
+
+static STATS_SECT_DECL(stcs) stcs_stats;
+
+/**
+ * Encodes a delta snapshot and decodes the varints following the header.
+ */
+static void
+stcs_delta(uint32_t client, uint32_t *a, uint32_t *b)
+{
+    uint8_t buf[64];
+    uint32_t *vals[2] = { a, b };
+    uint32_t val;
+    int shift;
+    int len;
+    int off;
+    int i;
+
+    len = stats_snap_encode(STATS_HDR(stcs_stats), STATS_SNAP_F_DELTA,
+                            client, buf, sizeof buf);
+    TEST_ASSERT_FATAL(len > STATS_SNAP_HDR_SZ);
+    TEST_ASSERT(buf[0] == STATS_SNAP_VERSION);
+    TEST_ASSERT(buf[1] == STATS_SNAP_F_DELTA);
+    TEST_ASSERT(buf[8] == sizeof (uint32_t));
+    TEST_ASSERT(buf[9] == 2);
+
+    off = STATS_SNAP_HDR_SZ;
+    for (i = 0; i < 2; i++) {
+        val = 0;
+        shift = 0;
+        do {
+            TEST_ASSERT_FATAL(off < len);
+            val |= (uint32_t)(buf[off] & 0x7f) << shift;
+            shift += 7;
+        } while (buf[off++] & 0x80);
+        *vals[i] = val;
+    }
+    TEST_ASSERT(off == len);
+}
+
+TEST_CASE_SELF(stats_test_case_snap)
+{
+    uint8_t buf[64];
+    uint32_t a;
+    uint32_t b;
+    int rc;
+
+    rc = stats_init(STATS_HDR(stcs_stats),
+                    STATS_SIZE_INIT_PARMS(stcs_stats, STATS_SIZE_32),
+                    NULL, 0);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = stats_register("stcs", STATS_HDR(stcs_stats));
+    TEST_ASSERT_FATAL(rc == 0);
+
+    STATS_INCN(stcs_stats, a, 5);
+    STATS_INCN(stcs_stats, b, 300);
+
+    /* Raw values, little endian. */
+    rc = stats_snap_encode(STATS_HDR(stcs_stats), 0, 0, buf, sizeof buf);
+    TEST_ASSERT_FATAL(rc == STATS_SNAP_HDR_SZ + 8);
+    TEST_ASSERT(buf[STATS_SNAP_HDR_SZ] == 5);
+    TEST_ASSERT(buf[STATS_SNAP_HDR_SZ + 4] == 300 % 256);
+    TEST_ASSERT(buf[STATS_SNAP_HDR_SZ + 5] == 300 / 256);
+
+    /* First delta holds the full values. */
+    stcs_delta(1, &a, &b);
+    TEST_ASSERT(a == 5 && b == 300);
+
+    /* Dropped: the same changes are reported again. */
+    stats_snap_delta_done(1, false);
+    stcs_delta(1, &a, &b);
+    TEST_ASSERT(a == 5 && b == 300);
+    stats_snap_delta_done(1, true);
+
+    STATS_INCN(stcs_stats, a, 2);
+
+    /* Committed: only changes since then.  Other clients are unaffected. */
+    stcs_delta(1, &a, &b);
+    TEST_ASSERT(a == 2 && b == 0);
+    stcs_delta(2, &a, &b);
+    TEST_ASSERT(a == 7 && b == 300);
+    stats_snap_delta_done(2, true);
+    stats_snap_delta_done(1, true);
+
+    stcs_delta(1, &a, &b);
+    TEST_ASSERT(a == 0 && b == 0);
+    stcs_delta(2, &a, &b);
+    TEST_ASSERT(a == 0 && b == 0);
+    stats_snap_delta_done(1, true);
+    stats_snap_delta_done(2, true);
+
+    /* Deltas wrap modulo the entry width. */
+    STATS_INCN(stcs_stats, b, UINT32_MAX);
+    stcs_delta(1, &a, &b);
+    TEST_ASSERT(a == 0 && b == UINT32_MAX);
+    stats_snap_delta_done(1, true);
+}
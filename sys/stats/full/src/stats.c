@@ -164,9 +164,46 @@ stats_module_init_internal(void)
     }
 #endif
 
+#if MYNEWT_VAL(STATS_SNAP_MGMT)
+    rc = stats_snap_mgmt_register();
+    if (rc) {
+        return rc;
+    }
+#endif
+
     return rc;
 }
 
+#if MYNEWT_VAL(STATS_NAMES)
+const char *
+stats_name_find(const struct stats_hdr *hdr, uint16_t off, int *hint)
+{
+    int i;
+    int n;
+
+    /* The stats name map contains two elements, an offset into the
+     * statistics entry structure, and the name corresponding with that
+     * offset.  This annotation allows for naming only certain statistics,
+     * and doesn't enforce ordering restrictions on the stats name map.
+     * Maps are nearly always declared in field order though, so resume the
+     * search just past the previous match.
+     */
+    i = *hint;
+    for (n = 0; n < hdr->s_map_cnt; n++) {
+        if (i >= hdr->s_map_cnt) {
+            i = 0;
+        }
+        if (hdr->s_map[i].snm_off == off) {
+            *hint = i + 1;
+            return hdr->s_map[i].snm_name;
+        }
+        i++;
+    }
+
+    return NULL;
+}
+#endif
+
 /**
  * Walk a specific statistic entry, and call walk_func with arg for
  * each field within that entry.
@@ -194,7 +231,9 @@ stats_walk(struct stats_hdr *hdr, stats_walk_func_t walk_func, void *arg)
     int len;
     int rc;
 #if MYNEWT_VAL(STATS_NAMES)
-    int i;
+    int hint;
+
+    hint = 0;
 #endif
 
     start = stats_offset(hdr);
@@ -208,17 +247,7 @@ stats_walk(struct stats_hdr *hdr, stats_walk_func_t walk_func, void *arg)
          */
         name = NULL;
 #if MYNEWT_VAL(STATS_NAMES)
-        /* The stats name map contains two elements, an offset into the
-         * statistics entry structure, and the name corresponding with that
-         * offset.  This annotation allows for naming only certain statistics,
-         * and doesn't enforce ordering restrictions on the stats name map.
-         */
-        for (i = 0; i < hdr->s_map_cnt; ++i) {
-            if (hdr->s_map[i].snm_off == cur) {
-                name = hdr->s_map[i].snm_name;
-                break;
-            }
-        }
+        name = (char *)stats_name_find(hdr, cur, &hint);
 #endif
         /* Do this check irrespective of whether MYNEWT_VALUE(STATS_NAMES)
          * is set.  Users may only partially name elements in the statistics
@@ -422,6 +451,28 @@ stats_init_and_reg(struct stats_hdr *shdr, uint8_t size, uint8_t cnt,
     return rc;
 }
 
+#if MYNEWT_VAL(STATS_ATOMIC)
+void
+stats_add_locked(void *stat, uint8_t size, uint64_t n)
+{
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    switch (size) {
+    case sizeof(uint16_t):
+        *(uint16_t *)stat += n;
+        break;
+    case sizeof(uint32_t):
+        *(uint32_t *)stat += n;
+        break;
+    case sizeof(uint64_t):
+        *(uint64_t *)stat += n;
+        break;
+    }
+    OS_EXIT_CRITICAL(sr);
+}
+#endif
+
 /**
  * Resets and zeroes the specified statistics section.
  *
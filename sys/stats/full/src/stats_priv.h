@@ -49,6 +49,25 @@ size_t stats_size(const struct stats_hdr *hdr);
  */
 void *stats_data(const struct stats_hdr *hdr);
 
+#if MYNEWT_VAL(STATS_NAMES)
+/**
+ * @brief Looks up the name of the stat at the given offset.
+ *
+ * Searching a whole group in field order through the same hint costs
+ * O(n) rather than O(n*m) when the name map is declared in field order.
+ *
+ * @param hdr                   The stat group to examine.
+ * @param off                   The stat's offset from the start of the
+ *                                  group header.
+ * @param hint                  Search position carried between calls;
+ *                                  initialize to 0.
+ *
+ * @return                      The stat's name; NULL if it is unnamed.
+ */
+const char *stats_name_find(const struct stats_hdr *hdr, uint16_t off,
+                            int *hint);
+#endif
+
 /**
  * @brief Writes the specified stat group to sys/config.
  *
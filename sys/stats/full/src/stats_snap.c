@@ -0,0 +1,335 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+
+#if MYNEWT_VAL(STATS_SNAP)
+
+#include <string.h>
+
+#include "stats/stats.h"
+#include "stats_priv.h"
+
+#define STATS_SNAP_FNV_BASIS    0x811c9dc5
+#define STATS_SNAP_FNV_PRIME    0x01000193
+
+#if MYNEWT_VAL(STATS_SNAP_DELTA_BUF_SIZE) > 0
+
+/**
+ * A client's baseline for a group: the values it last committed, followed
+ * by the values reported since then and not yet committed.  Entries are
+ * packed back to back in stats_snap_base_buf, and are never freed;
+ * groups are registered once, at startup, and collectors are expected to
+ * use a few fixed client ids.
+ */
+struct stats_snap_base {
+    const struct stats_hdr *ssb_hdr;
+    uint32_t ssb_client;
+    uint16_t ssb_len;
+    uint8_t ssb_pending;
+};
+
+#define STATS_SNAP_BASE_ALIGN   (sizeof (void *))
+
+#define STATS_SNAP_BASE_SIZE(len)                                       \
+    OS_ALIGN(sizeof (struct stats_snap_base) + 2 * (len),               \
+             STATS_SNAP_BASE_ALIGN)
+
+static uint8_t stats_snap_base_buf[MYNEWT_VAL(STATS_SNAP_DELTA_BUF_SIZE)]
+    __attribute__((aligned(STATS_SNAP_BASE_ALIGN)));
+static uint16_t stats_snap_base_used;
+
+static struct stats_snap_base *
+stats_snap_base_get(const struct stats_hdr *hdr, uint32_t client)
+{
+    struct stats_snap_base *base;
+    uint16_t off;
+    size_t need;
+
+    off = 0;
+    while (off < stats_snap_base_used) {
+        base = (struct stats_snap_base *)(stats_snap_base_buf + off);
+        if (base->ssb_hdr == hdr && base->ssb_client == client) {
+            return base;
+        }
+        off += STATS_SNAP_BASE_SIZE(base->ssb_len);
+    }
+
+    need = STATS_SNAP_BASE_SIZE(stats_size(hdr));
+    if (stats_snap_base_used + need > sizeof stats_snap_base_buf) {
+        return NULL;
+    }
+
+    /* A zeroed baseline makes the first delta the full value. */
+    base = (struct stats_snap_base *)(stats_snap_base_buf + off);
+    base->ssb_hdr = hdr;
+    base->ssb_client = client;
+    base->ssb_len = stats_size(hdr);
+    base->ssb_pending = 0;
+    memset(base + 1, 0, base->ssb_len);
+    stats_snap_base_used += need;
+
+    return base;
+}
+
+#endif
+
+static uint32_t
+stats_snap_fnv(uint32_t hash, const void *data, size_t len)
+{
+    const uint8_t *u8p;
+    size_t i;
+
+    u8p = data;
+    for (i = 0; i < len; i++) {
+        hash ^= u8p[i];
+        hash *= STATS_SNAP_FNV_PRIME;
+    }
+
+    return hash;
+}
+
+uint32_t
+stats_schema_hash(const struct stats_hdr *hdr)
+{
+    uint32_t hash;
+#if MYNEWT_VAL(STATS_NAMES)
+    const char *name;
+    uint16_t start;
+    uint16_t off;
+    int hint;
+    int i;
+#endif
+
+    hash = STATS_SNAP_FNV_BASIS;
+    hash = stats_snap_fnv(hash, hdr->s_name, strlen(hdr->s_name) + 1);
+    hash = stats_snap_fnv(hash, &hdr->s_size, sizeof hdr->s_size);
+    hash = stats_snap_fnv(hash, &hdr->s_cnt, sizeof hdr->s_cnt);
+
+#if MYNEWT_VAL(STATS_NAMES)
+    hint = 0;
+    start = (uint8_t *)stats_data(hdr) - (uint8_t *)hdr;
+    for (i = 0; i < hdr->s_cnt; i++) {
+        off = start + i * hdr->s_size;
+        name = stats_name_find(hdr, off, &hint);
+        if (name == NULL) {
+            name = "";
+        }
+        hash = stats_snap_fnv(hash, name, strlen(name) + 1);
+    }
+#endif
+
+    return hash;
+}
+
+int
+stats_group_id(const struct stats_hdr *hdr)
+{
+    const struct stats_hdr *cur;
+    int id;
+
+    id = 0;
+    STAILQ_FOREACH(cur, &g_stats_registry, s_next) {
+        if (cur == hdr) {
+            return id;
+        }
+        id++;
+    }
+
+    return -1;
+}
+
+int
+stats_snap_max_len(const struct stats_hdr *hdr, uint8_t flags)
+{
+    int ent_len;
+
+    if (flags & STATS_SNAP_F_DELTA) {
+        /* A LEB128 varint carries 7 bits per byte. */
+        ent_len = (hdr->s_size * 8 + 6) / 7;
+    } else {
+        ent_len = hdr->s_size;
+    }
+
+    return STATS_SNAP_HDR_SZ + hdr->s_cnt * ent_len;
+}
+
+static uint64_t
+stats_snap_get(const uint8_t *src, uint8_t size)
+{
+    uint16_t u16;
+    uint32_t u32;
+    uint64_t u64;
+
+    switch (size) {
+    case sizeof u16:
+        memcpy(&u16, src, sizeof u16);
+        return u16;
+    case sizeof u32:
+        memcpy(&u32, src, sizeof u32);
+        return u32;
+    default:
+        memcpy(&u64, src, sizeof u64);
+        return u64;
+    }
+}
+
+#if MYNEWT_VAL(STATS_SNAP_DELTA_BUF_SIZE) > 0
+static void
+stats_snap_set(uint8_t *dst, uint64_t val, uint8_t size)
+{
+    uint16_t u16;
+    uint32_t u32;
+
+    switch (size) {
+    case sizeof u16:
+        u16 = val;
+        memcpy(dst, &u16, sizeof u16);
+        break;
+    case sizeof u32:
+        u32 = val;
+        memcpy(dst, &u32, sizeof u32);
+        break;
+    default:
+        memcpy(dst, &val, sizeof val);
+        break;
+    }
+}
+#endif
+
+static void
+stats_snap_put_le(uint8_t *dst, uint64_t val, int size)
+{
+    int i;
+
+    for (i = 0; i < size; i++) {
+        dst[i] = val >> (i * 8);
+    }
+}
+
+void
+stats_snap_delta_done(uint32_t client, bool commit)
+{
+#if MYNEWT_VAL(STATS_SNAP_DELTA_BUF_SIZE) > 0
+    struct stats_snap_base *base;
+    uint16_t off;
+
+    off = 0;
+    while (off < stats_snap_base_used) {
+        base = (struct stats_snap_base *)(stats_snap_base_buf + off);
+        if (base->ssb_client == client && base->ssb_pending) {
+            if (commit) {
+                memcpy(base + 1, (uint8_t *)(base + 1) + base->ssb_len,
+                       base->ssb_len);
+            }
+            base->ssb_pending = 0;
+        }
+        off += STATS_SNAP_BASE_SIZE(base->ssb_len);
+    }
+#endif
+}
+
+int
+stats_snap_encode(struct stats_hdr *hdr, uint8_t flags, uint32_t client,
+                  void *buf, int buf_len)
+{
+    const uint8_t *src;
+    uint64_t mask;
+    uint64_t val;
+    uint8_t *dst;
+    int i;
+#if MYNEWT_VAL(STATS_SNAP_DELTA_BUF_SIZE) > 0
+    struct stats_snap_base *ssb;
+    uint8_t *pending;
+    uint8_t *base;
+    uint64_t delta;
+#endif
+
+    if (buf_len < stats_snap_max_len(hdr, flags)) {
+        return SYS_ENOMEM;
+    }
+
+    if (hdr->s_size == sizeof (uint64_t)) {
+        mask = UINT64_MAX;
+    } else {
+        mask = (1ULL << (hdr->s_size * 8)) - 1;
+    }
+
+#if MYNEWT_VAL(STATS_SNAP_DELTA_BUF_SIZE) > 0
+    base = NULL;
+    pending = NULL;
+    if (flags & STATS_SNAP_F_DELTA) {
+        ssb = stats_snap_base_get(hdr, client);
+        if (ssb == NULL) {
+            return SYS_ENOMEM;
+        }
+        /* Reported values wait next to the baseline until committed. */
+        ssb->ssb_pending = 1;
+        base = (uint8_t *)(ssb + 1);
+        pending = base + ssb->ssb_len;
+    }
+#else
+    if (flags & STATS_SNAP_F_DELTA) {
+        return SYS_ENOTSUP;
+    }
+#endif
+
+    dst = buf;
+    dst[0] = STATS_SNAP_VERSION;
+    dst[1] = flags;
+    stats_snap_put_le(dst + 2, stats_group_id(hdr), 2);
+    stats_snap_put_le(dst + 4, stats_schema_hash(hdr), 4);
+    dst[8] = hdr->s_size;
+    dst[9] = hdr->s_cnt;
+    dst += STATS_SNAP_HDR_SZ;
+
+    src = stats_data(hdr);
+    for (i = 0; i < hdr->s_cnt; i++) {
+        /* Read each counter once; it may be changing underneath us. */
+        val = stats_snap_get(src, hdr->s_size);
+
+#if MYNEWT_VAL(STATS_SNAP_DELTA_BUF_SIZE) > 0
+        if (base != NULL) {
+            delta = (val - stats_snap_get(base, hdr->s_size)) & mask;
+            stats_snap_set(pending, val, hdr->s_size);
+            base += hdr->s_size;
+            pending += hdr->s_size;
+
+            do {
+                *dst = delta & 0x7f;
+                delta >>= 7;
+                if (delta != 0) {
+                    *dst |= 0x80;
+                }
+                dst++;
+            } while (delta != 0);
+        } else
+#endif
+        {
+            stats_snap_put_le(dst, val & mask, hdr->s_size);
+            dst += hdr->s_size;
+        }
+
+        src += hdr->s_size;
+    }
+
+    return dst - (uint8_t *)buf;
+}
+
+#endif /* MYNEWT_VAL(STATS_SNAP) */
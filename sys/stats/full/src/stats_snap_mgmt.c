@@ -0,0 +1,277 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/mynewt.h"
+
+#if MYNEWT_VAL(STATS_SNAP_MGMT)
+
+#include <string.h>
+
+#include "mgmt/mgmt.h"
+#include "cborattr/cborattr.h"
+#include "stats/stats.h"
+
+#define STATS_SNAP_MGMT_ID_READ     0
+#define STATS_SNAP_MGMT_ID_SCHEMA   1
+
+#define STATS_SNAP_MGMT_NAME_MAX    32
+
+static int stats_snap_mgmt_read(struct mgmt_ctxt *);
+static int stats_snap_mgmt_schema(struct mgmt_ctxt *);
+
+static const struct mgmt_handler stats_snap_mgmt_handlers[] = {
+    [STATS_SNAP_MGMT_ID_READ] = { stats_snap_mgmt_read, NULL },
+    [STATS_SNAP_MGMT_ID_SCHEMA] = { stats_snap_mgmt_schema, NULL },
+};
+
+static struct mgmt_group stats_snap_mgmt_group = {
+    .mg_handlers = (struct mgmt_handler *)stats_snap_mgmt_handlers,
+    .mg_handlers_count = sizeof stats_snap_mgmt_handlers /
+                         sizeof stats_snap_mgmt_handlers[0],
+    .mg_group_id = MYNEWT_VAL(STATS_SNAP_MGMT_GROUP),
+};
+
+static int
+stats_snap_mgmt_encode(CborEncoder *enc, struct stats_hdr *hdr,
+                       uint8_t flags, uint32_t client)
+{
+    uint8_t buf[MYNEWT_VAL(STATS_SNAP_MGMT_BUF_SIZE)];
+    int len;
+
+    len = stats_snap_encode(hdr, flags, client, buf, sizeof buf);
+    if (len < 0) {
+        return MGMT_ERR_ENOMEM;
+    }
+
+    if (cbor_encode_byte_string(enc, buf, len) != CborNoError) {
+        return MGMT_ERR_ENOMEM;
+    }
+
+    return 0;
+}
+
+/**
+ * Command handler: stat snap
+ *
+ * Request:
+ *     o name (optional): the group to read; all groups if absent.
+ *     o delta (optional): report changes since the previous delta read
+ *       by the same client.
+ *     o client (optional): the collector's id, 0 if absent.  Each id has
+ *       its own delta baselines; collectors polling the same device must
+ *       use different ids.
+ *
+ * Response:
+ *     o snap: array of `stats_snap_encode()` records, one per group.
+ */
+static int
+stats_snap_mgmt_read(struct mgmt_ctxt *cb)
+{
+    char name[STATS_SNAP_MGMT_NAME_MAX];
+    struct stats_hdr *hdr;
+    CborError g_err = CborNoError;
+    CborEncoder snaps;
+    uint64_t client;
+    uint8_t flags;
+    bool delta;
+    int rc;
+
+    const struct cbor_attr_t attrs[] = {
+        [0] = {
+            .attribute = "name",
+            .type = CborAttrTextStringType,
+            .addr.string = name,
+            .len = sizeof name
+        },
+        [1] = {
+            .attribute = "delta",
+            .type = CborAttrBooleanType,
+            .addr.boolean = &delta
+        },
+        [2] = {
+            .attribute = "client",
+            .type = CborAttrUnsignedIntegerType,
+            .addr.uinteger = &client
+        },
+        [3] = {
+            .attribute = NULL
+        }
+    };
+
+    name[0] = '\0';
+    delta = false;
+    client = 0;
+
+    rc = cbor_read_object(&cb->it, attrs);
+    if (rc != 0 || client > UINT32_MAX) {
+        return MGMT_ERR_EINVAL;
+    }
+
+    flags = delta ? STATS_SNAP_F_DELTA : 0;
+
+    if (name[0] != '\0') {
+        hdr = stats_group_find(name);
+        if (hdr == NULL) {
+            return MGMT_ERR_ENOENT;
+        }
+    } else {
+        hdr = NULL;
+    }
+
+    /* Check every record fits before encoding any of them. */
+    if (hdr != NULL) {
+        if (stats_snap_max_len(hdr, flags) >
+            MYNEWT_VAL(STATS_SNAP_MGMT_BUF_SIZE)) {
+            return MGMT_ERR_ENOMEM;
+        }
+    } else {
+        STAILQ_FOREACH(hdr, &g_stats_registry, s_next) {
+            if (stats_snap_max_len(hdr, flags) >
+                MYNEWT_VAL(STATS_SNAP_MGMT_BUF_SIZE)) {
+                return MGMT_ERR_ENOMEM;
+            }
+        }
+    }
+
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "rc");
+    g_err |= cbor_encode_int(&cb->encoder, MGMT_ERR_EOK);
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "snap");
+    g_err |= cbor_encoder_create_array(&cb->encoder, &snaps,
+                                       CborIndefiniteLength);
+    if (g_err) {
+        return MGMT_ERR_ENOMEM;
+    }
+
+    if (name[0] != '\0') {
+        rc = stats_snap_mgmt_encode(&snaps, stats_group_find(name), flags,
+                                    client);
+    } else {
+        rc = 0;
+        STAILQ_FOREACH(hdr, &g_stats_registry, s_next) {
+            rc = stats_snap_mgmt_encode(&snaps, hdr, flags, client);
+            if (rc != 0) {
+                break;
+            }
+        }
+    }
+    if (rc == 0) {
+        g_err |= cbor_encoder_close_container(&cb->encoder, &snaps);
+        if (g_err) {
+            rc = MGMT_ERR_ENOMEM;
+        }
+    }
+
+    /* The new baselines only count once the whole response is encoded. */
+    if (flags & STATS_SNAP_F_DELTA) {
+        stats_snap_delta_done(client, rc == 0);
+    }
+
+    return rc;
+}
+
+static int
+stats_snap_mgmt_encode_field(struct stats_hdr *hdr, void *arg, char *name,
+                             uint16_t off)
+{
+    return cbor_encode_text_stringz(arg, name) != CborNoError;
+}
+
+/**
+ * Command handler: stat schema
+ *
+ * Request:
+ *     o name: the group to describe.
+ *
+ * Response:
+ *     o name, id, hash: the group's name, id and schema hash, as used in
+ *       snapshot records.
+ *     o size: the size of each entry, in bytes.
+ *     o fields: array of entry names, in snapshot order.
+ */
+static int
+stats_snap_mgmt_schema(struct mgmt_ctxt *cb)
+{
+    char name[STATS_SNAP_MGMT_NAME_MAX];
+    struct stats_hdr *hdr;
+    CborError g_err = CborNoError;
+    CborEncoder fields;
+    int rc;
+
+    const struct cbor_attr_t attrs[] = {
+        [0] = {
+            .attribute = "name",
+            .type = CborAttrTextStringType,
+            .addr.string = name,
+            .len = sizeof name
+        },
+        [1] = {
+            .attribute = NULL
+        }
+    };
+
+    name[0] = '\0';
+
+    rc = cbor_read_object(&cb->it, attrs);
+    if (rc != 0) {
+        return MGMT_ERR_EINVAL;
+    }
+
+    hdr = stats_group_find(name);
+    if (hdr == NULL) {
+        return MGMT_ERR_ENOENT;
+    }
+
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "rc");
+    g_err |= cbor_encode_int(&cb->encoder, MGMT_ERR_EOK);
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "name");
+    g_err |= cbor_encode_text_stringz(&cb->encoder, hdr->s_name);
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "id");
+    g_err |= cbor_encode_uint(&cb->encoder, stats_group_id(hdr));
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "hash");
+    g_err |= cbor_encode_uint(&cb->encoder, stats_schema_hash(hdr));
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "size");
+    g_err |= cbor_encode_uint(&cb->encoder, hdr->s_size);
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "fields");
+    g_err |= cbor_encoder_create_array(&cb->encoder, &fields,
+                                       CborIndefiniteLength);
+    if (g_err) {
+        return MGMT_ERR_ENOMEM;
+    }
+
+    rc = stats_walk(hdr, stats_snap_mgmt_encode_field, &fields);
+    if (rc != 0) {
+        return MGMT_ERR_ENOMEM;
+    }
+
+    g_err |= cbor_encoder_close_container(&cb->encoder, &fields);
+    if (g_err) {
+        return MGMT_ERR_ENOMEM;
+    }
+
+    return 0;
+}
+
+int
+stats_snap_mgmt_register(void)
+{
+    mgmt_register_group(&stats_snap_mgmt_group);
+    return 0;
+}
+
+#endif /* MYNEWT_VAL(STATS_SNAP_MGMT) */
@@ -107,4 +107,22 @@ int streamer_mbuf_new(struct streamer_mbuf *sm, struct os_mbuf *om);
  */
 int streamer_msys_new(struct streamer_mbuf *sm);
 
+/**
+ * @brief Writes a region of an external buffer to an mbuf streamer without
+ * copying it.
+ *
+ * The mbuf chain takes a reference to the buffer; see os_mbuf_append_ext().
+ * Data written afterwards with streamer_write() goes to new mbufs, so the
+ * external data is never modified.
+ *
+ * @param sm                    The mbuf streamer to write to.
+ * @param ext                   The external buffer to reference.
+ * @param off                   Offset of the region within the buffer.
+ * @param len                   Length of the region.
+ *
+ * @return                      0 on success; SYS_E[...] on failure.
+ */
+int streamer_mbuf_write_ext(struct streamer_mbuf *sm, struct os_mbuf_ext *ext,
+                            uint16_t off, uint16_t len);
+
 #endif
@@ -39,6 +39,20 @@ streamer_mbuf_write(struct streamer *streamer, const void *src, size_t len)
     return 0;
 }
 
+int
+streamer_mbuf_write_ext(struct streamer_mbuf *sm, struct os_mbuf_ext *ext,
+                        uint16_t off, uint16_t len)
+{
+    int rc;
+
+    rc = os_mbuf_append_ext(sm->om, ext, off, len);
+    if (rc != 0) {
+        return os_error_to_sys(rc);
+    }
+
+    return 0;
+}
+
 static int
 streamer_mbuf_vprintf(struct streamer *streamer, const char *fmt, va_list ap)
 {